@@ -0,0 +1,162 @@
+/* font_5x7.h — Police bitmap 5×7 en flash (PROGMEM): ASCII 32–126 et accents Latin-1 du français */
+#ifndef FONT_5X7_H
+#define FONT_5X7_H
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+
+// Chaque glyphe = 5 colonnes d'un octet, bit 0 = ligne du haut (7 lignes utilisées).
+// Lecture par pgm_read_byte() uniquement: les tables restent en flash, aucune copie en SRAM.
+#define FONT_WIDTH 5
+#define FONT_HEIGHT 7
+#define FONT_ADVANCE 6  // 5 colonnes + 1 colonne d'espace (× l'échelle)
+#define FONT_FIRST 32
+#define FONT_LAST 126
+
+static const uint8_t font_5x7[FONT_LAST - FONT_FIRST + 1][FONT_WIDTH] PROGMEM = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, // Espace (32)
+    {0x00, 0x00, 0x5F, 0x00, 0x00}, // !
+    {0x00, 0x07, 0x00, 0x07, 0x00}, // "
+    {0x14, 0x7F, 0x14, 0x7F, 0x14}, // #
+    {0x24, 0x2A, 0x7F, 0x2A, 0x12}, // $
+    {0x23, 0x13, 0x08, 0x64, 0x62}, // %
+    {0x36, 0x49, 0x55, 0x22, 0x50}, // &
+    {0x00, 0x05, 0x03, 0x00, 0x00}, // '
+    {0x00, 0x1C, 0x22, 0x41, 0x00}, // (
+    {0x00, 0x41, 0x22, 0x1C, 0x00}, // )
+    {0x14, 0x08, 0x3E, 0x08, 0x14}, // *
+    {0x08, 0x08, 0x3E, 0x08, 0x08}, // +
+    {0x00, 0x00, 0xA0, 0x60, 0x00}, // ,
+    {0x08, 0x08, 0x08, 0x08, 0x08}, // -
+    {0x00, 0x60, 0x60, 0x00, 0x00}, // .
+    {0x20, 0x10, 0x08, 0x04, 0x02}, // /
+    {0x3E, 0x51, 0x49, 0x45, 0x3E}, // 0
+    {0x00, 0x42, 0x7F, 0x40, 0x00}, // 1
+    {0x42, 0x61, 0x51, 0x49, 0x46}, // 2
+    {0x21, 0x41, 0x45, 0x4B, 0x31}, // 3
+    {0x18, 0x14, 0x12, 0x7F, 0x10}, // 4
+    {0x27, 0x45, 0x45, 0x45, 0x39}, // 5
+    {0x3C, 0x4A, 0x49, 0x49, 0x30}, // 6
+    {0x01, 0x71, 0x09, 0x05, 0x03}, // 7
+    {0x36, 0x49, 0x49, 0x49, 0x36}, // 8
+    {0x06, 0x49, 0x49, 0x29, 0x1E}, // 9
+    {0x00, 0x36, 0x36, 0x00, 0x00}, // :
+    {0x00, 0x56, 0x36, 0x00, 0x00}, // ;
+    {0x08, 0x14, 0x22, 0x41, 0x00}, // <
+    {0x14, 0x14, 0x14, 0x14, 0x14}, // =
+    {0x00, 0x41, 0x22, 0x14, 0x08}, // >
+    {0x02, 0x01, 0x51, 0x09, 0x06}, // ?
+    {0x32, 0x49, 0x59, 0x51, 0x3E}, // @
+    {0x7C, 0x12, 0x11, 0x12, 0x7C}, // A
+    {0x7F, 0x49, 0x49, 0x49, 0x36}, // B
+    {0x3E, 0x41, 0x41, 0x41, 0x22}, // C
+    {0x7F, 0x41, 0x41, 0x22, 0x1C}, // D
+    {0x7F, 0x49, 0x49, 0x49, 0x41}, // E
+    {0x7F, 0x09, 0x09, 0x09, 0x01}, // F
+    {0x3E, 0x41, 0x49, 0x49, 0x7A}, // G
+    {0x7F, 0x08, 0x08, 0x08, 0x7F}, // H
+    {0x00, 0x41, 0x7F, 0x41, 0x00}, // I
+    {0x20, 0x40, 0x41, 0x3F, 0x01}, // J
+    {0x7F, 0x08, 0x14, 0x22, 0x41}, // K
+    {0x7F, 0x40, 0x40, 0x40, 0x40}, // L
+    {0x7F, 0x02, 0x0C, 0x02, 0x7F}, // M
+    {0x7F, 0x04, 0x08, 0x10, 0x7F}, // N
+    {0x3E, 0x41, 0x41, 0x41, 0x3E}, // O
+    {0x7F, 0x09, 0x09, 0x09, 0x06}, // P
+    {0x3E, 0x41, 0x51, 0x21, 0x5E}, // Q
+    {0x7F, 0x09, 0x19, 0x29, 0x46}, // R
+    {0x46, 0x49, 0x49, 0x49, 0x31}, // S
+    {0x01, 0x01, 0x7F, 0x01, 0x01}, // T
+    {0x3F, 0x40, 0x40, 0x40, 0x3F}, // U
+    {0x1F, 0x20, 0x40, 0x20, 0x1F}, // V
+    {0x3F, 0x40, 0x38, 0x40, 0x3F}, // W
+    {0x63, 0x14, 0x08, 0x14, 0x63}, // X
+    {0x07, 0x08, 0x70, 0x08, 0x07}, // Y
+    {0x61, 0x51, 0x49, 0x45, 0x43}, // Z
+    {0x00, 0x7F, 0x41, 0x41, 0x00}, // [
+    {0x02, 0x04, 0x08, 0x10, 0x20}, // antislash
+    {0x00, 0x41, 0x41, 0x7F, 0x00}, // ]
+    {0x04, 0x02, 0x01, 0x02, 0x04}, // ^
+    {0x40, 0x40, 0x40, 0x40, 0x40}, // _
+    {0x00, 0x01, 0x02, 0x04, 0x00}, // `
+    {0x20, 0x54, 0x54, 0x54, 0x78}, // a
+    {0x7F, 0x48, 0x44, 0x44, 0x38}, // b
+    {0x38, 0x44, 0x44, 0x44, 0x20}, // c
+    {0x38, 0x44, 0x44, 0x48, 0x7F}, // d
+    {0x38, 0x54, 0x54, 0x54, 0x18}, // e
+    {0x08, 0x7E, 0x09, 0x01, 0x02}, // f
+    {0x0C, 0x52, 0x52, 0x52, 0x3E}, // g
+    {0x7F, 0x08, 0x04, 0x04, 0x78}, // h
+    {0x00, 0x44, 0x7D, 0x40, 0x00}, // i
+    {0x20, 0x40, 0x44, 0x3D, 0x00}, // j
+    {0x7F, 0x10, 0x28, 0x44, 0x00}, // k
+    {0x00, 0x41, 0x7F, 0x40, 0x00}, // l
+    {0x7C, 0x04, 0x18, 0x04, 0x78}, // m
+    {0x7C, 0x08, 0x04, 0x04, 0x78}, // n
+    {0x38, 0x44, 0x44, 0x44, 0x38}, // o
+    {0x7C, 0x14, 0x14, 0x14, 0x08}, // p
+    {0x08, 0x14, 0x14, 0x18, 0x7C}, // q
+    {0x7C, 0x08, 0x04, 0x04, 0x08}, // r
+    {0x48, 0x54, 0x54, 0x54, 0x20}, // s
+    {0x04, 0x3F, 0x44, 0x40, 0x20}, // t
+    {0x3C, 0x40, 0x40, 0x20, 0x7C}, // u
+    {0x1C, 0x20, 0x40, 0x20, 0x1C}, // v
+    {0x3C, 0x40, 0x30, 0x40, 0x3C}, // w
+    {0x44, 0x28, 0x10, 0x28, 0x44}, // x
+    {0x0C, 0x50, 0x50, 0x50, 0x3C}, // y
+    {0x44, 0x64, 0x54, 0x4C, 0x44}, // z
+    {0x00, 0x08, 0x36, 0x41, 0x00}, // {
+    {0x00, 0x00, 0x7F, 0x00, 0x00}, // |
+    {0x00, 0x41, 0x36, 0x08, 0x00}, // }
+    {0x08, 0x04, 0x08, 0x10, 0x08}, // ~
+};
+
+// Latin-1 (U+00A0–U+00FF) utile à l'interface en français: codes triés + glyphes au même index.
+// Majuscules accentuées dessinées sur 5 lignes (2–6) comme les minuscules: l'accent occupe
+// les lignes 0–1. U+00A0 (espace insécable) est traité comme un espace; les autres codes → '?'.
+static const uint8_t font_latin1_codes[] PROGMEM = {
+    0xAB, 0xB0, 0xBB, 0xC0, 0xC2, 0xC4, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCE,
+    0xCF, 0xD4, 0xD6, 0xD9, 0xDB, 0xDC, 0xE0, 0xE2, 0xE4, 0xE7, 0xE8, 0xE9,
+    0xEA, 0xEB, 0xEE, 0xEF, 0xF4, 0xF6, 0xF9, 0xFB, 0xFC, 0xFF,
+};
+
+static const uint8_t font_latin1[][FONT_WIDTH] PROGMEM = {
+    {0x08, 0x14, 0x2A, 0x14, 0x22}, // «
+    {0x06, 0x09, 0x09, 0x06, 0x00}, // °
+    {0x22, 0x14, 0x2A, 0x14, 0x08}, // »
+    {0x78, 0x15, 0x16, 0x14, 0x78}, // À
+    {0x78, 0x16, 0x15, 0x16, 0x78}, // Â
+    {0x78, 0x15, 0x14, 0x15, 0x78}, // Ä
+    {0x1C, 0x22, 0x62, 0x22, 0x14}, // Ç
+    {0x7C, 0x55, 0x56, 0x54, 0x44}, // È
+    {0x7C, 0x54, 0x56, 0x55, 0x44}, // É
+    {0x7C, 0x56, 0x55, 0x56, 0x44}, // Ê
+    {0x7C, 0x55, 0x54, 0x55, 0x44}, // Ë
+    {0x00, 0x46, 0x7D, 0x46, 0x00}, // Î
+    {0x00, 0x45, 0x7C, 0x45, 0x00}, // Ï
+    {0x38, 0x46, 0x45, 0x46, 0x38}, // Ô
+    {0x38, 0x45, 0x44, 0x45, 0x38}, // Ö
+    {0x3C, 0x41, 0x42, 0x40, 0x3C}, // Ù
+    {0x3C, 0x42, 0x41, 0x42, 0x3C}, // Û
+    {0x3C, 0x41, 0x40, 0x41, 0x3C}, // Ü
+    {0x20, 0x55, 0x56, 0x54, 0x78}, // à
+    {0x20, 0x56, 0x55, 0x56, 0x78}, // â
+    {0x20, 0x55, 0x54, 0x55, 0x78}, // ä
+    {0x1C, 0x22, 0x62, 0x22, 0x10}, // ç
+    {0x38, 0x55, 0x56, 0x54, 0x18}, // è
+    {0x38, 0x54, 0x56, 0x55, 0x18}, // é
+    {0x38, 0x56, 0x55, 0x56, 0x18}, // ê
+    {0x38, 0x55, 0x54, 0x55, 0x18}, // ë
+    {0x00, 0x46, 0x7D, 0x42, 0x00}, // î
+    {0x00, 0x45, 0x7C, 0x41, 0x00}, // ï
+    {0x38, 0x46, 0x45, 0x46, 0x38}, // ô
+    {0x38, 0x45, 0x44, 0x45, 0x38}, // ö
+    {0x3C, 0x41, 0x42, 0x20, 0x7C}, // ù
+    {0x3C, 0x42, 0x41, 0x22, 0x7C}, // û
+    {0x3C, 0x41, 0x40, 0x21, 0x7C}, // ü
+    {0x0C, 0x51, 0x50, 0x51, 0x3C}, // ÿ
+};
+
+static_assert(sizeof(font_latin1_codes) == sizeof(font_latin1) / FONT_WIDTH, "un code par glyphe Latin-1");
+
+#endif // FONT_5X7_H
@@ -3,7 +3,7 @@
  * 
  * Fonctionnalités:
  * - Lecture du capteur TEMT6000 (luminosité ambiante)
- * - Communication UART avec ESP32 (9600 bauds, 8 MHz)
+ * - Communication UART avec ESP32 (9600 bauds au boot, négociée jusqu'à 1 Mbaud, 8 MHz)
  * - Contrôle PWM de la LED de backlight
  * - Affichage sur écran ST7789 TFT (SPI)
  * 
@@ -22,32 +22,68 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include <avr/wdt.h>
+#include <avr/sleep.h>
 #include <util/delay.h>
+#include <util/crc16.h>
 #include <string.h>
+#include "../../esp32/esp32_micropython/LinkMessages.h"  // CMD_*, schémas des messages (partagé avec l'ESP32)
+#include "../../esp32/esp32_micropython/LedFade.h"  // Fondus perceptuels (partagé avec l'ESP32)
+#include "font_5x7.h"  // Police en flash
 
-// Configuration UART — 9600 baud @ 8 MHz (oscillateur interne)
+// Configuration UART — 9600 baud @ 8 MHz (oscillateur interne), U2X actif
 #define UART_BAUD 9600
 #ifndef F_CPU
 #define F_CPU 8000000UL
 #endif
-#define UART_UBRR 51  // 9600 @ 8MHz
-
-// Protocole UART
-// Format: [CMD] [DATA...] [\n]
-#define CMD_READ_LIGHT 0x01  // Lire la luminosité
-#define CMD_SET_LED 0x02     // Définir la luminosité LED (0-255)
-#define CMD_GET_LED 0x03     // Obtenir la luminosité LED actuelle
-#define CMD_UPDATE_DISPLAY 0x04  // Mettre à jour l'affichage ST7789
-#define CMD_SET_DISPLAY_DATA 0x05  // Envoyer les données d'affichage (profil, mode, etc.)
-#define CMD_SET_DISPLAY_IMAGE 0x08  // Commencer la réception d'une image RGB565
-#define CMD_SET_DISPLAY_IMAGE_CHUNK 0x09  // Recevoir un chunk d'image
-#define CMD_SET_ATMEGA_DEBUG 0x0A  // Activer/désactiver le debug UART sur l'ATmega
-#define CMD_SET_ATMEGA_LOG_LEVEL 0x0B  // Définir le niveau de log de l'ATmega
-#define CMD_SET_LAST_KEY 0x0C  // Envoyer uniquement la dernière touche appuyée
+#define UART_UBRR 103  // 9600 @ 8MHz avec U2X (0,2 %)
+
+// Vitesses négociables (index partagé avec LINK_BAUD_RATES côté ESP32)
+// U2X: UBRR = F_CPU / (8 × baud) - 1 → 250k = 3, 500k = 1, 1M = 0 (exacts à 8 MHz)
+#if F_CPU == 8000000UL
+#define LINK_BAUD_MASK 0x0F  // 9600 / 250k / 500k / 1M
+#else
+#define LINK_BAUD_MASK 0x01  // Autre quartz: rester à 9600
+#endif
+#define LINK_BAUD_FALLBACK_ERRORS 8  // Erreurs de ligne (FE/DOR) avant retour à 9600
+#define LINK_BAUD_FALLBACK_FRAMES 3  // Trames invalides consécutives avant retour à 9600
+
+// Protocole UART tramé (voir AtmegaLink.h côté ESP32)
+// Trame brute: [SEQ] [CMD] [LEN] [DATA × LEN] [CRC16 lo] [CRC16 hi]
+// CRC-16/CCITT (_crc_ccitt_update, init 0xFFFF) sur SEQ..DATA, puis encodage COBS + délimiteur 0x00
+// Chaque commande de l'ESP32 est acquittée (CMD_LINK_ACK) ou rejetée (CMD_LINK_NACK)
+// Commandes, constantes de trame et contenu des messages: LinkMessages.h
 
 // Capteur TEMT6000: 0 = ADC élevé = clair (LED OFF si >= 500), ADC bas = sombre (LED ON)
 #define LIGHT_SENSOR_INVERTED 0
 
+// Push de luminosité (abonnement CMD_LIGHT_SUBSCRIBE): valeurs actives dès le boot,
+// pour que l'ESP32 reste informé même après un reset de l'ATmega
+#define LIGHT_SUB_DEFAULT_DELTA 20
+#define LIGHT_SUB_DEFAULT_THRESHOLD 500
+#define LIGHT_SUB_DEFAULT_HYSTERESIS 40
+#define LIGHT_SUB_DEFAULT_INTERVAL_MS 500
+#define LIGHT_SAMPLE_MS 100  // Cadence ADC de la boucle principale (résolution de l'intervalle)
+#define LIGHT_LED_THRESHOLD 500  // Seuil LED locale
+#define LIGHT_LED_HYSTERESIS 16  // ± autour du seuil: le bruit ne fait plus clignoter la LED
+
+// Rafale en mode libre (interruption de fin de conversion, prescaler 128: ~210 µs par
+// conversion) lancée à chaque TASK_ADC_MS: 16 conversions en ~3,3 ms, ADATE coupé avant la
+// dernière. 160 réveils ADC/s au lieu de ~4,8k/s en mode libre continu.
+// 16 échantillons sommés puis décimés (>> 2) = 12 bits, filtrés par un IIR à virgule fixe
+// y += (x - y) >> ADC_IIR_SHIFT (10 Hz en sortie, α = 1/32 ≈ 3,2 s de constante de temps)
+#define ADC_OVERSAMPLE 16
+#define ADC_DECIMATE_SHIFT 2  // Somme de 16 × 10 bits → 12 bits
+#define ADC_IIR_SHIFT 5
+#define ADC_IIR_FRAC 4  // Bits fractionnaires de l'état (12 + 4 = 16 bits)
+// Échelon de lumière: deux échantillons décimés de suite hors de ±ADC_STEP_BAND (12 bits, ~4σ
+// du bruit décimé à ±20 LSB) du même côté → état recalé sur leur moyenne (suivi en 200 ms).
+// Un pic isolé ne suffit pas: il passe par l'IIR comme le reste du bruit
+#define ADC_STEP_BAND 48
+#define ADC_STEP_NONE 0xFFFF  // Aucun échantillon hors bande en attente
+// 1 = conversions en sommeil ADC Noise Reduction (rafale de 16 conversions simples au lieu du mode libre).
+// Horloge E/S coupée pendant ~3 ms: UART RX et PWM LED s'arrêtent (trames retransmises). Désactivé par défaut.
+#define ADC_NOISE_REDUCTION 0
+
 // Configuration ST7789
 // Pour un écran 1.9" 170x320, utiliser 170 comme hauteur
 // Si il y a du bruit en bas, essayer 172 ou ajuster les offsets
@@ -63,6 +99,36 @@
 #define ST7789_RST_DDR DDRB
 #define ST7789_RST_PIN PB0
 
+// Transport SPI de l'écran (SCK = F_CPU/2: 16 cycles par octet), choisi à la compilation
+// POLLED: écrire SPDR puis attendre SPIF; l'appel, la boucle et le calcul de l'octet suivant
+//   s'ajoutent aux 16 cycles du transfert.
+// PIPELINED: attendre la fin de l'octet précédent puis écrire; le calcul du suivant se fait
+//   pendant le transfert. DC et CS ne changent qu'après spi_flush().
+// L'USART en SPI maître (MSPIM, émission double-tampon) n'est pas utilisable: l'unique USART0
+// porte la liaison ESP32. Banc: durée de st7789_fill_screen loguée (Timer1).
+#define ST7789_SPI_POLLED 0
+#define ST7789_SPI_PIPELINED 1
+#ifndef ST7789_SPI_BACKEND
+#define ST7789_SPI_BACKEND ST7789_SPI_PIPELINED
+#endif
+#define TIMER1_US_PER_TICK (256000000UL / F_CPU)  // Timer1 à F_CPU/256: 32 µs à 8 MHz (2,1 s max)
+
+// Démarrage de l'écran pendant la boucle principale (la liaison répond dès sei()):
+// attentes en ms de l'ordonnanceur, effacement par bandes de lignes
+#define DISPLAY_BOOT_FILL_ROWS 4  // ~5 ms de SPI par bande
+
+// LED OC0B: fondu perceptuel vers chaque nouvelle valeur (LedFade.h), horloge = ms de l'ordonnanceur
+#define LED_FADE_MS 250
+
+// Boucle principale: tick Timer2 (CTC, F_CPU/64) et sommeil Idle entre deux événements.
+// Réveil par le tick, UART RX/UDRE ou la fin de conversion ADC: une trame est traitée dès son
+// délimiteur. Chaque tâche périodique a son échéance (retard mesuré, pas de rattrapage en rafale).
+#define SCHED_TICK_HZ 1000
+#define SCHED_TIMER2_TOP (F_CPU / 64 / SCHED_TICK_HZ - 1)  // OCR2A: 124 à 8 MHz
+#define TASK_ADC_MS LIGHT_SAMPLE_MS  // Luminosité, LED locale, push
+#define TASK_UI_MS 200  // Luminosité affichée
+#define TASK_DEBUG_MS 5000  // Logs [LIGHT], [UART], [SLEEP]
+
 // Commandes ST7789
 #define ST7789_NOP 0x00
 #define ST7789_SWRESET 0x01
@@ -78,38 +144,92 @@
 #define ST7789_INVOFF 0x20
 
 // Variables globales UART
-#define UART_BUFFER_SIZE 256
-volatile uint8_t uart_buffer[UART_BUFFER_SIZE];  // Buffer pour recevoir les commandes
-volatile uint8_t uart_buffer_index = 0;
-volatile uint8_t uart_cmd_pending = 0;  // 1 = commande reçue, à traiter dans la boucle principale
-volatile uint8_t uart_command = 0;
-volatile uint8_t led_brightness = 0;  // 0-255
-volatile uint16_t light_level = 0;    // Valeur ADC du TEMT6000 (0-1023)
+// Réception: anneau d'octets (trames COBS sans délimiteur, contiguës) + file de descripteurs.
+// L'ISR continue de recevoir pendant qu'une commande longue (dessin) s'exécute;
+// la boucle principale copie/décode chaque trame dans l'ordre puis libère sa place.
+#define UART_RX_RING_SIZE 256  // Index uint8_t: le débordement d'index fait le modulo (≈ 2 trames max)
+#define UART_RX_FRAME_ENC_MAX (LINK_FRAME_MAX + 1)  // Trame COBS max (sans délimiteur)
+#define UART_RX_QUEUE_SIZE 4  // Puissance de 2
+#define UART_RX_QUEUE_MASK (UART_RX_QUEUE_SIZE - 1)
+typedef struct {
+    uint8_t start;   // Position dans l'anneau
+    uint8_t len;     // Octets encodés (0 = trame perdue, NACK à envoyer)
+    uint8_t info;    // len > 0: inutilisé; len = 0: [seq supposé]
+    uint8_t reason;  // len = 0: LINK_NACK_*
+} UartRxFrame;
+uint8_t uart_rx_ring[UART_RX_RING_SIZE];
+volatile uint8_t uart_rx_head = 0;  // Écrit par l'ISR
+volatile uint8_t uart_rx_tail = 0;  // Début de la plus ancienne trame non consommée (boucle principale)
+UartRxFrame uart_rx_queue[UART_RX_QUEUE_SIZE];
+volatile uint8_t uart_rx_queue_head = 0;  // Écrit par l'ISR
+volatile uint8_t uart_rx_queue_tail = 0;  // Écrit par la boucle principale
+uint8_t uart_rx_frame_start = 0;  // ISR: trame en cours d'accumulation
+uint8_t uart_rx_frame_len = 0;
+uint8_t uart_rx_frame_seq = 0;
+uint8_t uart_rx_discard = 0;  // ISR: 0, ou raison d'abandon de la trame en cours (0xFF = erreur de ligne, silencieuse)
+volatile uint8_t uart_rx_lost_nack = 0;  // File pleine: NACK à envoyer dès que possible
+// Santé de la liaison (compteurs 16 bits, rebouclent) — envoyés par CMD_LINK_STATUS
+typedef struct {
+    uint16_t rx_frames;       // Trames valides reçues
+    uint16_t tx_frames;       // Trames émises
+    uint16_t crc_errors;
+    uint16_t framing_errors;  // COBS ou longueur invalide
+    uint16_t line_errors;     // FE / DOR (ISR)
+    uint16_t overruns;        // DOR seuls: octet écrasé dans l'UART (ISR)
+    uint16_t dropped;         // Trames perdues: anneau / file pleins, trop longues (ISR)
+    uint16_t duplicates;      // Retransmissions déjà exécutées (ACK perdu côté ESP32)
+    uint16_t unknown_cmds;
+} LinkStats;
+volatile LinkStats link_stats;
+uint8_t uart_rx_frame[LINK_FRAME_MAX];  // Trame décodée en cours de traitement
+#define UART_RX_PENDING() (uart_rx_queue_head != uart_rx_queue_tail || uart_rx_lost_nack)
+uint8_t uart_rx_last_seq = 0;
+uint8_t uart_rx_have_seq = 0;
+uint8_t uart_tx_seq = 0;
+uint8_t link_baud_idx = 0;  // 0 = UART_BAUD
+volatile uint8_t uart_line_errors = 0;  // FE/DOR depuis la dernière trame valide
+uint8_t uart_bad_frames = 0;  // Trames invalides consécutives
+uint8_t uart_tx_frame[LINK_FRAME_MAX];
+// Anneau d'émission vidé par l'interruption UDRE (la boucle principale ne bloque plus par octet)
+#define UART_TX_RING_SIZE 128  // Puissance de 2, contient une trame complète encodée
+#define UART_TX_RING_MASK (UART_TX_RING_SIZE - 1)
+uint8_t uart_tx_ring[UART_TX_RING_SIZE];
+volatile uint8_t uart_tx_head = 0;  // Écrit par la boucle principale
+volatile uint8_t uart_tx_tail = 0;  // Écrit par l'ISR UDRE
+uint16_t uart_tx_full_count = 0;  // Contre-pression: octets ayant attendu une place libre
+uint8_t uart_tx_max_used = 0;  // Occupation maximale de l'anneau
+volatile uint8_t led_brightness = 0;  // 0-255, cible du fondu (CMD_GET_LED, écran)
+ledfade::Fade<1> led_fade;
+// Ordonnanceur: horloge en ms (ISR Timer2) et mesures du sommeil, remises à zéro à chaque log
+volatile uint16_t sched_ms = 0;
+volatile uint8_t sched_sleeping = 0;  // CPU en sommeil (échantillonné par le tick)
+volatile uint16_t sched_awake_ms = 0;  // Ticks tombés CPU éveillé: courant ≈ part éveillée
+uint16_t sched_wakes = 0;  // Sorties de sommeil (tick, UART, ADC)
+uint16_t sched_late_max = 0;  // Retard maximal d'une tâche sur son échéance (ms)
+volatile uint16_t light_level = 0;    // Valeur ADC filtrée du TEMT6000 (0-1023)
 volatile uint8_t esp32_backlight_ticks = 0;  // Si > 0: utiliser display_backlight (priorité ESP32)
+uint16_t light_sub_delta = LIGHT_SUB_DEFAULT_DELTA;  // 0 = pas de push
+uint16_t light_sub_threshold = LIGHT_SUB_DEFAULT_THRESHOLD;
+uint16_t light_sub_hysteresis = LIGHT_SUB_DEFAULT_HYSTERESIS;
+uint8_t light_sub_interval = LIGHT_SUB_DEFAULT_INTERVAL_MS / LIGHT_SAMPLE_MS;  // En échantillons ADC
+uint16_t light_reported = 0xFFFF;  // Dernière valeur poussée (0xFFFF = jamais)
+uint8_t light_reported_zone = 0;  // 1 = au-dessus du seuil (avec hystérésis)
+uint8_t light_push_age = 0xFF;  // Échantillons depuis le dernier push
 
 // Variables pour la réception d'images
-#define IMAGE_CHUNK_SIZE 64  // Taille des chunks pour transmission UART (plus grand que I2C)
 volatile uint16_t image_expected_size = 0;  // Taille totale de l'image attendue
 volatile uint16_t image_received_bytes = 0;  // Nombre de bytes reçus
 volatile uint16_t image_chunk_index = 0;  // Index du chunk en cours
 volatile uint8_t image_receiving = 0;  // Flag: 1 si on reçoit une image
-volatile uint8_t image_chunk_buffer[IMAGE_CHUNK_SIZE];  // Buffer pour stocker temporairement un chunk
-volatile uint8_t image_chunk_buffer_index = 0;
 // Note: On dessine directement sur l'écran au lieu d'utiliser un buffer (trop grand pour RAM)
 
 // Variables pour les données d'affichage
 #define DISPLAY_DATA_BUFFER_SIZE 64
-volatile char display_mode[16] = "data";
-volatile char display_profile[32] = "Profile 1";
-volatile char display_output_mode[16] = "usb";
-volatile uint8_t display_keys_count = 0;
-volatile uint8_t display_backlight_enabled = 0;
-volatile char display_last_key[16] = "";  // Dernière touche appuyée
-volatile char display_connected_device[32] = "";  // Appareil connecté (USB, Bluetooth, etc.)
-volatile uint8_t display_backlight_brightness = 0;
+// État affiché: CMD_SET_DISPLAY_DATA / CMD_SET_LAST_KEY y sont décodés directement
+// (valeurs par défaut posées dans main(), .bss: pas d'initialiseur en flash)
+DisplayData display_data;
 volatile char display_custom1[32] = "";
 volatile char display_custom2[32] = "";
-volatile uint8_t display_brightness = 128;
 volatile uint8_t display_data_receiving = 0;
 volatile uint8_t display_data_buffer_index = 0;
 volatile uint8_t display_initialized = 0;  // Flag: 1 si l'affichage a été initialisé avec Welcome
@@ -118,37 +238,58 @@ volatile uint8_t display_initialized = 0;  // Flag: 1 si l'affichage a été ini
 volatile uint8_t debug_enabled = 0;  // 0 = désactivé, 1 = activé
 volatile uint8_t log_level = 2;  // 0 = none, 1 = error, 2 = info, 3 = debug
 
-// Prototype de uart_send_byte (déclaré avant debug_print pour éviter les erreurs de compilation)
+// Prototypes UART (déclarés avant debug_print pour éviter les erreurs de compilation)
 void uart_send_byte(uint8_t data);
+void uart_send_frame(uint8_t cmd, const uint8_t* data, uint8_t len);
+void uart_set_baud(uint8_t idx);
+
+// Debug: les messages sont bufferisés par ligne puis envoyés à l'ESP32
+// dans une trame CMD_LINK_LOG (le texte brut casserait le tramage COBS)
+#define DEBUG_LINE_SIZE 48
+char debug_line[DEBUG_LINE_SIZE];
+uint8_t debug_line_len = 0;
 
-// Debug: Utiliser l'UART principal (vers ESP32) pour les messages de débogage
-// Tous les messages debug_print() seront envoyés sur l'UART principal (115200 baud)
-// L'ESP32 pourra les recevoir et les logger
 void debug_init(void) {
-    // Pas besoin d'initialiser ici, l'UART principal est déjà initialisé dans uart_init()
-    // Cette fonction existe juste pour compatibilité
+    debug_line_len = 0;
+}
+
+void debug_flush(void) {
+    if (debug_line_len > 0) {
+        uart_send_frame(CMD_LINK_LOG, (const uint8_t*)debug_line, debug_line_len);
+        debug_line_len = 0;
+    }
 }
 
-// Envoyer un string sur l'UART principal (vers ESP32)
+void debug_putc(char c) {
+    if (c == '\r') return;
+    if (c == '\n') {
+        debug_flush();
+        return;
+    }
+    debug_line[debug_line_len++] = c;
+    if (debug_line_len >= DEBUG_LINE_SIZE) debug_flush();
+}
+
+// Envoyer un string (log texte vers l'ESP32)
 void debug_print(const char* str) {
     while (*str) {
-        uart_send_byte(*str++);
+        debug_putc(*str++);
     }
 }
 
-// Envoyer une valeur hexadécimale sur l'UART principal
+// Envoyer une valeur hexadécimale
 void debug_print_hex(uint8_t val) {
     char hex[] = "0123456789ABCDEF";
-    uart_send_byte(hex[(val >> 4) & 0x0F]);
-    uart_send_byte(hex[val & 0x0F]);
+    debug_putc(hex[(val >> 4) & 0x0F]);
+    debug_putc(hex[val & 0x0F]);
 }
 
-// Envoyer une valeur décimale sur l'UART principal
+// Envoyer une valeur décimale
 void debug_print_dec(uint16_t val) {
     char buf[6];
     uint8_t i = 0;
     if (val == 0) {
-        uart_send_byte('0');
+        debug_putc('0');
         return;
     }
     while (val > 0 && i < 5) {
@@ -156,10 +297,19 @@ void debug_print_dec(uint16_t val) {
         val /= 10;
     }
     while (i > 0) {
-        uart_send_byte(buf[--i]);
+        debug_putc(buf[--i]);
     }
 }
 
+// Durée Timer1 (F_CPU/256) en ms, une décimale
+static void debug_print_timer1_ms(uint16_t ticks) {
+    uint32_t tenths_ms = (uint32_t)ticks * TIMER1_US_PER_TICK / 100;
+    debug_print_dec(tenths_ms / 10);
+    debug_putc('.');
+    debug_putc('0' + tenths_ms % 10);
+    debug_print(" ms\r\n");
+}
+
 // Macros conditionnelles pour le debug selon le niveau
 #define LOG_ERROR(x) do { if (debug_enabled && log_level >= 1) debug_print(x); } while(0)
 #define LOG_INFO(x) do { if (debug_enabled && log_level >= 2) debug_print(x); } while(0)
@@ -168,34 +318,174 @@ void debug_print_dec(uint16_t val) {
 // Prototypes de fonctions ST7789
 void st7789_write_cmd(uint8_t cmd);
 void st7789_write_data(uint8_t data);
-void st7789_init(void);
-void st7789_set_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
+void st7789_init_step(void);
+void st7789_begin_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
+void st7789_end_window(void);
 void st7789_fill_screen(uint16_t color);
 void st7789_fill_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color);
 void st7789_draw_image_rgb565(uint8_t* imageData, uint16_t imageSize);
 void st7789_update_display(void);
-void st7789_draw_char(uint16_t x, uint16_t y, char c, uint16_t color, uint16_t bg_color);
-void st7789_draw_text(uint16_t x, uint16_t y, const char* text, uint16_t color, uint16_t bg_color);
-void processUartCommand(void);
+uint16_t font_text_width(const char* text, uint8_t scale);
+void st7789_draw_codes(uint16_t x, uint16_t y, const uint8_t* codes, uint8_t count, uint16_t color, uint16_t bg_color, uint8_t scale);
+uint16_t st7789_draw_text_scaled(uint16_t x, uint16_t y, const char* text, uint16_t color, uint16_t bg_color, uint8_t scale);
+uint16_t st7789_draw_text(uint16_t x, uint16_t y, const char* text, uint16_t color, uint16_t bg_color);
+void processUartFrame(void);
+void light_push_check(void);
+void link_check_fallback(void);
+void processUartCommand(uint8_t cmd, const uint8_t* data, uint8_t len);
 void uart_send_response(uint8_t cmd, uint8_t* data, uint8_t len);
-void uart_send_light_ascii(void);
 void display_light_level_on_screen(uint16_t value);
 void display_simple_info(void);
-void display_init_panel(void);
-void display_update_partial(uint8_t force_key_device);
+void display_init_panel(uint16_t y0, uint16_t y1);
+void display_update_partial(void);
 
 // Initialiser ADC pour TEMT6000
+// État de l'ADC (écrit par ADC_vect)
+volatile uint16_t adc_acc = 0;  // Somme des échantillons en cours (16 × 1023 max)
+volatile uint8_t adc_count = 0;
+volatile uint16_t adc_filter = 0;  // État IIR, 12 bits << ADC_IIR_FRAC
+volatile uint8_t adc_seeded = 0;  // 0 = premier échantillon décimé pas encore reçu
+uint16_t adc_step_pending = ADC_STEP_NONE;  // Échantillon hors bande précédent (ADC_vect seul)
+
+// Un pas du filtre IIR passe-bas: state += (x - state) / 2^ADC_IIR_SHIFT, arrondi (un décalage
+// seul tronque vers -inf: état biaisé vers le bas), ou recalage sur un échelon (ADC_STEP_BAND).
+// *pending: échantillon hors bande précédent, ADC_STEP_NONE au départ.
+// Fonction pure, vérifiée par le scénario adc de firmware/sim
+uint16_t adc_iir_step(uint16_t state, uint16_t sample12, uint16_t* pending) {
+    int32_t diff = ((int32_t)sample12 << ADC_IIR_FRAC) - (int32_t)state;
+    const int32_t band = (int32_t)ADC_STEP_BAND << ADC_IIR_FRAC;
+    uint8_t out = diff > band || diff < -band;
+    if (out && *pending != ADC_STEP_NONE && (((int32_t)*pending << ADC_IIR_FRAC) > (int32_t)state) == (diff > 0)) {
+        uint16_t mean = (uint16_t)((*pending + sample12 + 1) >> 1);
+        *pending = ADC_STEP_NONE;
+        return mean << ADC_IIR_FRAC;
+    }
+    *pending = out ? sample12 : ADC_STEP_NONE;
+    return (uint16_t)((int32_t)state + ((diff + (1 << (ADC_IIR_SHIFT - 1))) >> ADC_IIR_SHIFT));
+}
+
+// État du filtre (12 bits + fraction) → 10 bits arrondis (échelle historique des seuils)
+uint16_t adc_state_level(uint16_t state) {
+    uint16_t level = ((uint32_t)state + (1 << (ADC_IIR_FRAC + 1))) >> (ADC_IIR_FRAC + 2);
+    return (level > 1023) ? 1023 : level;
+}
+
 void adc_init(void) {
     // ADC0 (PC0) comme entrée analogique
     ADMUX = (1 << REFS0);  // Référence AVCC (5V)
-    ADCSRA = (1 << ADEN) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);  // Prescaler 128
+    DIDR0 = (1 << ADC0D);  // Buffer numérique de PC0 coupé (bruit, consommation)
+#if ADC_NOISE_REDUCTION
+    // Conversions déclenchées par l'entrée en sommeil (adc_sample_burst)
+    ADCSRA = (1 << ADEN) | (1 << ADIE) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);  // Prescaler 128
+#else
+    // Mode libre (ADCSRB = 0) armé par rafale (adc_start_burst), première rafale lancée ici
+    ADCSRB = 0;
+    ADCSRA = (1 << ADEN) | (1 << ADATE) | (1 << ADIE) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);
+    ADCSRA |= (1 << ADSC);
+#endif
+}
+
+// Fin de conversion: accumuler, décimer, filtrer (~60 cycles, 1 fois / 16 pour l'IIR)
+ISR(ADC_vect) {
+    uint16_t acc = adc_acc + ADC;
+    if (++adc_count < ADC_OVERSAMPLE) {
+        // Avant-dernière: la dernière est déjà lancée, pas de suivante (ADIF écrit à 0: gardé)
+        if (adc_count == ADC_OVERSAMPLE - 1) ADCSRA &= ~((1 << ADATE) | (1 << ADIF));
+        adc_acc = acc;
+        return;
+    }
+    uint16_t sample12 = (acc + (1 << (ADC_DECIMATE_SHIFT - 1))) >> ADC_DECIMATE_SHIFT;  // Arrondi
+    adc_acc = 0;
+    adc_count = 0;
+    if (adc_seeded) {
+        adc_filter = adc_iir_step(adc_filter, sample12, &adc_step_pending);
+    } else {
+        adc_filter = sample12 << ADC_IIR_FRAC;  // Pas de rampe depuis 0 au boot
+        adc_seeded = 1;
+    }
 }
 
-// Lire la valeur ADC du TEMT6000
-uint16_t adc_read(void) {
-    ADCSRA |= (1 << ADSC);  // Démarrer conversion
-    while (ADCSRA & (1 << ADSC));  // Attendre fin conversion
-    return ADC;
+#if ADC_NOISE_REDUCTION
+// 16 conversions en sommeil ADC Noise Reduction (le CPU est réveillé par ADC_vect)
+static void adc_sample_burst(void) {
+    set_sleep_mode(SLEEP_MODE_ADC);
+    for (uint8_t i = 0; i < ADC_OVERSAMPLE; i++) {
+        sleep_mode();
+    }
+    set_sleep_mode(SLEEP_MODE_IDLE);
+}
+#else
+// 16 conversions en mode libre, une interruption chacune, pendant que la boucle dort en Idle
+static void adc_start_burst(void) {
+    ADCSRA = (ADCSRA & ~(1 << ADIF)) | (1 << ADATE) | (1 << ADSC);
+}
+#endif
+
+// Luminosité filtrée (0-1023): seule lecture faite par la boucle principale
+uint16_t adc_light_level(void) {
+#if ADC_NOISE_REDUCTION
+    adc_sample_burst();
+#endif
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t state = adc_filter;
+    SREG = sreg;
+#if !ADC_NOISE_REDUCTION
+    adc_start_burst();  // Lue au prochain TASK_ADC_MS
+#endif
+    return adc_state_level(state);
+}
+
+// Tick de l'ordonnanceur: Timer2 en CTC, interruption de comparaison à SCHED_TICK_HZ
+void sched_init(void) {
+    TCCR2A = (1 << WGM21);  // CTC, TOP = OCR2A
+    OCR2A = SCHED_TIMER2_TOP;
+    TIMSK2 = (1 << OCIE2A);
+    TCCR2B = (1 << CS22);  // F_CPU/64
+    set_sleep_mode(SLEEP_MODE_IDLE);  // UART, SPI, ADC et timers restent horlogés
+}
+
+ISR(TIMER2_COMPA_vect) {
+    sched_ms++;
+    if (!sched_sleeping) sched_awake_ms++;
+}
+
+// Horloge en ms (16 bits, reboucle toutes les 65 s: comparer par différence)
+static inline uint16_t sched_now(void) {
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t now = sched_ms;
+    SREG = sreg;
+    return now;
+}
+
+// Échéance atteinte: tâche à exécuter, prochaine échéance une période plus loin.
+// Retard plus long qu'une période (dessin long): recalage sur now, une seule exécution.
+static uint8_t sched_due(uint16_t* deadline, uint16_t period, uint16_t now) {
+    uint16_t late = now - *deadline;
+    if ((int16_t)late < 0) return 0;
+    if (late > sched_late_max) sched_late_max = late;
+    *deadline += period;
+    if ((int16_t)(now - *deadline) >= 0) *deadline = now + period;
+    return 1;
+}
+
+// Sommeil Idle jusqu'à la prochaine interruption, sauf travail déjà en attente (trame, tick non
+// traité). L'instruction qui suit sei() s'exécute avant toute interruption: une interruption
+// arrivée après le test ne peut pas être manquée, elle réveille le CPU aussitôt endormi.
+static void sched_sleep(uint16_t handled_ms) {
+    cli();
+    if (UART_RX_PENDING() || sched_ms != handled_ms) {
+        sei();
+        return;
+    }
+    sched_sleeping = 1;
+    sleep_enable();
+    sei();
+    sleep_cpu();
+    sleep_disable();
+    sched_sleeping = 0;
+    sched_wakes++;
 }
 
 // Initialiser PWM pour LED (Timer0, OC0B sur PD5)
@@ -210,10 +500,17 @@ void pwm_init(void) {
     OCR0B = 0;  // LED éteinte par défaut
 }
 
-// Définir la luminosité LED (0-255)
+// Définir la luminosité LED (0-255): fondu relancé seulement si la valeur change
 void set_led_brightness(uint8_t brightness) {
     led_brightness = brightness;
-    OCR0B = brightness;  // PWM duty cycle
+    led_fade.retarget(&brightness, LED_FADE_MS, sched_now());
+}
+
+// Avance le fondu (à chaque ms de l'ordonnanceur): PWM écrit seulement quand le rapport cyclique change
+static void led_fade_tick(uint16_t now) {
+    if (led_fade.update(now)) {
+        OCR0B = led_fade.value(0);  // PWM duty cycle
+    }
 }
 
 // Initialiser SPI pour ST7789
@@ -234,19 +531,40 @@ void spi_init(void) {
     // CS et RST HIGH par défaut
     ST7789_CS_PORT |= (1 << ST7789_CS_PIN);
     ST7789_RST_PORT |= (1 << ST7789_RST_PIN);
+    
+    // Octet factice (CS haut, ignoré par l'écran): SPIF levé au repos, le premier
+    // spi_write du mode PIPELINED n'attend pas un transfert qui n'a jamais eu lieu
+    SPDR = 0;
+    while (!(SPSR & (1 << SPIF)));
 }
 
+#if ST7789_SPI_BACKEND == ST7789_SPI_PIPELINED
+// Envoyer un byte via SPI dès la fin du précédent (sans attendre le sien)
+static inline void spi_write(uint8_t data) {
+    while (!(SPSR & (1 << SPIF)));
+    SPDR = data;
+}
+
+// Attendre la fin du dernier octet (avant de changer DC ou de remonter CS)
+static inline void spi_flush(void) {
+    while (!(SPSR & (1 << SPIF)));
+}
+#else
 // Envoyer un byte via SPI
 void spi_write(uint8_t data) {
     SPDR = data;
     while (!(SPSR & (1 << SPIF)));
 }
 
+static inline void spi_flush(void) {}
+#endif
+
 // Envoyer une commande au ST7789
 void st7789_write_cmd(uint8_t cmd) {
     ST7789_CS_PORT &= ~(1 << ST7789_CS_PIN);  // CS LOW
     ST7789_DC_PORT &= ~(1 << ST7789_DC_PIN);  // DC LOW (command)
     spi_write(cmd);
+    spi_flush();
     ST7789_CS_PORT |= (1 << ST7789_CS_PIN);   // CS HIGH
 }
 
@@ -255,6 +573,7 @@ void st7789_write_data(uint8_t data) {
     ST7789_CS_PORT &= ~(1 << ST7789_CS_PIN);  // CS LOW
     ST7789_DC_PORT |= (1 << ST7789_DC_PIN);    // DC HIGH (data)
     spi_write(data);
+    spi_flush();
     ST7789_CS_PORT |= (1 << ST7789_CS_PIN);   // CS HIGH
 }
 
@@ -265,106 +584,174 @@ void st7789_write_data_multiple(uint8_t* data, uint16_t len) {
     for (uint16_t i = 0; i < len; i++) {
         spi_write(data[i]);
     }
+    spi_flush();
     ST7789_CS_PORT |= (1 << ST7789_CS_PIN);   // CS HIGH
 }
 
-// Initialiser le ST7789
-void st7789_init(void) {
-    // Reset hardware
-    ST7789_RST_PORT &= ~(1 << ST7789_RST_PIN);
-    _delay_ms(20);
-    ST7789_RST_PORT |= (1 << ST7789_RST_PIN);
-    _delay_ms(20);
-    
-    // Software reset
-    st7789_write_cmd(ST7789_SWRESET);
-    _delay_ms(150);
-    
-    // Sortir du mode sleep
-    st7789_write_cmd(ST7789_SLPOUT);
-    _delay_ms(150);
-    
-    // Configuration couleur (RGB565)
-    st7789_write_cmd(ST7789_COLMOD);
-    st7789_write_data(0x55);  // 16-bit color (RGB565)
-    _delay_ms(10);
-    
-    // Memory access control (orientation)
-    // Pour un écran 1.9" 170x320 en mode landscape, connecteur à droite
-    st7789_write_cmd(ST7789_MADCTL);
-    // Essayer différentes valeurs pour trouver la bonne rotation
-    // 0x00 = Normal (portrait, RGB order)
-    // 0x60 = 90° rotation (MV=1, landscape, connecteur à gauche)
-    // 0xA0 = 270° rotation (MV=1, MY=1, landscape, connecteur à droite)
-    // 0xC0 = 180° rotation (MY=1, MX=1)
-    st7789_write_data(0xA0);  // Rotation 270° : landscape avec connecteur à droite
-    _delay_ms(10);
-    
-    // Inversion des couleurs - INVON pour que 0x0000 soit noir
-    // Si le fond est blanc/rose avec INVOFF, utiliser INVON
-    st7789_write_cmd(ST7789_INVON);  // Inversion des couleurs activée
-    _delay_ms(10);
-    
-    // Activer l'affichage
-    st7789_write_cmd(ST7789_DISPON);
-    _delay_ms(100);  // Délai plus long pour s'assurer que l'écran est prêt
-    
-    // CRITIQUE: Remplir TOUT l'écran en noir avec fill_screen (plus fiable)
-    uint16_t black = 0x0000;  // Noir RGB565
-    st7789_fill_screen(black);  // Utiliser fill_screen pour être sûr que tout est noir
-    _delay_ms(50);
-    
-    // Afficher les informations simplifiées
-    display_simple_info();
-    
-    // Marquer que l'affichage a été initialisé
-    display_initialized = 1;
-    
-    debug_print("ST7789 initialized\r\n");
+// Initialiser le ST7789 sans bloquer la liaison: une étape par appel (à chaque tick de la
+// boucle principale) tant que display_initialized vaut 0. Mêmes commandes et attentes qu'avant,
+// en ms de l'ordonnanceur (jamais plus courtes que demandé). Les commandes d'affichage reçues
+// entre-temps ne mettent à jour que display_data: le panneau est dessiné à la fin.
+enum St7789InitStep : uint8_t {
+    ST7789_INIT_RESET,
+    ST7789_INIT_RELEASE,
+    ST7789_INIT_SWRESET,
+    ST7789_INIT_SLPOUT,
+    ST7789_INIT_COLMOD,
+    ST7789_INIT_MADCTL,
+    ST7789_INIT_INVON,
+    ST7789_INIT_DISPON,
+    ST7789_INIT_FILL,
+    ST7789_INIT_PANEL
+};
+static uint8_t st7789_init_state = ST7789_INIT_RESET;
+static uint16_t st7789_init_at = 0;  // Échéance de l'étape suivante (ms de l'ordonnanceur)
+static uint8_t st7789_init_row = 0;
+
+static inline void st7789_init_wait_ms(uint16_t ms) {
+    st7789_init_at = sched_now() + ms + 1;  // Tick en cours déjà entamé
+}
+
+void st7789_init_step(void) {
+    if ((int16_t)(sched_now() - st7789_init_at) < 0) {
+        return;
+    }
+    switch (st7789_init_state++) {
+        case ST7789_INIT_RESET:
+            // Reset hardware
+            ST7789_RST_PORT &= ~(1 << ST7789_RST_PIN);
+            st7789_init_wait_ms(20);
+            break;
+            
+        case ST7789_INIT_RELEASE:
+            ST7789_RST_PORT |= (1 << ST7789_RST_PIN);
+            st7789_init_wait_ms(20);
+            break;
+            
+        case ST7789_INIT_SWRESET:
+            // Software reset
+            st7789_write_cmd(ST7789_SWRESET);
+            st7789_init_wait_ms(150);
+            break;
+            
+        case ST7789_INIT_SLPOUT:
+            // Sortir du mode sleep
+            st7789_write_cmd(ST7789_SLPOUT);
+            st7789_init_wait_ms(150);
+            break;
+            
+        case ST7789_INIT_COLMOD:
+            // Configuration couleur (RGB565)
+            st7789_write_cmd(ST7789_COLMOD);
+            st7789_write_data(0x55);  // 16-bit color (RGB565)
+            st7789_init_wait_ms(10);
+            break;
+            
+        case ST7789_INIT_MADCTL:
+            // Memory access control (orientation)
+            // Pour un écran 1.9" 170x320 en mode landscape, connecteur à droite
+            st7789_write_cmd(ST7789_MADCTL);
+            // Essayer différentes valeurs pour trouver la bonne rotation
+            // 0x00 = Normal (portrait, RGB order)
+            // 0x60 = 90° rotation (MV=1, landscape, connecteur à gauche)
+            // 0xA0 = 270° rotation (MV=1, MY=1, landscape, connecteur à droite)
+            // 0xC0 = 180° rotation (MY=1, MX=1)
+            st7789_write_data(0xA0);  // Rotation 270° : landscape avec connecteur à droite
+            st7789_init_wait_ms(10);
+            break;
+            
+        case ST7789_INIT_INVON:
+            // Inversion des couleurs - INVON pour que 0x0000 soit noir
+            // Si le fond est blanc/rose avec INVOFF, utiliser INVON
+            st7789_write_cmd(ST7789_INVON);  // Inversion des couleurs activée
+            st7789_init_wait_ms(10);
+            break;
+            
+        case ST7789_INIT_DISPON:
+            // Activer l'affichage
+            st7789_write_cmd(ST7789_DISPON);
+            st7789_init_wait_ms(100);  // Délai plus long pour s'assurer que l'écran est prêt
+            break;
+            
+        case ST7789_INIT_FILL:
+            // CRITIQUE: repeindre TOUT l'écran (fond noir + panneau), par bandes: un
+            // fill_screen suivi du panneau bloquerait la liaison ~0,5 s
+            display_init_panel(st7789_init_row, st7789_init_row + DISPLAY_BOOT_FILL_ROWS);
+            st7789_init_row += DISPLAY_BOOT_FILL_ROWS;
+            if (st7789_init_row < ST7789_HEIGHT) st7789_init_state = ST7789_INIT_FILL;
+            break;
+            
+        case ST7789_INIT_PANEL:
+            // Marquer que l'affichage a été initialisé, puis dessiner l'état courant (textes)
+            display_initialized = 1;
+            display_simple_info();
+            debug_print("[BOOT] display ready: ");
+            debug_print_timer1_ms(TCNT1);
+            TCCR1B = 0;  // Fin du chronomètre de boot (Timer1 rendu au banc de fill_screen)
+            break;
+    }
+}
+
+// Commande au milieu d'une transaction (CS déjà bas): DC bas le temps d'un octet
+static void st7789_burst_cmd(uint8_t cmd) {
+    spi_flush();
+    ST7789_DC_PORT &= ~(1 << ST7789_DC_PIN);
+    spi_write(cmd);
+    spi_flush();
+    ST7789_DC_PORT |= (1 << ST7789_DC_PIN);
 }
 
-// Définir la fenêtre d'affichage
-void st7789_set_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
+// Ouvrir une fenêtre d'écriture: CASET / RASET / RAMWR dans une seule transaction,
+// qui reste ouverte (CS bas, DC données) pour les pixels. Fermer par st7789_end_window().
+void st7789_begin_window(uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1) {
     // Pas d'offset - utiliser les coordonnées directement
-    st7789_write_cmd(ST7789_CASET);
-    st7789_write_data(x0 >> 8);
-    st7789_write_data(x0 & 0xFF);
-    st7789_write_data(x1 >> 8);
-    st7789_write_data(x1 & 0xFF);
-    
-    st7789_write_cmd(ST7789_RASET);
-    st7789_write_data(y0 >> 8);
-    st7789_write_data(y0 & 0xFF);
-    st7789_write_data(y1 >> 8);
-    st7789_write_data(y1 & 0xFF);
-    
-    st7789_write_cmd(ST7789_RAMWR);
+    ST7789_CS_PORT &= ~(1 << ST7789_CS_PIN);
+    st7789_burst_cmd(ST7789_CASET);
+    spi_write(x0 >> 8);
+    spi_write(x0 & 0xFF);
+    spi_write(x1 >> 8);
+    spi_write(x1 & 0xFF);
+    
+    st7789_burst_cmd(ST7789_RASET);
+    spi_write(y0 >> 8);
+    spi_write(y0 & 0xFF);
+    spi_write(y1 >> 8);
+    spi_write(y1 & 0xFF);
+    
+    st7789_burst_cmd(ST7789_RAMWR);
+}
+
+void st7789_end_window(void) {
+    spi_flush();
+    ST7789_CS_PORT |= (1 << ST7789_CS_PIN);
+}
+
+// count pixels d'une même couleur (fenêtre déjà ouverte)
+static void st7789_write_run(uint16_t color, uint16_t count) {
+    uint8_t high = color >> 8, low = color & 0xFF;
+    while (count--) {
+        spi_write(high);
+        spi_write(low);
+    }
 }
 
-// Effacer l'écran avec une couleur
+// Effacer l'écran avec une couleur (chronométré: banc des transports SPI)
 void st7789_fill_screen(uint16_t color) {
-    st7789_set_window(0, 0, ST7789_WIDTH - 1, ST7789_HEIGHT - 1);
+    TCCR1A = 0;
+    TCNT1 = 0;
+    TCCR1B = (1 << CS12);  // F_CPU/256
     
-    // RGB565: Format 16-bit RRRRRGGGGGGBBBBB
-    // Pour ST7789, tester les deux ordres possibles
-    uint8_t color_high = (color >> 8) & 0xFF;
-    uint8_t color_low = color & 0xFF;
-    
-    ST7789_CS_PORT &= ~(1 << ST7789_CS_PIN);
-    ST7789_DC_PORT |= (1 << ST7789_DC_PIN);
-    
-    // Dessiner pixel par pixel pour éviter l'overflow
-    // 320*170 = 54400 pixels (OK pour uint16_t)
-    // Essayer l'ordre normal (high puis low) - certains écrans ST7789 nécessitent cet ordre
+    // RGB565 poids fort d'abord; ligne par ligne (320 × 210 = 67200 pixels > 16 bits)
+    st7789_begin_window(0, 0, ST7789_WIDTH - 1, ST7789_HEIGHT - 1);
     for (uint16_t y = 0; y < ST7789_HEIGHT; y++) {
-        for (uint16_t x = 0; x < ST7789_WIDTH; x++) {
-            // Ordre normal (high puis low) pour RGB565 - test pour corriger le fond blanc/rose
-            spi_write(color_high);
-            spi_write(color_low);
-        }
+        st7789_write_run(color, ST7789_WIDTH);
     }
+    st7789_end_window();
     
-    ST7789_CS_PORT |= (1 << ST7789_CS_PIN);
+    uint16_t ticks = TCNT1;
+    TCCR1B = 0;
+    debug_print(ST7789_SPI_BACKEND == ST7789_SPI_PIPELINED ? "[ST7789] fill (pipelined): " : "[ST7789] fill (polled): ");
+    debug_print_timer1_ms(ticks);
 }
 
 // Dessiner un rectangle rempli
@@ -372,21 +759,12 @@ void st7789_fill_rect(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t c
     if (x + w > ST7789_WIDTH) w = ST7789_WIDTH - x;
     if (y + h > ST7789_HEIGHT) h = ST7789_HEIGHT - y;
     
-    st7789_set_window(x, y, x + w - 1, y + h - 1);
-    
-    uint8_t color_high = (color >> 8) & 0xFF;
-    uint8_t color_low = color & 0xFF;
-    
-    ST7789_CS_PORT &= ~(1 << ST7789_CS_PIN);
-    ST7789_DC_PORT |= (1 << ST7789_DC_PIN);
-    
-    // Utiliser l'ordre normal (high puis low) pour correspondre à fill_screen
-    for (uint16_t i = 0; i < w * h; i++) {
-        spi_write(color_high);
-        spi_write(color_low);
+    // RGB565 poids fort d'abord, comme fill_screen (w × h ≤ 67200: ligne par ligne)
+    st7789_begin_window(x, y, x + w - 1, y + h - 1);
+    for (uint16_t row = 0; row < h; row++) {
+        st7789_write_run(color, w);
     }
-    
-    ST7789_CS_PORT |= (1 << ST7789_CS_PIN);
+    st7789_end_window();
 }
 
 // Dessiner une image RGB565 complète (240x320)
@@ -397,19 +775,12 @@ void st7789_draw_image_rgb565(uint8_t* imageData, uint16_t imageSize) {
         return;  // Taille invalide
     }
     
-    // Définir la fenêtre pour tout l'écran
-    st7789_set_window(0, 0, ST7789_WIDTH - 1, ST7789_HEIGHT - 1);
-    
-    // Envoyer les données pixel par pixel
-    ST7789_CS_PORT &= ~(1 << ST7789_CS_PIN);
-    ST7789_DC_PORT |= (1 << ST7789_DC_PIN);
-    
-    // Envoyer les données RGB565 (2 bytes par pixel)
+    // Fenêtre sur tout l'écran, données RGB565 (2 bytes par pixel)
+    st7789_begin_window(0, 0, ST7789_WIDTH - 1, ST7789_HEIGHT - 1);
     for (uint16_t i = 0; i < imageSize; i++) {
         spi_write(imageData[i]);
     }
-    
-    ST7789_CS_PORT |= (1 << ST7789_CS_PIN);
+    st7789_end_window();
 }
 
 // Dessiner une barre de progression horizontale
@@ -427,135 +798,96 @@ void st7789_draw_progress_bar(uint16_t x, uint16_t y, uint16_t w, uint16_t h, ui
     }
 }
 
-// Police bitmap simple 5x7 pour les caractères ASCII
-// Chaque caractère est représenté par 5 colonnes de 7 bits
-const uint8_t font_5x7[][5] = {
-    {0x00, 0x00, 0x00, 0x00, 0x00}, // Espace (32)
-    {0x00, 0x00, 0x5F, 0x00, 0x00}, // !
-    {0x00, 0x07, 0x00, 0x07, 0x00}, // "
-    {0x14, 0x7F, 0x14, 0x7F, 0x14}, // #
-    {0x24, 0x2A, 0x7F, 0x2A, 0x12}, // $
-    {0x23, 0x13, 0x08, 0x64, 0x62}, // %
-    {0x36, 0x49, 0x55, 0x22, 0x50}, // &
-    {0x00, 0x05, 0x03, 0x00, 0x00}, // '
-    {0x00, 0x1C, 0x22, 0x41, 0x00}, // (
-    {0x00, 0x41, 0x22, 0x1C, 0x00}, // )
-    {0x14, 0x08, 0x3E, 0x08, 0x14}, // *
-    {0x08, 0x08, 0x3E, 0x08, 0x08}, // +
-    {0x00, 0x00, 0xA0, 0x60, 0x00}, // ,
-    {0x08, 0x08, 0x08, 0x08, 0x08}, // -
-    {0x00, 0x60, 0x60, 0x00, 0x00}, // .
-    {0x20, 0x10, 0x08, 0x04, 0x02}, // /
-    {0x3E, 0x51, 0x49, 0x45, 0x3E}, // 0
-    {0x00, 0x42, 0x7F, 0x40, 0x00}, // 1
-    {0x42, 0x61, 0x51, 0x49, 0x46}, // 2
-    {0x21, 0x41, 0x45, 0x4B, 0x31}, // 3
-    {0x18, 0x14, 0x12, 0x7F, 0x10}, // 4
-    {0x27, 0x45, 0x45, 0x45, 0x39}, // 5
-    {0x3C, 0x4A, 0x49, 0x49, 0x30}, // 6
-    {0x01, 0x71, 0x09, 0x05, 0x03}, // 7
-    {0x36, 0x49, 0x49, 0x49, 0x36}, // 8
-    {0x06, 0x49, 0x49, 0x29, 0x1E}, // 9
-    {0x00, 0x36, 0x36, 0x00, 0x00}, // :
-    {0x00, 0x56, 0x36, 0x00, 0x00}, // ;
-    {0x08, 0x14, 0x22, 0x41, 0x00}, // <
-    {0x14, 0x14, 0x14, 0x14, 0x14}, // =
-    {0x00, 0x41, 0x22, 0x14, 0x08}, // >
-    {0x02, 0x01, 0x51, 0x09, 0x06}, // ?
-    {0x32, 0x49, 0x59, 0x51, 0x3E}, // @
-    {0x7C, 0x12, 0x11, 0x12, 0x7C}, // A
-    {0x7F, 0x49, 0x49, 0x49, 0x36}, // B
-    {0x3E, 0x41, 0x41, 0x41, 0x22}, // C
-    {0x7F, 0x41, 0x41, 0x22, 0x1C}, // D
-    {0x7F, 0x49, 0x49, 0x49, 0x41}, // E
-    {0x7F, 0x09, 0x09, 0x09, 0x01}, // F
-    {0x3E, 0x41, 0x49, 0x49, 0x7A}, // G
-    {0x7F, 0x08, 0x08, 0x08, 0x7F}, // H
-    {0x00, 0x41, 0x7F, 0x41, 0x00}, // I
-    {0x20, 0x40, 0x41, 0x3F, 0x01}, // J
-    {0x7F, 0x08, 0x14, 0x22, 0x41}, // K
-    {0x7F, 0x40, 0x40, 0x40, 0x40}, // L
-    {0x7F, 0x02, 0x0C, 0x02, 0x7F}, // M
-    {0x7F, 0x04, 0x08, 0x10, 0x7F}, // N
-    {0x3E, 0x41, 0x41, 0x41, 0x3E}, // O
-    {0x7F, 0x09, 0x09, 0x09, 0x06}, // P
-    {0x3E, 0x41, 0x51, 0x21, 0x5E}, // Q
-    {0x7F, 0x09, 0x19, 0x29, 0x46}, // R
-    {0x46, 0x49, 0x49, 0x49, 0x31}, // S
-    {0x01, 0x01, 0x7F, 0x01, 0x01}, // T
-    {0x3F, 0x40, 0x40, 0x40, 0x3F}, // U
-    {0x1F, 0x20, 0x40, 0x20, 0x1F}, // V
-    {0x3F, 0x40, 0x38, 0x40, 0x3F}, // W
-    {0x63, 0x14, 0x08, 0x14, 0x63}, // X
-    {0x07, 0x08, 0x70, 0x08, 0x07}, // Y
-    {0x61, 0x51, 0x49, 0x45, 0x43}, // Z
-};
-
-// Dessiner un caractère à la position (x, y)
-void st7789_draw_char(uint16_t x, uint16_t y, char c, uint16_t color, uint16_t bg_color) {
-    // Espace
-    if (c == ' ') {
-        st7789_fill_rect(x, y, 5, 7, bg_color);
-        return;
+// Point de code Latin-1 suivant de text, qui avance. Texte UTF-8 (l'ESP32 relaie le JSON tel quel);
+// un octet ≥ 0x80 hors séquence valide est pris comme Latin-1 brut, hors Latin-1 → '?'
+static uint8_t font_next_code(const char** text) {
+    const uint8_t* p = (const uint8_t*)*text;
+    uint8_t c = *p++;
+    if (c >= 0xC0 && (*p & 0xC0) == 0x80) {
+        c = (c <= 0xC3) ? (uint8_t)((c << 6) | (*p & 0x3F)) : '?';
+        while ((*p & 0xC0) == 0x80) p++;  // Octets de continuation
     }
-    
-    // Convertir les minuscules en majuscules (la police ne supporte que A-Z)
-    if (c >= 'a' && c <= 'z') {
-        c = c - 'a' + 'A';
-    }
-    
-    // Remplacer les caractères accentués par leurs équivalents
-    if (c == 233 || c == 232 || c == 234 || c == 235) {  // é, è, ê, ë
-        c = 'E';
-    } else if (c == 224 || c == 225 || c == 226 || c == 227) {  // à, á, â, ã
-        c = 'A';
-    } else if (c == 249 || c == 250 || c == 251 || c == 252) {  // ù, ú, û, ü
-        c = 'U';
-    } else if (c == 239 || c == 238 || c == 237 || c == 236) {  // ï, î, í, ì
-        c = 'I';
-    } else if (c == 242 || c == 243 || c == 244 || c == 245) {  // ò, ó, ô, õ
-        c = 'O';
+    *text = (const char*)p;
+    return c;
+}
+
+// Glyphe (en flash) d'un point de code Latin-1
+static const uint8_t* font_glyph(uint8_t code) {
+    if (code >= FONT_FIRST && code <= FONT_LAST) return font_5x7[code - FONT_FIRST];
+    if (code == 0xA0) return font_5x7[0];  // Espace insécable
+    for (uint8_t i = 0; i < sizeof(font_latin1_codes); i++) {
+        if (pgm_read_byte(&font_latin1_codes[i]) == code) return font_latin1[i];
     }
-    
-    // Vérifier si le caractère est dans la plage ASCII imprimable (32-90 = espace à Z)
-    if (c < 32 || c > 90) {
-        return;  // Caractère non supporté
+    return font_5x7['?' - FONT_FIRST];
+}
+
+// Largeur en pixels de text à l'échelle scale, sans l'espace après le dernier glyphe:
+// alignement à droite (x = bord - largeur) et effacement exact de l'ancien texte
+uint16_t font_text_width(const char* text, uint8_t scale) {
+    uint16_t glyphs = 0;
+    while (*text) {
+        font_next_code(&text);
+        glyphs++;
     }
-    
-    uint8_t char_index = c - 32;
-    if (char_index >= sizeof(font_5x7) / sizeof(font_5x7[0])) {
-        return;  // Index hors limites
+    return glyphs ? (glyphs * FONT_ADVANCE - 1) * scale : 0;
+}
+
+// Dessiner count glyphes côte à côte (codes Latin-1) à l'échelle scale (1–3): une seule fenêtre
+// (count × 6 - 1) s × 7s, colonnes d'espace comprises, et tous ses pixels (texte ou fond) dans la
+// même transaction SPI. La police stocke une colonne par octet, bit 0 = ligne du haut; l'écran se
+// remplit ligne par ligne: chaque ligne de la police est émise scale fois, en segments (pixels
+// voisins de même couleur regroupés).
+void st7789_draw_codes(uint16_t x, uint16_t y, const uint8_t* codes, uint8_t count, uint16_t color, uint16_t bg_color, uint8_t scale) {
+    uint16_t w = ((uint16_t)count * FONT_ADVANCE - 1) * scale;
+    if (count == 0 || x + w > ST7789_WIDTH || y + FONT_HEIGHT * scale > ST7789_HEIGHT) {
+        return;  // Hors écran
     }
-    
-    // Dessiner le caractère pixel par pixel
-    // La police stocke les bits du LSB (bit 0) au MSB (bit 6) pour chaque colonne
-    for (uint8_t col = 0; col < 5; col++) {
-        uint8_t col_data = font_5x7[char_index][col];
-        for (uint8_t row = 0; row < 7; row++) {
-            // Vérifier le bit correspondant (bit 0 = ligne du bas, bit 6 = ligne du haut)
-            if (col_data & (1 << row)) {
-                st7789_fill_rect(x + col, y + row, 1, 1, color);
-            } else {
-                st7789_fill_rect(x + col, y + row, 1, 1, bg_color);
+    st7789_begin_window(x, y, x + w - 1, y + FONT_HEIGHT * scale - 1);
+    for (uint8_t mask = 0x01; mask != 0x80; mask <<= 1) {
+        for (uint8_t rep = 0; rep < scale; rep++) {
+            uint8_t run_on = 0;
+            uint16_t run = 0;
+            for (uint8_t i = 0; i < count; i++) {
+                const uint8_t* glyph = font_glyph(codes[i]);
+                for (uint8_t col = 0; col < FONT_ADVANCE; col++) {
+                    if (col == FONT_WIDTH && i == count - 1) break;  // Pas d'espace après le dernier
+                    uint8_t on = col < FONT_WIDTH && (pgm_read_byte(&glyph[col]) & mask);
+                    if (on != run_on && run) {
+                        st7789_write_run(run_on ? color : bg_color, run * scale);
+                        run = 0;
+                    }
+                    run_on = on;
+                    run++;
+                }
             }
+            st7789_write_run(run_on ? color : bg_color, run * scale);
         }
     }
+    st7789_end_window();
 }
 
-// Dessiner une chaîne de texte
-void st7789_draw_text(uint16_t x, uint16_t y, const char* text, uint16_t color, uint16_t bg_color) {
+// Dessiner une chaîne UTF-8 à l'échelle scale, une fenêtre par glyphe (les colonnes d'espace
+// ne sont pas touchées); renvoie la largeur dessinée (font_text_width)
+uint16_t st7789_draw_text_scaled(uint16_t x, uint16_t y, const char* text, uint16_t color, uint16_t bg_color, uint8_t scale) {
     uint16_t x_pos = x;
     while (*text) {
-        st7789_draw_char(x_pos, y, *text, color, bg_color);
-        x_pos += 6;  // Espacement entre les caractères (5 pixels + 1 pixel d'espace)
-        text++;
+        uint8_t code = font_next_code(&text);
+        st7789_draw_codes(x_pos, y, &code, 1, color, bg_color, scale);
+        x_pos += FONT_ADVANCE * scale;  // 5 pixels + 1 pixel d'espace
     }
+    return x_pos > x ? x_pos - x - scale : 0;
+}
+
+// Dessiner une chaîne de texte (échelle 1)
+uint16_t st7789_draw_text(uint16_t x, uint16_t y, const char* text, uint16_t color, uint16_t bg_color) {
+    return st7789_draw_text_scaled(x, y, text, color, bg_color, 1);
 }
 
 // Mettre à jour l'affichage avec les informations réelles
 void st7789_update_display(void) {
+    if (!display_initialized) return;  // Écran encore en démarrage (st7789_init_step)
     // Si on est en mode image ou gif, ne pas écraser l'image
-    if (strcmp((char*)display_mode, "image") == 0 || strcmp((char*)display_mode, "gif") == 0) {
+    if (strcmp(display_data.mode, "image") == 0 || strcmp(display_data.mode, "gif") == 0) {
         return;  // L'image est déjà affichée, ne pas l'écraser
     }
     
@@ -570,23 +902,23 @@ void st7789_update_display(void) {
     uint16_t text_y = 150;  // 150px du top (au lieu de 10)
     uint16_t white = 0xFFFF;  // Blanc RGB565
     
-    // Afficher "WELCOME TO MY KEYPAD" (en majuscules car la police ne supporte que A-Z)
+    // Afficher "WELCOME TO MY KEYPAD"
     st7789_draw_text(text_x, text_y, "WELCOME TO MY KEYPAD", white, black);
     
     // Afficher l'état de connexion sur la ligne suivante
     uint16_t conn_y = text_y + 12;  // un peu plus bas que le premier texte
-    st7789_draw_text(text_x, conn_y, "CONNECTION : ", white, black);
+    uint16_t label_w = st7789_draw_text(text_x, conn_y, "CONNECTION :", white, black);
     
     // Déterminer l'état de connexion
     const char* conn_status = "IDLE";
-    if (strcmp((char*)display_output_mode, "usb") == 0) {
+    if (strcmp(display_data.output, "usb") == 0) {
         conn_status = "USB";
-    } else if (strcmp((char*)display_output_mode, "bluetooth") == 0) {
+    } else if (strcmp(display_data.output, "bluetooth") == 0) {
         conn_status = "BLUETOOTH";
     }
     
-    // Afficher le statut de connexion (position après "CONNECTION : ")
-    uint16_t status_x = text_x + (13 * 6);  // 13 caractères * 6 pixels = 78 pixels
+    // Afficher le statut de connexion après "CONNECTION : " (largeur mesurée + espace)
+    uint16_t status_x = text_x + label_w + 1 + FONT_ADVANCE;
     st7789_draw_text(status_x, conn_y, conn_status, white, black);
     
     return;  // On a affiché le Welcome, on sort (ne pas afficher les autres éléments)
@@ -619,8 +951,8 @@ void st7789_update_display(void) {
     
     // Indicateur de mode (petit rectangle coloré à gauche)
     uint16_t mode_indicator_color = color_green;
-    if (strcmp((char*)display_mode, "image") == 0) mode_indicator_color = color_yellow;
-    else if (strcmp((char*)display_mode, "gif") == 0) mode_indicator_color = color_magenta;
+    if (strcmp(display_data.mode, "image") == 0) mode_indicator_color = color_yellow;
+    else if (strcmp(display_data.mode, "gif") == 0) mode_indicator_color = color_magenta;
     st7789_fill_rect(8, header_y + 8, 8, 20, mode_indicator_color);
     
     // Zone d'information principale (milieu)
@@ -633,13 +965,13 @@ void st7789_update_display(void) {
     // Ligne 1: Mode de sortie (USB/BLE)
     uint16_t line1_y = info_y + 10;
     uint16_t output_color = color_cyan;
-    if (strcmp((char*)display_output_mode, "usb") == 0) output_color = color_green;
-    else if (strcmp((char*)display_output_mode, "bluetooth") == 0) output_color = color_blue;
+    if (strcmp(display_data.output, "usb") == 0) output_color = color_green;
+    else if (strcmp(display_data.output, "bluetooth") == 0) output_color = color_blue;
     st7789_fill_rect(10, line1_y, 100, 20, output_color);
     
     // Ligne 2: Nombre de touches configurées
     uint16_t line2_y = line1_y + 30;
-    uint16_t keys_bar_width = (display_keys_count * 200) / 17;  // 17 touches max
+    uint16_t keys_bar_width = (display_data.keys * 200) / 17;  // 17 touches max
     if (keys_bar_width > 200) keys_bar_width = 200;
     st7789_fill_rect(10, line2_y, 200, 20, color_gray);
     if (keys_bar_width > 0) {
@@ -648,8 +980,8 @@ void st7789_update_display(void) {
     
     // Ligne 3: Backlight status
     uint16_t line3_y = line2_y + 30;
-    uint16_t backlight_color = display_backlight_enabled ? color_yellow : color_dark_gray;
-    uint16_t backlight_width = (display_backlight_brightness * 200) / 255;
+    uint16_t backlight_color = display_data.backlightEnabled ? color_yellow : color_dark_gray;
+    uint16_t backlight_width = (display_data.backlightBrightness * 200) / 255;
     if (backlight_width > 200) backlight_width = 200;
     st7789_fill_rect(10, line3_y, 200, 20, color_gray);
     if (backlight_width > 0) {
@@ -693,6 +1025,7 @@ void st7789_update_display(void) {
 void uart_init(void) {
     UBRR0H = (uint8_t)(UART_UBRR >> 8);
     UBRR0L = (uint8_t)(UART_UBRR & 0xFF);
+    UCSR0A = (1 << U2X0);  // Double vitesse: seule façon d'atteindre 250k/500k/1M à 8 MHz
     
     // Activer réception et transmission, interruptions de réception
     UCSR0B = (1 << RXEN0) | (1 << TXEN0) | (1 << RXCIE0);
@@ -701,166 +1034,185 @@ void uart_init(void) {
     UCSR0C = (1 << UCSZ01) | (1 << UCSZ00);
 }
 
+// Tâche ADC (TASK_ADC_MS): luminosité filtrée, push vers l'ESP32, LED locale
+static void task_adc(void) {
+    light_level = adc_light_level();
+    light_push_check();
+    // Zone claire/sombre avec hystérésis autour du seuil (garde l'état dans la bande)
+    static uint8_t light_high = 0;
+    if (light_level >= LIGHT_LED_THRESHOLD + LIGHT_LED_HYSTERESIS) {
+        light_high = 1;
+    } else if (light_level < LIGHT_LED_THRESHOLD - LIGHT_LED_HYSTERESIS) {
+        light_high = 0;
+    }
+    // LED: priorité ESP32 (display_backlight) si commande récente, sinon logique locale
+    if (esp32_backlight_ticks > 0) {
+        esp32_backlight_ticks--;
+        set_led_brightness(display_data.backlightEnabled ? display_data.backlightBrightness : 0);
+    } else {
+        // ADC >= 500 = clair -> LED OFF. ADC < 500 = sombre -> LED ON
+#if LIGHT_SENSOR_INVERTED
+        if (light_high) {
+            set_led_brightness(255);  // Inversé: haut = sombre
+        } else {
+            set_led_brightness(0);
+        }
+#else
+        if (light_high) {
+            set_led_brightness(0);    // Clair -> LED OFF
+        } else {
+            set_led_brightness(255);  // Sombre -> LED ON
+        }
+#endif
+    }
+}
+
+// Tâche écran (TASK_UI_MS): luminosité affichée si elle a varié
+static void task_ui(void) {
+    static uint16_t last_shown_light_ui = 0xFFFF;  // Initialiser à une valeur invalide pour forcer le premier affichage
+    uint16_t diff;
+    if (light_level > last_shown_light_ui) {
+        diff = light_level - last_shown_light_ui;
+    } else {
+        diff = last_shown_light_ui - light_level;
+    }
+    // Mettre à jour l'affichage simplifié si variation >= 5 ou première fois
+    if (diff >= 5 || last_shown_light_ui == 0xFFFF) {
+        display_simple_info();  // Afficher toutes les infos (inclut la luminosité)
+        last_shown_light_ui = light_level;
+    }
+}
+
+// Tâche de log (TASK_DEBUG_MS): luminosité, contre-pression UART, sommeil
+static void task_debug(void) {
+    debug_print("[LIGHT] Level: ");
+    debug_print_dec(light_level);
+    debug_print(" (0x");
+    debug_print_hex((uint8_t)(light_level >> 8));
+    debug_print_hex((uint8_t)(light_level & 0xFF));
+    debug_print(")\r\n");
+    // Contre-pression TX: octets ayant attendu une place dans l'anneau
+    static uint16_t reported_tx_full = 0;
+    if (uart_tx_full_count != reported_tx_full) {
+        debug_print("[UART] TX ring full: ");
+        debug_print_dec(uart_tx_full_count - reported_tx_full);
+        debug_print(" waits, max used ");
+        debug_print_dec(uart_tx_max_used);
+        debug_print("\r\n");
+        reported_tx_full = uart_tx_full_count;
+    }
+    // Trames perdues en réception (anneau / file pleins, trop longues) — NACK envoyés
+    static uint16_t reported_rx_overflow = 0;
+    uint16_t rx_overflow = link_stats.dropped;
+    if (rx_overflow != reported_rx_overflow) {
+        debug_print("[UART] RX frames dropped: ");
+        debug_print_dec(rx_overflow - reported_rx_overflow);
+        debug_print("\r\n");
+        reported_rx_overflow = rx_overflow;
+    }
+    // Sommeil: ticks tombés CPU éveillé (courant moyen ≈ I_actif × part + I_idle × reste),
+    // réveils (tick, UART, rafales ADC) et pire retard d'une tâche sur son échéance
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t awake = sched_awake_ms;
+    sched_awake_ms = 0;
+    SREG = sreg;
+    debug_print("[SLEEP] awake ");
+    debug_print_dec(awake);
+    debug_print("/");
+    debug_print_dec(TASK_DEBUG_MS);
+    debug_print(" ms, ");
+    debug_print_dec(sched_wakes);
+    debug_print(" wakes, late max ");
+    debug_print_dec(sched_late_max);
+    debug_print(" ms\r\n");
+    sched_wakes = 0;
+    sched_late_max = 0;
+}
+
 int main(void) {
     // CRITIQUE: Désactiver le watchdog timer au démarrage (si activé)
     // Le watchdog peut causer des resets si non désactivé
     MCUSR &= ~(1 << WDRF);  // Clear watchdog reset flag
     wdt_disable();  // Désactiver le watchdog
     
-    // Délai initial pour stabilisation de l'alimentation
-    _delay_ms(200);  // Délai plus long pour stabilisation au boot
+    // Chronomètre du boot (Timer1, F_CPU/256): liaison prête puis écran prêt
+    // Plus de délais d'attente: l'alimentation est couverte par le délai de démarrage des
+    // fusibles (SUT), l'UART est utilisable dès uart_init(), l'écran démarre dans la boucle
+    TCCR1A = 0;
+    TCNT1 = 0;
+    TCCR1B = (1 << CS12);
     
     // IMPORTANT: Initialiser l'UART EN PREMIER pour que debug_print() fonctionne
     uart_init();
-    _delay_ms(100);  // Attendre que l'UART soit stable
     
     // Initialiser le débogage (utilise maintenant l'UART principal)
+    // Peu de lignes avant sei(): à 9600 bauds chaque octet de log retarde le boot de ~1 ms
     debug_init();
     debug_print("\r\n=== ATmega328P Light Controller ===\r\n");
-    debug_print("UART Baud: 115200\r\n");
-    debug_print("Boot sequence started...\r\n");
     
     // Initialiser les périphériques
     adc_init();
-    debug_print("ADC initialized\r\n");
-    
     pwm_init();
-    debug_print("PWM initialized\r\n");
+    sched_init();
     // LED backlight: contrôlée par light_level (>= 500 = ON)
-    
     spi_init();
-    debug_print("SPI initialized\r\n");
-    
-    // Délai avant initialisation de l'écran pour s'assurer que l'alimentation est stable
-    _delay_ms(100);
-    st7789_init();
-    debug_print("ST7789 initialized\r\n");
     
     // Initialiser les valeurs d'affichage par défaut
-    strcpy((char*)display_mode, "data");
-    strcpy((char*)display_profile, "Profile 1");
+    strcpy(display_data.mode, "data");
+    strcpy(display_data.profile, "Profile 1");
     // Par défaut, l'ESP32 utilise le HID BLE (pas USB), donc on affiche BLUETOOTH
-    strcpy((char*)display_output_mode, "bluetooth");
-    display_keys_count = 0;
-    display_backlight_enabled = 1;
-    display_backlight_brightness = 255;
-    display_brightness = 128;
+    strcpy(display_data.output, "bluetooth");
+    display_data.keys = 0;
+    display_data.backlightEnabled = 1;
+    display_data.backlightBrightness = 255;
+    display_data.brightness = 128;
     
-    // Ne pas appeler st7789_update_display() ici - l'affichage Welcome est déjà fait dans st7789_init()
-    // On attendra qu'une commande UART demande explicitement une mise à jour
-    
-    debug_print("UART initialized\r\n");
+    // L'écran (reset, init, effacement, panneau) démarre ensuite dans la boucle principale:
+    // st7789_init_step() à chaque tick, les trames sont acquittées pendant ce temps
     
     // Activer interruptions globales
     sei();
-    debug_print("Interrupts enabled\r\n");
-    debug_print("Ready!\r\n");
-    
-    // Boucle principale - optimisée pour la réactivité
+    debug_print("[BOOT] link ready: ");
+    debug_print_timer1_ms(TCNT1);
+    
+    // Boucle principale: trames dès leur arrivée, tâches à leur échéance, sommeil entre les deux
+    uint16_t handled_ms = sched_now();
+    uint16_t adc_deadline = handled_ms + TASK_ADC_MS;
+    uint16_t ui_deadline = handled_ms + TASK_UI_MS;
+    uint16_t debug_deadline = handled_ms + TASK_DEBUG_MS;
     while (1) {
         // Traiter les commandes UART (déferrées depuis l'ISR pour éviter blocage SPI)
-        if (uart_cmd_pending) {
-            processUartCommand();
+        if (UART_RX_PENDING()) {
+            processUartFrame();
         }
+        link_check_fallback();
         
-        // Lire la luminosité toutes les ~20ms (au lieu de 100ms)
-        static uint8_t adc_counter = 0;
-        adc_counter++;
-        if (adc_counter >= 5) {  // ~100ms (5 * 20ms) pour l'ADC
-            adc_counter = 0;
-            light_level = adc_read();
-            // LED: priorité ESP32 (display_backlight) si commande récente, sinon logique locale
-            if (esp32_backlight_ticks > 0) {
-                esp32_backlight_ticks--;
-                set_led_brightness(display_backlight_enabled ? display_backlight_brightness : 0);
-            } else {
-                // ADC >= 500 = clair -> LED OFF. ADC < 500 = sombre -> LED ON
-#if LIGHT_SENSOR_INVERTED
-                if (light_level >= 500) {
-                    set_led_brightness(255);  // Inversé: haut = sombre
-                } else {
-                    set_led_brightness(0);
-                }
-#else
-                if (light_level >= 500) {
-                    set_led_brightness(0);    // Clair -> LED OFF
-                } else {
-                    set_led_brightness(255);  // Sombre -> LED ON
-                }
-#endif
+        // Nouveau tick: ms manquées pendant un dessin long non rejouées (échéances en temps absolu)
+        uint16_t now = sched_now();
+        if (now != handled_ms) {
+            handled_ms = now;
+            led_fade_tick(now);
+            if (!display_initialized) {
+                st7789_init_step();
             }
-        }
-        
-        // Rafraîchissement d'affichage de la lumière - toutes les ~200ms
-        static uint16_t ui_counter = 0;
-        static uint16_t last_shown_light_ui = 0xFFFF;  // Initialiser à une valeur invalide pour forcer le premier affichage
-        ui_counter++;
-        if (ui_counter >= 10) {  // ~200 ms (10 * 20 ms)
-            ui_counter = 0;
-            uint16_t diff;
-            if (light_level > last_shown_light_ui) {
-                diff = light_level - last_shown_light_ui;
-            } else {
-                diff = last_shown_light_ui - light_level;
+            if (sched_due(&adc_deadline, TASK_ADC_MS, now)) {
+                task_adc();
             }
-            // Mettre à jour l'affichage simplifié si variation >= 5 ou première fois
-            if (diff >= 5 || last_shown_light_ui == 0xFFFF) {
-                display_simple_info();  // Afficher toutes les infos (inclut la luminosité)
-                last_shown_light_ui = light_level;
+            if (sched_due(&ui_deadline, TASK_UI_MS, now)) {
+                task_ui();
+            }
+            if (sched_due(&debug_deadline, TASK_DEBUG_MS, now)) {
+                task_debug();
             }
         }
         
-        // L'ESP32 demande la luminosité via CMD_READ_LIGHT toutes les 2 s — pas besoin d'envoi périodique
-        
-        // Envoyer un message de debug toutes les 5 secondes (réduit pour moins de spam)
-        static uint16_t debug_counter = 0;
-        debug_counter++;
-        if (debug_counter >= 250) {  // ~5 secondes (250 * 20ms)
-            debug_counter = 0;
-            debug_print("[LIGHT] Level: ");
-            debug_print_dec(light_level);
-            debug_print(" (0x");
-            debug_print_hex((uint8_t)(light_level >> 8));
-            debug_print_hex((uint8_t)(light_level & 0xFF));
-            debug_print(")\r\n");
-        }
-        
-        // Délai réduit pour améliorer la réactivité (20ms au lieu de 100ms)
-        _delay_ms(20);
+        sched_sleep(handled_ms);
     }
     
     return 0;
 }
 
-// Envoyer la luminosité actuelle en ASCII lisible sur l'UART (ex: "LIGHT=512\n")
-void uart_send_light_ascii(void) {
-    uint16_t value = light_level;
-    
-    // Prefixe
-    uart_send_byte('L');
-    uart_send_byte('I');
-    uart_send_byte('G');
-    uart_send_byte('H');
-    uart_send_byte('T');
-    uart_send_byte('=');
-    
-    // Conversion décimale (similaire à debug_print_dec mais sur l'UART principal)
-    char buf[6];
-    uint8_t i = 0;
-    if (value == 0) {
-        uart_send_byte('0');
-    } else {
-        while (value > 0 && i < 5) {
-            buf[i++] = '0' + (value % 10);
-            value /= 10;
-        }
-        while (i > 0) {
-            uart_send_byte(buf[--i]);
-        }
-    }
-    uart_send_byte('\n');
-}
-
     // Afficher la valeur de luminosité sur l'écran ST7789
 void display_light_level_on_screen(uint16_t value) {
     // Construire une chaîne "LIGHT: 0123"
@@ -932,223 +1284,425 @@ void display_light_level_on_screen(uint16_t value) {
 #define BLACK_COL 0x0000
 #define CONTENT_HEIGHT (ZONE_LINE_H + 2 + 1 + 2 + (7 * ZONE_LINE_H))  // 133
 
+// Compositeur du panneau (mode retenu): une cellule par position de caractère et par ligne,
+// qui garde le code Latin-1 affiché (' ' = vide). Une nouvelle ligne est comparée cellule par
+// cellule; seules les cellules changées sont redessinées, les cellules changées voisines dans
+// une même fenêtre (st7789_draw_codes). Les cellules au-delà du texte redeviennent ' '.
+#define LABEL_MODE "MODE DE CONNECTION : "
+#define LABEL_DEVICE "APPAREIL : "
+#define LABEL_LAST_KEY "TOUCHE : "
+#define LABEL_KEYS "TOUCHES CONFIGURÉES : "
+#define LABEL_BACKLIGHT "RÉTRO-ÉCLAIRAGE : "
+#define LABEL_LIGHT "LUMINOSITÉ : "
+// Cellules d'une ligne: libellé + valeur la plus longue (sizeof compte les octets UTF-8: marge)
+#define LINE_CELLS(label, value_max) (sizeof(label) - 1 + (value_max))
+#define CELLS_PROFILE (sizeof(DisplayData::profile) - 1)
+#define CELLS_MODE LINE_CELLS(LABEL_MODE, 9)  // "BLUETOOTH"
+#define CELLS_DEVICE LINE_CELLS(LABEL_DEVICE, sizeof(DisplayData::device) - 1)
+#define CELLS_LAST_KEY LINE_CELLS(LABEL_LAST_KEY, sizeof(DisplayData::lastKey) - 1)
+#define CELLS_KEYS LINE_CELLS(LABEL_KEYS, 6)  // "255/17"
+#define CELLS_BACKLIGHT LINE_CELLS(LABEL_BACKLIGHT, 3)  // "OFF"
+#define CELLS_LIGHT LINE_CELLS(LABEL_LIGHT, 5)
+#define PANEL_CELLS (CELLS_PROFILE + CELLS_MODE + CELLS_DEVICE + CELLS_LAST_KEY + CELLS_KEYS + CELLS_BACKLIGHT + CELLS_LIGHT)
+
+enum PanelLine { LINE_PROFILE, LINE_MODE, LINE_DEVICE, LINE_LAST_KEY, LINE_KEYS, LINE_BACKLIGHT, LINE_LIGHT, PANEL_LINES };
+
+static const uint8_t panel_line_cells[PANEL_LINES] = {
+    CELLS_PROFILE, CELLS_MODE, CELLS_DEVICE, CELLS_LAST_KEY, CELLS_KEYS, CELLS_BACKLIGHT, CELLS_LIGHT,
+};
+static_assert(CELLS_DEVICE * FONT_ADVANCE <= ZONE_W + 1, "ligne plus large que la zone");
+
+static uint8_t panel_cells[PANEL_CELLS];  // ~190 octets, remplace les copies prev_* des valeurs
+
 // Dessiner le panneau statique une seule fois (fond, bordures, séparateur)
-void display_init_panel(void) {
-    st7789_fill_screen(BLACK_COL);
-    st7789_fill_rect(PANEL_X, PANEL_Y, PANEL_W, PANEL_H, INNER_BG);
-    st7789_fill_rect(PANEL_X, PANEL_Y, PANEL_W, 1, BORDER_GRAY);
-    st7789_fill_rect(PANEL_X, PANEL_Y + PANEL_H - 1, PANEL_W, 1, BORDER_GRAY);
-    st7789_fill_rect(PANEL_X, PANEL_Y, 1, PANEL_H, BORDER_GRAY);
-    st7789_fill_rect(PANEL_X + PANEL_W - 1, PANEL_Y, 1, PANEL_H, BORDER_GRAY);
+// fill_rect limité aux lignes [band_y0, band_y1)
+static void st7789_fill_rect_band(uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint16_t color,
+                                  uint16_t band_y0, uint16_t band_y1) {
+    uint16_t y0 = y > band_y0 ? y : band_y0;
+    uint16_t y1 = y + h < band_y1 ? y + h : band_y1;
+    if (y0 < y1) st7789_fill_rect(x, y0, w, y1 - y0, color);
+}
+
+// Fond du panneau (écran noir, cadre, séparateur) sur les lignes [y0, y1): peint par bandes
+// pendant le démarrage de l'écran (st7789_init_step), cellules vides une fois le bas atteint
+void display_init_panel(uint16_t y0, uint16_t y1) {
+    st7789_fill_rect_band(0, 0, ST7789_WIDTH, ST7789_HEIGHT, BLACK_COL, y0, y1);
+    st7789_fill_rect_band(PANEL_X, PANEL_Y, PANEL_W, PANEL_H, INNER_BG, y0, y1);
+    st7789_fill_rect_band(PANEL_X, PANEL_Y, PANEL_W, 1, BORDER_GRAY, y0, y1);
+    st7789_fill_rect_band(PANEL_X, PANEL_Y + PANEL_H - 1, PANEL_W, 1, BORDER_GRAY, y0, y1);
+    st7789_fill_rect_band(PANEL_X, PANEL_Y, 1, PANEL_H, BORDER_GRAY, y0, y1);
+    st7789_fill_rect_band(PANEL_X + PANEL_W - 1, PANEL_Y, 1, PANEL_H, BORDER_GRAY, y0, y1);
     uint16_t sep_y = PANEL_Y + ((PANEL_H - CONTENT_HEIGHT) / 2) + 1 + ZONE_LINE_H + 2;
-    st7789_fill_rect(ZONE_X, sep_y, ZONE_W, 1, BORDER_GRAY);
+    st7789_fill_rect_band(ZONE_X, sep_y, ZONE_W, 1, BORDER_GRAY, y0, y1);
+    if (y1 >= ST7789_HEIGHT) {
+        memset(panel_cells, ' ', sizeof(panel_cells));  // Écran vide sous toutes les cellules
+    }
 }
 
-// Helper: mettre une chaîne en majuscules dans out (max len-1 chars + null)
-static void to_upper_str(const char* in, char* out, uint8_t len) {
-    uint8_t i = 0;
-    while (i < len - 1 && in && *in) {
-        char c = *in++;
-        if (c >= 'a' && c <= 'z') c = c - 'a' + 'A';
-        out[i++] = c;
-    }
-    out[i] = '\0';
-}
-
-// Mise à jour partielle: ne redessine que les zones dont la valeur a changé
-// force_key_device=1: force toujours la mise à jour des zones dernière touche et appareil
-void display_update_partial(uint8_t force_key_device) {
-    static uint8_t panel_drawn = 0;
-    static char prev_profile[32] = "";
-    static char prev_output_mode[16] = "";
-    static char prev_connected_device[32] = "";
-    static char prev_last_key[16] = "";
-    static uint8_t prev_keys_count = 255;
-    static uint8_t prev_backlight_enabled = 255;
-    static uint16_t prev_light_level = 0xFFFF;
-    
-    uint16_t start_y = PANEL_Y + ((PANEL_H - CONTENT_HEIGHT) / 2) + 1;
-    
-    if (!panel_drawn) {
-        display_init_panel();
-        panel_drawn = 1;
-    }
-    
-    uint16_t y_profile = start_y;
-    uint16_t y_mode = start_y + ZONE_LINE_H + 2 + 1 + 2;
-    uint16_t y_device = y_mode + ZONE_LINE_H;
-    uint16_t y_last_key = y_device + ZONE_LINE_H;
-    uint16_t y_keys = y_last_key + ZONE_LINE_H;
-    uint16_t y_backlight = y_keys + ZONE_LINE_H;
-    uint16_t y_light = y_backlight + ZONE_LINE_H;
-    
-    char buf[48];
-    uint8_t pos;
-    const char* p;
-    
-    // Zone 1: Profil
-    const char* profile_ptr = (char*)display_profile;
-    if (!profile_ptr || !profile_ptr[0]) profile_ptr = "Profile 1";
-    if (strcmp(profile_ptr, prev_profile) != 0) {
-        strncpy((char*)prev_profile, profile_ptr, 31);
-        prev_profile[31] = '\0';
-        to_upper_str(profile_ptr, buf, sizeof(buf));
-        st7789_fill_rect(ZONE_X, y_profile, ZONE_W, ZONE_LINE_H, INNER_BG);
-        st7789_draw_text(ZONE_X, y_profile, buf, WHITE_COL, INNER_BG);
-    }
-    
-    // Zone 2: Mode de connexion
-    const char* conn_status = "IDLE";
-    if (strcmp((char*)display_output_mode, "usb") == 0) conn_status = "USB";
-    else if (strcmp((char*)display_output_mode, "bluetooth") == 0) conn_status = "BLUETOOTH";
-    if (strcmp((char*)display_output_mode, prev_output_mode) != 0) {
-        strncpy((char*)prev_output_mode, (char*)display_output_mode, 15);
-        prev_output_mode[15] = '\0';
-        pos = 0;
-        p = "MODE DE CONNECTION : ";
-        while (*p && pos < 47) buf[pos++] = *p++;
-        p = conn_status;
-        while (*p && pos < 47) buf[pos++] = *p++;
-        buf[pos] = '\0';
-        st7789_fill_rect(ZONE_X, y_mode, ZONE_W, ZONE_LINE_H, INNER_BG);
-        st7789_draw_text(ZONE_X, y_mode, buf, WHITE_COL, INNER_BG);
-    }
-    
-    // Zone 3: Appareil connecté (fallback: déduire de display_output_mode si vide)
-    const char* device_ptr = (char*)display_connected_device;
-    if (!device_ptr || !device_ptr[0]) {
-        device_ptr = (strcmp((char*)display_output_mode, "bluetooth") == 0) ? "Bluetooth" : "Wired";
-    }
-    if (force_key_device || strcmp(device_ptr, prev_connected_device) != 0) {
-        strncpy((char*)prev_connected_device, device_ptr, 31);
-        prev_connected_device[31] = '\0';
-        pos = 0;
-        p = "APPAREIL : ";
-        while (*p && pos < 47) buf[pos++] = *p++;
-        p = device_ptr;
-        while (*p && pos < 47) {
-            char c = *p++;
-            if (c >= 'a' && c <= 'z') c = c - 'a' + 'A';
-            buf[pos++] = c;
-        }
-        buf[pos] = '\0';
-        st7789_fill_rect(ZONE_X, y_device, ZONE_W, ZONE_LINE_H, INNER_BG);
-        st7789_draw_text(ZONE_X, y_device, buf, WHITE_COL, INNER_BG);
-    }
-    
-    // Zone 4: Dernière touche
-    const char* last_key_ptr = (char*)display_last_key;
-    const char* last_key_display = (!last_key_ptr || !last_key_ptr[0]) ? "AUCUNE" : last_key_ptr;
-    if (force_key_device || strcmp(last_key_display, prev_last_key) != 0) {
-        strncpy((char*)prev_last_key, last_key_display, 15);
-        prev_last_key[15] = '\0';
-        pos = 0;
-        p = "TOUCHE : ";
-        while (*p && pos < 47) buf[pos++] = *p++;
-        p = last_key_display;
-        while (*p && pos < 47) {
-            char c = *p++;
-            if (c >= 'a' && c <= 'z') c = c - 'a' + 'A';
-            buf[pos++] = c;
-        }
-        buf[pos] = '\0';
-        st7789_fill_rect(ZONE_X, y_last_key, ZONE_W, ZONE_LINE_H, INNER_BG);
-        st7789_draw_text(ZONE_X, y_last_key, buf, WHITE_COL, INNER_BG);
-    }
-    
-    // Zone 5: Touches configurées
-    uint8_t kc = display_keys_count;
-    if (kc != prev_keys_count) {
-        prev_keys_count = kc;
-        pos = 0;
-        p = "TOUCHE CONFIGURE : ";
-        while (*p && pos < 47) buf[pos++] = *p++;
-        if (kc == 0) buf[pos++] = '0';
-        else {
-            char nb[4];
-            uint8_t i = 0;
-            uint8_t n = kc;
-            while (n > 0 && i < 3) { nb[i++] = '0' + (n % 10); n /= 10; }
-            while (i > 0 && pos < 47) buf[pos++] = nb[--i];
+// Composer une ligne du panneau: text (UTF-8) comparé aux cellules retenues
+static void panel_set_line(uint8_t line, const char* text) {
+    uint8_t* cells = panel_cells;
+    for (uint8_t i = 0; i < line; i++) cells += panel_line_cells[i];
+    uint8_t count = panel_line_cells[line];
+    
+    // Profil, séparateur, puis une ligne de ZONE_LINE_H par valeur
+    uint16_t y = PANEL_Y + ((PANEL_H - CONTENT_HEIGHT) / 2) + 1;
+    if (line > LINE_PROFILE) y += ZONE_LINE_H + 2 + 1 + 2 + (line - LINE_MODE) * ZONE_LINE_H;
+    
+    uint8_t dirty = 0xFF;  // Début du segment de cellules changées en cours
+    for (uint8_t i = 0; i <= count; i++) {
+        uint8_t changed = 0;
+        if (i < count) {
+            uint8_t code = *text ? font_next_code(&text) : ' ';
+            if (code != cells[i]) {
+                cells[i] = code;
+                changed = 1;
+            }
         }
-        buf[pos++] = '/'; buf[pos++] = '1'; buf[pos++] = '7';
-        buf[pos] = '\0';
-        st7789_fill_rect(ZONE_X, y_keys, ZONE_W, ZONE_LINE_H, INNER_BG);
-        st7789_draw_text(ZONE_X, y_keys, buf, WHITE_COL, INNER_BG);
-    }
-    
-    // Zone 6: Rétro-éclairage
-    uint8_t be = display_backlight_enabled ? 1 : 0;
-    if (be != prev_backlight_enabled) {
-        prev_backlight_enabled = be;
-        pos = 0;
-        p = "RETRO-ECLAIRAGE : ";
-        while (*p && pos < 47) buf[pos++] = *p++;
-        if (be) { buf[pos++] = 'O'; buf[pos++] = 'N'; }
-        else { buf[pos++] = 'O'; buf[pos++] = 'F'; buf[pos++] = 'F'; }
-        buf[pos] = '\0';
-        st7789_fill_rect(ZONE_X, y_backlight, ZONE_W, ZONE_LINE_H, INNER_BG);
-        st7789_draw_text(ZONE_X, y_backlight, buf, WHITE_COL, INNER_BG);
-    }
-    
-    // Zone 7: Luminosité
-    uint16_t lv = light_level;
-    if (lv != prev_light_level) {
-        prev_light_level = lv;
-        pos = 0;
-        p = "LUMINOSITE : ";
-        while (*p && pos < 47) buf[pos++] = *p++;
-        if (lv == 0) buf[pos++] = '0';
-        else {
-            char nb[5];
-            uint8_t i = 0;
-            uint16_t n = lv;
-            while (n > 0 && i < 4) { nb[i++] = '0' + (n % 10); n /= 10; }
-            while (i > 0 && pos < 47) buf[pos++] = nb[--i];
+        if (changed) {
+            if (dirty == 0xFF) dirty = i;
+        } else if (dirty != 0xFF) {
+            st7789_draw_codes(ZONE_X + dirty * FONT_ADVANCE, y, cells + dirty, i - dirty, WHITE_COL, INNER_BG, 1);
+            dirty = 0xFF;
         }
-        buf[pos] = '\0';
-        st7789_fill_rect(ZONE_X, y_light, ZONE_W, ZONE_LINE_H, INNER_BG);
-        st7789_draw_text(ZONE_X, y_light, buf, WHITE_COL, INNER_BG);
     }
 }
 
+// label + value dans buf (PANEL_TEXT_SIZE octets)
+#define PANEL_TEXT_SIZE 48
+static const char* panel_text(char* buf, const char* label, const char* value) {
+    uint8_t pos = 0;
+    while (*label && pos < PANEL_TEXT_SIZE - 1) buf[pos++] = *label++;
+    while (*value && pos < PANEL_TEXT_SIZE - 1) buf[pos++] = *value++;
+    buf[pos] = '\0';
+    return buf;
+}
+
+// Entier décimal dans out (6 octets min), renvoie out
+static char* format_dec(char* out, uint16_t v) {
+    char digits[5];
+    uint8_t n = 0;
+    do {
+        digits[n++] = '0' + (v % 10);
+        v /= 10;
+    } while (v > 0);
+    uint8_t pos = 0;
+    while (n > 0) out[pos++] = digits[--n];
+    out[pos] = '\0';
+    return out;
+}
+
+// Mise à jour partielle: recompose toutes les lignes, seules les cellules changées partent à l'écran
+// (une valeur de luminosité 512 → 517 redessine un glyphe)
+void display_update_partial(void) {
+    if (!display_initialized) return;  // Fond peint et cellules dessinées par st7789_init_step()
+    
+    char buf[PANEL_TEXT_SIZE];
+    char value[10];
+    
+    // Ligne 1: Profil
+    const char* profile_ptr = display_data.profile;
+    if (!profile_ptr[0]) profile_ptr = "Profile 1";
+    panel_set_line(LINE_PROFILE, profile_ptr);
+    
+    // Ligne 2: Mode de connexion
+    const char* conn_status = "IDLE";
+    if (strcmp(display_data.output, "usb") == 0) conn_status = "USB";
+    else if (strcmp(display_data.output, "bluetooth") == 0) conn_status = "BLUETOOTH";
+    panel_set_line(LINE_MODE, panel_text(buf, LABEL_MODE, conn_status));
+    
+    // Ligne 3: Appareil connecté (fallback: déduire de display_data.output si vide)
+    const char* device_ptr = display_data.device;
+    if (!device_ptr[0]) {
+        device_ptr = (strcmp(display_data.output, "bluetooth") == 0) ? "Bluetooth" : "Wired";
+    }
+    panel_set_line(LINE_DEVICE, panel_text(buf, LABEL_DEVICE, device_ptr));
+    
+    // Ligne 4: Dernière touche
+    const char* last_key_display = display_data.lastKey[0] ? display_data.lastKey : "AUCUNE";
+    panel_set_line(LINE_LAST_KEY, panel_text(buf, LABEL_LAST_KEY, last_key_display));
+    
+    // Ligne 5: Touches configurées
+    strcat(format_dec(value, display_data.keys), "/17");
+    panel_set_line(LINE_KEYS, panel_text(buf, LABEL_KEYS, value));
+    
+    // Ligne 6: Rétro-éclairage
+    panel_set_line(LINE_BACKLIGHT, panel_text(buf, LABEL_BACKLIGHT, display_data.backlightEnabled ? "ON" : "OFF"));
+    
+    // Ligne 7: Luminosité
+    panel_set_line(LINE_LIGHT, panel_text(buf, LABEL_LIGHT, format_dec(value, light_level)));
+}
+
 // Alias pour compatibilité - appelle la mise à jour partielle
 void display_simple_info(void) {
-    display_update_partial(0);
+    display_update_partial();
+}
+
+// Fonction pour envoyer un octet via UART
+// Sortir un octet de l'anneau vers UDR0 (ISR UDRE, ou boucle d'attente si interruptions coupées)
+static inline void uart_tx_pump(void) {
+    uint8_t tail = uart_tx_tail;
+    if (tail == uart_tx_head) {
+        UCSR0B &= ~(1 << UDRIE0);  // Anneau vide: couper l'interruption
+        return;
+    }
+    UCSR0A = (UCSR0A & (1 << U2X0)) | (1 << TXC0);  // Effacer TXC0 (FE/DOR/UPE écrits à 0)
+    UDR0 = uart_tx_ring[tail];
+    uart_tx_tail = (tail + 1) & UART_TX_RING_MASK;
 }
 
-// Fonction pour envoyer une réponse via UART
+// Mettre un octet dans l'anneau d'émission (n'attend que si l'anneau est plein)
 void uart_send_byte(uint8_t data) {
-    while (!(UCSR0A & (1 << UDRE0)));  // Attendre que le buffer de transmission soit vide
-    UDR0 = data;
+    uint8_t head = uart_tx_head;
+    uint8_t next = (head + 1) & UART_TX_RING_MASK;
+    if (next == uart_tx_tail) {
+        if (uart_tx_full_count < 0xFFFF) uart_tx_full_count++;
+        while (next == uart_tx_tail) {
+            // Boot (avant sei) ou appel depuis une ISR: vider à la main
+            if (!(SREG & (1 << SREG_I)) && (UCSR0A & (1 << UDRE0))) uart_tx_pump();
+        }
+    }
+    uart_tx_ring[head] = data;
+    uart_tx_head = next;
+    uint8_t used = (next - uart_tx_tail) & UART_TX_RING_MASK;
+    if (used > uart_tx_max_used) uart_tx_max_used = used;
+    UCSR0B |= (1 << UDRIE0);
 }
 
-void uart_send_response(uint8_t cmd, uint8_t* data, uint8_t len) {
-    // Envoyer la commande
-    uart_send_byte(cmd);
-    // Envoyer les données
+// Attendre que tout soit sorti sur la ligne (anneau vide + registre à décalage vide)
+static void uart_tx_drain(void) {
+    while (uart_tx_head != uart_tx_tail) {
+        if (!(SREG & (1 << SREG_I)) && (UCSR0A & (1 << UDRE0))) uart_tx_pump();
+    }
+    while (!(UCSR0A & (1 << UDRE0)));
+    while (!(UCSR0A & (1 << TXC0)));
+}
+
+// Changer de vitesse (index LINK_BAUD_*) une fois le dernier octet sorti
+void uart_set_baud(uint8_t idx) {
+    static const uint8_t ubrr[LINK_BAUD_COUNT] = {UART_UBRR, 3, 1, 0};
+    if (idx >= LINK_BAUD_COUNT || !(LINK_BAUD_MASK & (1 << idx))) return;
+    uart_tx_drain();  // ACK entièrement transmis à l'ancienne vitesse
+    cli();
+    UBRR0H = 0;
+    UBRR0L = ubrr[idx];
+    uart_rx_head = uart_rx_frame_start;  // Abandonner la trame partielle (trames complètes conservées)
+    uart_rx_frame_len = 0;
+    uart_rx_discard = 0;
+    uart_line_errors = 0;
+    sei();
+    uart_bad_frames = 0;
+    link_baud_idx = idx;
+}
+
+// Trop d'erreurs à haute vitesse (ESP32 revenu à 9600, parasites): revenir à 9600
+void link_check_fallback(void) {
+    if (link_baud_idx == 0) return;
+    if (uart_line_errors >= LINK_BAUD_FALLBACK_ERRORS || uart_bad_frames >= LINK_BAUD_FALLBACK_FRAMES) {
+        uart_set_baud(0);
+        LOG_INFO("[UART] Link errors, back to 9600\r\n");
+    }
+}
+
+// Encoder en COBS et envoyer (les 0x00 disparaissent, 0x00 final = fin de trame)
+static void uart_send_cobs(const uint8_t* raw, uint8_t len) {
+    uint8_t i = 0;
+    for (;;) {
+        uint8_t run = 0;
+        while ((uint8_t)(i + run) < len && raw[i + run] != 0 && run < 254) run++;
+        uart_send_byte(run + 1);
+        for (uint8_t k = 0; k < run; k++) {
+            uart_send_byte(raw[i + k]);
+        }
+        i += run;
+        if (i >= len) break;
+        if (run < 254) i++;  // Zéro consommé (implicite dans le code)
+    }
+    uart_send_byte(0x00);
+}
+
+// Décoder une trame COBS depuis l'anneau RX (len <= UART_RX_FRAME_ENC_MAX garanti par l'ISR,
+// donc la trame décodée tient dans uart_rx_frame), retourne la longueur décodée (0 = invalide)
+static uint8_t cobs_decode_ring(uint8_t pos, uint8_t len, uint8_t* out) {
+    uint8_t n = 0;
+    while (len > 0) {
+        uint8_t code = uart_rx_ring[pos++];
+        len--;
+        if (code == 0 || code - 1 > len) return 0;
+        for (uint8_t k = 1; k < code; k++) {
+            out[n++] = uart_rx_ring[pos++];
+        }
+        len -= code - 1;
+        if (code < 0xFF && len > 0) out[n++] = 0;
+    }
+    return n;
+}
+
+static uint16_t link_crc16(const uint8_t* data, uint8_t len) {
+    uint16_t crc = 0xFFFF;
     for (uint8_t i = 0; i < len; i++) {
-        uart_send_byte(data[i]);
+        crc = _crc_ccitt_update(crc, data[i]);
     }
-    uart_send_byte('\n');
+    return crc;
 }
 
-// Traiter une commande UART complète
-void processUartCommand() {
-    if (uart_buffer_index < 1) return;
-    
-    uart_command = uart_buffer[0];
-    
-    LOG_DEBUG("[UART] Command received: 0x");
-    debug_print_hex(uart_command);
-    debug_print("\r\n");
+// Envoyer une trame [SEQ][CMD][LEN][DATA][CRC16] vers l'ESP32
+void uart_send_frame(uint8_t cmd, const uint8_t* data, uint8_t len) {
+    if (len > LINK_MAX_PAYLOAD) len = LINK_MAX_PAYLOAD;
+    uint8_t* f = uart_tx_frame;
+    f[0] = uart_tx_seq++;
+    f[1] = cmd;
+    f[2] = len;
+    if (len > 0) memcpy(&f[LINK_HEADER_SIZE], data, len);
+    uint8_t n = LINK_HEADER_SIZE + len;
+    uint16_t crc = link_crc16(f, n);
+    f[n++] = crc & 0xFF;
+    f[n++] = crc >> 8;
+    uart_send_cobs(f, n);
+    link_stats.tx_frames++;
+}
+
+void uart_send_response(uint8_t cmd, uint8_t* data, uint8_t len) {
+    uart_send_frame(cmd, data, len);
+}
+
+static void uart_send_nack(uint8_t seq, uint8_t reason) {
+    uint8_t nack[2] = {seq, reason};
+    uart_send_frame(CMD_LINK_NACK, nack, 2);
+}
+
+// Prendre la plus ancienne trame reçue: valider (COBS, longueur, CRC), acquitter puis exécuter
+void processUartFrame(void) {
+    if (uart_rx_queue_head == uart_rx_queue_tail) {
+        // Trame perdue faute de descripteur libre: l'ESP32 retransmet sur NACK
+        uart_rx_lost_nack = 0;
+        uart_send_nack(0, LINK_NACK_OVERFLOW);
+        return;
+    }
+    __asm__ __volatile__("" ::: "memory");  // Lire descripteur et anneau après l'index publié par l'ISR
+    UartRxFrame f = uart_rx_queue[uart_rx_queue_tail];
+    if (f.len == 0) {
+        uart_rx_queue_tail = (uart_rx_queue_tail + 1) & UART_RX_QUEUE_MASK;
+        uart_send_nack(f.info, f.reason);
+        return;
+    }
+    uint8_t* buf = uart_rx_frame;
+    uint8_t n = cobs_decode_ring(f.start, f.len, buf);
+    // Copie faite: libérer l'anneau avant l'exécution (l'ISR peut recevoir pendant le dessin)
+    uart_rx_tail = f.start + f.len;
+    uart_rx_queue_tail = (uart_rx_queue_tail + 1) & UART_RX_QUEUE_MASK;
+    
+    if (n < LINK_HEADER_SIZE + LINK_CRC_SIZE) {
+        uart_send_nack(n > 0 ? buf[0] : 0, LINK_NACK_LENGTH);
+        uart_bad_frames++;
+        link_stats.framing_errors++;
+    } else if ((uint16_t)buf[2] + LINK_HEADER_SIZE + LINK_CRC_SIZE != n) {
+        uart_send_nack(buf[0], LINK_NACK_LENGTH);
+        uart_bad_frames++;
+        link_stats.framing_errors++;
+    } else if (link_crc16(buf, n - LINK_CRC_SIZE) != (uint16_t)(buf[n - 2] | (buf[n - 1] << 8))) {
+        uart_send_nack(buf[0], LINK_NACK_CRC);
+        uart_bad_frames++;
+        link_stats.crc_errors++;
+    } else {
+        uint8_t seq = buf[0];
+        uart_bad_frames = 0;
+        uart_line_errors = 0;
+        link_stats.rx_frames++;
+        // ACK avant exécution: l'ESP32 n'attend pas la fin du dessin
+        uart_send_frame(CMD_LINK_ACK, &seq, 1);
+        // CAPS ouvre une session (négociation au boot de l'ESP32, seq repartie de 0):
+        // la dernière seq de la session précédente ne doit pas masquer la première commande
+        if (buf[1] == CMD_LINK_BAUD_CAPS) uart_rx_have_seq = 0;
+        // Retransmission d'une trame déjà exécutée (ACK perdu): ne pas rejouer
+        if (!uart_rx_have_seq || seq != uart_rx_last_seq) {
+            uart_rx_last_seq = seq;
+            uart_rx_have_seq = 1;
+            processUartCommand(buf[1], &buf[LINK_HEADER_SIZE], buf[2]);
+        } else {
+            link_stats.duplicates++;
+        }
+    }
+}
+
+// Trame d'état compacte (LinkStatusMsg: ordre = LinkStats puis uart_tx_full_count;
+// lue par AtmegaLink::_onPeerStatus)
+static void link_send_status(void) {
+    LinkStatus status;
+    status.version = LINK_STATUS_VERSION;
+    status.baudIdx = link_baud_idx;
+    uint8_t sreg = SREG;
+    cli();  // Instantané cohérent (l'ISR RX incrémente line_errors / overruns / dropped)
+    status.rxFrames = link_stats.rx_frames;
+    status.txFrames = link_stats.tx_frames;
+    status.crcErrors = link_stats.crc_errors;
+    status.framingErrors = link_stats.framing_errors;
+    status.lineErrors = link_stats.line_errors;
+    status.overruns = link_stats.overruns;
+    status.dropped = link_stats.dropped;
+    status.duplicates = link_stats.duplicates;
+    status.unknownCmds = link_stats.unknown_cmds;
+    status.txFull = uart_tx_full_count;
+    SREG = sreg;
+    uint8_t frame[LinkStatusMsg::MAX];
+    uart_send_frame(CMD_LINK_STATUS, frame, lmsg::encode<LinkStatusMsg>(status, frame));
+}
+
+// Envoyer la luminosité (LightLevelMsg) — réponse à CMD_READ_LIGHT ou push
+static void light_send(void) {
+    LightLevel light = {light_level};
+    uint8_t response[LightLevelMsg::MAX];
+    uart_send_frame(CMD_READ_LIGHT, response, lmsg::encode<LightLevelMsg>(light, response));
+    light_reported = light.level;
+    light_reported_zone = (light.level >= light_sub_threshold) ? 1 : 0;
+    light_push_age = 0;
+}
+
+// Après chaque échantillon ADC: pousser si variation >= delta ou passage du seuil
+// (hors bande d'hystérésis), au plus une fois par intervalle. UART muet sinon.
+void light_push_check(void) {
+    if (light_push_age < 0xFF) light_push_age++;
+    if (light_sub_delta == 0) return;
+    
+    uint16_t level = light_level;
+    uint16_t half = light_sub_hysteresis / 2;
+    uint8_t zone = light_reported_zone;
+    if (level >= light_sub_threshold + half) {
+        zone = 1;
+    } else if (level + half < light_sub_threshold) {
+        zone = 0;
+    }
+    uint16_t diff = (level > light_reported) ? level - light_reported : light_reported - level;
+    if (light_reported != 0xFFFF && zone == light_reported_zone && diff < light_sub_delta) return;
+    if (light_push_age < light_sub_interval) return;
+    light_send();
+    light_reported_zone = zone;
+}
+
+// Traiter une commande (payload déjà validé par processUartFrame)
+void processUartCommand(uint8_t cmd, const uint8_t* data, uint8_t len) {
+    if (debug_enabled && log_level >= 3) {
+        debug_print("[UART] Command received: 0x");
+        debug_print_hex(cmd);
+        debug_print("\r\n");
+    }
     
-    switch (uart_command) {
+    switch (cmd) {
         case CMD_READ_LIGHT:
-            // Envoyer la luminosité (2 bytes, little-endian)
+            light_send();
+            break;
+            
+        case CMD_LIGHT_SUBSCRIBE:
+            // delta = 0: désabonnement (plus aucun push, CMD_READ_LIGHT reste possible)
             {
-                uint8_t response[2] = {(uint8_t)(light_level & 0xFF), (uint8_t)((light_level >> 8) & 0xFF)};
-                uart_send_response(CMD_READ_LIGHT, response, 2);
+                LightSubscribe sub;
+                if (lmsg::decode<LightSubscribeMsg>(data, len, sub) < LightSubscribeMsg::FIELDS) break;
+                light_sub_delta = sub.delta;
+                light_sub_threshold = sub.threshold;
+                light_sub_hysteresis = sub.hysteresis;
+                uint16_t interval = (sub.intervalMs + LIGHT_SAMPLE_MS - 1) / LIGHT_SAMPLE_MS;
+                light_sub_interval = (interval > 0xFE) ? 0xFE : interval;
+                if (light_sub_delta != 0) light_send();  // Valeur initiale
             }
             break;
             
@@ -1161,8 +1715,8 @@ void processUartCommand() {
             break;
             
         case CMD_SET_LED:
-            if (uart_buffer_index >= 2) {
-                uint8_t brightness = uart_buffer[1];
+            if (len >= 1) {
+                uint8_t brightness = data[0];
                 LOG_INFO("[UART] Setting LED brightness: ");
                 debug_print_dec(brightness);
                 debug_print("\r\n");
@@ -1175,115 +1729,53 @@ void processUartCommand() {
             st7789_update_display();
             break;
             
+        case CMD_LINK_BAUD_CAPS:
+            {
+                uint8_t response[2] = {LINK_BAUD_MASK, link_baud_idx};
+                uart_send_response(CMD_LINK_BAUD_CAPS, response, 2);
+            }
+            break;
+            
+        case CMD_LINK_BAUD_SET:
+            // L'ACK est déjà parti: l'ESP32 bascule à sa réception
+            if (len >= 1) {
+                uart_set_baud(data[0]);
+            }
+            break;
+            
+        case CMD_LINK_BAUD_TEST:
+            uart_send_frame(CMD_LINK_BAUD_TEST, data, len);
+            break;
+            
+        case CMD_LINK_PING:
+            uart_send_frame(CMD_LINK_PING, data, len);
+            break;
+            
+        case CMD_LINK_STATUS:
+            link_send_status();
+            break;
+            
         case CMD_SET_DISPLAY_DATA:
-            // Parser les données d'affichage
-            if (uart_buffer_index > 1) {
-                uint8_t pos = 1;
-                if (pos < uart_buffer_index) {
-                    display_brightness = uart_buffer[pos++];
-                }
-                // Mode
-                if (pos < uart_buffer_index) {
-                    uint8_t mode_len = uart_buffer[pos++];
-                    if (mode_len < 16 && pos + mode_len <= uart_buffer_index) {
-                        memcpy((void*)display_mode, (const void*)&uart_buffer[pos], mode_len);
-                        display_mode[mode_len] = '\0';
-                        pos += mode_len;
-                    }
-                }
-                // Profile
-                if (pos < uart_buffer_index) {
-                    uint8_t profile_len = uart_buffer[pos++];
-                    if (profile_len < 32 && pos + profile_len <= uart_buffer_index) {
-                        memcpy((void*)display_profile, (const void*)&uart_buffer[pos], profile_len);
-                        display_profile[profile_len] = '\0';
-                        pos += profile_len;
-                    }
-                }
-                // Output mode
-                if (pos < uart_buffer_index) {
-                    uint8_t output_len = uart_buffer[pos++];
-                    if (output_len < 16 && pos + output_len <= uart_buffer_index) {
-                        memcpy((void*)display_output_mode, (const void*)&uart_buffer[pos], output_len);
-                        display_output_mode[output_len] = '\0';
-                        pos += output_len;
-                    }
-                }
-                // Keys count
-                if (pos < uart_buffer_index) {
-                    display_keys_count = uart_buffer[pos++];
-                }
-                // Last key pressed
-                if (pos < uart_buffer_index) {
-                    uint8_t last_key_len = uart_buffer[pos++];
-                    if (last_key_len < 16) {
-                        if (last_key_len > 0 && pos + last_key_len <= uart_buffer_index) {
-                            memcpy((void*)display_last_key, (const void*)&uart_buffer[pos], last_key_len);
-                            display_last_key[last_key_len] = '\0';
-                            pos += last_key_len;
-                        } else if (last_key_len == 0) {
-                            display_last_key[0] = '\0';
-                        }
-                    }
-                }
-                // Backlight enabled
-                if (pos < uart_buffer_index) {
-                    display_backlight_enabled = uart_buffer[pos++];
-                }
-                // Backlight brightness
-                if (pos < uart_buffer_index) {
-                    display_backlight_brightness = uart_buffer[pos++];
-                }
-                // Time (optionnel - skip)
-                if (pos < uart_buffer_index) {
-                    uint8_t time_len = uart_buffer[pos++];
-                    if (time_len > 0 && pos + time_len <= uart_buffer_index) {
-                        pos += time_len;
-                    }
-                }
-                // Appareil connecté (optionnel)
-                if (pos < uart_buffer_index) {
-                    uint8_t device_len = uart_buffer[pos++];
-                    if (device_len > 0 && device_len < 32 && pos + device_len <= uart_buffer_index) {
-                        memcpy((void*)display_connected_device, (const void*)&uart_buffer[pos], device_len);
-                        display_connected_device[device_len] = '\0';
-                        pos += device_len;
-                    } else if (device_len == 0) {
-                        display_connected_device[0] = '\0';
-                    }
-                }
-                
-                // Mise à jour partielle (force last_key et device à chaque réception UART)
-                display_update_partial(1);
+            // Champs de fin optionnels; arrêt au premier champ invalide (LinkMessages.h)
+            if (lmsg::decode<DisplayDataMsg>(data, len, display_data) > 0) {
+                display_update_partial();  // Seules les cellules changées sont redessinées
             }
             break;
             
         case CMD_SET_LAST_KEY:
-            if (uart_buffer_index >= 2) {
-                uint8_t last_key_len = uart_buffer[1];
-                uint8_t pos = 2;
-                if (last_key_len < 16) {
-                    if (last_key_len > 0 && (pos + last_key_len) <= uart_buffer_index) {
-                        memcpy((void*)display_last_key, (const void*)&uart_buffer[pos], last_key_len);
-                        display_last_key[last_key_len] = '\0';
-                        pos += last_key_len;
-                    } else if (last_key_len == 0) {
-                        display_last_key[0] = '\0';
-                    }
-                    if (pos + 2 <= uart_buffer_index) {
-                        display_backlight_enabled = uart_buffer[pos++];
-                        display_backlight_brightness = uart_buffer[pos++];
-                        esp32_backlight_ticks = 100;  // 10 s de priorité ESP32 (~100 * 100ms)
-                        set_led_brightness(display_backlight_enabled ? display_backlight_brightness : 0);
-                    }
-                    display_update_partial(1);
+            {
+                uint8_t fields = lmsg::decode<LastKeyMsg>(data, len, display_data);
+                if (fields == LastKeyMsg::FIELDS) {
+                    esp32_backlight_ticks = 100;  // 10 s de priorité ESP32 (~100 * 100ms)
+                    set_led_brightness(display_data.backlightEnabled ? display_data.backlightBrightness : 0);
                 }
+                if (fields > 0) display_update_partial();
             }
             break;
             
         case CMD_SET_ATMEGA_DEBUG:
-            if (uart_buffer_index >= 2) {
-                debug_enabled = uart_buffer[1];
+            if (len >= 1) {
+                debug_enabled = data[0];
                 LOG_INFO("[UART] Debug ");
                 if (debug_enabled) {
                     LOG_INFO("enabled\r\n");
@@ -1294,8 +1786,8 @@ void processUartCommand() {
             break;
             
         case CMD_SET_ATMEGA_LOG_LEVEL:
-            if (uart_buffer_index >= 2) {
-                log_level = uart_buffer[1];
+            if (len >= 1) {
+                log_level = data[0];
                 if (log_level > 3) log_level = 3;
                 LOG_INFO("[UART] Log level set to: ");
                 debug_print_dec(log_level);
@@ -1304,8 +1796,10 @@ void processUartCommand() {
             break;
             
         case CMD_SET_DISPLAY_IMAGE:
-            if (uart_buffer_index >= 3) {
-                image_expected_size = uart_buffer[1] | (uart_buffer[2] << 8);
+            {
+                ImageStart start;
+                if (lmsg::decode<ImageStartMsg>(data, len, start) < ImageStartMsg::FIELDS) break;
+                image_expected_size = start.size;
                 image_received_bytes = 0;
                 image_chunk_index = 0;
                 image_receiving = 1;
@@ -1316,15 +1810,16 @@ void processUartCommand() {
             break;
             
         case CMD_SET_DISPLAY_IMAGE_CHUNK:
-            if (image_receiving && uart_buffer_index >= 4) {
-                uint16_t chunk_idx = uart_buffer[1] | (uart_buffer[2] << 8);
-                uint8_t chunk_size = uart_buffer[3];
+            if (image_receiving) {
+                ImageChunk chunk;  // chunk.data pointe dans la trame reçue
+                uint8_t fields = lmsg::decode<ImageChunkMsg>(data, len, chunk);
+                uint16_t chunk_idx = chunk.index;
+                uint8_t chunk_size = chunk.size;
                 
-                if (chunk_size > 0 && chunk_size <= IMAGE_CHUNK_SIZE && 
-                    (uart_buffer_index - 4) >= chunk_size) {
+                if (fields == ImageChunkMsg::FIELDS && chunk_size > 0) {
                     
                     // Calculer la position dans l'image
-                    uint16_t byte_offset = chunk_idx * IMAGE_CHUNK_SIZE;
+                    uint16_t byte_offset = chunk_idx * LINK_IMAGE_CHUNK_MAX;
                     uint16_t pixel_offset = byte_offset / 2;
                     uint16_t x = pixel_offset % ST7789_WIDTH;
                     uint16_t y = pixel_offset / ST7789_WIDTH;
@@ -1336,14 +1831,14 @@ void processUartCommand() {
                         pixels_in_chunk = ST7789_WIDTH - x;
                     }
                     
-                    // Dessiner le chunk sur l'écran
-                    st7789_set_window(x, y, end_x - 1, y);
-                    ST7789_CS_PORT &= ~(1 << ST7789_CS_PIN);
-                    ST7789_DC_PORT |= (1 << ST7789_DC_PIN);
-                    for (uint8_t i = 0; i < chunk_size; i++) {
-                        spi_write(uart_buffer[4 + i]);
+                    // Dessiner le chunk sur l'écran (pas pendant son démarrage: effacé ensuite)
+                    if (display_initialized) {
+                        st7789_begin_window(x, y, end_x - 1, y);
+                        for (uint8_t i = 0; i < chunk_size; i++) {
+                            spi_write(chunk.data[i]);
+                        }
+                        st7789_end_window();
                     }
-                    ST7789_CS_PORT |= (1 << ST7789_CS_PIN);
                     
                     image_received_bytes += chunk_size;
                     image_chunk_index++;
@@ -1357,29 +1852,84 @@ void processUartCommand() {
                 }
             }
             break;
+            
+        default:
+            link_stats.unknown_cmds++;
+            break;
     }
-    
-    // Réinitialiser le buffer et le flag de commande en attente
-    uart_buffer_index = 0;
-    uart_command = 0;
-    uart_cmd_pending = 0;
 }
 
-// Interruption UART (réception) - bufferise; la boucle principale traite quand uart_cmd_pending
+// Interruption UART (émission): registre de données libre
+ISR(USART_UDRE_vect) {
+    uart_tx_pump();
+}
+
+// Terminer la trame en cours (ISR): descripteur vers la boucle principale. Seul compteur des
+// trames perdues: len = 0 (trame abandonnée, NACK à venir) ou file pleine, une fois chacune
+static inline void uart_rx_push(uint8_t start, uint8_t len, uint8_t info, uint8_t reason) {
+    uint8_t qh = uart_rx_queue_head;
+    uint8_t next = (qh + 1) & UART_RX_QUEUE_MASK;
+    if (len == 0 || next == uart_rx_queue_tail) link_stats.dropped++;
+    if (next == uart_rx_queue_tail) {
+        // File pleine: la trame est perdue, rendre sa place et le signaler
+        uart_rx_head = start;
+        uart_rx_lost_nack = 1;
+        return;
+    }
+    uart_rx_queue[qh].start = start;
+    uart_rx_queue[qh].len = len;
+    uart_rx_queue[qh].info = info;
+    uart_rx_queue[qh].reason = reason;
+    uart_rx_queue_head = next;
+}
+
+// Interruption UART (réception) - accumule les trames COBS dans l'anneau; au délimiteur 0x00
+// la trame est publiée dans la file. Trame perdue (anneau plein, trop longue) → NACK OVERFLOW
 ISR(USART_RX_vect) {
+    uint8_t status = UCSR0A;  // Lire avant UDR0
     uint8_t received = UDR0;
     
-    if (received == '\n' || received == '\r') {
-        if (uart_buffer_index > 0) {
-            uart_cmd_pending = 1;  // Conserver le buffer pour processUartCommand
+    if (status & ((1 << FE0) | (1 << DOR0))) {
+        // Octet corrompu (mauvaise vitesse, parasite): abandonner la trame en cours sans NACK
+        if (uart_line_errors < 255) uart_line_errors++;
+        link_stats.line_errors++;
+        if (status & (1 << DOR0)) link_stats.overruns++;
+        uart_rx_discard = 0xFF;
+        uart_rx_head = uart_rx_frame_start;
+        return;
+    }
+    
+    if (received == 0x00) {
+        if (uart_rx_discard) {
+            if (uart_rx_discard != 0xFF) {
+                uart_rx_push(uart_rx_frame_start, 0, uart_rx_frame_seq, uart_rx_discard);
+            }
+        } else if (uart_rx_frame_len > 0) {
+            uart_rx_push(uart_rx_frame_start, uart_rx_frame_len, 0, 0);
         }
-        // Ne PAS reset uart_buffer_index - la boucle principale le fera après traitement
+        uart_rx_frame_start = uart_rx_head;
+        uart_rx_frame_len = 0;
+        uart_rx_frame_seq = 0;
+        uart_rx_discard = 0;
+        return;
+    }
+    
+    if (uart_rx_discard) return;  // Ignorer jusqu'au délimiteur
+    // SEQ = 2e octet encodé si le premier code COBS > 1 (sinon SEQ = 0), pour le NACK
+    if (uart_rx_frame_len == 1 && uart_rx_ring[uart_rx_frame_start] > 1) {
+        uart_rx_frame_seq = received;
+    }
+    
+    uint8_t head = uart_rx_head;
+    if (uart_rx_frame_len >= UART_RX_FRAME_ENC_MAX) {
+        uart_rx_discard = LINK_NACK_LENGTH;
+    } else if ((uint8_t)(head + 1) == uart_rx_tail) {
+        uart_rx_discard = LINK_NACK_OVERFLOW;  // Anneau plein: boucle principale trop lente
     } else {
-        if (uart_cmd_pending) return;  // Attendre que la boucle principale traite
-        if (uart_buffer_index < UART_BUFFER_SIZE - 1) {
-            uart_buffer[uart_buffer_index++] = received;
-        } else {
-            uart_buffer_index = 0;
-        }
+        uart_rx_ring[head] = received;
+        uart_rx_head = head + 1;
+        uart_rx_frame_len++;
+        return;
     }
-}
\ No newline at end of file
+    uart_rx_head = uart_rx_frame_start;  // Rendre la place de la trame abandonnée
+}
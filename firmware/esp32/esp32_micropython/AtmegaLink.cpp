@@ -0,0 +1,428 @@
+/*
+ * AtmegaLink.cpp — COBS + CRC-16 + ACK/retry (côté ESP32)
+ */
+#include "AtmegaLink.h"
+#include "Log.h"
+
+static const uint32_t LINK_BAUDS[LINK_BAUD_COUNT] = LINK_BAUD_RATES;
+static_assert(SCHED_LINK_MS * 4 <= LINK_RX_FILL_MS, "tampon RX plein avant 4 passages de la tâche link");
+static const uint16_t LINK_RTT_EDGES[LINK_RTT_BUCKETS - 1] = LINK_RTT_EDGES_MS;
+
+uint16_t AtmegaLink::crc16(const uint8_t* data, uint16_t len) {
+    // Même calcul que _crc_ccitt_update (avr-libc) côté ATmega
+    uint16_t crc = 0xFFFF;
+    for (uint16_t i = 0; i < len; i++) {
+        uint8_t d = data[i] ^ (uint8_t)(crc & 0xFF);
+        d ^= d << 4;
+        crc = ((((uint16_t)d << 8) | (crc >> 8)) ^ (uint8_t)(d >> 4) ^ ((uint16_t)d << 3));
+    }
+    return crc;
+}
+
+uint16_t AtmegaLink::cobsEncode(const uint8_t* in, uint16_t len, uint8_t* out) {
+    uint16_t i = 0, o = 0;
+    for (;;) {
+        uint8_t run = 0;
+        while (i + run < len && in[i + run] != 0 && run < 254) run++;
+        out[o++] = run + 1;
+        memcpy(&out[o], &in[i], run);
+        o += run;
+        i += run;
+        if (i >= len) break;
+        if (run < 254) i++;  // Zéro consommé (implicite dans le code)
+    }
+    return o;
+}
+
+uint16_t AtmegaLink::cobsDecode(uint8_t* buf, uint16_t len) {
+    uint16_t in = 0, out = 0;
+    while (in < len) {
+        uint8_t code = buf[in++];
+        if (code == 0 || in + code - 1 > len) return 0;
+        for (uint8_t k = 1; k < code; k++) buf[out++] = buf[in++];
+        if (code < 0xFF && in < len) buf[out++] = 0;
+    }
+    return out;
+}
+
+void AtmegaLink::begin(Stream* serial) {
+    _serial = serial;
+    _qHead = _qCount = 0;
+    _inFlight = false;
+    _rxLen = 0;
+    _rxOverflow = false;
+    _rxBadRun = 0;
+    _neg = NEG_IDLE;
+    _baudIdx = 0;
+    _statsAt = millis();
+}
+
+uint32_t AtmegaLink::baud() const {
+    return LINK_BAUDS[_baudIdx];
+}
+
+bool AtmegaLink::send(uint8_t cmd, const uint8_t* payload, uint8_t len) {
+    if (len > LINK_MAX_PAYLOAD || _qCount >= LINK_TX_QUEUE) {
+        LOG_W(LOGF_LINK_QUEUE_FULL, cmd, _qCount);
+        _stats.queueFull++;
+        return false;
+    }
+    TxSlot& slot = _queue[(_qHead + _qCount) % LINK_TX_QUEUE];
+    slot.cmd = cmd;
+    slot.len = len;
+    if (len > 0 && payload != nullptr) memcpy(slot.payload, payload, len);
+    _qCount++;
+    if (!_inFlight) _transmitHead();
+    return true;
+}
+
+void AtmegaLink::_transmitHead() {
+    if (_qCount == 0 || _serial == nullptr) return;
+    TxSlot& slot = _queue[_qHead];
+    if (!_inFlight) {
+        _inFlightSeq = _nextSeq++;
+        _retries = 0;
+        _inFlight = true;
+        _overflowNacked = false;
+    }
+
+    uint8_t frame[LINK_FRAME_MAX];
+    frame[0] = _inFlightSeq;
+    frame[1] = slot.cmd;
+    frame[2] = slot.len;
+    memcpy(&frame[LINK_HEADER_SIZE], slot.payload, slot.len);
+    uint16_t n = LINK_HEADER_SIZE + slot.len;
+    uint16_t crc = crc16(frame, n);
+    frame[n++] = crc & 0xFF;
+    frame[n++] = crc >> 8;
+
+    uint8_t encoded[LINK_ENCODED_MAX];
+    uint16_t e = cobsEncode(frame, n, encoded);
+    encoded[e++] = 0x00;
+    // Jamais bloquant: si le tampon TX n'a pas la place, réessayer au prochain poll()
+    if (_serial->availableForWrite() < (int)e) {
+        if (!_txBlocked) _stats.txStalls++;
+        _txBlocked = true;
+        return;
+    }
+    _txBlocked = false;
+    _serial->write(encoded, e);
+    _sentAt = millis();
+    _statWire += e;
+    _stats.txFrames++;
+    if (slot.cmd == CMD_LINK_PING) _pingSentUs = micros();
+}
+
+void AtmegaLink::_popHead() {
+    _inFlight = false;
+    _txBlocked = false;
+    _qHead = (_qHead + 1) % LINK_TX_QUEUE;
+    _qCount--;
+}
+
+void AtmegaLink::poll() {
+    if (_serial == nullptr) return;
+
+    // Réception: accumuler jusqu'au délimiteur 0x00
+    while (_serial->available()) {
+        uint8_t b = (uint8_t)_serial->read();
+        if (b == 0x00) {
+            if (!_rxOverflow && _rxLen > 0) {
+                uint16_t n = cobsDecode(_rxBuf, _rxLen);
+                if (n > 0) {
+                    _handleFrame(_rxBuf, n);
+                } else {
+                    LOG_W(LOGF_LINK_BAD_FRAME, _rxLen, 0u);
+                    _stats.framingErrors++;
+                    _rxBadRun++;
+                }
+            }
+            _rxLen = 0;
+            _rxOverflow = false;
+        } else if (_rxLen < sizeof(_rxBuf)) {
+            _rxBuf[_rxLen++] = b;
+        } else {
+            if (!_rxOverflow) _stats.rxOverruns++;
+            _rxOverflow = true;  // Ignorer jusqu'au prochain délimiteur
+        }
+    }
+
+    // Trame en attente de place dans le tampon TX
+    if (_txBlocked) _transmitHead();
+
+    // Retransmission sur timeout (le délai court depuis l'écriture effective)
+    if (_inFlight && !_txBlocked && (millis() - _sentAt) >= LINK_ACK_TIMEOUT_MS) {
+        if (_retries < LINK_MAX_RETRIES) {
+            _retries++;
+            _stats.retries++;
+            _overflowNacked = false;
+            LOG_W(LOGF_LINK_RETRY, _queue[_qHead].cmd, _inFlightSeq, _retries);
+            _transmitHead();
+        } else {
+            uint8_t cmd = _queue[_qHead].cmd;
+            LOG_E(LOGF_LINK_DROPPED, cmd, _inFlightSeq);
+            _stats.dropped++;
+            _popHead();
+            _onDropped(cmd);
+            _transmitHead();
+        }
+    }
+
+    // Trames illisibles en série: l'ATmega n'est plus à notre vitesse (reset...)
+    if (_rxBadRun >= LINK_BAUD_MAX_BAD_RX) {
+        _rxBadRun = 0;
+        _onDropped(0);
+    }
+
+    _negotiationPoll();
+    _healthPoll();
+
+    unsigned long now = millis();
+    if (now - _statsAt >= LINK_STATS_PERIOD_MS) {
+        if (_statWire > 0) {
+            uint32_t period = now - _statsAt;
+            LOG_I(LOGF_LINK_THROUGHPUT, baud(), _statPayload * 1000 / period, _statWire * 1000 / period);
+        }
+        if (_stats.txStalls != _reportedStalls || _stats.queueFull != _reportedQueueFull) {
+            LOG_W(LOGF_LINK_BACKPRESSURE, _stats.txStalls - _reportedStalls, _stats.queueFull - _reportedQueueFull);
+            _reportedStalls = _stats.txStalls;
+            _reportedQueueFull = _stats.queueFull;
+        }
+        _statsAt = now;
+        _statPayload = _statWire = 0;
+    }
+}
+
+void AtmegaLink::_handleFrame(uint8_t* frame, uint16_t len) {
+    if (len < LINK_HEADER_SIZE + LINK_CRC_SIZE) {
+        LOG_W(LOGF_LINK_BAD_FRAME, len, 1u);
+        _stats.framingErrors++;
+        _rxBadRun++;
+        return;
+    }
+    uint8_t cmd = frame[1];
+    uint8_t plen = frame[2];
+    if ((uint16_t)plen + LINK_HEADER_SIZE + LINK_CRC_SIZE != len) {
+        LOG_W(LOGF_LINK_BAD_FRAME, len, 2u);
+        _stats.framingErrors++;
+        _rxBadRun++;
+        return;
+    }
+    uint16_t crc = frame[len - 2] | (frame[len - 1] << 8);
+    if (crc16(frame, len - LINK_CRC_SIZE) != crc) {
+        LOG_W(LOGF_LINK_BAD_FRAME, len, 3u);
+        _stats.crcErrors++;
+        _rxBadRun++;
+        return;
+    }
+    _rxBadRun = 0;
+    _stats.rxFrames++;
+    const uint8_t* payload = &frame[LINK_HEADER_SIZE];
+
+    if (cmd == CMD_LINK_ACK) {
+        if (_inFlight && plen >= 1 && payload[0] == _inFlightSeq) {
+            uint8_t acked = _queue[_qHead].cmd;
+            _statPayload += _queue[_qHead].len;
+            _popHead();
+            _onAcked(acked);  // Peut changer la vitesse avant la trame suivante
+            _transmitHead();
+        }
+        return;
+    }
+    if (cmd == CMD_LINK_NACK) {
+        // Trame rejetée côté ATmega: retransmettre tout de suite si c'est celle en vol.
+        // [0, OVERFLOW]: trame perdue sans seq connu (file de l'ATmega pleine), prise pour
+        // celle en vol une fois par émission; NACK tardif ou dupliqué d'une autre seq: ignoré
+        _stats.nacks++;
+        if (!_inFlight || plen < 1 || _retries >= LINK_MAX_RETRIES) return;
+        bool overflow = plen >= 2 && payload[0] == 0 && payload[1] == LINK_NACK_OVERFLOW;
+        if (payload[0] != _inFlightSeq && !(overflow && !_overflowNacked)) return;
+        if (overflow) _overflowNacked = true;
+        _retries++;
+        _stats.retries++;
+        LOG_W(LOGF_LINK_RETRY, _queue[_qHead].cmd, _inFlightSeq, _retries);
+        _transmitHead();
+        return;
+    }
+    if (cmd == CMD_LINK_BAUD_CAPS) {
+        if (_neg == NEG_CAPS && plen >= 1) {
+            _peerMask = payload[0];
+            _tryNext(LINK_BAUD_COUNT);
+        }
+        return;
+    }
+    if (cmd == CMD_LINK_BAUD_TEST) {
+        if (_neg != NEG_TEST) return;  // Écho tardif d'un essai abandonné
+        if (plen != LINK_BAUD_TEST_LEN) {
+            _failTest(2);
+            return;
+        }
+        for (uint8_t i = 0; i < plen; i++) {
+            if (payload[i] != _testByte(i)) {
+                _failTest(2);
+                return;
+            }
+        }
+        // Aller-retour du motif: trame encodée émise + écho reçu
+        uint32_t us = micros() - _testStartUs;
+        uint32_t bytes = 2 * (LINK_HEADER_SIZE + LINK_BAUD_TEST_LEN + LINK_CRC_SIZE + 2);
+        _neg = NEG_IDLE;
+        LOG_I(LOGF_LINK_BAUD_OK, baud(), bytes, us, us ? (uint32_t)((uint64_t)bytes * 1000000 / us) : 0u);
+        return;
+    }
+    if (cmd == CMD_LINK_PING) {
+        _onPingReply(payload, plen);
+        return;
+    }
+    if (cmd == CMD_LINK_STATUS) {
+        _onPeerStatus(payload, plen);
+        return;
+    }
+    if (_frameCb == nullptr || !_frameCb(cmd, payload, plen)) _stats.unknownCmds++;
+}
+
+// ─── Santé de la liaison ─────────────────────────────────────────────────────
+
+// Ping + demande d'état quand la liaison est libre (n'allonge pas les files)
+void AtmegaLink::_healthPoll() {
+    unsigned long now = millis();
+    if (_pingOutstanding && now - _pingAt >= LINK_PING_TIMEOUT_MS) {
+        _pingOutstanding = false;
+        _stats.pingsLost++;
+    }
+    if (_neg != NEG_IDLE || _qCount != 0 || _pingOutstanding) return;
+    if (now - _pingAt < LINK_PING_INTERVAL_MS) return;
+    _pingAt = now;
+    _pingToken++;
+    uint8_t token[4];
+    memcpy(token, &_pingToken, 4);
+    if (send(CMD_LINK_PING, token, 4)) {
+        _pingOutstanding = true;
+        send(CMD_LINK_STATUS, nullptr, 0);
+    }
+}
+
+void AtmegaLink::_onPingReply(const uint8_t* payload, uint8_t len) {
+    uint32_t token;
+    if (!_pingOutstanding || len < 4) return;
+    memcpy(&token, payload, 4);
+    if (token != _pingToken) return;  // Écho d'un ping déjà compté perdu
+    _pingOutstanding = false;
+    uint32_t rtt = micros() - _pingSentUs;
+    _stats.pings++;
+    _stats.rttSumUs += rtt;
+    if (_stats.pings == 1 || rtt < _stats.rttMinUs) _stats.rttMinUs = rtt;
+    if (rtt > _stats.rttMaxUs) _stats.rttMaxUs = rtt;
+    uint8_t b = 0;
+    while (b < LINK_RTT_BUCKETS - 1 && rtt >= (uint32_t)LINK_RTT_EDGES[b] * 1000) b++;
+    _stats.rttHist[b]++;
+}
+
+// Trame d'état ATmega (LinkStatusMsg), ignorée si version inconnue ou tronquée
+void AtmegaLink::_onPeerStatus(const uint8_t* payload, uint8_t len) {
+    LinkStatus status;
+    if (lmsg::decode<LinkStatusMsg>(payload, len, status) < LinkStatusMsg::FIELDS) return;
+    if (status.version != LINK_STATUS_VERSION) return;
+    static_cast<LinkStatus&>(_peer) = status;
+    _peer.receivedAt = millis();
+    _peer.valid = true;
+}
+
+// ─── Négociation de vitesse ──────────────────────────────────────────────────
+
+// Motif de test: transitions maximales, 0x00 (COBS) et octets de contrôle
+uint8_t AtmegaLink::_testByte(uint8_t i) {
+    static const uint8_t HEAD[] = {0x55, 0xAA, 0x00, 0xFF, 0x0A, 0x0D, 0xF0, 0x0F};
+    return (i < sizeof(HEAD)) ? HEAD[i] : (uint8_t)(i * 37 + 11);
+}
+
+void AtmegaLink::negotiate() {
+    if (_setBaud == nullptr || _serial == nullptr || _neg != NEG_IDLE) return;
+    _negRetryAt = 0;
+    _neg = NEG_CAPS;
+    _negAt = millis();
+    send(CMD_LINK_BAUD_CAPS, nullptr, 0);
+}
+
+// Essayer la plus haute vitesse commune d'index < below
+void AtmegaLink::_tryNext(uint8_t below) {
+    uint8_t common = _peerMask & LINK_BAUD_MASK;
+    for (int8_t idx = (int8_t)below - 1; idx > 0; idx--) {
+        if (!(common & (1 << idx)) || _baudFailures[idx] >= LINK_BAUD_MAX_FAILURES) continue;
+        uint8_t pattern[LINK_BAUD_TEST_LEN];
+        for (uint8_t i = 0; i < LINK_BAUD_TEST_LEN; i++) pattern[i] = _testByte(i);
+        uint8_t sel = (uint8_t)idx;
+        // SET et TEST consécutifs dans la file: le TEST part juste après la bascule
+        if (!send(CMD_LINK_BAUD_SET, &sel, 1)) break;
+        if (!send(CMD_LINK_BAUD_TEST, pattern, LINK_BAUD_TEST_LEN)) break;
+        _tryIdx = sel;
+        _neg = NEG_SWITCH;
+        _negAt = millis();
+        return;
+    }
+    _neg = NEG_IDLE;  // Rester à la vitesse courante
+}
+
+void AtmegaLink::_applyBaud(uint8_t idx) {
+    if (idx == _baudIdx || _setBaud == nullptr) return;
+    _serial->flush();
+    _setBaud(LINK_BAUDS[idx]);
+    _baudIdx = idx;
+    _rxLen = 0;
+    _rxOverflow = false;
+    _rxBadRun = 0;
+}
+
+void AtmegaLink::_onAcked(uint8_t cmd) {
+    if (cmd == CMD_LINK_BAUD_SET && _neg == NEG_SWITCH) {
+        _applyBaud(_tryIdx);
+        _neg = NEG_TEST;
+        _negAt = millis();
+        _testStartUs = micros();
+    }
+}
+
+// Trame abandonnée (cmd) ou réception illisible (cmd = 0)
+void AtmegaLink::_onDropped(uint8_t cmd) {
+    if (_neg == NEG_TEST && (cmd == CMD_LINK_BAUD_TEST || cmd == 0)) {
+        _failTest(1);
+        return;
+    }
+    if (_baudIdx != 0 && _neg == NEG_IDLE) {
+        // Vitesse non tenue en fonctionnement: repli, nouvel essai plus tard
+        if (_baudFailures[_baudIdx] < LINK_BAUD_MAX_FAILURES) _baudFailures[_baudIdx]++;
+        LOG_W(LOGF_LINK_BAUD_FAIL, baud(), 3u, LINK_BAUDS[0]);
+        _applyBaud(0);
+        _scheduleNegotiation();
+    }
+}
+
+// L'ATmega revient seul à 9600 sur erreurs de ligne dès notre prochaine trame
+void AtmegaLink::_failTest(uint8_t reason) {
+    LOG_W(LOGF_LINK_BAUD_FAIL, LINK_BAUDS[_tryIdx], reason, LINK_BAUDS[0]);
+    _baudFailures[_tryIdx] = LINK_BAUD_MAX_FAILURES;
+    _applyBaud(0);
+    _tryNext(_tryIdx);  // SET suivant à 9600, réémis jusqu'au retour de l'ATmega
+}
+
+void AtmegaLink::_scheduleNegotiation() {
+    _negRetryAt = millis() + LINK_NEGOTIATE_RETRY_MS;
+    if (_negRetryAt == 0) _negRetryAt = 1;
+}
+
+void AtmegaLink::_negotiationPoll() {
+    unsigned long now = millis();
+    if (_neg == NEG_IDLE) {
+        if (_negRetryAt != 0 && (long)(now - _negRetryAt) >= 0) negotiate();
+        return;
+    }
+    if (now - _negAt < LINK_NEGOTIATE_TIMEOUT_MS) return;
+    if (_neg == NEG_TEST) {
+        _failTest(1);  // ACK du TEST reçu mais pas d'écho
+        return;
+    }
+    // CAPS sans réponse ou SET jamais acquitté: ATmega absent / pas encore démarré
+    LOG_W(LOGF_LINK_BAUD_NO_PEER, (unsigned)LINK_NEGOTIATE_RETRY_MS);
+    _neg = NEG_IDLE;
+    _scheduleNegotiation();
+}
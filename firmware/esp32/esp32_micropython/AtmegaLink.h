@@ -0,0 +1,161 @@
+/*
+ * AtmegaLink.h — Protocole tramé UART ESP32 <-> ATmega
+ *
+ * Trame brute: [SEQ][CMD][LEN][DATA × LEN][CRC16 lo][CRC16 hi]
+ *   - CRC-16/CCITT réfléchi (init 0xFFFF, = _crc_ccitt_update avr-libc) sur SEQ..DATA
+ *   - Encodage COBS (aucun 0x00 dans la trame) puis délimiteur 0x00
+ *
+ * ESP32 → ATmega: chaque commande est acquittée (CMD_LINK_ACK [seq]).
+ *   Stop-and-wait non bloquant: poll() retransmet sur timeout ou NACK,
+ *   LINK_MAX_RETRIES fois au plus. L'ATmega ignore les doublons (même SEQ).
+ * ATmega → ESP32: réponses et logs, non acquittés (l'ESP32 redemande au besoin).
+ * Santé: compteurs des deux côtés, ping périodique (histogramme RTT) et
+ *   trame d'état compacte de l'ATmega (CMD_LINK_STATUS), voir stats()/peer().
+ * Écriture jamais bloquante (pas de flush): une trame n'est écrite que si le
+ * tampon TX du port a la place (availableForWrite), sinon reportée au poll().
+ *
+ * Vitesse: négociée au boot à partir de ATMEGA_UART_BAUD (negotiate()):
+ *   CAPS (vitesses de l'ATmega) → SET [index] + TEST [motif] en file;
+ *   l'ACK du SET fait basculer l'ESP32, l'écho du motif confirme la vitesse.
+ *   Échec du test ou erreurs répétées → retour à 9600 des deux côtés
+ *   (l'ATmega revient seul sur erreurs de ligne) puis vitesse inférieure.
+ */
+#ifndef ATMEGA_LINK_H
+#define ATMEGA_LINK_H
+
+#include "Config.h"
+
+#define LINK_ENCODED_MAX (LINK_FRAME_MAX + LINK_FRAME_MAX / 254 + 2)  // COBS + délimiteur
+#define LINK_TX_QUEUE 8
+#define LINK_BAUD_TEST_LEN LINK_MAX_PAYLOAD
+#define LINK_NEGOTIATE_TIMEOUT_MS (LINK_ACK_TIMEOUT_MS * (LINK_MAX_RETRIES + 2))
+#define LINK_RTT_BUCKETS 8  // Bornes supérieures: LINK_RTT_EDGES_MS, dernier = au-delà
+#define LINK_RTT_EDGES_MS {1, 2, 5, 10, 20, 50, 100}
+
+class AtmegaLink {
+public:
+    // Retourne false si la commande est inconnue (comptée dans stats().unknownCmds)
+    using FrameCallback = bool (*)(uint8_t cmd, const uint8_t* payload, uint8_t len);
+    using BaudSetter = void (*)(uint32_t baud);
+
+    void begin(Stream* serial);
+    void setFrameCallback(FrameCallback cb) { _frameCb = cb; }
+    // Sans setter (ex: Stream non matériel), la vitesse reste ATMEGA_UART_BAUD
+    void setBaudSetter(BaudSetter fn) { _setBaud = fn; }
+    // (Re)lance la négociation de vitesse (non bloquant, suivi dans poll())
+    void negotiate();
+    uint32_t baud() const;
+
+    // Met la commande en file (false si file pleine ou payload trop grand)
+    bool send(uint8_t cmd, const uint8_t* payload, uint8_t len);
+    // À appeler dans loop(): réception, ACK/NACK, retransmissions
+    void poll();
+
+    bool idle() const { return _qCount == 0; }
+    uint8_t queueFree() const { return LINK_TX_QUEUE - _qCount; }
+    bool negotiating() const { return _neg != NEG_IDLE; }
+
+    // Compteurs côté ESP32 (depuis le boot)
+    struct Stats {
+        uint32_t txFrames;       // Trames écrites (retransmissions comprises)
+        uint32_t rxFrames;       // Trames valides reçues
+        uint32_t crcErrors;
+        uint32_t framingErrors;  // COBS ou longueur invalide
+        uint32_t rxOverruns;     // Trame plus longue que le tampon RX
+        uint32_t dropped;        // Abandonnées après LINK_MAX_RETRIES
+        uint32_t retries;
+        uint32_t nacks;          // NACK reçus
+        uint32_t unknownCmds;
+        uint32_t txStalls;       // Contre-pression: écritures reportées (tampon TX plein)
+        uint32_t queueFull;      // Contre-pression: send() refusés (file pleine)
+        // Ping (CMD_LINK_PING toutes les LINK_PING_INTERVAL_MS)
+        uint32_t pings;
+        uint32_t pingsLost;
+        uint32_t rttMinUs;
+        uint32_t rttMaxUs;
+        uint64_t rttSumUs;
+        uint32_t rttHist[LINK_RTT_BUCKETS];
+    };
+    // Dernière trame d'état de l'ATmega (CMD_LINK_STATUS, LinkStatusMsg)
+    struct PeerStatus : LinkStatus {
+        bool valid;
+        unsigned long receivedAt;  // millis()
+    };
+    const Stats& stats() const { return _stats; }
+    const PeerStatus& peer() const { return _peer; }
+
+    static uint16_t crc16(const uint8_t* data, uint16_t len);
+    static uint16_t cobsEncode(const uint8_t* in, uint16_t len, uint8_t* out);
+    static uint16_t cobsDecode(uint8_t* buf, uint16_t len);  // En place, 0 = invalide
+
+private:
+    struct TxSlot {
+        uint8_t cmd;
+        uint8_t len;
+        uint8_t payload[LINK_MAX_PAYLOAD];
+    };
+
+    enum NegState : uint8_t { NEG_IDLE, NEG_CAPS, NEG_SWITCH, NEG_TEST };
+
+    Stream* _serial = nullptr;
+    FrameCallback _frameCb = nullptr;
+    BaudSetter _setBaud = nullptr;
+
+    TxSlot _queue[LINK_TX_QUEUE];
+    uint8_t _qHead = 0;
+    uint8_t _qCount = 0;
+    uint8_t _nextSeq = 0;
+    bool _inFlight = false;
+    uint8_t _inFlightSeq = 0;
+    uint8_t _retries = 0;
+    bool _overflowNacked = false;  // NACK [0, OVERFLOW] déjà compté pour l'émission en cours
+    unsigned long _sentAt = 0;
+    bool _txBlocked = false;  // Tête prête mais pas encore écrite (tampon TX plein)
+    Stats _stats = {};
+    PeerStatus _peer = {};
+    uint32_t _reportedStalls = 0;
+    uint32_t _reportedQueueFull = 0;
+
+    uint8_t _rxBuf[LINK_ENCODED_MAX];
+    uint16_t _rxLen = 0;
+    bool _rxOverflow = false;
+    uint8_t _rxBadRun = 0;
+
+    // Négociation
+    NegState _neg = NEG_IDLE;
+    uint8_t _baudIdx = 0;
+    uint8_t _tryIdx = 0;
+    uint8_t _peerMask = 0;
+    uint8_t _baudFailures[LINK_BAUD_COUNT] = {};
+    unsigned long _negAt = 0;
+    unsigned long _negRetryAt = 0;  // 0 = aucun essai programmé
+    uint32_t _testStartUs = 0;
+
+    // Débit effectif (fenêtre LINK_STATS_PERIOD_MS)
+    unsigned long _statsAt = 0;
+    uint32_t _statPayload = 0;  // Octets utiles acquittés
+    uint32_t _statWire = 0;     // Octets émis (COBS, retransmissions comprises)
+
+    // Ping
+    unsigned long _pingAt = 0;  // millis() du dernier ping mis en file
+    uint32_t _pingToken = 0;
+    uint32_t _pingSentUs = 0;   // micros() à l'écriture effective
+    bool _pingOutstanding = false;
+
+    void _transmitHead();
+    void _popHead();
+    void _handleFrame(uint8_t* frame, uint16_t len);
+    void _onAcked(uint8_t cmd);
+    void _onDropped(uint8_t cmd);
+    void _tryNext(uint8_t below);
+    void _failTest(uint8_t reason);
+    void _applyBaud(uint8_t idx);
+    void _scheduleNegotiation();
+    void _negotiationPoll();
+    void _healthPoll();
+    void _onPingReply(const uint8_t* payload, uint8_t len);
+    void _onPeerStatus(const uint8_t* payload, uint8_t len);
+    static uint8_t _testByte(uint8_t i);
+};
+
+#endif // ATMEGA_LINK_H
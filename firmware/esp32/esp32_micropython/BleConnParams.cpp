@@ -0,0 +1,140 @@
+/*
+ * BleConnParams.cpp — Choix du mode, demandes et comptes de temps radio
+ */
+#include "BleConnParams.h"
+#include "Log.h"
+
+static const char* const MODE_NAMES[] = {"host", "active", "idle"};
+
+const char* BleConnParams::modeName(Mode m) {
+    return (m <= IDLE) ? MODE_NAMES[m] : "?";
+}
+
+BleConnParams::Mode BleConnParams::classify(const Params& p) {
+    if (p.interval >= BLE_CONN_ACTIVE_MIN && p.interval <= BLE_CONN_FALLBACK_MAX && p.latency == 0) return ACTIVE;
+    if (p.interval >= BLE_CONN_IDLE_MIN && p.latency > 0) return IDLE;
+    return HOST;
+}
+
+static uint32_t event_period_us(const BleConnParams::Params& p) {
+    return (uint32_t)p.interval * 1250 * ((uint32_t)p.latency + 1);
+}
+
+uint32_t BleConnParams::dutyPpm(const Params& p) {
+    uint32_t periodUs = event_period_us(p);
+    return periodUs ? (uint32_t)((uint64_t)BLE_CONN_EVENT_US * 1000000 / periodUs) : 0;
+}
+
+uint32_t BleConnParams::averageDutyPpm() const {
+    return _stats.connectedMs ? (uint32_t)(_stats.radioUs * 1000 / _stats.connectedMs) : 0;
+}
+
+BleConnParams::Params BleConnParams::current() const {
+    portENTER_CRITICAL(&_mux);
+    Params p = _params;
+    portEXIT_CRITICAL(&_mux);
+    return p;
+}
+
+void BleConnParams::onConnect(const Params& p) {
+    portENTER_CRITICAL(&_mux);
+    _params = p;
+    _connected = true;
+    _connectEvent = true;
+    _updateEvent = false;
+    portEXIT_CRITICAL(&_mux);
+    LOG_I(LOGF_BLE_CONN_OPEN, (unsigned)p.interval * 1250, p.latency, (unsigned)p.timeout * 10, dutyPpm(p));
+}
+
+void BleConnParams::onDisconnect() {
+    portENTER_CRITICAL(&_mux);
+    _connected = false;
+    portEXIT_CRITICAL(&_mux);
+}
+
+void BleConnParams::onUpdate(uint8_t status, const Params& p) {
+    portENTER_CRITICAL(&_mux);
+    if (status == 0) _params = p;
+    _updateStatus = status;
+    _updateEvent = true;
+    portEXIT_CRITICAL(&_mux);
+    LOG_I(LOGF_BLE_CONN_UPDATED, (unsigned)p.interval * 1250, p.latency, (unsigned)p.timeout * 10, status,
+          dutyPpm(p));
+}
+
+void BleConnParams::_account(uint32_t nowMs, const Params& p) {
+    uint32_t elapsed = nowMs - _accountMs;
+    _accountMs = nowMs;
+    if (elapsed == 0 || p.interval == 0) return;
+    _stats.connectedMs += elapsed;
+    if (p.interval <= BLE_CONN_FALLBACK_MAX) _stats.activeMs += elapsed;
+    _stats.radioUs += (uint64_t)elapsed * 1000 * BLE_CONN_EVENT_US / event_period_us(p);
+}
+
+void BleConnParams::_requestMode(Mode m, uint32_t nowMs) {
+    _requested = m;
+    if (!_request) return;
+    bool active = (m == ACTIVE);
+    bool refused = _refused & (1 << m);
+    if (refused && !active) return;  // Repos refusé par cet hôte: ses paramètres restent
+    uint16_t minInt = active ? (refused ? BLE_CONN_FALLBACK_MIN : BLE_CONN_ACTIVE_MIN) : BLE_CONN_IDLE_MIN;
+    uint16_t maxInt = active ? (refused ? BLE_CONN_FALLBACK_MAX : BLE_CONN_ACTIVE_MAX) : BLE_CONN_IDLE_MAX;
+    uint16_t latency = active ? BLE_CONN_ACTIVE_LATENCY : BLE_CONN_IDLE_LATENCY;
+    uint16_t timeout = active ? BLE_CONN_ACTIVE_TIMEOUT : BLE_CONN_IDLE_TIMEOUT;
+    _stats.requests++;
+    _pending = _request(minInt, maxInt, latency, timeout);
+    _requestMs = nowMs;
+    // Trois entiers: le nom du mode garde 7 caractères dans l'enregistrement de log
+    LOG_I(LOGF_BLE_CONN_REQUEST, (unsigned)minInt * 1250, (unsigned)maxInt * 1250, latency, modeName(m));
+}
+
+void BleConnParams::_onRefused() {
+    _stats.rejected++;
+    if (_requested == HOST) return;
+    uint8_t bit = 1 << _requested;
+    if (_requested == ACTIVE && !(_refused & bit)) _requested = HOST;  // Redemandé aussitôt en plage de repli
+    _refused |= bit;
+    // Sinon _requested garde le mode refusé: pas de nouvelle demande identique
+}
+
+void BleConnParams::poll(uint32_t nowMs) {
+    portENTER_CRITICAL(&_mux);
+    bool connected = _connected;
+    bool connectEvent = _connectEvent;
+    bool updateEvent = _updateEvent;
+    uint8_t status = _updateStatus;
+    Params p = _params;
+    _connectEvent = _updateEvent = false;
+    portEXIT_CRITICAL(&_mux);
+
+    if (_wasConnected) _account(nowMs, p);
+    if (connectEvent) {
+        // Nouvelle connexion: paramètres de l'hôte pendant l'appairage et la découverte
+        _requested = HOST;
+        _pending = false;
+        _connectMs = _accountMs = _lastActivityMs = nowMs;
+    }
+    _wasConnected = connected;
+    if (!connected) {
+        _requested = HOST;
+        _pending = false;
+        return;
+    }
+
+    if (updateEvent) {
+        // Réponse à la demande, ou changement décidé par l'hôte (compté aussi)
+        if (status == 0) _stats.accepted++;
+        else if (_pending) _onRefused();
+        else _stats.rejected++;
+        _pending = false;
+    }
+    if (_pending) {
+        if (nowMs - _requestMs < BLE_CONN_UPDATE_WAIT_MS) return;
+        _pending = false;
+        _onRefused();  // Sans réponse (NimBLE ne signale pas les refus): traité comme un refus
+    }
+    if (nowMs - _connectMs < BLE_CONN_SETTLE_MS) return;
+
+    Mode want = (nowMs - _lastActivityMs < BLE_CONN_IDLE_MS) ? ACTIVE : IDLE;
+    if (want != _requested) _requestMode(want, nowMs);
+}
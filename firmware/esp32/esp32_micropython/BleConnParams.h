@@ -0,0 +1,96 @@
+/*
+ * BleConnParams.h — Paramètres de connexion BLE adaptatifs (frappe / repos)
+ *
+ * Tant que touches ou encodeur sont actifs: intervalle court sans latence esclave
+ * (BLE_CONN_ACTIVE_*, 7,5–15 ms). Après BLE_CONN_IDLE_MS sans activité: intervalle long
+ * avec latence esclave (BLE_CONN_IDLE_*), la radio ne se réveille qu'une fois sur
+ * (latence + 1) événements. Une seule demande en cours; un refus de l'hôte n'est pas
+ * répété tant que le mode voulu ne change pas. Un hôte qui refuse l'actif (iOS) reçoit
+ * aussitôt la plage de repli BLE_CONN_FALLBACK_*; les refus sont gardés par hôte
+ * (refused(), mémorisé par BleSlots) pour ne pas les redemander à la reconnexion.
+ *
+ * Indépendant de la pile BLE: la demande passe par un Requester, les événements de
+ * connexion / mise à jour sont fournis par l'appelant (tâche BT). poll() dans loop().
+ * Unités BLE: intervalle en 1,25 ms, latence en événements, timeout en 10 ms.
+ */
+#ifndef BLE_CONN_PARAMS_H
+#define BLE_CONN_PARAMS_H
+
+#include "Config.h"
+
+class BleConnParams {
+public:
+    enum Mode : uint8_t { HOST, ACTIVE, IDLE };  // HOST: paramètres hors des deux profils
+
+    struct Params {
+        uint16_t interval;
+        uint16_t latency;
+        uint16_t timeout;
+    };
+
+    struct Stats {
+        uint32_t requests;
+        uint32_t accepted;       // Mises à jour négociées (status 0)
+        uint32_t rejected;
+        uint32_t connectedMs;
+        uint32_t activeMs;       // Connecté avec un intervalle ≤ BLE_CONN_ACTIVE_MAX
+        uint64_t radioUs;        // Estimation: BLE_CONN_EVENT_US par événement radio
+    };
+
+    using Requester = bool (*)(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout);
+    void setRequester(Requester fn) { _request = fn; }
+
+    // Tâche BT
+    void onConnect(const Params& p);
+    void onDisconnect();
+    void onUpdate(uint8_t status, const Params& p);
+
+    // loop()
+    void onActivity(uint32_t nowMs) { _lastActivityMs = nowMs; }
+    void poll(uint32_t nowMs);
+    // Modes refusés par l'hôte connecté (bit 1 << Mode), à restaurer avant la fin de BLE_CONN_SETTLE_MS
+    void setRefused(uint8_t mask) { _refused = mask; }
+    uint8_t refused() const { return _refused; }
+
+    bool connected() const { return _connected; }
+    Params current() const;
+    Mode mode() const { return classify(current()); }
+    static Mode classify(const Params& p);
+    static const char* modeName(Mode m);
+    const Stats& stats() const { return _stats; }
+
+    // Pire délai d'un rapport: un intervalle (l'esclave peut émettre à chaque événement,
+    // la latence esclave ne retarde pas ses propres envois)
+    static uint32_t reportLatencyUs(const Params& p) { return (uint32_t)p.interval * 1250; }
+    // Part du temps radio estimée (ppm) sans trafic: un événement toutes les (latence + 1)
+    static uint32_t dutyPpm(const Params& p);
+    uint32_t averageDutyPpm() const;
+
+private:
+    void _account(uint32_t nowMs, const Params& p);
+    void _requestMode(Mode m, uint32_t nowMs);
+    void _onRefused();
+
+    Requester _request = nullptr;
+    mutable portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+
+    // Écrits par la tâche BT (sous _mux), consommés par poll()
+    volatile bool _connected = false;
+    bool _connectEvent = false;
+    bool _updateEvent = false;
+    uint8_t _updateStatus = 0;
+    Params _params = {0, 0, 0};
+
+    // loop()
+    Mode _requested = HOST;    // Dernier mode demandé (accordé, en attente ou refusé)
+    uint8_t _refused = 0;
+    bool _pending = false;
+    uint32_t _requestMs = 0;
+    uint32_t _connectMs = 0;
+    uint32_t _lastActivityMs = 0;
+    uint32_t _accountMs = 0;
+    bool _wasConnected = false;
+    Stats _stats = {};
+};
+
+#endif // BLE_CONN_PARAMS_H
@@ -0,0 +1,201 @@
+/*
+ * BleSlots.cpp — Slots d'hôtes liés, acceptation des connexions et publicité
+ */
+#include "BleSlots.h"
+#include "Log.h"
+#include <string.h>
+
+void BleSlots::begin(BleTransport* ble, BleConnParams* conn, uint8_t active, const Slot* slots) {
+    _ble = ble;
+    _conn = conn;
+    _active = (active < BLE_SLOT_COUNT) ? active : 0;
+    if (slots) memcpy(_slots, slots, sizeof(_slots));
+    _adv = ADV_PENDING;
+    _advMs = 0;
+}
+
+void BleSlots::onConnect(const uint8_t* addr) {
+    portENTER_CRITICAL(&_mux);
+    memcpy(_peer, addr, sizeof(_peer));
+    _linkUp = true;
+    _connectEvent = true;
+    portEXIT_CRITICAL(&_mux);
+}
+
+void BleSlots::onDisconnect() {
+    portENTER_CRITICAL(&_mux);
+    _linkUp = false;
+    _disconnectEvent = true;
+    _pairedEvent = false;
+    portEXIT_CRITICAL(&_mux);
+}
+
+void BleSlots::onPaired(const uint8_t* addr, uint8_t addrType, bool bonded) {
+    portENTER_CRITICAL(&_mux);
+    memcpy(_pairedAddr, addr, sizeof(_pairedAddr));
+    _pairedType = addrType;
+    _pairedBonded = bonded;
+    _pairedEvent = true;
+    portEXIT_CRITICAL(&_mux);
+}
+
+int8_t BleSlots::_find(const uint8_t* addr) const {
+    // Adresse seule: Bluedroid ne donne le type qu'à l'appairage
+    for (uint8_t i = 0; i < BLE_SLOT_COUNT; i++) {
+        if (_slots[i].bonded && memcmp(_slots[i].addr, addr, sizeof(_slots[i].addr)) == 0) return i;
+    }
+    return -1;
+}
+
+void BleSlots::_readvertise(uint32_t atMs) {
+    _adv = ADV_PENDING;
+    _advMs = atMs;
+}
+
+void BleSlots::_advertise(uint32_t nowMs) {
+    const Slot& s = _slots[_active];
+    if (s.bonded && _ble->advertiseDirected(s.addr, s.addrType)) {
+        _stats.directed++;
+        _adv = ADV_DIRECTED;
+        _advMs = nowMs + BLE_SLOT_DIRECTED_MS;
+        LOG_I(LOGF_BLE_SLOT_ADV, _active + 1, "directed");
+    } else {
+        _ble->startAdvertising();
+        _adv = ADV_OPEN;
+        LOG_I(LOGF_BLE_SLOT_ADV, _active + 1, "open");
+    }
+}
+
+void BleSlots::poll(uint32_t nowMs) {
+    if (!_ble) return;
+
+    portENTER_CRITICAL(&_mux);
+    bool linkUp = _linkUp;
+    bool connectEvent = _connectEvent;
+    bool disconnectEvent = _disconnectEvent;
+    bool pairedEvent = _pairedEvent;
+    bool pairedBonded = _pairedBonded;
+    uint8_t peer[6], pairedAddr[6];
+    memcpy(peer, _peer, sizeof(peer));
+    memcpy(pairedAddr, _pairedAddr, sizeof(pairedAddr));
+    uint8_t pairedType = _pairedType;
+    _connectEvent = _disconnectEvent = _pairedEvent = false;
+    portEXIT_CRITICAL(&_mux);
+
+    // Déconnexion d'abord: une connexion arrivée depuis n'est prise que si le lien est encore là
+    if (disconnectEvent) {
+        _accepted = false;
+        if (!linkUp) _readvertise(nowMs + BLE_SLOT_READV_MS);
+    }
+
+    if (connectEvent && linkUp) {
+        _adv = ADV_IDLE;  // Les deux piles arrêtent la publicité à la connexion
+        int8_t owner = _find(peer);
+        if (owner >= 0 && owner != _active) {
+            // Hôte lié à un autre slot (reconnexion automatique): refusé, il n'attend pas de frappe
+            _stats.rejected++;
+            LOG_I(LOGF_BLE_SLOT_REJECTED, owner + 1, _active + 1);
+            _ble->disconnect();
+        } else {
+            // Refus mémorisés seulement si l'adresse est déjà celle du slot (sinon: à l'appairage)
+            _accepted = true;
+            _known = (owner == _active);
+            _conn->setRefused(_known ? _slots[_active].refused : 0);
+            if (_switching) {
+                _switching = false;
+                _stats.switches++;
+                _stats.lastSwitchMs = nowMs - _switchMs;
+                LOG_I(LOGF_BLE_SLOT_CONNECTED, _active + 1, _stats.lastSwitchMs);
+            }
+        }
+    }
+
+    if (pairedEvent && linkUp && _accepted && pairedBonded) {
+        // Adresse d'identité connue ici seulement pour un hôte à adresse aléatoire résoluble
+        int8_t owner = _find(pairedAddr);
+        Slot& s = _slots[_active];
+        if (owner >= 0 && owner != _active) {
+            _accepted = false;
+            _stats.rejected++;
+            LOG_I(LOGF_BLE_SLOT_REJECTED, owner + 1, _active + 1);
+            _ble->disconnect();
+        } else if (owner < 0) {
+            // Nouvel hôte du slot: l'ancien perd ses clés (un seul hôte par slot)
+            if (s.bonded) _ble->removeBond(s.addr, s.addrType);
+            s.bonded = 1;
+            s.addrType = pairedType;
+            memcpy(s.addr, pairedAddr, sizeof(s.addr));
+            s.refused = _conn->refused();
+            _known = true;
+            _dirty |= 1 << _active;
+            LOG_I(LOGF_BLE_SLOT_BONDED, _active + 1, pairedType);
+        } else {
+            if (!_known) _conn->setRefused(_conn->refused() | s.refused);
+            _known = true;
+            if (s.addrType != pairedType) {
+                s.addrType = pairedType;   // Bluedroid: type inconnu à la connexion
+                _dirty |= 1 << _active;
+            }
+        }
+    }
+
+    if (_accepted && _known && _conn->refused() != _slots[_active].refused) {
+        _slots[_active].refused = _conn->refused();
+        _dirty |= 1 << _active;
+    }
+
+    if (linkUp) return;
+    if (_adv == ADV_PENDING && (int32_t)(nowMs - _advMs) >= 0) {
+        _advertise(nowMs);
+    } else if (_adv == ADV_DIRECTED && (int32_t)(nowMs - _advMs) >= 0) {
+        // Hôte absent ou pas encore en écoute: publicité ouverte (il s'y reconnecte aussi)
+        _ble->startAdvertising();
+        _adv = ADV_OPEN;
+        LOG_I(LOGF_BLE_SLOT_ADV, _active + 1, "open");
+    }
+}
+
+void BleSlots::select(uint8_t slot, uint32_t nowMs) {
+    if (slot >= BLE_SLOT_COUNT || !_ble) return;
+    if (slot == _active && _accepted) return;
+    if (slot != _active) _dirty |= DIRTY_ACTIVE;
+    _active = slot;
+    _switching = true;
+    _switchMs = nowMs;
+    LOG_I(LOGF_BLE_SLOT_SELECT, slot + 1, _slots[slot].bonded ? "bonded" : "empty");
+
+    portENTER_CRITICAL(&_mux);
+    bool linkUp = _linkUp;
+    portEXIT_CRITICAL(&_mux);
+    _accepted = false;  // Plus aucun rapport vers l'hôte précédent
+    if (linkUp) _ble->disconnect();  // La publicité repart sur la déconnexion
+    else _readvertise(nowMs);
+}
+
+void BleSlots::clear(uint8_t slot, uint32_t nowMs) {
+    if (slot >= BLE_SLOT_COUNT || !_ble) return;
+    Slot& s = _slots[slot];
+    if (s.bonded) _ble->removeBond(s.addr, s.addrType);
+    s.bonded = 0;
+    s.addrType = 0;
+    memset(s.addr, 0, sizeof(s.addr));
+    s.refused = 0;   // Le mode de sortie reste: préférence du slot, pas de l'hôte
+    _dirty |= 1 << slot;
+    LOG_I(LOGF_BLE_SLOT_CLEARED, slot + 1);
+    if (slot == _active) {
+        _accepted = false;  // L'hôte n'a plus de clés: déconnecté, le slot repart en publicité ouverte
+        select(slot, nowMs);
+    }
+}
+
+void BleSlots::setOutput(uint8_t slot, uint8_t output) {
+    if (slot >= BLE_SLOT_COUNT || _slots[slot].output == output) return;
+    _slots[slot].output = output;
+    _dirty |= 1 << slot;
+}
+
+uint8_t BleSlots::takeDirty() {
+    uint8_t d = _dirty;
+    _dirty = 0;
+    return d;
+}
@@ -0,0 +1,93 @@
+/*
+ * BleSlots.h — Hôtes BLE liés (BLE_SLOT_COUNT slots), bascule rapide par publicité dirigée
+ *
+ * Chaque slot garde un hôte lié (adresse d'identité; les clés sont en NVS côté pile),
+ * ses modes de connexion refusés (BleConnParams::refused) et son mode de sortie HID.
+ * select(): déconnexion de l'hôte courant, puis publicité dirigée vers l'hôte du slot
+ * (BLE_SLOT_DIRECTED_MS), puis ouverte. Slot vide: publicité ouverte, le prochain hôte
+ * qui se lie le remplit. Un hôte lié à un autre slot est déconnecté dès sa connexion.
+ *
+ * Indépendant de la pile (BleTransport). onConnect/onDisconnect/onPaired depuis la tâche
+ * BT, poll() et le reste depuis loop(); l'appelant écrit en NVS les slots de takeDirty().
+ */
+#ifndef BLE_SLOTS_H
+#define BLE_SLOTS_H
+
+#include "Config.h"
+#include "BleConnParams.h"
+#include "BleTransport.h"
+
+class BleSlots {
+public:
+    // Enregistrement NVS d'un slot (putBytes): nouveaux champs en fin uniquement
+    struct Slot {
+        uint8_t bonded;      // 1: addr = hôte lié
+        uint8_t addrType;
+        uint8_t addr[6];
+        uint8_t output;      // Mode de sortie HID du slot (HidOutput::Mode)
+        uint8_t refused;     // Modes BleConnParams refusés par cet hôte
+    };
+
+    struct Stats {
+        uint32_t switches;
+        uint32_t lastSwitchMs;   // select() → connexion de l'hôte du slot
+        uint32_t rejected;       // Hôtes d'un autre slot déconnectés
+        uint32_t directed;       // Publicités dirigées lancées
+    };
+
+    static const uint8_t DIRTY_ACTIVE = 0x80;   // takeDirty(): slot actif changé (bits 0.. = slots)
+
+    void begin(BleTransport* ble, BleConnParams* conn, uint8_t active, const Slot* slots);
+
+    // Tâche BT
+    void onConnect(const uint8_t* addr);
+    void onDisconnect();
+    void onPaired(const uint8_t* addr, uint8_t addrType, bool bonded);
+
+    // loop()
+    void poll(uint32_t nowMs);
+    void select(uint8_t slot, uint32_t nowMs);
+    void clear(uint8_t slot, uint32_t nowMs);      // Oublie l'hôte (et ses clés)
+    void setOutput(uint8_t slot, uint8_t output);
+    uint8_t takeDirty();
+
+    uint8_t active() const { return _active; }
+    const Slot& slot(uint8_t i) const { return _slots[i < BLE_SLOT_COUNT ? i : 0]; }
+    bool connected() const { return _accepted; }   // Hôte du slot actif connecté
+    const Stats& stats() const { return _stats; }
+
+private:
+    enum Adv : uint8_t { ADV_IDLE, ADV_PENDING, ADV_DIRECTED, ADV_OPEN };
+
+    int8_t _find(const uint8_t* addr) const;
+    void _readvertise(uint32_t atMs);
+    void _advertise(uint32_t nowMs);
+
+    BleTransport* _ble = nullptr;
+    BleConnParams* _conn = nullptr;
+    Slot _slots[BLE_SLOT_COUNT] = {};
+    uint8_t _active = 0;
+    uint8_t _dirty = 0;
+    mutable portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+
+    // Écrits par la tâche BT (sous _mux), consommés par poll()
+    bool _linkUp = false;
+    bool _connectEvent = false;
+    bool _disconnectEvent = false;
+    bool _pairedEvent = false;
+    bool _pairedBonded = false;
+    uint8_t _peer[6] = {};
+    uint8_t _pairedAddr[6] = {};
+    uint8_t _pairedType = 0;
+
+    // loop()
+    bool _accepted = false;
+    bool _known = false;          // Hôte connecté = hôte lié du slot (refus mémorisés applicables)
+    Adv _adv = ADV_PENDING;       // Après l'init de la pile: publicité selon le slot actif
+    uint32_t _advMs = 0;          // ADV_PENDING: instant de relance; ADV_DIRECTED: fin
+    bool _switching = false;
+    uint32_t _switchMs = 0;
+    Stats _stats = {};
+};
+
+#endif // BLE_SLOTS_H
@@ -0,0 +1,45 @@
+/*
+ * BleTransport.cpp — Descripteurs HID communs, mesures d'init et de débit
+ */
+#include "BleTransport.h"
+#include "Log.h"
+
+const uint8_t BLE_HID_INFO[4] = {0x01, 0x01, 0x00, 0x03};  // HID 1.01, remote wake + normally connectable
+
+const uint8_t BLE_HID_REPORT_MAP[] = {
+    0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x85, 0x01,
+    0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x08,
+    0x81, 0x02, 0x95, 0x01, 0x75, 0x08, 0x81, 0x01, 0x95, 0x06, 0x75, 0x08, 0x15, 0x00, 0x25, 0x81,
+    0x05, 0x07, 0x19, 0x00, 0x29, 0x81, 0x81, 0x00, 0xC0,
+    0x05, 0x0C, 0x09, 0x01, 0xA1, 0x01, 0x85, 0x02,
+    0x15, 0x00, 0x26, 0x9C, 0x02, 0x75, 0x10, 0x95, 0x01, 0x09, 0xE9, 0x09, 0xEA, 0x09, 0xE2, 0x09, 0xB5, 0x09, 0xB6, 0x09, 0xCD, 0x81, 0x00, 0xC0
+};
+const size_t BLE_HID_REPORT_MAP_LEN = sizeof(BLE_HID_REPORT_MAP);
+
+const uint8_t BLE_HID_EMPTY_REPORT[9] = {0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+bool BleTransport::start(const char* name, const Callbacks& cb) {
+    // Tâche d'init sur l'autre cœur que loop(): le delta de tas inclut ce que loop() alloue entre-temps
+    _init.heapBefore = ESP.getFreeHeap();
+    uint32_t t0 = millis();
+    bool ok = begin(name, cb);
+    _init.initMs = millis() - t0;
+    _init.heapAfter = ESP.getFreeHeap();
+    LOG_I(LOGF_BLE_INIT, _init.initMs, heapUsed(), stackName());
+    return ok;
+}
+
+uint16_t BleTransport::benchmark(uint16_t count) {
+    if (count == 0 || !connected()) return 0;
+    uint16_t sent = 0;
+    uint32_t t0 = micros();
+    for (uint16_t i = 0; i < count; i++) {
+        // Rapport vide: aucune touche vue par l'hôte, quel que soit le nombre envoyé
+        if (sendReport(BLE_HID_EMPTY_REPORT, sizeof(BLE_HID_EMPTY_REPORT))) sent++;
+    }
+    uint32_t us = micros() - t0;
+    uint32_t perSec = us ? (uint32_t)((uint64_t)sent * 1000000 / us) : 0;
+    LOG_I(LOGF_BLE_BENCH, sent, count, us, perSec);
+    LOG_I(LOGF_BLE_INIT, _init.initMs, heapUsed(), stackName());
+    return sent;
+}
@@ -0,0 +1,71 @@
+/*
+ * BleTransport.h — Transport BLE (rapports HID + console série) derrière une interface
+ *
+ * Une implémentation par pile, choisie à la compilation (BLE_STACK dans Config.h):
+ * BleTransportBluedroid.cpp (BLEDevice d'arduino-esp32) ou BleTransportNimBLE.cpp
+ * (NimBLE-Arduino 2.x). Le reste du firmware (HidOutput, BleConnParams, console web)
+ * ne voit que cette interface; la simulation hôte fournit la sienne (sim/sim_ble.cpp).
+ *
+ * Les Callbacks sont appelés depuis la tâche de la pile BLE: pas de travail long.
+ * Unités BLE des paramètres de connexion: voir BleConnParams.h.
+ */
+#ifndef BLE_TRANSPORT_H
+#define BLE_TRANSPORT_H
+
+#include "Config.h"
+
+// Service HID commun aux piles: HID Information, Report Map (clavier id 1, consumer id 2)
+extern const uint8_t BLE_HID_INFO[4];
+extern const uint8_t BLE_HID_REPORT_MAP[];
+extern const size_t BLE_HID_REPORT_MAP_LEN;
+extern const uint8_t BLE_HID_EMPTY_REPORT[9];   // Clavier, aucune touche
+
+class BleTransport {
+public:
+    struct Callbacks {
+        // addr: adresse de l'hôte, 6 octets dans l'ordre de la pile (identité si l'hôte est lié)
+        void (*connected)(const uint8_t* addr, uint8_t addrType, uint16_t interval, uint16_t latency,
+                          uint16_t timeout);
+        void (*disconnected)();
+        // Fin d'appairage ou de reprise du chiffrement; bonded: clés gardées en NVS par la pile
+        void (*paired)(const uint8_t* addr, uint8_t addrType, bool bonded);
+        void (*connParamsUpdated)(uint8_t status, uint16_t interval, uint16_t latency, uint16_t timeout);
+        void (*serialReceived)(const uint8_t* data, size_t len);
+    };
+
+    struct InitStats {
+        uint32_t initMs;       // begin(): pile, services GATT, advertising
+        uint32_t heapBefore;   // Tas libre avant / après begin()
+        uint32_t heapAfter;
+    };
+
+    virtual ~BleTransport() {}
+
+    virtual const char* stackName() const = 0;
+    virtual bool begin(const char* name, const Callbacks& cb) = 0;
+    virtual bool connected() const = 0;
+    virtual bool sendReport(const uint8_t* report, size_t len) = 0;    // Caractéristique 0x2A4D
+    virtual bool sendSerial(const uint8_t* data, size_t len) = 0;      // BLE_CHAR_SERIAL
+    virtual void startAdvertising() = 0;                               // Ouverte: tout hôte
+    virtual bool advertiseDirected(const uint8_t* addr, uint8_t addrType) = 0;  // Haute fréquence, ≤ 1,28 s
+    virtual void disconnect() = 0;
+    virtual void removeBond(const uint8_t* addr, uint8_t addrType) = 0;
+    virtual bool requestConnParams(uint16_t minInterval, uint16_t maxInterval, uint16_t latency,
+                                   uint16_t timeout) = 0;
+
+    // begin() chronométré, tas libre avant / après → [BLE] Init (comparaison des piles)
+    bool start(const char* name, const Callbacks& cb);
+    const InitStats& initStats() const { return _init; }
+    uint32_t heapUsed() const { return (_init.heapBefore > _init.heapAfter) ? _init.heapBefore - _init.heapAfter : 0; }
+    // count rapports vides notifiés d'affilée → [BLE] Notify bench, puis rappel de [BLE] Init;
+    // rend le nombre de rapports acceptés par la pile
+    uint16_t benchmark(uint16_t count);
+
+protected:
+    InitStats _init = {};
+};
+
+// Implémentation compilée (une seule par firmware)
+BleTransport& bleTransport();
+
+#endif // BLE_TRANSPORT_H
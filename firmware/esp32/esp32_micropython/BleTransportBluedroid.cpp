@@ -0,0 +1,233 @@
+/*
+ * BleTransportBluedroid.cpp — BleTransport sur Bluedroid (BLEDevice d'arduino-esp32)
+ *
+ * Compatible Android, Windows, iOS. Pile la plus lourde: ~100 ko de tas, init de
+ * plusieurs centaines de ms (tâche de fond au boot).
+ */
+#include "BleTransport.h"
+
+#if BLE_STACK == BLE_STACK_BLUEDROID
+
+#include <BLEDevice.h>
+#include <BLEServer.h>
+#include <BLEUtils.h>
+#include <BLE2902.h>
+
+class BleTransportBluedroid : public BleTransport {
+public:
+    const char* stackName() const override { return "bluedroid"; }
+    bool begin(const char* name, const Callbacks& cb) override;
+    bool connected() const override { return _connected; }
+    bool sendReport(const uint8_t* report, size_t len) override;
+    bool sendSerial(const uint8_t* data, size_t len) override;
+    void startAdvertising() override;
+    bool advertiseDirected(const uint8_t* addr, uint8_t addrType) override;
+    void disconnect() override;
+    void removeBond(const uint8_t* addr, uint8_t addrType) override;
+    bool requestConnParams(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout) override;
+
+private:
+    class ServerCallbacks : public BLEServerCallbacks {
+    public:
+        explicit ServerCallbacks(BleTransportBluedroid* t) : _t(t) {}
+        // Appelé avec onConnect(pSrv): adresse de l'hôte et paramètres de départ
+        void onConnect(BLEServer* pSrv, esp_ble_gatts_cb_param_t* param) override;
+        void onDisconnect(BLEServer* pSrv) override;
+    private:
+        BleTransportBluedroid* _t;
+    };
+
+    class SerialCallbacks : public BLECharacteristicCallbacks {
+    public:
+        explicit SerialCallbacks(BleTransportBluedroid* t) : _t(t) {}
+        void onWrite(BLECharacteristic* pCharacteristic) override;
+    private:
+        BleTransportBluedroid* _t;
+    };
+
+    // Appairage "Just Works" avec liaison: tout accepter, signaler la fin
+    class SecurityCallbacks : public BLESecurityCallbacks {
+    public:
+        explicit SecurityCallbacks(BleTransportBluedroid* t) : _t(t) {}
+        uint32_t onPassKeyRequest() override { return 0; }
+        void onPassKeyNotify(uint32_t passKey) override {}
+        bool onConfirmPIN(uint32_t pin) override { return true; }
+        bool onSecurityRequest() override { return true; }
+        void onAuthenticationComplete(esp_ble_auth_cmpl_t cmpl) override;
+    private:
+        BleTransportBluedroid* _t;
+    };
+
+    static void _gapEvent(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t* param);
+
+    Callbacks _cb = {};
+    BLEServer* _server = nullptr;
+    BLECharacteristic* _input = nullptr;
+    BLECharacteristic* _serial = nullptr;
+    esp_bd_addr_t _remoteBda = {0};   // Hôte connecté (demandes de paramètres de connexion)
+    volatile bool _connected = false;
+};
+
+static BleTransportBluedroid transport;
+
+BleTransport& bleTransport() { return transport; }
+
+void BleTransportBluedroid::ServerCallbacks::onConnect(BLEServer* pSrv, esp_ble_gatts_cb_param_t* param) {
+    memcpy(_t->_remoteBda, param->connect.remote_bda, sizeof(esp_bd_addr_t));
+    _t->_connected = true;
+    if (_t->_cb.connected) {
+        // IDF 4.4: pas de type d'adresse à la connexion (connu à la fin de l'appairage)
+        _t->_cb.connected(_t->_remoteBda, BLE_ADDR_TYPE_PUBLIC, param->connect.conn_params.interval,
+                          param->connect.conn_params.latency, param->connect.conn_params.timeout);
+    }
+}
+
+void BleTransportBluedroid::ServerCallbacks::onDisconnect(BLEServer* pSrv) {
+    _t->_connected = false;
+    if (_t->_cb.disconnected) _t->_cb.disconnected();
+}
+
+void BleTransportBluedroid::SerialCallbacks::onWrite(BLECharacteristic* pCharacteristic) {
+    String value = pCharacteristic->getValue();
+    if (value.length() > 0 && _t->_cb.serialReceived) {
+        _t->_cb.serialReceived((const uint8_t*)value.c_str(), value.length());
+    }
+}
+
+void BleTransportBluedroid::SecurityCallbacks::onAuthenticationComplete(esp_ble_auth_cmpl_t cmpl) {
+    if (!_t->_cb.paired) return;
+    bool bonded = cmpl.success && (cmpl.auth_mode & ESP_LE_AUTH_BOND);
+    _t->_cb.paired(cmpl.bd_addr, cmpl.addr_type, bonded);
+}
+
+// Résultat de chaque négociation de paramètres (demandée par le firmware ou par l'hôte)
+void BleTransportBluedroid::_gapEvent(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t* param) {
+    if (event != ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT || !transport._cb.connParamsUpdated) return;
+    transport._cb.connParamsUpdated(param->update_conn_params.status, param->update_conn_params.conn_int,
+                                    param->update_conn_params.latency, param->update_conn_params.timeout);
+}
+
+bool BleTransportBluedroid::begin(const char* name, const Callbacks& cb) {
+    _cb = cb;
+    try {
+        BLEDevice::init(name);
+        BLEDevice::setCustomGapHandler(_gapEvent);
+
+        // Sécurité BLE — "Just Works" (pas d'écran) avec liaison: les clés restent en NVS,
+        // un hôte déjà lié se reconnecte sans nouvel appairage (BleSlots). Clé d'identité
+        // (IRK) échangée: adresse aléatoire de l'hôte résolue vers son adresse d'identité.
+        BLEDevice::setSecurityCallbacks(new SecurityCallbacks(this));
+        BLESecurity* pSecurity = new BLESecurity();
+        pSecurity->setAuthenticationMode(ESP_LE_AUTH_BOND);
+        pSecurity->setCapability(ESP_IO_CAP_NONE);
+        pSecurity->setInitEncryptionKey(ESP_BLE_ENC_KEY_MASK | ESP_BLE_ID_KEY_MASK);
+        pSecurity->setRespEncryptionKey(ESP_BLE_ENC_KEY_MASK | ESP_BLE_ID_KEY_MASK);
+        _server = BLEDevice::createServer();
+        _server->setCallbacks(new ServerCallbacks(this));
+
+        BLEService* pService = _server->createService(BLEUUID((uint16_t)0x1812));
+        BLECharacteristic* pInfo = pService->createCharacteristic(BLEUUID((uint16_t)0x2A4A), BLECharacteristic::PROPERTY_READ);
+        pInfo->setValue((uint8_t*)BLE_HID_INFO, sizeof(BLE_HID_INFO));
+        BLECharacteristic* pMap = pService->createCharacteristic(BLEUUID((uint16_t)0x2A4B), BLECharacteristic::PROPERTY_READ);
+        pMap->setValue((uint8_t*)BLE_HID_REPORT_MAP, BLE_HID_REPORT_MAP_LEN);
+        uint8_t proto = 0x01;
+        BLECharacteristic* pProto = pService->createCharacteristic(BLEUUID((uint16_t)0x2A4E), BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_WRITE_NR);
+        pProto->setValue(&proto, 1);
+        uint8_t ctrl = 0x00;
+        BLECharacteristic* pCtrl = pService->createCharacteristic(BLEUUID((uint16_t)0x2A4C), BLECharacteristic::PROPERTY_WRITE_NR);
+        pCtrl->setValue(&ctrl, 1);
+        _input = pService->createCharacteristic(BLEUUID((uint16_t)0x2A4D), BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY | BLECharacteristic::PROPERTY_WRITE_NR);
+        _input->addDescriptor(new BLE2902());
+        _input->setValue((uint8_t*)BLE_HID_EMPTY_REPORT, sizeof(BLE_HID_EMPTY_REPORT));
+        pService->start();
+
+        BLEService* pDevInfo = _server->createService(BLEUUID((uint16_t)0x180A));
+        BLECharacteristic* pMfr = pDevInfo->createCharacteristic(BLEUUID((uint16_t)0x2A29), BLECharacteristic::PROPERTY_READ);
+        pMfr->setValue("Macropad");
+        BLECharacteristic* pModel = pDevInfo->createCharacteristic(BLEUUID((uint16_t)0x2A24), BLECharacteristic::PROPERTY_READ);
+        pModel->setValue("Keyboard");
+        pDevInfo->start();
+
+        BLEService* pBat = _server->createService(BLEUUID((uint16_t)0x180F));
+        BLECharacteristic* pBatLev = pBat->createCharacteristic(BLEUUID((uint16_t)0x2A19), BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY);
+        pBatLev->addDescriptor(new BLE2902());
+        uint8_t bat = 100;
+        pBatLev->setValue(&bat, 1);
+        pBat->start();
+
+        BLEService* pSerialSvc = _server->createService(BLEUUID(BLE_SVC_SERIAL));
+        _serial = pSerialSvc->createCharacteristic(BLEUUID(BLE_CHAR_SERIAL), BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_WRITE | BLECharacteristic::PROPERTY_NOTIFY | BLECharacteristic::PROPERTY_WRITE_NR);
+        _serial->addDescriptor(new BLE2902());
+        _serial->setCallbacks(new SerialCallbacks(this));
+        pSerialSvc->start();
+
+        BLEAdvertising* pAdvertising = BLEDevice::getAdvertising();
+        pAdvertising->addServiceUUID(BLEUUID((uint16_t)0x1812));
+        pAdvertising->addServiceUUID(BLEUUID((uint16_t)0x180A));
+        pAdvertising->addServiceUUID(BLEUUID((uint16_t)0x180F));
+        pAdvertising->addServiceUUID(BLEUUID(BLE_SVC_SERIAL));
+        pAdvertising->setScanResponse(true);
+        pAdvertising->setMinPreferred(0x06);
+        pAdvertising->setMaxPreferred(0x12);
+        BLEDevice::startAdvertising();
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+void BleTransportBluedroid::startAdvertising() {
+    BLEDevice::getAdvertising()->stop();  // Publicité dirigée éventuellement encore en cours
+    BLEDevice::startAdvertising();
+}
+
+bool BleTransportBluedroid::advertiseDirected(const uint8_t* addr, uint8_t addrType) {
+    BLEDevice::getAdvertising()->stop();
+    esp_ble_adv_params_t params = {};
+    params.adv_int_min = 0x20;  // Ignorés en haute fréquence (≤ 3,75 ms imposé par le contrôleur)
+    params.adv_int_max = 0x20;
+    params.adv_type = ADV_TYPE_DIRECT_IND_HIGH;
+    params.own_addr_type = BLE_ADDR_TYPE_PUBLIC;
+    memcpy(params.peer_addr, addr, sizeof(esp_bd_addr_t));
+    params.peer_addr_type = (esp_ble_addr_type_t)addrType;
+    params.channel_map = ADV_CHNL_ALL;
+    params.adv_filter_policy = ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY;
+    return esp_ble_gap_start_advertising(&params) == ESP_OK;
+}
+
+void BleTransportBluedroid::disconnect() {
+    if (_server && _connected) _server->disconnect(_server->getConnId());
+}
+
+void BleTransportBluedroid::removeBond(const uint8_t* addr, uint8_t addrType) {
+    esp_bd_addr_t bda;
+    memcpy(bda, addr, sizeof(esp_bd_addr_t));
+    esp_ble_remove_bond_device(bda);
+}
+
+bool BleTransportBluedroid::sendReport(const uint8_t* report, size_t len) {
+    if (!_input) return false;
+    _input->setValue((uint8_t*)report, len);
+    _input->notify();
+    return true;
+}
+
+bool BleTransportBluedroid::sendSerial(const uint8_t* data, size_t len) {
+    if (!_serial || !_connected) return false;
+    _serial->setValue((uint8_t*)data, len);
+    _serial->notify();
+    return true;
+}
+
+bool BleTransportBluedroid::requestConnParams(uint16_t minInterval, uint16_t maxInterval, uint16_t latency,
+                                              uint16_t timeout) {
+    esp_ble_conn_update_params_t params;
+    memcpy(params.bda, _remoteBda, sizeof(esp_bd_addr_t));
+    params.min_int = minInterval;
+    params.max_int = maxInterval;
+    params.latency = latency;
+    params.timeout = timeout;
+    return esp_ble_gap_update_conn_params(&params) == ESP_OK;
+}
+
+#endif // BLE_STACK == BLE_STACK_BLUEDROID
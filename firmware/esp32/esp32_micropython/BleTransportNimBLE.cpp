@@ -0,0 +1,190 @@
+/*
+ * BleTransportNimBLE.cpp — BleTransport sur NimBLE (bibliothèque NimBLE-Arduino 2.x)
+ *
+ * Même GATT que Bluedroid (HID, Device Info, batterie, série). Pile hôte plus légère:
+ * moins de tas et init plus courte, à vérifier sur cible avec [BLE] Init et {"type":"ble_bench"}.
+ * Compilée avec -DBLE_STACK=BLE_STACK_NIMBLE (voir Config.h).
+ */
+#include "BleTransport.h"
+
+#if BLE_STACK == BLE_STACK_NIMBLE
+
+#include <NimBLEDevice.h>
+
+class BleTransportNimBLE : public BleTransport {
+public:
+    const char* stackName() const override { return "nimble"; }
+    bool begin(const char* name, const Callbacks& cb) override;
+    bool connected() const override { return _connected; }
+    bool sendReport(const uint8_t* report, size_t len) override;
+    bool sendSerial(const uint8_t* data, size_t len) override;
+    void startAdvertising() override;
+    bool advertiseDirected(const uint8_t* addr, uint8_t addrType) override;
+    void disconnect() override;
+    void removeBond(const uint8_t* addr, uint8_t addrType) override;
+    bool requestConnParams(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout) override;
+
+private:
+    class ServerCallbacks : public NimBLEServerCallbacks {
+    public:
+        explicit ServerCallbacks(BleTransportNimBLE* t) : _t(t) {}
+        void onConnect(NimBLEServer* pSrv, NimBLEConnInfo& info) override;
+        void onDisconnect(NimBLEServer* pSrv, NimBLEConnInfo& info, int reason) override;
+        // Appelé seulement sur succès: un refus de l'hôte passe par BLE_CONN_UPDATE_WAIT_MS
+        void onConnParamsUpdate(NimBLEConnInfo& info) override;
+        void onAuthenticationComplete(NimBLEConnInfo& info) override;
+    private:
+        BleTransportNimBLE* _t;
+    };
+
+    class SerialCallbacks : public NimBLECharacteristicCallbacks {
+    public:
+        explicit SerialCallbacks(BleTransportNimBLE* t) : _t(t) {}
+        void onWrite(NimBLECharacteristic* pCharacteristic, NimBLEConnInfo& info) override;
+    private:
+        BleTransportNimBLE* _t;
+    };
+
+    Callbacks _cb = {};
+    NimBLEServer* _server = nullptr;
+    NimBLECharacteristic* _input = nullptr;
+    NimBLECharacteristic* _serial = nullptr;
+    uint16_t _connHandle = 0;
+    volatile bool _connected = false;
+};
+
+static BleTransportNimBLE transport;
+
+BleTransport& bleTransport() { return transport; }
+
+void BleTransportNimBLE::ServerCallbacks::onConnect(NimBLEServer* pSrv, NimBLEConnInfo& info) {
+    _t->_connHandle = info.getConnHandle();
+    _t->_connected = true;
+    if (_t->_cb.connected) {
+        NimBLEAddress id = info.getIdAddress();
+        _t->_cb.connected(id.getVal(), id.getType(), info.getConnInterval(), info.getConnLatency(),
+                          info.getConnTimeout());
+    }
+}
+
+void BleTransportNimBLE::ServerCallbacks::onDisconnect(NimBLEServer* pSrv, NimBLEConnInfo& info, int reason) {
+    _t->_connected = false;
+    if (_t->_cb.disconnected) _t->_cb.disconnected();
+}
+
+void BleTransportNimBLE::ServerCallbacks::onConnParamsUpdate(NimBLEConnInfo& info) {
+    if (_t->_cb.connParamsUpdated) {
+        _t->_cb.connParamsUpdated(0, info.getConnInterval(), info.getConnLatency(), info.getConnTimeout());
+    }
+}
+
+void BleTransportNimBLE::ServerCallbacks::onAuthenticationComplete(NimBLEConnInfo& info) {
+    if (!_t->_cb.paired) return;
+    NimBLEAddress id = info.getIdAddress();
+    _t->_cb.paired(id.getVal(), id.getType(), info.isEncrypted() && info.isBonded());
+}
+
+void BleTransportNimBLE::SerialCallbacks::onWrite(NimBLECharacteristic* pCharacteristic, NimBLEConnInfo& info) {
+    NimBLEAttValue value = pCharacteristic->getValue();
+    if (value.size() > 0 && _t->_cb.serialReceived) _t->_cb.serialReceived(value.data(), value.size());
+}
+
+bool BleTransportNimBLE::begin(const char* name, const Callbacks& cb) {
+    _cb = cb;
+    if (!NimBLEDevice::init(name)) return false;
+
+    // Même sécurité que Bluedroid: liaison, pas d'entrée/sortie (appairage "Just Works"),
+    // clés en NVS (BleSlots); Secure Connections si l'hôte la propose
+    NimBLEDevice::setSecurityAuth(true, false, true);
+    NimBLEDevice::setSecurityIOCap(BLE_HS_IO_NO_INPUT_OUTPUT);
+    _server = NimBLEDevice::createServer();
+    _server->setCallbacks(new ServerCallbacks(this));
+    _server->advertiseOnDisconnect(false);  // Relancé par BleSlots (dirigée vers l'hôte du slot)
+
+    // Descripteurs 0x2902 ajoutés par NimBLE pour les caractéristiques NOTIFY
+    NimBLEService* pService = _server->createService(NimBLEUUID((uint16_t)0x1812));
+    NimBLECharacteristic* pInfo = pService->createCharacteristic(NimBLEUUID((uint16_t)0x2A4A), NIMBLE_PROPERTY::READ);
+    pInfo->setValue(BLE_HID_INFO, sizeof(BLE_HID_INFO));
+    NimBLECharacteristic* pMap = pService->createCharacteristic(NimBLEUUID((uint16_t)0x2A4B), NIMBLE_PROPERTY::READ);
+    pMap->setValue(BLE_HID_REPORT_MAP, BLE_HID_REPORT_MAP_LEN);
+    uint8_t proto = 0x01;
+    NimBLECharacteristic* pProto = pService->createCharacteristic(NimBLEUUID((uint16_t)0x2A4E), NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE_NR);
+    pProto->setValue(&proto, 1);
+    uint8_t ctrl = 0x00;
+    NimBLECharacteristic* pCtrl = pService->createCharacteristic(NimBLEUUID((uint16_t)0x2A4C), NIMBLE_PROPERTY::WRITE_NR);
+    pCtrl->setValue(&ctrl, 1);
+    _input = pService->createCharacteristic(NimBLEUUID((uint16_t)0x2A4D), NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::WRITE_NR);
+    _input->setValue(BLE_HID_EMPTY_REPORT, sizeof(BLE_HID_EMPTY_REPORT));
+    pService->start();
+
+    NimBLEService* pDevInfo = _server->createService(NimBLEUUID((uint16_t)0x180A));
+    NimBLECharacteristic* pMfr = pDevInfo->createCharacteristic(NimBLEUUID((uint16_t)0x2A29), NIMBLE_PROPERTY::READ);
+    pMfr->setValue("Macropad");
+    NimBLECharacteristic* pModel = pDevInfo->createCharacteristic(NimBLEUUID((uint16_t)0x2A24), NIMBLE_PROPERTY::READ);
+    pModel->setValue("Keyboard");
+    pDevInfo->start();
+
+    NimBLEService* pBat = _server->createService(NimBLEUUID((uint16_t)0x180F));
+    NimBLECharacteristic* pBatLev = pBat->createCharacteristic(NimBLEUUID((uint16_t)0x2A19), NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY);
+    uint8_t bat = 100;
+    pBatLev->setValue(&bat, 1);
+    pBat->start();
+
+    NimBLEService* pSerialSvc = _server->createService(NimBLEUUID(BLE_SVC_SERIAL));
+    _serial = pSerialSvc->createCharacteristic(NimBLEUUID(BLE_CHAR_SERIAL), NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::WRITE | NIMBLE_PROPERTY::NOTIFY | NIMBLE_PROPERTY::WRITE_NR);
+    _serial->setCallbacks(new SerialCallbacks(this));
+    pSerialSvc->start();
+
+    NimBLEAdvertising* pAdvertising = NimBLEDevice::getAdvertising();
+    pAdvertising->setName(name);   // NimBLE 2.x: le nom n'est plus ajouté d'office
+    pAdvertising->addServiceUUID(NimBLEUUID((uint16_t)0x1812));
+    pAdvertising->addServiceUUID(NimBLEUUID((uint16_t)0x180A));
+    pAdvertising->addServiceUUID(NimBLEUUID((uint16_t)0x180F));
+    pAdvertising->addServiceUUID(NimBLEUUID(BLE_SVC_SERIAL));
+    pAdvertising->enableScanResponse(true);
+    pAdvertising->setPreferredParams(0x06, 0x12);
+    return NimBLEDevice::startAdvertising();
+}
+
+void BleTransportNimBLE::startAdvertising() {
+    NimBLEAdvertising* pAdvertising = NimBLEDevice::getAdvertising();
+    pAdvertising->stop();  // Publicité dirigée éventuellement encore en cours
+    pAdvertising->setConnectableMode(BLE_GAP_CONN_MODE_UND);
+    pAdvertising->start();
+}
+
+bool BleTransportNimBLE::advertiseDirected(const uint8_t* addr, uint8_t addrType) {
+    NimBLEAdvertising* pAdvertising = NimBLEDevice::getAdvertising();
+    pAdvertising->stop();
+    pAdvertising->setConnectableMode(BLE_GAP_CONN_MODE_DIR);
+    NimBLEAddress peer(addr, addrType);
+    return pAdvertising->start(BLE_SLOT_DIRECTED_MS, &peer);
+}
+
+void BleTransportNimBLE::disconnect() {
+    if (_server && _connected) _server->disconnect(_connHandle);
+}
+
+void BleTransportNimBLE::removeBond(const uint8_t* addr, uint8_t addrType) {
+    NimBLEDevice::deleteBond(NimBLEAddress(addr, addrType));
+}
+
+bool BleTransportNimBLE::sendReport(const uint8_t* report, size_t len) {
+    if (!_input) return false;
+    _input->setValue(report, len);
+    return _input->notify();  // false: plus de tampon (mbuf) dans la pile, rapport perdu
+}
+
+bool BleTransportNimBLE::sendSerial(const uint8_t* data, size_t len) {
+    if (!_serial || !_connected) return false;
+    _serial->setValue(data, len);
+    return _serial->notify();
+}
+
+bool BleTransportNimBLE::requestConnParams(uint16_t minInterval, uint16_t maxInterval, uint16_t latency,
+                                           uint16_t timeout) {
+    if (!_server || !_connected) return false;
+    return _server->updateConnParams(_connHandle, minInterval, maxInterval, latency, timeout);
+}
+
+#endif // BLE_STACK == BLE_STACK_NIMBLE
@@ -9,12 +9,18 @@
 #define CONFIG_H
 
 #include <Arduino.h>
+#include "LinkMessages.h"
 
 // ─── Version ─────────────────────────────────────────────────────────────────
 #define FW_VERSION_MAJOR 1
 #define FW_VERSION_MINOR 0
 #define FW_VERSION_PATCH 0
 
+// ─── Logs (Log.h) ───────────────────────────────────────────────────────────
+// Niveau max compilé: 0 = aucun, 1 = erreur, 2 = warn, 3 = info, 4 = debug
+// Les appels LOG_x au-dessus de ce niveau sont supprimés à la compilation.
+#define LOG_LEVEL 3
+
 // ─── Matrice de touches 5×4 ─────────────────────────────────────────────────
 #define NUM_ROWS 5
 #define NUM_COLS 4
@@ -39,9 +45,9 @@ static const uint8_t COL_PINS[NUM_COLS] = {16, 17, 18, 8};    // C0..C3
 // ─── USB Passthrough (obsolète avec hub USB) ───────────────────────────────────
 #define ENABLE_USB_PASSTHROUGH 0   // Hub USB = clavier + fingerprint simultanés
 
-// ─── BLE Switch appareil (PROFILE+1 maintenu 2s) ──────────────────────────────
+// ─── BLE Switch appareil (PROFILE + 1/2/3 maintenus → slot BleSlots) ──────────
 #define ENABLE_BLE_DEVICE_SWITCH 1
-#define BLE_SWITCH_COMBO_MS 2000
+#define BLE_SWITCH_COMBO_MS 1000
 
 // ─── UART ATmega ────────────────────────────────────────────────────────────
 // Câblage: ESP32 TX(10) -> 2k2 -> ATmega RX(PD0)  |  ATmega TX(PD1) -> diviseur 2k2/3k3 -> ESP32 RX(11)
@@ -51,24 +57,43 @@ static const uint8_t COL_PINS[NUM_COLS] = {16, 17, 18, 8};    // C0..C3
 #define ATMEGA_UART_TX 10
 #define ATMEGA_UART_RX 11
 #define ATMEGA_UART_BAUD 9600
+#define ATMEGA_UART_TX_BUFFER 512  // Tampon TX logiciel: write() non bloquant (plusieurs trames)
+#define ATMEGA_UART_RX_BUFFER 1024 // Tampon RX du pilote (256 par défaut: ~2,5 ms à LINK_BAUD_MAX)
+
+// Commandes et contenu des trames: LinkMessages.h (partagé avec l'ATmega)
+
+// Protocole tramé (AtmegaLink.h): COBS + CRC-16 + SEQ + ACK/NACK
+#define LINK_ACK_TIMEOUT_MS 300
+#define LINK_MAX_RETRIES 3
 
-#define CMD_READ_LIGHT 0x01
-#define CMD_SET_LED 0x02
-#define CMD_GET_LED 0x03
-#define CMD_UPDATE_DISPLAY 0x04
-#define CMD_SET_DISPLAY_DATA 0x05
-#define CMD_SET_DISPLAY_IMAGE 0x08
-#define CMD_SET_DISPLAY_IMAGE_CHUNK 0x09
-#define CMD_SET_ATMEGA_DEBUG 0x0A
-#define CMD_SET_ATMEGA_LOG_LEVEL 0x0B
-#define CMD_SET_LAST_KEY 0x0C
+// Négociation de vitesse: démarrage à ATMEGA_UART_BAUD puis essai de la plus
+// haute vitesse commune (index partagé avec l'ATmega, U2X: exactes à 8 MHz)
+#define LINK_BAUD_MAX 1000000            // Plus haute vitesse négociée (dimensionne SCHED_LINK_MS)
+#define LINK_BAUD_RATES {ATMEGA_UART_BAUD, 250000, 500000, LINK_BAUD_MAX}
+#define LINK_BAUD_MASK 0x0F             // Vitesses acceptées côté ESP32
+#define LINK_BAUD_MAX_FAILURES 2        // Échecs avant d'écarter une vitesse
+#define LINK_BAUD_MAX_BAD_RX 8          // Trames RX invalides consécutives → retour à 9600
+#define LINK_NEGOTIATE_RETRY_MS 5000    // Nouvel essai si l'ATmega ne répond pas / après repli
+#define LINK_STATS_PERIOD_MS 10000      // Rapport de débit effectif
+
+// Santé: ping (RTT) + trame d'état ATmega quand la liaison est libre
+#define LINK_PING_INTERVAL_MS 10000
+#define LINK_PING_TIMEOUT_MS 2000
 
 // ─── LEDs ───────────────────────────────────────────────────────────────────
-// Built-in RGB LED (ESP32-S3 DevKit): NeoPixel sur GPIO 38 — contrôlé par ledStrip
+// Built-in RGB LED (ESP32-S3 DevKit): WS2812 sur GPIO 38 — pilotée par LedEngine (RMT)
 #define ENABLE_LED_STRIP 1   // 1 = built-in RGB LED (ESP32-S3 DevKit)
 #define LED_STRIP_PIN 38    // Built-in RGB: GPIO 38 (v1.1) ou 48 (v1.0)
-#define LED_STRIP_COUNT 1   // Single built-in LED (pas de strip externe)
-#define LED_PWM_PIN -1      // -1 = pas de PWM séparé (built-in = NeoPixel uniquement)
+#define LED_STRIP_COUNT 1   // Single built-in LED (pas de strip externe), max LED_MAX
+#define LED_PWM_PIN -1      // -1 = pas de PWM séparé (built-in = WS2812 uniquement)
+#define LED_MAX 17          // Rétro-éclairage par touche (row_col_to_led_index)
+#define LED_FRAME_MS 20     // Cadence fixe des effets (50 trames/s)
+#define LED_EFFECT_DEFAULT 0          // 0 = statique, 1 = réactif, 2 = respiration, 3 = vague
+#define LED_BREATH_PERIOD_MS 4000     // Période de la respiration
+#define LED_WAVE_PERIOD_MS 2000       // Période de la vague (déphasage réparti sur les LEDs)
+#define LED_FADE_MS 250               // Fondu perceptuel du rétro-éclairage (LedFade.h)
+#define LED_REACTIVE_DECAY_SHIFT 3    // Flash réactif: -1/8 par trame (~300 ms)
+#define LED_BENCH_FRAMES 200          // {"type":"led_bench"}: trames mesurées par effet
 
 // ─── Keymap par défaut (grille physique) ────────────────────────────────────
 // [PROFILE] [/] [*] [-]
@@ -79,8 +104,7 @@ static const uint8_t COL_PINS[NUM_COLS] = {16, 17, 18, 8};    // C0..C3
 // Défini dans le .ino principal
 
 // ─── Codes HID Keypad (Usage Page 0x07) ──────────────────────────────────────
-// BLE: envoi direct. USB: +0x88 pour bypass ASCII (non-printing key).
-#define HID_USB_RAW_OFFSET 0x88
+// Rapports bruts sur les deux transports (HidRouter), directement dans l'interface UsbHid
 
 // Keypad 0-9, / * - + . =, flèches
 #define HID_KP_1 0x59
@@ -116,6 +140,63 @@ static const uint8_t COL_PINS[NUM_COLS] = {16, 17, 18, 8};    // C0..C3
 #define CONSUMER_PREV 0xB6
 #define CONSUMER_PLAY_PAUSE 0xCD
 
+// ─── Interface HID USB (UsbHid, TinyUSB) ────────────────────────────────────
+// Interface propre (remplace USBHIDKeyboard / USBHIDConsumerControl): clavier boot, NKRO, consumer
+#define HID_USB_ID_KEYBOARD 1          // Mêmes IDs que BLE_HID_REPORT_MAP
+#define HID_USB_ID_CONSUMER 2
+#define HID_USB_ID_NKRO 3
+#define HID_USB_NKRO 1                 // 1: touches en bitmap (protocole report); 0: rapport 6 touches
+#define HID_USB_NKRO_BITS 232          // Usages clavier 0x00-0xE7 (29 octets)
+#define HID_USB_INTERVAL_MS 1          // bInterval: polling 1 kHz (full speed)
+#define HID_USB_EP_SIZE 64
+
+// ─── Routage HID USB + BLE (HidRouter) ──────────────────────────────────────
+// Une file par transport, vidée par la tâche hid_tx: un transport lent ne retarde pas l'autre
+#define HID_QUEUE_LEN 32               // Rapports par transport (appui + relâché = 2)
+#define HID_USB_PACE_US 1000           // Un rapport par trame USB (1 ms)
+#define HID_USB_CONSUMER_HOLD_MS 30    // Media USB: appui tenu avant le relâché
+#define HID_TX_TASK_STACK 4096
+#define HID_TX_TASK_CORE 1             // Cœur de loop(), priorité au-dessus: réveil à chaque tick
+#define HID_TX_TASK_PRIO 2
+
+// ─── Démarrage par étapes (esp32_micropython.ino) ───────────────────────────
+// setup(): USB HID, keymap, LEDs, matrice; puis une étape par passage de loop()
+#define BOOT_BLE_TASK_STACK 8192   // Tâche d'init BLE (pile BLE_STACK), supprimée une fois prête
+#define BOOT_BLE_TASK_CORE 0       // Cœur du contrôleur BT: loop() continue de scanner sur l'autre
+
+// ─── Paramètres de connexion BLE (BleConnParams) ─────────────────────────────
+// Unités BLE: intervalle 1,25 ms, latence en événements, timeout 10 ms
+#define BLE_CONN_ACTIVE_MIN 6          // 7,5 ms pendant la frappe (iOS refuse < 15 ms: refus compté)
+#define BLE_CONN_ACTIVE_MAX 12         // 15 ms
+#define BLE_CONN_FALLBACK_MIN 12       // Hôte qui a refusé l'actif: 15–30 ms (règles Apple), mémorisé par slot
+#define BLE_CONN_FALLBACK_MAX 24
+#define BLE_CONN_ACTIVE_LATENCY 0
+#define BLE_CONN_ACTIVE_TIMEOUT 200    // 2 s
+#define BLE_CONN_IDLE_MIN 48           // 60 ms au repos
+#define BLE_CONN_IDLE_MAX 60           // 75 ms (max ≥ min + 15 ms: recommandation Apple)
+#define BLE_CONN_IDLE_LATENCY 4        // Sans trafic: un événement sur 5 (375 ms)
+#define BLE_CONN_IDLE_TIMEOUT 400      // 4 s > 3 × 75 ms × 5
+#define BLE_CONN_IDLE_MS 5000          // Sans touche ni encodeur → paramètres de repos
+#define BLE_CONN_SETTLE_MS 2000        // Après connexion: appairage et découverte d'abord
+#define BLE_CONN_UPDATE_WAIT_MS 3000   // Sans réponse de l'hôte: la demande est abandonnée
+#define BLE_CONN_EVENT_US 400          // Temps radio estimé d'un événement vide (duty cycle)
+
+// ─── Pile BLE (BleTransport) ────────────────────────────────────────────────
+// Une seule implémentation compilée: -DBLE_STACK=BLE_STACK_NIMBLE pour NimBLE-Arduino 2.x
+#define BLE_STACK_BLUEDROID 0      // BLEDevice d'arduino-esp32 (défaut)
+#define BLE_STACK_NIMBLE 1         // Pile plus légère: tas et temps d'init réduits
+#ifndef BLE_STACK
+#define BLE_STACK BLE_STACK_BLUEDROID
+#endif
+#define BLE_DEVICE_NAME "Macropad Keyboard"  // "Keyboard": mieux reconnu par iOS
+#define BLE_BENCH_REPORTS 200      // {"type":"ble_bench"}: rapports vides notifiés d'affilée
+
+// ─── Hôtes BLE multiples (BleSlots) ─────────────────────────────────────────
+// Clés de liaison gardées en NVS par la pile; adresse et réglages du slot dans Preferences
+#define BLE_SLOT_COUNT 3           // PROFILE + 1/2/3 (ligne 4 de la matrice) maintenus
+#define BLE_SLOT_DIRECTED_MS 1300  // Publicité dirigée haute fréquence (1,28 s max), puis ouverte
+#define BLE_SLOT_READV_MS 100      // Après une déconnexion: relance de la publicité
+
 // ─── BLE UUIDs ──────────────────────────────────────────────────────────────
 #define BLE_SVC_HID "1812"
 #define BLE_CHAR_INPUT "2A4D"
@@ -131,10 +212,43 @@ static const uint8_t COL_PINS[NUM_COLS] = {16, 17, 18, 8};    // C0..C3
 //           (2) Courant suffisant (batterie dégradée = chute de tension sous charge)
 //           (3) Entrée 5V: utiliser un boost 3.7V→5V, pas de connexion directe batterie→5V
 
-// ─── Light sensor poll ──────────────────────────────────────────────────────
-#define LIGHT_POLL_INTERVAL_MS 30000   // USB: mise à jour toutes les 30 s
-#define LIGHT_POLL_INTERVAL_BLE_MS 60000  // BLE: toutes les 60 s (pour LED)
-#define LIGHT_POLL_MIN_INTERVAL_MS 30000  // Throttle: min 30s entre 2 CMD_READ_LIGHT
+// ─── Veille (PowerIdle) ─────────────────────────────────────────────────────
+// Sans touche, encodeur ni message web (et sans USB monté): colonnes à 0, réveil GPIO sur
+// les lignes et l'encodeur, light sleep automatique si le build l'active (esp_pm + tickless idle)
+#define POWER_IDLE_MS 30000        // Période calme avant la veille, 0 = jamais (NVS "idle_ms")
+#define POWER_IDLE_WAIT_MS 250     // Attente max par passage: entretien de loop() (BLE, liaison, web)
+#define POWER_IDLE_MIN_MHZ 80      // Fréquence CPU en veille (DFS), APB stable pour l'UART
+#define POWER_WAKE_BUDGET_US 5000  // Front → premier rapport HID: au-delà, avertissement
+
+// ─── Ordonnanceur de loop() (Scheduler) ──────────────────────────────────────
+// Tâches de loop() par priorité (HID d'abord), échéances dans une roue de SCHED_WHEEL_LEVELS
+// niveaux de 64 cases (1 ms, 64 ms, 4,096 s). Budget: durée d'un passage au-delà de
+// laquelle un avertissement est émis (au plus 1 par tâche / SCHED_WARN_MS)
+#define SCHED_MAX_TASKS 16         // Masque des tâches prêtes sur 32 bits: 32 au plus
+#define SCHED_WHEEL_LEVELS 3
+#define SCHED_WARN_MS 10000
+#define SCHED_HID_MS 2             // Matrice + encodeur (anti-rebond DEBOUNCE_MS)
+#define SCHED_HID_BUDGET_US 1000
+#define SCHED_LINK_MS 2            // Trames ATmega (voir LINK_RX_FILL_MS)
+// Tampon RX plein à LINK_BAUD_MAX (10 bits par octet): ~10 ms pour 1024 octets, soit 5 périodes
+// de la tâche link (une tâche au budget SCHED_LINK_BUDGET_US passe entre deux sans perte)
+#define LINK_RX_FILL_MS ((uint32_t)ATMEGA_UART_RX_BUFFER * 10 * 1000 / LINK_BAUD_MAX)
+#define SCHED_LINK_BUDGET_US 2000
+#define SCHED_BLE_MS 10            // Créneaux, connexion/déconnexion, paramètres de connexion
+#define SCHED_BLE_BUDGET_US 3000
+#define SCHED_WEB_MS 5             // Lignes JSON série / BLE (sauvegardes NVS: budget large)
+#define SCHED_WEB_BUDGET_US 50000
+#define SCHED_LED_BUDGET_US 2000   // Période LED_FRAME_MS
+#define SCHED_DEFAULT_BUDGET_US 5000
+#define BLE_HELLO_DELAY_MS 200     // Nouvelle connexion BLE → données d'affichage + rapport vide
+#define OTA_RESTART_DELAY_MS 500   // Fin d'OTA → redémarrage (réponse web envoyée)
+
+// ─── Light sensor (push ATmega) ─────────────────────────────────────────────
+// L'ATmega pousse CMD_READ_LIGHT quand la valeur varie de LIGHT_SUB_DELTA ou passe
+// LIGHT_THRESHOLD (± LIGHT_SUB_HYSTERESIS/2), au plus 1 fois / LIGHT_SUB_MIN_INTERVAL_MS
+#define LIGHT_SUB_DELTA 20
+#define LIGHT_SUB_HYSTERESIS 40
+#define LIGHT_SUB_MIN_INTERVAL_MS 500  // Résolution 100 ms (cadence ADC de l'ATmega)
 #define LIGHT_THRESHOLD 500  // < 500 = sombre (LED ON). Si capteur inversé (haut=sombre): utiliser >= pour ON
 #define LIGHT_SENSOR_INVERTED 0  // 0 = ADC >= 500 = clair (LED OFF). ADC < 500 = sombre (LED ON)
 
@@ -1,9 +1,9 @@
 /*
- * HidOutput.cpp — Envoi HID BLE + USB
+ * HidOutput.cpp — Envoi HID BLE + USB (rapports déposés dans les files HidRouter)
  * Support complet: lettres, chiffres, symboles, touches nommées (ENTER, TAB, etc.)
  */
 #include "HidOutput.h"
-#include <BLEDevice.h>
+#include "UsbHid.h"
 
 // Codes HID Keyboard (Usage Page 0x07) — compatibles BLE et USB
 #define HID_KB_A  0x04
@@ -101,14 +101,72 @@ static const KeycodeEntryMod NAMED_KEYS_SHIFT[] = {
 static const int NUM_NAMED = sizeof(NAMED_KEYS) / sizeof(NAMED_KEYS[0]);
 static const int NUM_NAMED_SHIFT = sizeof(NAMED_KEYS_SHIFT) / sizeof(NAMED_KEYS_SHIFT[0]);
 
-void HidOutput::begin(USBHIDKeyboard* keyboard, USBHIDConsumerControl* consumer) {
-    _keyboard = keyboard;
-    _consumer = consumer;
+// Rapports sans report ID (HidRouter::Report): chaque transport ajoute le sien
+// USB: endpoint occupé (rapport précédent pas encore lu par l'hôte) → false, réessayé
+static bool usb_send(const HidRouter::Report& r, uint32_t queuedUs) {
+    if (r.kind == HidRouter::KIND_CONSUMER) return usbHid().sendConsumer(r.data[0] | (r.data[1] << 8), queuedUs);
+    return usbHid().sendKeyboard(r.data, queuedUs);
 }
 
-void HidOutput::setBleState(bool connected, BLECharacteristic* pInput) {
+static bool ble_send(const HidRouter::Report& r, uint32_t queuedUs) {
+    (void)queuedUs;
+    uint8_t buf[1 + sizeof(r.data)];
+    buf[0] = (r.kind == HidRouter::KIND_CONSUMER) ? 0x02 : 0x01;  // IDs de BLE_HID_REPORT_MAP
+    memcpy(buf + 1, r.data, r.len);
+    return bleTransport().sendReport(buf, 1 + r.len);
+}
+
+void HidOutput::begin() {
+    _router.setSink(HidRouter::SINK_USB, usb_send, HID_USB_PACE_US);
+    _router.setSink(HidRouter::SINK_BLE, ble_send, (uint32_t)BLE_CONN_ACTIVE_MIN * 1250);
+}
+
+void HidOutput::setUsbState(bool mounted) {
+    _router.setActive(HidRouter::SINK_USB, mounted);
+}
+
+void HidOutput::setBleState(bool connected, BleTransport* ble) {
     _bleConnected = connected;
-    _pInput = pInput;
+    _ble = ble;
+    _router.setActive(HidRouter::SINK_BLE, connected && ble != nullptr);
+}
+
+void HidOutput::setKeyRoute(uint8_t row, uint8_t col, Mode route) {
+    if (row < NUM_ROWS && col < NUM_COLS) _keyRoutes[row][col] = route;
+}
+
+HidOutput::Mode HidOutput::keyRoute(uint8_t row, uint8_t col) const {
+    return (row < NUM_ROWS && col < NUM_COLS) ? (Mode)_keyRoutes[row][col] : MODE_AUTO;
+}
+
+uint8_t HidOutput::_sinks(Mode rule) const {
+    bool ble = _bleConnected && _ble != nullptr;
+    uint8_t bleRoute = ble ? HidRouter::ROUTE_BLE : 0;
+    switch ((rule != MODE_AUTO) ? rule : _mode) {
+        case MODE_BLE:  return bleRoute;
+        case MODE_USB:  return HidRouter::ROUTE_USB;
+        case MODE_BOTH: return HidRouter::ROUTE_USB | bleRoute;
+        default:        return ble ? HidRouter::ROUTE_BLE : HidRouter::ROUTE_USB;
+    }
+}
+
+const char* HidOutput::modeName(Mode mode) {
+    switch (mode) {
+        case MODE_BLE:  return "ble";
+        case MODE_USB:  return "usb";
+        case MODE_BOTH: return "both";
+        default:        return "auto";
+    }
+}
+
+bool HidOutput::modeFromName(const char* name, Mode* out) {
+    for (uint8_t m = MODE_AUTO; m <= MODE_BOTH; m++) {
+        if (strcmp(name, modeName((Mode)m)) == 0) {
+            *out = (Mode)m;
+            return true;
+        }
+    }
+    return false;
 }
 
 bool HidOutput::keyShouldRepeat(const String& symbol) {
@@ -167,89 +225,90 @@ bool HidOutput::getKeycodeAndModifier(const String& symbol, KeycodeResult* out)
     return false;
 }
 
-void HidOutput::_sendKeypadReport(uint8_t kc, uint8_t modifier) {
-    uint8_t release[9] = {0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-
-    if (_bleConnected && _pInput != nullptr) {
-        uint8_t report[9] = {0x01, modifier, 0x00, kc, 0x00, 0x00, 0x00, 0x00, 0x00};
-        _pInput->setValue(report, 9);
-        _pInput->notify();
-        delay(2);
-        _pInput->setValue(release, 9);
-        _pInput->notify();
-    } else if (_keyboard != nullptr) {
-        // USB: 0x81 = Left Shift modifier, 0x88+kc = raw key
-        if (modifier & HID_MOD_SHIFT) {
-            _keyboard->press(0x81);
-            delay(5);
-        }
-        uint8_t usbCode = kc + HID_USB_RAW_OFFSET;
-        _keyboard->press(usbCode);
-        delay(10);
-        _keyboard->release(usbCode);
-        if (modifier & HID_MOD_SHIFT) {
-            _keyboard->release(0x81);
-        }
-    }
+void HidOutput::_submit(HidRouter::Sink s, const HidRouter::Report* r, uint8_t n) {
+    _router.submit(s, r, n, micros());
+    if (_wake) _wake();
 }
 
-void HidOutput::_sendConsumerReport(uint16_t code) {
-    if (_bleConnected && _pInput != nullptr) {
+void HidOutput::_sendKeypadReport(uint8_t kc, uint8_t modifier, uint8_t sinks) {
+    HidRouter::Report r[2] = {};
+    r[0].kind = r[1].kind = HidRouter::KIND_KEYBOARD;
+    r[0].len = r[1].len = 8;
+    r[0].data[0] = modifier;  // Modificateurs dans le même rapport que la touche
+    r[0].data[2] = kc;
+    if (sinks & HidRouter::ROUTE_USB) _submit(HidRouter::SINK_USB, r, 2);
+    if (sinks & HidRouter::ROUTE_BLE) _submit(HidRouter::SINK_BLE, r, 2);
+}
+
+void HidOutput::_sendConsumerReport(uint16_t code, uint8_t sinks) {
+    HidRouter::Report r[2] = {};
+    if (sinks & HidRouter::ROUTE_BLE) {
         uint8_t kc = 0;
         if (code == CONSUMER_VOL_UP) kc = HID_KB_VOL_UP;
         else if (code == CONSUMER_VOL_DOWN) kc = HID_KB_VOL_DOWN;
         else if (code == CONSUMER_MUTE) kc = HID_KB_MUTE;
 
         if (kc != 0) {
-            static unsigned long lastBleVolSent = 0;
-            unsigned long now = millis();
-            if ((now - lastBleVolSent) < BLE_VOLUME_STEP_DELAY_MS) return;
-            lastBleVolSent = now;
-            _sendKeypadReport(kc, 0);
-            return;
+            // Android: volume par la page clavier, un pas par BLE_VOLUME_STEP_DELAY_MS (les autres tombent)
+            uint32_t now = millis();
+            if ((now - _lastBleVolMs) >= BLE_VOLUME_STEP_DELAY_MS) {
+                _lastBleVolMs = now;
+                r[0].kind = r[1].kind = HidRouter::KIND_KEYBOARD;
+                r[0].len = r[1].len = 8;
+                r[0].data[2] = kc;
+                r[1].holdMs = BLE_VOLUME_STEP_DELAY_MS;
+                _submit(HidRouter::SINK_BLE, r, 2);
+            }
+        } else {
+            r[0].kind = r[1].kind = HidRouter::KIND_CONSUMER;
+            r[0].len = r[1].len = 2;
+            r[0].data[0] = code & 0xFF;
+            r[0].data[1] = code >> 8;
+            _submit(HidRouter::SINK_BLE, r, 2);
         }
-        uint8_t report[3] = {0x02, (uint8_t)(code & 0xFF), (uint8_t)(code >> 8)};
-        _pInput->setValue(report, 3);
-        _pInput->notify();
-        delay(2);
-        uint8_t release[3] = {0x02, 0x00, 0x00};
-        _pInput->setValue(release, 3);
-        _pInput->notify();
-    } else if (_consumer != nullptr) {
-        _consumer->press(code);
-        delay(30);
-        _consumer->release();
+    }
+    if (sinks & HidRouter::ROUTE_USB) {
+        memset(r, 0, sizeof(r));
+        r[0].kind = r[1].kind = HidRouter::KIND_CONSUMER;
+        r[0].len = r[1].len = 2;
+        r[0].data[0] = code & 0xFF;
+        r[0].data[1] = code >> 8;
+        r[0].holdMs = HID_USB_CONSUMER_HOLD_MS;
+        _submit(HidRouter::SINK_USB, r, 2);
     }
 }
 
 void HidOutput::sendKey(const String& symbol, uint8_t row, uint8_t col) {
     if (symbol == "PROFILE") return;
 
-    if (symbol == "VOL_UP") { sendVolumeUp(); return; }
-    if (symbol == "VOL_DOWN") { sendVolumeDown(); return; }
-    if (symbol == "MUTE") { sendMute(); return; }
-    if (symbol == "Prev") { sendConsumer(CONSUMER_PREV); return; }
-    if (symbol == "Next") { sendConsumer(CONSUMER_NEXT); return; }
-    if (symbol == "Select") { sendConsumer(CONSUMER_PLAY_PAUSE); return; }
+    // Media: règle de la touche, sinon règle media
+    Mode rule = keyRoute(row, col);
+    uint8_t media = _sinks((rule != MODE_AUTO) ? rule : _mediaRoute);
+    if (symbol == "VOL_UP") { _sendConsumerReport(CONSUMER_VOL_UP, media); return; }
+    if (symbol == "VOL_DOWN") { _sendConsumerReport(CONSUMER_VOL_DOWN, media); return; }
+    if (symbol == "MUTE") { _sendConsumerReport(CONSUMER_MUTE, media); return; }
+    if (symbol == "Prev") { _sendConsumerReport(CONSUMER_PREV, media); return; }
+    if (symbol == "Next") { _sendConsumerReport(CONSUMER_NEXT, media); return; }
+    if (symbol == "Select") { _sendConsumerReport(CONSUMER_PLAY_PAUSE, media); return; }
 
     KeycodeResult r;
     if (getKeycodeAndModifier(symbol, &r) && r.code > 0) {
-        _sendKeypadReport(r.code, r.modifier);
+        _sendKeypadReport(r.code, r.modifier, _sinks(rule));
     }
 }
 
 void HidOutput::sendVolumeUp() {
-    _sendConsumerReport(CONSUMER_VOL_UP);
+    _sendConsumerReport(CONSUMER_VOL_UP, _sinks(_mediaRoute));
 }
 
 void HidOutput::sendVolumeDown() {
-    _sendConsumerReport(CONSUMER_VOL_DOWN);
+    _sendConsumerReport(CONSUMER_VOL_DOWN, _sinks(_mediaRoute));
 }
 
 void HidOutput::sendMute() {
-    _sendConsumerReport(CONSUMER_MUTE);
+    _sendConsumerReport(CONSUMER_MUTE, _sinks(_mediaRoute));
 }
 
 void HidOutput::sendConsumer(uint16_t code) {
-    _sendConsumerReport(code);
+    _sendConsumerReport(code, _sinks(_mediaRoute));
 }
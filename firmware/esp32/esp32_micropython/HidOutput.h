@@ -1,14 +1,14 @@
 /*
  * HidOutput.h — Envoi HID (BLE + USB)
- * Centralise la logique keypad + Consumer Control
+ * Centralise la logique keypad + Consumer Control; les rapports partent par HidRouter
+ * (une file par transport), vers les transports choisis par les règles de routage
  */
 #ifndef HID_OUTPUT_H
 #define HID_OUTPUT_H
 
 #include "Config.h"
-#include <BLEDevice.h>
-#include <USBHIDKeyboard.h>
-#include <USBHIDConsumerControl.h>
+#include "BleTransport.h"
+#include "HidRouter.h"
 
 struct KeycodeEntry {
     const char* symbol;
@@ -22,8 +22,32 @@ struct KeycodeResult {
 
 class HidOutput {
 public:
-    void begin(USBHIDKeyboard* keyboard, USBHIDConsumerControl* consumer = nullptr);
-    void setBleState(bool connected, BLECharacteristic* pInput);
+    // Sortie (mémorisée par slot BLE) ou règle de routage (touche, media):
+    // AUTO = BLE si connecté, sinon USB (règle: suit la sortie du slot); BOTH = tous les transports actifs
+    enum Mode : uint8_t { MODE_AUTO, MODE_BLE, MODE_USB, MODE_BOTH };
+
+    // USB: interface UsbHid (usbHid().begin() avant USB.begin())
+    void begin();
+    void setUsbState(bool mounted);   // Non monté: file USB vidée et fermée
+    void setBleState(bool connected, BleTransport* ble);
+    void setMode(Mode mode) { _mode = mode; }
+    Mode mode() const { return _mode; }
+    // Règles: touche (row, col) puis media (volume, lecture), MODE_AUTO = pas de règle
+    void setKeyRoute(uint8_t row, uint8_t col, Mode route);
+    Mode keyRoute(uint8_t row, uint8_t col) const;
+    void setMediaRoute(Mode route) { _mediaRoute = route; }
+    Mode mediaRoute() const { return _mediaRoute; }
+    // Transports (HidRouter::ROUTE_*) d'une touche sans règle
+    uint8_t routes() const { return _sinks(MODE_AUTO); }
+    bool usesBle() const { return routes() & HidRouter::ROUTE_BLE; }
+    bool usesUsb() const { return routes() & HidRouter::ROUTE_USB; }
+    static const char* modeName(Mode mode);
+    static bool modeFromName(const char* name, Mode* out);
+
+    // Tâche d'envoi: poll() rend le délai avant la prochaine échéance (HidRouter::IDLE: rien)
+    uint32_t poll(uint32_t nowUs) { return _router.poll(nowUs); }
+    void setWake(void (*fn)()) { _wake = fn; }   // Appelé après chaque dépôt (réveil de la tâche)
+    HidRouter& router() { return _router; }
 
     void sendKey(const String& symbol, uint8_t row, uint8_t col);
     void sendVolumeUp();
@@ -36,13 +60,19 @@ public:
     static bool getKeycodeAndModifier(const String& symbol, KeycodeResult* out);
 
 private:
-    USBHIDKeyboard* _keyboard = nullptr;
-    USBHIDConsumerControl* _consumer = nullptr;
     bool _bleConnected = false;
-    BLECharacteristic* _pInput = nullptr;
+    BleTransport* _ble = nullptr;
+    Mode _mode = MODE_AUTO;
+    Mode _mediaRoute = MODE_AUTO;
+    uint8_t _keyRoutes[NUM_ROWS][NUM_COLS] = {};
+    HidRouter _router;
+    void (*_wake)() = nullptr;
+    uint32_t _lastBleVolMs = 0;
 
-    void _sendKeypadReport(uint8_t kc, uint8_t modifier = 0);
-    void _sendConsumerReport(uint16_t code);
+    uint8_t _sinks(Mode rule) const;
+    void _submit(HidRouter::Sink s, const HidRouter::Report* r, uint8_t n);
+    void _sendKeypadReport(uint8_t kc, uint8_t modifier, uint8_t sinks);
+    void _sendConsumerReport(uint16_t code, uint8_t sinks);
 };
 
 #endif // HID_OUTPUT_H
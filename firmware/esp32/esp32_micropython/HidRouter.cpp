@@ -0,0 +1,121 @@
+/*
+ * HidRouter.cpp — Files par transport, cadence et reprise des envois refusés
+ */
+#include "HidRouter.h"
+#include <string.h>
+
+static const char* const SINK_NAMES[] = {"usb", "ble"};
+
+const char* HidRouter::sinkName(Sink s) {
+    return (s < SINK_COUNT) ? SINK_NAMES[s] : "?";
+}
+
+void HidRouter::_clear(Queue& q) {
+    q.head = 0;
+    q.count = 0;
+    q.gen++;
+}
+
+void HidRouter::setSink(Sink s, Sender fn, uint32_t paceUs) {
+    portENTER_CRITICAL(&_mux);
+    _q[s].send = fn;
+    _q[s].paceUs = paceUs;
+    portEXIT_CRITICAL(&_mux);
+}
+
+void HidRouter::setPaceUs(Sink s, uint32_t paceUs) {
+    portENTER_CRITICAL(&_mux);
+    _q[s].paceUs = paceUs;
+    portEXIT_CRITICAL(&_mux);
+}
+
+void HidRouter::setActive(Sink s, bool active) {
+    portENTER_CRITICAL(&_mux);
+    Queue& q = _q[s];
+    if (q.active && !active) _clear(q);  // Hôte parti: ses rapports en attente n'ont plus de sens
+    q.active = active;
+    portEXIT_CRITICAL(&_mux);
+}
+
+bool HidRouter::submit(Sink s, const Report* r, uint8_t n, uint32_t nowUs) {
+    portENTER_CRITICAL(&_mux);
+    Queue& q = _q[s];
+    bool ok = q.active && q.send && q.count + n <= HID_QUEUE_LEN;
+    if (ok) {
+        // File vide: la cadence repart d'ici (pas de crédit accumulé pendant le repos)
+        if (q.count == 0 && (int32_t)(nowUs - q.nextUs) > 0) q.nextUs = nowUs;
+        for (uint8_t i = 0; i < n; i++) {
+            Entry& e = q.e[(q.head + q.count) % HID_QUEUE_LEN];
+            e.r = r[i];
+            e.queuedUs = nowUs;
+            q.count++;
+        }
+        if (q.count > q.st.maxQueued) q.st.maxQueued = q.count;
+    } else if (q.active) {
+        q.st.dropped += n;
+    }
+    portEXIT_CRITICAL(&_mux);
+    return ok;
+}
+
+void HidRouter::_pollSink(Queue& q, uint32_t nowUs) {
+    for (;;) {
+        portENTER_CRITICAL(&_mux);
+        bool due = q.count > 0 && (int32_t)(nowUs - q.nextUs) >= 0;
+        Entry e;
+        uint16_t gen = q.gen;
+        Sender send = q.send;
+        if (due) e = q.e[q.head];
+        portEXIT_CRITICAL(&_mux);
+        if (!due) return;
+
+        // Hors _mux: l'envoi BLE peut prendre du temps dans la pile
+        bool sent = send(e.r, e.queuedUs);
+
+        portENTER_CRITICAL(&_mux);
+        if (q.gen == gen) {
+            if (sent) {
+                q.head = (q.head + 1) % HID_QUEUE_LEN;
+                q.count--;
+                q.st.sent++;
+                uint32_t delayUs = nowUs - e.queuedUs;
+                if (delayUs > q.st.maxDelayUs) q.st.maxDelayUs = delayUs;
+                q.nextUs = nowUs + q.paceUs + (uint32_t)e.r.holdMs * 1000;
+            } else {
+                q.st.retries++;  // Reste en tête, réessayé au prochain poll()
+            }
+        }
+        portEXIT_CRITICAL(&_mux);
+        if (!sent) return;
+    }
+}
+
+uint32_t HidRouter::poll(uint32_t nowUs) {
+    uint32_t wait = IDLE;
+    for (uint8_t s = 0; s < SINK_COUNT; s++) {
+        Queue& q = _q[s];
+        _pollSink(q, nowUs);
+        portENTER_CRITICAL(&_mux);
+        if (q.count > 0) {
+            int32_t left = (int32_t)(q.nextUs - nowUs);
+            uint32_t w = (left > 0) ? (uint32_t)left : 0;
+            if (w < wait) wait = w;
+        }
+        portEXIT_CRITICAL(&_mux);
+    }
+    return wait;
+}
+
+uint8_t HidRouter::queued(Sink s) const {
+    portENTER_CRITICAL(&_mux);
+    uint8_t n = _q[s].count;
+    portEXIT_CRITICAL(&_mux);
+    return n;
+}
+
+HidRouter::Stats HidRouter::stats(Sink s) const {
+    portENTER_CRITICAL(&_mux);
+    Stats st = _q[s].st;
+    portEXIT_CRITICAL(&_mux);
+    return st;
+}
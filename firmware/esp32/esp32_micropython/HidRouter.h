@@ -0,0 +1,84 @@
+/*
+ * HidRouter.h — Files de rapports HID par transport (USB, BLE), cadence propre à chacune
+ *
+ * Un rapport part vers un ou plusieurs transports; chacun a sa file et sa cadence
+ * (USB: HID_USB_PACE_US, BLE: intervalle de connexion). Un envoi refusé (transport occupé,
+ * pile BLE saturée) reste en tête de sa file et sera réessayé: un transport lent ne retarde
+ * jamais les autres. Appui et relâché entrent ensemble ou pas du tout (jamais de touche
+ * bloquée chez l'hôte).
+ *
+ * Indépendant des piles: envoi par un Sender, temps fourni par l'appelant (µs).
+ * submit() depuis loop(), poll() depuis la tâche d'envoi (files sous _mux).
+ */
+#ifndef HID_ROUTER_H
+#define HID_ROUTER_H
+
+#include "Config.h"
+
+class HidRouter {
+public:
+    enum Sink : uint8_t { SINK_USB, SINK_BLE, SINK_COUNT };
+    static const uint8_t ROUTE_USB = 1 << SINK_USB;
+    static const uint8_t ROUTE_BLE = 1 << SINK_BLE;
+
+    enum Kind : uint8_t { KIND_KEYBOARD, KIND_CONSUMER };
+
+    // Sans report ID: chaque transport ajoute le sien
+    struct Report {
+        uint8_t kind;
+        uint8_t len;
+        uint8_t data[8];      // Clavier: modificateurs, réservé, 6 touches; consumer: usage 16 bits LE
+        uint16_t holdMs;      // Attente en plus de la cadence avant le rapport suivant de la file
+    };
+
+    struct Stats {
+        uint32_t sent;
+        uint32_t dropped;     // File pleine (groupe entier refusé)
+        uint32_t retries;     // Envoi refusé par le transport, réessayé
+        uint32_t maxDelayUs;  // submit() → envoi accepté
+        uint8_t maxQueued;
+    };
+
+    // queuedUs: instant du submit() (mesure de latence par le transport)
+    using Sender = bool (*)(const Report& r, uint32_t queuedUs);
+
+    void setSink(Sink s, Sender fn, uint32_t paceUs);
+    void setPaceUs(Sink s, uint32_t paceUs);
+    void setActive(Sink s, bool active);   // Inactif: file vidée, submit() refusé
+    bool active(Sink s) const { return _q[s].active; }
+
+    // n rapports d'affilée dans la file de s, ou aucun si la place manque
+    bool submit(Sink s, const Report* r, uint8_t n, uint32_t nowUs);
+    // Envoie ce qui est dû; rend le délai avant la prochaine échéance (µs), IDLE si tout est vide
+    static const uint32_t IDLE = 0xFFFFFFFF;
+    uint32_t poll(uint32_t nowUs);
+
+    uint8_t queued(Sink s) const;
+    Stats stats(Sink s) const;
+    static const char* sinkName(Sink s);
+
+private:
+    struct Entry {
+        Report r;
+        uint32_t queuedUs;
+    };
+    struct Queue {
+        Entry e[HID_QUEUE_LEN];
+        uint8_t head;
+        uint8_t count;
+        bool active;
+        Sender send;
+        uint32_t paceUs;
+        uint32_t nextUs;      // Pas d'envoi avant (cadence + holdMs du précédent)
+        uint16_t gen;         // Incrémenté à chaque vidage (envoi en cours hors _mux)
+        Stats st;
+    };
+
+    void _pollSink(Queue& q, uint32_t nowUs);
+    static void _clear(Queue& q);
+
+    Queue _q[SINK_COUNT] = {};
+    mutable portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+#endif // HID_ROUTER_H
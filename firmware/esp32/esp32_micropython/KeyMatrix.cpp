@@ -8,6 +8,23 @@ bool KeyMatrix::isKeyPressed(uint8_t row, uint8_t col) const {
     return _lastState[row][col] != 0;
 }
 
+bool KeyMatrix::anyPressed() const {
+    for (int r = 0; r < NUM_ROWS; r++) {
+        for (int c = 0; c < NUM_COLS; c++) {
+            if (_lastState[r][c]) return true;
+        }
+    }
+    return false;
+}
+
+void KeyMatrix::setIdle(bool idle) {
+    // Hors veille: colonnes au repos (HIGH) comme après scan()
+    for (int i = 0; i < NUM_COLS; i++) {
+        digitalWrite(COL_PINS[i], idle ? LOW : HIGH);
+    }
+    if (idle) delayMicroseconds(50);  // Lignes stables avant l'armement du réveil
+}
+
 void KeyMatrix::begin() {
     for (int i = 0; i < NUM_COLS; i++) {
         pinMode(COL_PINS[i], OUTPUT);
@@ -17,6 +17,10 @@ public:
 
     // État actuel d'une touche (pour détection combo PROFILE+0)
     bool isKeyPressed(uint8_t row, uint8_t col) const;
+    bool anyPressed() const;
+
+    // Veille (PowerIdle): toutes les colonnes à 0, une touche tire sa ligne à 0 (réveil GPIO)
+    void setIdle(bool idle);
 
     void setCallback(KeyCallback cb) { _callback = cb; }
     void setDebounceMs(uint16_t ms) { _debounceMs = ms; }
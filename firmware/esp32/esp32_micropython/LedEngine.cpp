@@ -0,0 +1,206 @@
+/*
+ * LedEngine.cpp — Rendu des effets et encodage WS2812 → RMT
+ */
+#include "LedEngine.h"
+#include "Log.h"
+
+// WS2812 à 800 kHz, tick RMT de 100 ns: bit = 1,2 us (T0H 0,4 / T1H 0,8 us)
+#define LED_RMT_TICK_NS 100
+#define LED_T0H 4
+#define LED_T0L 8
+#define LED_T1H 8
+#define LED_T1L 4
+
+#define LED_BREATH_STEP ((uint16_t)(65536UL * LED_FRAME_MS / LED_BREATH_PERIOD_MS))
+#define LED_WAVE_STEP ((uint16_t)(65536UL * LED_FRAME_MS / LED_WAVE_PERIOD_MS))
+#define LED_WAVE_SPACING ((uint16_t)(65536UL / LED_MAX))
+#define LED_BREATH_FLOOR 16     // La respiration ne s'éteint jamais complètement
+#define LED_MAX_CATCHUP 64      // Au-delà (loop() bloquée longtemps): flashs déjà éteints
+
+static const char* const EFFECT_NAMES[LedEngine::EFFECT_COUNT] = {
+    "static", "reactive", "breathing", "wave"
+};
+
+// v × s / 256, s = 255 → v inchangé
+static inline uint8_t scale8(uint8_t v, uint8_t s) {
+    return (uint8_t)(((uint16_t)v * ((uint16_t)s + 1)) >> 8);
+}
+
+// Phase 16 bits → niveau 0..255: triangle au carré (montée douce, pas de sinus flottant)
+static inline uint8_t wave8(uint16_t phase) {
+    uint16_t t = (phase & 0x8000) ? (uint16_t)~phase : phase;
+    uint16_t x = t >> 7;
+    return (uint8_t)((x * (x + 1)) >> 8);
+}
+
+static inline uint8_t breath8(uint16_t phase) {
+    return LED_BREATH_FLOOR + scale8(wave8(phase), 255 - LED_BREATH_FLOOR);
+}
+
+const char* LedEngine::effectName(Effect e) {
+    return (e < EFFECT_COUNT) ? EFFECT_NAMES[e] : "?";
+}
+
+bool LedEngine::effectFromName(const char* name, Effect* out) {
+    for (uint8_t i = 0; i < EFFECT_COUNT; i++) {
+        if (strcmp(name, EFFECT_NAMES[i]) == 0) {
+            *out = (Effect)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool LedEngine::begin(int pin, uint8_t count) {
+    _count = (count < LED_MAX) ? count : LED_MAX;
+    // Un bloc mémoire RMT: le pilote le recharge par interruption pendant l'envoi
+    _rmt = rmtInit(pin, true, RMT_MEM_64);
+    if (!_rmt) return false;
+    rmtSetTick(_rmt, LED_RMT_TICK_NS);
+    _lastFrameMs = millis();
+    _shownValid = false;
+    return true;
+}
+
+void LedEngine::setEffect(Effect e) {
+    if (e >= EFFECT_COUNT) return;
+    _effect = e;
+    memset(_flash, 0, sizeof(_flash));
+}
+
+void LedEngine::setBaseColor(uint8_t r, uint8_t g, uint8_t b) {
+    _base[0] = r;
+    _base[1] = g;
+    _base[2] = b;
+}
+
+void LedEngine::keyPressed(uint8_t led) {
+    if (led < LED_MAX) _flash[led] = 255;
+}
+
+bool LedEngine::animating() const {
+    if (_effect == BREATHING || _effect == WAVE) return true;
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_flash[i]) return true;
+    }
+    return false;   // Trame sur le fil: le pilote RMT tient son verrou PM jusqu'à la fin
+}
+
+void LedEngine::_advance(uint32_t frames) {
+    _breathPhase += (uint16_t)(frames * LED_BREATH_STEP);
+    _wavePhase += (uint16_t)(frames * LED_WAVE_STEP);
+    uint32_t n = (frames < LED_MAX_CATCHUP) ? frames : LED_MAX_CATCHUP;
+    for (uint8_t i = 0; i < LED_MAX; i++) {
+        uint8_t f = _flash[i];
+        for (uint32_t k = 0; k < n && f; k++) {
+            uint8_t d = (f >> LED_REACTIVE_DECAY_SHIFT) + 1;
+            f = (f > d) ? f - d : 0;
+        }
+        _flash[i] = f;
+    }
+}
+
+void LedEngine::_render(uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t* px = _frame[i];
+        uint8_t level;
+        switch (_effect) {
+        case REACTIVE:
+            // Fond → blanc selon l'intensité du flash
+            for (uint8_t c = 0; c < 3; c++) {
+                px[c] = _base[c] + scale8(255 - _base[c], _flash[i]);
+            }
+            break;
+        case BREATHING:
+            level = breath8(_breathPhase);
+            for (uint8_t c = 0; c < 3; c++) px[c] = scale8(_base[c], level);
+            break;
+        case WAVE:
+            level = breath8(_wavePhase + (uint16_t)(i * LED_WAVE_SPACING));
+            for (uint8_t c = 0; c < 3; c++) px[c] = scale8(_base[c], level);
+            break;
+        default:
+            px[0] = _base[0];
+            px[1] = _base[1];
+            px[2] = _base[2];
+            break;
+        }
+        for (uint8_t c = 0; c < 3; c++) px[c] = scale8(px[c], _brightness);
+    }
+}
+
+void LedEngine::_encode(rmt_data_t* items, uint8_t count) {
+    rmt_data_t* it = items;
+    for (uint8_t i = 0; i < count; i++) {
+        // Ordre WS2812: G, R, B
+        uint32_t grb = ((uint32_t)_frame[i][1] << 16) | ((uint32_t)_frame[i][0] << 8) | _frame[i][2];
+        for (uint32_t mask = 1UL << 23; mask; mask >>= 1, it++) {
+            bool one = (grb & mask) != 0;
+            it->level0 = 1;
+            it->duration0 = one ? LED_T1H : LED_T0H;
+            it->level1 = 0;
+            it->duration1 = one ? LED_T1L : LED_T0L;
+        }
+    }
+}
+
+void LedEngine::update(uint32_t nowMs) {
+    if (!_rmt) return;
+    uint32_t elapsed = nowMs - _lastFrameMs;
+    if (elapsed < LED_FRAME_MS) return;
+    // Cadence fixe: les phases avancent du nombre de trames écoulées, même si loop() a pris du retard
+    uint32_t frames = elapsed / LED_FRAME_MS;
+    _lastFrameMs += frames * LED_FRAME_MS;
+    _advance(frames);
+
+    uint32_t c0 = ESP.getCycleCount();
+    _render(_count);
+    _stats.frames++;
+    if (_shownValid && memcmp(_frame, _shown, (size_t)_count * 3) == 0) {
+        _stats.unchanged++;
+        return;
+    }
+    // Tampon libre: celui du rmtWrite() d'avant, dont l'envoi est fini puisque rmtWrite()
+    // attend la fin de l'envoi en cours (sémaphore TX du pilote) avant d'en lancer un autre.
+    // Trames espacées de LED_FRAME_MS: latch (≥ 280 us) toujours respecté
+    rmt_data_t* items = _items[_txBuf ^ 1];
+    _encode(items, _count);
+    uint32_t cycles = ESP.getCycleCount() - c0;
+    if (cycles > _stats.renderCyclesMax) _stats.renderCyclesMax = cycles;
+
+    if (!rmtWrite(_rmt, items, (size_t)_count * 24)) return;
+    _txBuf ^= 1;
+    memcpy(_shown, _frame, (size_t)_count * 3);
+    _shownValid = true;
+    _stats.pushes++;
+}
+
+void LedEngine::benchmark(uint16_t frames) {
+    if (frames == 0) return;
+    rmt_data_t* items = _items[_txBuf ^ 1];   // Jamais celui que le pilote peut encore lire
+
+    Effect savedEffect = _effect;
+    uint16_t savedBreath = _breathPhase, savedWave = _wavePhase;
+    uint8_t savedFlash[LED_MAX];
+    memcpy(savedFlash, _flash, sizeof(_flash));
+    uint32_t mhz = getCpuFrequencyMhz();
+
+    for (uint8_t e = 0; e < EFFECT_COUNT; e++) {
+        _effect = (Effect)e;
+        uint32_t c0 = ESP.getCycleCount();
+        for (uint16_t n = 0; n < frames; n++) {
+            if ((n & 7) == 0) _flash[(n >> 3) % LED_MAX] = 255;
+            _advance(1);
+            _render(LED_MAX);
+            _encode(items, LED_MAX);
+        }
+        uint32_t perFrame = (ESP.getCycleCount() - c0) / frames;
+        LOG_I(LOGF_LED_BENCH, (unsigned)LED_MAX, perFrame, perFrame / mhz, mhz, effectName(_effect));
+    }
+
+    _effect = savedEffect;
+    _breathPhase = savedBreath;
+    _wavePhase = savedWave;
+    memcpy(_flash, savedFlash, sizeof(_flash));
+    LOG_I(LOGF_LED_STATS, _stats.frames, _stats.pushes, _stats.unchanged, _stats.renderCyclesMax);
+}
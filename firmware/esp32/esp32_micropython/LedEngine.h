@@ -0,0 +1,74 @@
+/*
+ * LedEngine.h — Effets RGB par trames (virgule fixe) + sortie WS2812 par RMT non bloquante
+ *
+ * update() rend une trame toutes les LED_FRAME_MS (statique, réactif, respiration, vague),
+ * entiers uniquement: phase sur 16 bits (65536 = une période), niveaux sur 8 bits.
+ * La trame n'est envoyée que si elle diffère de la dernière envoyée: les bits sont
+ * encodés en impulsions RMT et rmtWrite() rend la main tout de suite (pas de show()
+ * bloquant, interruptions actives). Deux tampons d'items alternés: le pilote lit l'un
+ * pendant l'envoi, la trame suivante est encodée dans l'autre.
+ */
+#ifndef LED_ENGINE_H
+#define LED_ENGINE_H
+
+#include "Config.h"
+#include <esp32-hal-rmt.h>
+
+class LedEngine {
+public:
+    enum Effect : uint8_t { STATIC, REACTIVE, BREATHING, WAVE, EFFECT_COUNT };
+
+    struct Stats {
+        uint32_t frames;          // Trames rendues
+        uint32_t pushes;          // Trames envoyées (différentes de la précédente)
+        uint32_t unchanged;       // Trames identiques: rien envoyé
+        uint32_t renderCyclesMax; // Rendu + encodage RMT, pire trame
+    };
+
+    bool begin(int pin, uint8_t count);
+    void update(uint32_t nowMs);
+
+    void setEffect(Effect e);
+    Effect effect() const { return _effect; }
+    static const char* effectName(Effect e);
+    static bool effectFromName(const char* name, Effect* out);
+
+    // Couleur de fond (rétro-éclairage ambiant), modulée par l'effet
+    void setBaseColor(uint8_t r, uint8_t g, uint8_t b);
+    // Échelle globale appliquée à l'envoi (équivalent de Adafruit_NeoPixel::setBrightness)
+    void setBrightness(uint8_t b) { _brightness = b; }
+    // Effet réactif: flash de la LED de la touche, décroissant trame après trame
+    void keyPressed(uint8_t led);
+    // Trames encore différentes d'une à l'autre (respiration, vague, flash en cours): pas de veille
+    bool animating() const;
+
+    // Coût CPU d'une trame (rendu + encodage) à LED_MAX LEDs pour chaque effet → logs
+    void benchmark(uint16_t frames);
+    const Stats& stats() const { return _stats; }
+
+private:
+    void _advance(uint32_t frames);
+    void _render(uint8_t count);
+    void _encode(rmt_data_t* items, uint8_t count);
+
+    rmt_obj_t* _rmt = nullptr;
+    uint8_t _count = 0;
+    Effect _effect = STATIC;
+    uint8_t _base[3] = {0, 0, 0};
+    uint8_t _brightness = 255;
+
+    uint16_t _breathPhase = 0;
+    uint16_t _wavePhase = 0;
+    uint8_t _flash[LED_MAX] = {};   // Intensité du flash réactif par LED (0..255)
+
+    uint8_t _frame[LED_MAX][3] = {};
+    uint8_t _shown[LED_MAX][3] = {};
+    bool _shownValid = false;
+    rmt_data_t _items[2][LED_MAX * 24];  // Un item par bit (GRB, MSB d'abord)
+    uint8_t _txBuf = 0;                  // Tampon passé au dernier rmtWrite()
+
+    uint32_t _lastFrameMs = 0;
+    Stats _stats = {};
+};
+
+#endif // LED_ENGINE_H
@@ -0,0 +1,142 @@
+/*
+ * LedFade.h — Fondus LED perceptuels: départ, cible, durée, évalués au temps écoulé
+ *
+ * Partagé par le sketch ESP32 (LED RGB) et atmega_light/main.cpp (PWM OC0B), inclus par
+ * chemin relatif comme LinkMessages.h. C++11, stdint uniquement, entiers seulement.
+ *
+ * Les valeurs sont des rapports cycliques 0..255. Au départ d'un fondu, chaque extrémité
+ * est convertie en clarté CIE L* (recherche dichotomique dans LED_CIE_LUT); l'interpolation
+ * se fait en clarté (pas réguliers pour l'œil) et LED_CIE_LUT redonne le rapport cyclique.
+ * Tous les canaux suivent la même progression: ils arrivent ensemble, exactement sur la cible.
+ *
+ * Coût d'update(): une multiplication 32 bits, puis par canal une multiplication 8×8 et une
+ * lecture de table (pas de division: la pente est calculée une fois dans start()).
+ * Temps en ms sur 16 bits (différences modulo 65536): durée ≤ 65535 ms.
+ */
+#ifndef LED_FADE_H
+#define LED_FADE_H
+
+#include <stdint.h>
+
+#if defined(__AVR__)
+#include <avr/pgmspace.h>
+#define LED_FADE_LUT_ATTR PROGMEM
+#define LED_FADE_LUT_READ(p) pgm_read_byte(p)
+#else
+#define LED_FADE_LUT_ATTR
+#define LED_FADE_LUT_READ(p) (*(p))
+#endif
+
+namespace ledfade {
+
+// Clarté L* (0..255 pour 0..100) → rapport cyclique (luminance CIE 1931 × 255, arrondie)
+static const uint8_t LED_CIE_LUT[256] LED_FADE_LUT_ATTR = {
+      0,   0,   0,   0,   0,   1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,
+      2,   2,   2,   2,   2,   2,   2,   3,   3,   3,   3,   3,   3,   3,   3,   4,
+      4,   4,   4,   4,   4,   5,   5,   5,   5,   5,   6,   6,   6,   6,   6,   7,
+      7,   7,   7,   8,   8,   8,   8,   9,   9,   9,  10,  10,  10,  10,  11,  11,
+     11,  12,  12,  12,  13,  13,  13,  14,  14,  15,  15,  15,  16,  16,  17,  17,
+     17,  18,  18,  19,  19,  20,  20,  21,  21,  22,  22,  23,  23,  24,  24,  25,
+     25,  26,  26,  27,  28,  28,  29,  29,  30,  31,  31,  32,  32,  33,  34,  34,
+     35,  36,  37,  37,  38,  39,  39,  40,  41,  42,  43,  43,  44,  45,  46,  47,
+     47,  48,  49,  50,  51,  52,  53,  54,  54,  55,  56,  57,  58,  59,  60,  61,
+     62,  63,  64,  65,  66,  67,  68,  70,  71,  72,  73,  74,  75,  76,  77,  79,
+     80,  81,  82,  83,  85,  86,  87,  88,  90,  91,  92,  94,  95,  96,  98,  99,
+    100, 102, 103, 105, 106, 108, 109, 110, 112, 113, 115, 116, 118, 120, 121, 123,
+    124, 126, 128, 129, 131, 132, 134, 136, 138, 139, 141, 143, 145, 146, 148, 150,
+    152, 154, 155, 157, 159, 161, 163, 165, 167, 169, 171, 173, 175, 177, 179, 181,
+    183, 185, 187, 189, 191, 193, 196, 198, 200, 202, 204, 207, 209, 211, 214, 216,
+    218, 220, 223, 225, 228, 230, 232, 235, 237, 240, 242, 245, 247, 250, 252, 255,
+};
+
+inline uint8_t cie(uint8_t lightness) {
+    return LED_FADE_LUT_READ(&LED_CIE_LUT[lightness]);
+}
+
+// Rapport cyclique → plus petite clarté qui l'atteint
+inline uint8_t lightness(uint8_t duty) {
+    uint8_t lo = 0, hi = 255;
+    while (lo < hi) {
+        uint8_t mid = lo + ((hi - lo) >> 1);
+        if (cie(mid) < duty) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+template <uint8_t N>
+class Fade {
+public:
+    // Fondu depuis la valeur courante vers target (N canaux); durée 0 = immédiat
+    void start(const uint8_t* target, uint16_t durationMs, uint16_t nowMs) {
+        for (uint8_t i = 0; i < N; i++) {
+            _target[i] = target[i];
+            _from[i] = lightness(_out[i]);
+            _to[i] = lightness(target[i]);
+        }
+        _t0 = nowMs;
+        _duration = durationMs;
+        _rate = durationMs ? (1UL << 24) / durationMs : 0;  // Progression Q24 par ms
+        _active = true;
+    }
+
+    // Relance seulement si la cible change: appels répétés avec la même cible sans effet
+    bool retarget(const uint8_t* target, uint16_t durationMs, uint16_t nowMs) {
+        for (uint8_t i = 0; i < N; i++) {
+            if (target[i] != _target[i]) {
+                start(target, durationMs, nowMs);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Valeur immédiate, fondu en cours abandonné
+    void set(const uint8_t* value) {
+        for (uint8_t i = 0; i < N; i++) _out[i] = _target[i] = value[i];
+        _active = false;
+    }
+
+    // Sortie au temps nowMs; true si elle a changé
+    bool update(uint16_t nowMs) {
+        if (!_active) return false;
+        uint16_t elapsed = nowMs - _t0;
+        bool changed = false;
+        if (elapsed >= _duration) {
+            _active = false;
+            for (uint8_t i = 0; i < N; i++) {
+                changed |= _out[i] != _target[i];
+                _out[i] = _target[i];
+            }
+            return changed;
+        }
+        uint8_t p = (uint8_t)(((uint32_t)elapsed * _rate) >> 16);  // 0..255
+        for (uint8_t i = 0; i < N; i++) {
+            uint8_t l = (_to[i] >= _from[i])
+                ? _from[i] + (uint8_t)(((uint16_t)(_to[i] - _from[i]) * p) >> 8)
+                : _from[i] - (uint8_t)(((uint16_t)(_from[i] - _to[i]) * p) >> 8);
+            uint8_t v = cie(l);
+            changed |= v != _out[i];
+            _out[i] = v;
+        }
+        return changed;
+    }
+
+    const uint8_t* value() const { return _out; }
+    uint8_t value(uint8_t i) const { return _out[i]; }
+    bool active() const { return _active; }
+
+private:
+    uint8_t _out[N] = {};
+    uint8_t _target[N] = {};
+    uint8_t _from[N] = {};     // Clartés des extrémités
+    uint8_t _to[N] = {};
+    uint16_t _t0 = 0;
+    uint16_t _duration = 0;
+    uint32_t _rate = 0;
+    bool _active = false;
+};
+
+}  // namespace ledfade
+
+#endif // LED_FADE_H
@@ -0,0 +1,343 @@
+/*
+ * LinkMessages.h — Messages ESP32 <-> ATmega: identifiants et contenu des trames
+ *
+ * Seule définition du protocole applicatif, incluse par le sketch ESP32 (Config.h)
+ * et par atmega_light/main.cpp (chemin relatif). Pas de dépendance hors
+ * stdint/string, C++11 (avr-g++ 5.4: -std=gnu++11 dans atmega_light.cppproj).
+ *
+ * Un message = une struct + la liste de ses champs dans l'ordre du fil:
+ *   typedef lmsg::Message<S, LMSG_U8(S, a), LMSG_STR(S, b)> XxxMsg;
+ * Les templates déroulent encodeur et décodeur à la compilation (offsets
+ * constants, ni table ni tampon intermédiaire):
+ *   lmsg::encode<XxxMsg>(s, buf, cap) → longueur écrite, 0 si cap insuffisant
+ *   lmsg::decode<XxxMsg>(data, len, s) → nombre de champs décodés: arrêt au
+ *     premier champ absent ou invalide, les champs précédents restent écrits
+ *     (les champs de fin sont optionnels).
+ *
+ * Champs (entiers little-endian):
+ *   LMSG_U8 / LMSG_U16   entier
+ *   LMSG_STR             [longueur][octets] sans '\0', longueur < taille du tableau
+ *   LMSG_SKIP_STR        [longueur][octets] ignorés à la réception, émis vide
+ *   LMSG_BYTES           [longueur][octets] reçus par pointeur dans le payload (zéro copie)
+ * Compatibilité: un nouveau champ s'ajoute en fin de message uniquement.
+ */
+#ifndef LINK_MESSAGES_H
+#define LINK_MESSAGES_H
+
+#include <stdint.h>
+#include <string.h>
+
+// ─── Trame (voir AtmegaLink.h) ──────────────────────────────────────────────
+// [SEQ][CMD][LEN][DATA × LEN][CRC16 lo][CRC16 hi], COBS + délimiteur 0x00
+#define LINK_HEADER_SIZE 3
+#define LINK_CRC_SIZE 2
+#define LINK_MAX_PAYLOAD 96
+#define LINK_FRAME_MAX (LINK_HEADER_SIZE + LINK_MAX_PAYLOAD + LINK_CRC_SIZE)
+
+// Raisons de NACK (payload [seq, raison])
+#define LINK_NACK_CRC 1
+#define LINK_NACK_LENGTH 2
+#define LINK_NACK_OVERFLOW 3
+
+// ─── Commandes ──────────────────────────────────────────────────────────────
+// Payload entre crochets; → réponse de l'ATmega (non acquittée)
+#define CMD_READ_LIGHT 0x01               // [] → LightLevelMsg (aussi poussé sur abonnement)
+#define CMD_SET_LED 0x02                  // [luminosité 0-255]
+#define CMD_GET_LED 0x03                  // [] → [luminosité]
+#define CMD_UPDATE_DISPLAY 0x04           // [] redessiner l'écran
+#define CMD_SET_DISPLAY_DATA 0x05         // DisplayDataMsg
+#define CMD_SET_DISPLAY_IMAGE 0x08        // ImageStartMsg
+#define CMD_SET_DISPLAY_IMAGE_CHUNK 0x09  // ImageChunkMsg
+#define CMD_SET_ATMEGA_DEBUG 0x0A         // [0/1] debug UART de l'ATmega
+#define CMD_SET_ATMEGA_LOG_LEVEL 0x0B     // [0-3]
+#define CMD_SET_LAST_KEY 0x0C             // LastKeyMsg
+#define CMD_LIGHT_SUBSCRIBE 0x0D          // LightSubscribeMsg → push CMD_READ_LIGHT
+
+// Liaison
+#define CMD_LINK_LOG 0x40        // ATmega → ESP32: ligne de log texte
+#define CMD_LINK_BAUD_CAPS 0x41  // [] → [masque des vitesses, index courant]
+#define CMD_LINK_BAUD_SET 0x42   // [index] l'ATmega bascule après son ACK
+#define CMD_LINK_BAUD_TEST 0x43  // [motif] renvoyé tel quel
+#define CMD_LINK_PING 0x44       // [jeton] renvoyé tel quel
+#define CMD_LINK_STATUS 0x45     // [] → LinkStatusMsg
+#define CMD_LINK_ACK 0x7E        // [seq] trame reçue intacte
+#define CMD_LINK_NACK 0x7F       // [seq, raison] trame rejetée
+
+// Index des vitesses partagé (ESP32: LINK_BAUD_RATES, ATmega: table UBRR)
+#define LINK_BAUD_COUNT 4
+
+#define LINK_STATUS_VERSION 1
+#define LINK_IMAGE_CHUNK_MAX 64  // Octets d'image par CMD_SET_DISPLAY_IMAGE_CHUNK
+
+// ─── Générateur ─────────────────────────────────────────────────────────────
+
+namespace lmsg {
+
+// Longueur ramenée au début d'une séquence UTF-8 coupée en fin de chaîne (champ rempli par
+// strlcpy, limite cap - 1): l'ATmega afficherait l'octet de tête seul comme du Latin-1 brut
+inline uint8_t utf8Boundary(const char* s, uint8_t n) {
+    uint8_t k = n;
+    while (k > 0 && ((uint8_t)s[k - 1] & 0xC0) == 0x80) k--;  // Octets de continuation
+    if (k == 0 || (uint8_t)s[k - 1] < 0xC0) return n;
+    uint8_t lead = (uint8_t)s[k - 1];
+    uint8_t len = (lead >= 0xF0) ? 4 : (lead >= 0xE0) ? 3 : 2;
+    return (n - (k - 1) < len) ? k - 1 : n;
+}
+
+// Chaîne [longueur][octets]: hors ligne, partagée par tous les champs LMSG_STR
+inline uint8_t* putStr(uint8_t* p, const uint8_t* end, const char* s, uint8_t cap) {
+    uint8_t n = 0;
+    while (n < cap - 1 && s[n]) n++;
+    n = utf8Boundary(s, n);
+    if (end - p < 1 + n) return nullptr;
+    *p++ = n;
+    memcpy(p, s, n);
+    return p + n;
+}
+
+inline const uint8_t* getStr(const uint8_t* p, const uint8_t* end, char* dst, uint8_t cap) {
+    if (p >= end) return nullptr;
+    uint8_t n = *p++;
+    if (n >= cap || n > end - p) return nullptr;
+    memcpy(dst, p, n);
+    dst[n] = '\0';
+    return p + n;
+}
+
+// put<CHECK>: CHECK = false quand la place est garantie à la compilation (encode sur
+// tableau >= MAX), les tests de fin disparaissent
+template <typename T, uint8_t T::*M>
+struct U8 {
+    static const uint8_t MAX = 1;
+    template <bool CHECK>
+    static uint8_t* put(uint8_t* p, const uint8_t* end, const T& m) {
+        if (CHECK && p >= end) return nullptr;
+        *p = m.*M;
+        return p + 1;
+    }
+    static const uint8_t* get(const uint8_t* p, const uint8_t* end, T& m) {
+        if (p >= end) return nullptr;
+        m.*M = *p;
+        return p + 1;
+    }
+};
+
+template <typename T, uint16_t T::*M>
+struct U16 {
+    static const uint8_t MAX = 2;
+    template <bool CHECK>
+    static uint8_t* put(uint8_t* p, const uint8_t* end, const T& m) {
+        if (CHECK && end - p < 2) return nullptr;
+        p[0] = (m.*M) & 0xFF;
+        p[1] = (m.*M) >> 8;
+        return p + 2;
+    }
+    static const uint8_t* get(const uint8_t* p, const uint8_t* end, T& m) {
+        if (end - p < 2) return nullptr;
+        m.*M = p[0] | (p[1] << 8);
+        return p + 2;
+    }
+};
+
+template <typename T, uint8_t N, char (T::*M)[N]>
+struct Str {
+    static const uint8_t MAX = N;
+    template <bool CHECK>
+    static uint8_t* put(uint8_t* p, const uint8_t* end, const T& m) { return putStr(p, end, m.*M, N); }
+    static const uint8_t* get(const uint8_t* p, const uint8_t* end, T& m) { return getStr(p, end, m.*M, N); }
+};
+
+template <typename T>
+struct SkipStr {
+    static const uint8_t MAX = 1;
+    template <bool CHECK>
+    static uint8_t* put(uint8_t* p, const uint8_t* end, const T&) {
+        if (CHECK && p >= end) return nullptr;
+        *p = 0;
+        return p + 1;
+    }
+    static const uint8_t* get(const uint8_t* p, const uint8_t* end, T&) {
+        if (p >= end || *p >= end - p) return nullptr;
+        return p + 1 + *p;
+    }
+};
+
+template <typename T, uint8_t MAXLEN, const uint8_t* T::*P, uint8_t T::*L>
+struct Bytes {
+    static const uint8_t MAX = 1 + MAXLEN;
+    template <bool CHECK>
+    static uint8_t* put(uint8_t* p, const uint8_t* end, const T& m) {
+        uint8_t n = m.*L;
+        if (n > MAXLEN || end - p < 1 + n) return nullptr;
+        *p++ = n;
+        memcpy(p, m.*P, n);
+        return p + n;
+    }
+    static const uint8_t* get(const uint8_t* p, const uint8_t* end, T& m) {
+        if (p >= end) return nullptr;
+        uint8_t n = *p++;
+        if (n > MAXLEN || n > end - p) return nullptr;
+        m.*P = p;
+        m.*L = n;
+        return p + n;
+    }
+};
+
+// Liste de champs: récursion déroulée par le compilateur
+template <typename T, typename... F>
+struct Message;
+
+template <typename T>
+struct Message<T> {
+    typedef T Type;
+    static const uint8_t MAX = 0;
+    template <bool CHECK>
+    static uint8_t* put(uint8_t* p, const uint8_t*, const T&) { return p; }
+    static uint8_t get(const uint8_t*, const uint8_t*, T&) { return 0; }
+};
+
+template <typename T, typename F, typename... R>
+struct Message<T, F, R...> {
+    typedef T Type;
+    static const uint8_t FIELDS = 1 + sizeof...(R);
+    static const uint8_t MAX = F::MAX + Message<T, R...>::MAX;  // Taille encodée maximale
+    static_assert(F::MAX + Message<T, R...>::MAX <= 255, "message trop long");
+    template <bool CHECK>
+    static uint8_t* put(uint8_t* p, const uint8_t* end, const T& m) {
+        p = F::template put<CHECK>(p, end, m);
+        if (CHECK && !p) return nullptr;
+        return Message<T, R...>::template put<CHECK>(p, end, m);
+    }
+    static uint8_t get(const uint8_t* p, const uint8_t* end, T& m) {
+        p = F::get(p, end, m);
+        return p ? 1 + Message<T, R...>::get(p, end, m) : 0;
+    }
+};
+
+// Tampon de taille quelconque (message plus long que le payload possible)
+template <typename M>
+uint8_t encode(const typename M::Type& m, uint8_t* buf, uint8_t cap) {
+    uint8_t* end = M::template put<true>(buf, buf + cap, m);
+    return end ? end - buf : 0;
+}
+
+// Tableau assez grand pour tout message: aucun test de place
+template <typename M, uint8_t N>
+uint8_t encode(const typename M::Type& m, uint8_t (&buf)[N]) {
+    static_assert(N >= M::MAX, "tampon plus petit que le message");
+    return M::template put<false>(buf, buf + N, m) - buf;
+}
+
+template <typename M>
+uint8_t decode(const uint8_t* data, uint8_t len, typename M::Type& m) {
+    return M::get(data, data + len, m);
+}
+
+}  // namespace lmsg
+
+#define LMSG_U8(T, f) lmsg::U8<T, &T::f>
+#define LMSG_U16(T, f) lmsg::U16<T, &T::f>
+#define LMSG_STR(T, f) lmsg::Str<T, sizeof(T::f), &T::f>
+#define LMSG_SKIP_STR(T) lmsg::SkipStr<T>
+#define LMSG_BYTES(T, max, f, n) lmsg::Bytes<T, max, &T::f, &T::n>
+
+// ─── Messages ───────────────────────────────────────────────────────────────
+
+// Écran (CMD_SET_DISPLAY_DATA, CMD_SET_LAST_KEY): décodé directement dans l'état
+// affiché de l'ATmega
+struct DisplayData {
+    uint8_t brightness;
+    char mode[8];                // "data", "image", "gif"
+    char profile[24];
+    char output[16];             // "usb", "bluetooth"
+    uint8_t keys;                // Touches configurées
+    char lastKey[16];
+    uint8_t backlightEnabled;
+    uint8_t backlightBrightness;
+    char device[24];             // Appareil connecté ("" = déduit de output)
+};
+
+typedef lmsg::Message<DisplayData,
+                      LMSG_U8(DisplayData, brightness),
+                      LMSG_STR(DisplayData, mode),
+                      LMSG_STR(DisplayData, profile),
+                      LMSG_STR(DisplayData, output),
+                      LMSG_U8(DisplayData, keys),
+                      LMSG_STR(DisplayData, lastKey),
+                      LMSG_U8(DisplayData, backlightEnabled),
+                      LMSG_U8(DisplayData, backlightBrightness),
+                      LMSG_SKIP_STR(DisplayData),  // Heure (réservé)
+                      LMSG_STR(DisplayData, device)>
+    DisplayDataMsg;
+
+// Chaînes bornées pour que l'écran complet tienne dans une trame (encodage sans test de place)
+static_assert(DisplayDataMsg::MAX <= LINK_MAX_PAYLOAD, "DisplayData plus long qu'un payload");
+
+// Rétroéclairage appliqué seulement si les 3 champs sont présents
+typedef lmsg::Message<DisplayData,
+                      LMSG_STR(DisplayData, lastKey),
+                      LMSG_U8(DisplayData, backlightEnabled),
+                      LMSG_U8(DisplayData, backlightBrightness)>
+    LastKeyMsg;
+
+struct LightSubscribe {
+    uint16_t delta;       // 0 = désabonnement
+    uint16_t threshold;
+    uint16_t hysteresis;
+    uint16_t intervalMs;  // Intervalle minimal entre deux push
+};
+
+typedef lmsg::Message<LightSubscribe,
+                      LMSG_U16(LightSubscribe, delta),
+                      LMSG_U16(LightSubscribe, threshold),
+                      LMSG_U16(LightSubscribe, hysteresis),
+                      LMSG_U16(LightSubscribe, intervalMs)>
+    LightSubscribeMsg;
+
+struct LightLevel {
+    uint16_t level;  // ADC filtré 0-1023
+};
+
+typedef lmsg::Message<LightLevel, LMSG_U16(LightLevel, level)> LightLevelMsg;
+
+struct ImageStart {
+    uint16_t size;  // Octets RGB565 attendus
+};
+
+typedef lmsg::Message<ImageStart, LMSG_U16(ImageStart, size)> ImageStartMsg;
+
+struct ImageChunk {
+    uint16_t index;       // Position = index × LINK_IMAGE_CHUNK_MAX octets
+    const uint8_t* data;  // Pixels RGB565 (poids fort d'abord), dans le payload reçu
+    uint8_t size;
+};
+
+typedef lmsg::Message<ImageChunk,
+                      LMSG_U16(ImageChunk, index),
+                      LMSG_BYTES(ImageChunk, LINK_IMAGE_CHUNK_MAX, data, size)>
+    ImageChunkMsg;
+
+// Trame d'état de l'ATmega: compteurs de liaison (LinkStats côté ATmega)
+struct LinkStatus {
+    uint8_t version;  // LINK_STATUS_VERSION
+    uint8_t baudIdx;
+    uint16_t rxFrames, txFrames, crcErrors, framingErrors, lineErrors, overruns;
+    uint16_t dropped, duplicates, unknownCmds, txFull;
+};
+
+typedef lmsg::Message<LinkStatus,
+                      LMSG_U8(LinkStatus, version),
+                      LMSG_U8(LinkStatus, baudIdx),
+                      LMSG_U16(LinkStatus, rxFrames),
+                      LMSG_U16(LinkStatus, txFrames),
+                      LMSG_U16(LinkStatus, crcErrors),
+                      LMSG_U16(LinkStatus, framingErrors),
+                      LMSG_U16(LinkStatus, lineErrors),
+                      LMSG_U16(LinkStatus, overruns),
+                      LMSG_U16(LinkStatus, dropped),
+                      LMSG_U16(LinkStatus, duplicates),
+                      LMSG_U16(LinkStatus, unknownCmds),
+                      LMSG_U16(LinkStatus, txFull)>
+    LinkStatusMsg;
+
+#endif // LINK_MESSAGES_H
@@ -0,0 +1,182 @@
+/*
+ * Log.cpp — Vidage différé de l'anneau de log (tâche priorité idle)
+ * Lecture type seqlock: un enregistrement réécrit pendant la copie est compté perdu.
+ */
+#include "Log.h"
+
+struct LogFmtEntry {
+    const char* fmt;
+    uint8_t sinks;
+};
+
+static const LogFmtEntry LOG_FMT_TABLE[LOGF_COUNT] = {
+#define LOG_FMT_ENTRY(name, sinks, fmt) {fmt, sinks},
+    LOG_FORMATS(LOG_FMT_ENTRY)
+#undef LOG_FMT_ENTRY
+};
+
+#define LOG_FLUSH_IDLE_MS 10
+#define LOG_COST_SAMPLES 8
+
+// Formater un enregistrement: parcourt le format et consomme les arguments dans l'ordre
+static void format_record(const LogRecord& r, char* out, size_t outlen) {
+    const char* f = (r.fmt < LOGF_COUNT) ? LOG_FMT_TABLE[r.fmt].fmt : "[LOG] fmt inconnu %u";
+    const uint8_t* arg = r.data;
+    const uint8_t* end = r.data + r.len;
+    size_t n = 0;
+    if (r.fmt >= LOGF_COUNT) {
+        snprintf(out, outlen, f, (unsigned)r.fmt);
+        return;
+    }
+    while (*f && n < outlen - 1) {
+        if (*f != '%') {
+            out[n++] = *f++;
+            continue;
+        }
+        // Spécificateur: %[0-9]*[duxXcs]
+        char spec[8];
+        uint8_t s = 0;
+        spec[s++] = *f++;
+        while (*f && strchr("0123456789-", *f) && s < sizeof(spec) - 2) spec[s++] = *f++;
+        char conv = *f ? *f++ : 0;
+        spec[s++] = conv;
+        spec[s] = '\0';
+        int w = 0;
+        if (conv == 's') {
+            const char* str = (arg < end) ? (const char*)arg : "";
+            w = snprintf(out + n, outlen - n, spec, str);
+            arg = end;
+        } else if (conv == '%') {
+            out[n++] = '%';
+            continue;
+        } else {
+            uint32_t v = 0;
+            if (arg + 4 <= end) {
+                memcpy(&v, arg, 4);
+                arg += 4;
+            }
+            w = snprintf(out + n, outlen - n, spec, (unsigned)v);
+        }
+        if (w > 0) n += min((size_t)w, outlen - 1 - n);
+    }
+    out[n] = '\0';
+}
+
+void Log::begin() {
+    // Mesure du coût d'écriture (anneau pas encore vidé: on rembobine ensuite)
+    uint32_t c0 = ESP.getCycleCount();
+    for (uint8_t i = 0; i < LOG_COST_SAMPLES; i++) {
+        write(LOG_LVL_DEBUG, LOGF_LOG_WRITE_COST, (uint32_t)i);
+    }
+    uint32_t cost = (ESP.getCycleCount() - c0) / LOG_COST_SAMPLES;
+    for (uint16_t i = 0; i < LOG_RING_SIZE; i++) _ring[i].seq.store(0, std::memory_order_relaxed);
+    _head.store(0, std::memory_order_relaxed);
+    _tail = 0;
+    write(LOG_LVL_INFO, LOGF_LOG_WRITE_COST, cost);
+
+    // Priorité idle: ne tourne que lorsque loop() et BLE sont bloqués
+    xTaskCreatePinnedToCore(_flushTask, "log_flush", 4096, this, tskIDLE_PRIORITY, nullptr, ARDUINO_RUNNING_CORE);
+}
+
+bool Log::_flushOne() {
+    uint32_t head = _head.load(std::memory_order_acquire);
+    if (_tail == head) return false;
+    if (head - _tail > LOG_RING_SIZE) {
+        // Producteurs ont fait le tour: les plus anciens sont écrasés
+        _lost += head - _tail - LOG_RING_SIZE;
+        _tail = head - LOG_RING_SIZE;
+    }
+
+    LogRecord& slot = _ring[_tail & (LOG_RING_SIZE - 1)];
+    uint32_t s1 = slot.seq.load(std::memory_order_acquire);
+    if (s1 != _tail + 1) {
+        if (s1 == 0 || s1 < _tail + 1) return false;  // Écriture en cours
+        _lost++;                                      // Déjà réécrit
+        _tail++;
+        return true;
+    }
+    LogRecord copy;
+    copy.ts_us = slot.ts_us;
+    copy.fmt = slot.fmt;
+    copy.level = slot.level;
+    copy.len = min<uint8_t>(slot.len, LOG_RECORD_DATA);
+    memcpy(copy.data, slot.data, LOG_RECORD_DATA);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint32_t s2 = slot.seq.load(std::memory_order_relaxed);
+    _tail++;
+    if (s2 != s1) {
+        _lost++;
+        return true;
+    }
+
+    char line[LOG_LINE_MAX];
+    format_record(copy, line, sizeof(line));
+    uint8_t sinks = (copy.fmt < LOGF_COUNT) ? LOG_FMT_TABLE[copy.fmt].sinks : LOG_SINK_SERIAL;
+    if (sinks & LOG_SINK_SERIAL) {
+        Serial.printf("%s\n", line);
+    }
+    if (_webSink && (sinks & (LOG_SINK_WEB_TX | LOG_SINK_WEB_RX))) {
+        portENTER_CRITICAL(&_webMux);
+        if (_webCount < LOG_WEB_LINES) {
+            WebLine& w = _web[(_webHead + _webCount) % LOG_WEB_LINES];
+            w.tx = (sinks & LOG_SINK_WEB_TX) != 0;
+            memcpy(w.msg, line, sizeof(w.msg));
+            _webCount++;
+        } else {
+            _webLost++;   // loop() en retard: la console web perd la ligne, Serial l'a eue
+        }
+        portEXIT_CRITICAL(&_webMux);
+    }
+    return true;
+}
+
+// Une ligne à la fois: copiée sous verrou, envoyée hors verrou
+void Log::pollWeb() {
+    WebLine w;
+    for (;;) {
+        portENTER_CRITICAL(&_webMux);
+        if (_webCount == 0) {
+            portEXIT_CRITICAL(&_webMux);
+            return;
+        }
+        w = _web[_webHead];
+        _webHead = (_webHead + 1) % LOG_WEB_LINES;
+        _webCount--;
+        portEXIT_CRITICAL(&_webMux);
+        if (_webSink) _webSink(w.tx ? "tx" : "rx", w.msg);
+    }
+}
+
+void Log::_flushTask(void* arg) {
+    Log* self = static_cast<Log*>(arg);
+    uint32_t reportedLost = 0;
+    for (;;) {
+        bool any = false;
+        while (self->_flushOne()) any = true;
+        if (self->_lost != reportedLost) {
+            Serial.printf("[LOG] %u records lost (ring overrun)\n", (unsigned)(self->_lost - reportedLost));
+            reportedLost = self->_lost;
+        }
+        if (!any) vTaskDelay(pdMS_TO_TICKS(LOG_FLUSH_IDLE_MS));
+    }
+}
+
+// Dump brut de l'anneau (hex, 1 enregistrement par ligne) pour log_decode.py
+void Log::dump(Print& out) {
+    uint32_t head = _head.load(std::memory_order_acquire);
+    out.printf("LOGDUMP BEGIN v1 rec=%u n=%u head=%u lost=%u\n",
+               (unsigned)sizeof(LogRecord), (unsigned)LOG_RING_SIZE, (unsigned)head, (unsigned)_lost);
+    char hex[sizeof(LogRecord) * 2 + 1];
+    static const char H[] = "0123456789ABCDEF";
+    for (uint16_t i = 0; i < LOG_RING_SIZE; i++) {
+        const uint8_t* raw = reinterpret_cast<const uint8_t*>(&_ring[i]);
+        if (_ring[i].seq.load(std::memory_order_relaxed) == 0) continue;
+        for (size_t b = 0; b < sizeof(LogRecord); b++) {
+            hex[b * 2] = H[raw[b] >> 4];
+            hex[b * 2 + 1] = H[raw[b] & 0x0F];
+        }
+        hex[sizeof(hex) - 1] = '\0';
+        out.printf("LOGDUMP %s\n", hex);
+    }
+    out.printf("LOGDUMP END\n");
+}
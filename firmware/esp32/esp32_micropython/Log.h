@@ -0,0 +1,141 @@
+/*
+ * Log.h — Journal binaire différé (anneau RAM sans verrou)
+ *
+ * Le site d'appel écrit seulement [ID de format + arguments bruts] dans un
+ * anneau de 256 enregistrements de 32 octets (quelques dizaines de cycles).
+ * Une tâche FreeRTOS de priorité idle formate ensuite vers Serial; les lignes pour
+ * le web sont remises à loop() (pollWeb) par un petit anneau sous verrou.
+ * Les niveaux au-dessus de LOG_LEVEL (Config.h) disparaissent à la compilation.
+ *
+ *   LOG_I(LOGF_HID_KEY_PRESSED, row, col, symbol.c_str());
+ *
+ * Dump: message web {"type":"log_dump"} → lignes "LOGDUMP ..." sur Serial,
+ * décodables avec firmware/tools/log_decode.py.
+ */
+#ifndef LOG_H
+#define LOG_H
+
+#include "Config.h"
+#include "LogFormats.h"
+#include <atomic>
+#include <type_traits>
+#include <esp_timer.h>
+
+#define LOG_LVL_NONE  0
+#define LOG_LVL_ERROR 1
+#define LOG_LVL_WARN  2
+#define LOG_LVL_INFO  3
+#define LOG_LVL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LVL_INFO
+#endif
+
+#define LOG_RING_SIZE 256      // Puissance de 2
+#define LOG_RECORD_DATA 20     // Octets d'arguments par enregistrement (5 entiers)
+#define LOG_LINE_MAX 160       // Ligne formatée
+#define LOG_WEB_LINES 8        // Lignes web en attente de loop() (au-delà: perdues, webLost)
+
+// Enregistrement brut — format du dump (little-endian, 32 octets)
+struct LogRecord {
+    std::atomic<uint32_t> seq;  // 0 = en cours d'écriture, sinon ticket + 1
+    uint32_t ts_us;             // esp_timer (µs, 32 bits bas)
+    uint16_t fmt;               // LogFmt
+    uint8_t level;
+    uint8_t len;                // Octets utilisés dans data
+    uint8_t data[LOG_RECORD_DATA];
+};
+static_assert(sizeof(LogRecord) == 32, "LogRecord: format du dump = 32 octets");
+
+class Log {
+public:
+    // dir = "tx" / "rx" (console web uart_log); appelé par pollWeb(), jamais par la tâche de vidage
+    using WebSink = void (*)(const char* dir, const char* msg);
+
+    void begin();
+    void setWebSink(WebSink sink) { _webSink = sink; }
+    void pollWeb();   // loop(): lignes web remises par la tâche de vidage → _webSink
+    void dump(Print& out);
+
+    uint32_t lost() const { return _lost; }
+    uint32_t webLost() const { return _webLost; }
+
+    template <typename... Args>
+    inline void write(uint8_t level, LogFmt fmt, Args... args) {
+        uint32_t ticket = _head.fetch_add(1, std::memory_order_relaxed);
+        LogRecord& r = _ring[ticket & (LOG_RING_SIZE - 1)];
+        r.seq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        uint8_t* p = r.data;
+        uint8_t* end = r.data + LOG_RECORD_DATA;
+        (void)end;
+        (_pack(p, end, args), ...);
+        r.ts_us = (uint32_t)esp_timer_get_time();
+        r.fmt = fmt;
+        r.level = level;
+        r.len = (uint8_t)(p - r.data);
+        r.seq.store(ticket + 1, std::memory_order_release);
+    }
+
+private:
+    LogRecord _ring[LOG_RING_SIZE];
+    std::atomic<uint32_t> _head{0};
+    uint32_t _tail = 0;          // Consommateur unique: tâche de vidage
+    uint32_t _lost = 0;
+    WebSink _webSink = nullptr;
+
+    // Anneau tâche de vidage → loop(): Serial, String et BLE ne sont touchés que par loop()
+    struct WebLine {
+        bool tx;
+        char msg[LOG_LINE_MAX];
+    };
+    WebLine _web[LOG_WEB_LINES];
+    uint8_t _webHead = 0;
+    uint8_t _webCount = 0;
+    uint32_t _webLost = 0;
+    portMUX_TYPE _webMux = portMUX_INITIALIZER_UNLOCKED;
+
+    template <typename T>
+    static inline typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+    _pack(uint8_t*& p, uint8_t* end, T v) {
+        if (p + 4 > end) return;
+        uint32_t w = (uint32_t)v;
+        memcpy(p, &w, 4);
+        p += 4;
+    }
+    // %s toujours en dernier: copié en ligne, tronqué à la place restante
+    static inline void _pack(uint8_t*& p, uint8_t* end, const char* s) {
+        if (p >= end) return;
+        while (s && *s && p < end - 1) *p++ = (uint8_t)*s++;
+        *p++ = 0;
+    }
+
+    static void _flushTask(void* arg);
+    bool _flushOne();
+};
+
+extern Log logger;
+
+// ─── Macros (supprimées à la compilation sous LOG_LEVEL) ──────────────────────
+#if LOG_LEVEL >= LOG_LVL_ERROR
+#define LOG_E(fmt, ...) logger.write(LOG_LVL_ERROR, fmt, ##__VA_ARGS__)
+#else
+#define LOG_E(fmt, ...) do {} while (0)
+#endif
+#if LOG_LEVEL >= LOG_LVL_WARN
+#define LOG_W(fmt, ...) logger.write(LOG_LVL_WARN, fmt, ##__VA_ARGS__)
+#else
+#define LOG_W(fmt, ...) do {} while (0)
+#endif
+#if LOG_LEVEL >= LOG_LVL_INFO
+#define LOG_I(fmt, ...) logger.write(LOG_LVL_INFO, fmt, ##__VA_ARGS__)
+#else
+#define LOG_I(fmt, ...) do {} while (0)
+#endif
+#if LOG_LEVEL >= LOG_LVL_DEBUG
+#define LOG_D(fmt, ...) logger.write(LOG_LVL_DEBUG, fmt, ##__VA_ARGS__)
+#else
+#define LOG_D(fmt, ...) do {} while (0)
+#endif
+
+#endif // LOG_H
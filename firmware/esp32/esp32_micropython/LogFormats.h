@@ -0,0 +1,73 @@
+/*
+ * LogFormats.h — Table des formats de log (ID → chaîne printf)
+ *
+ * Les sites d'appel n'écrivent que l'ID et les arguments bruts dans l'anneau;
+ * le formatage est fait plus tard par la tâche de vidage (Log.cpp) ou par
+ * l'outil hôte firmware/tools/log_decode.py, qui relit ce fichier.
+ *
+ * X(nom, sorties, format)
+ *   - Ajouter en FIN de liste uniquement: l'ID = position dans la table,
+ *     les dumps déjà capturés restent décodables.
+ *   - Spécificateurs supportés: %d %u %x %X %c %s (avec largeur/0, ex: %02X).
+ *     Chaque entier occupe 4 octets; %s doit être le dernier argument
+ *     (copié en ligne, tronqué à la place restante).
+ */
+#ifndef LOG_FORMATS_H
+#define LOG_FORMATS_H
+
+// Sorties: Serial toujours; WEB_TX / WEB_RX = aussi vers la console web (uart_log)
+#define LOG_SINK_SERIAL 0x01
+#define LOG_SINK_WEB_TX 0x02
+#define LOG_SINK_WEB_RX 0x04
+
+#define LOG_FORMATS(X) \
+    X(LOG_WRITE_COST,   LOG_SINK_SERIAL, "[LOG] Write cost: %u cycles/call") \
+    X(HID_KEY_PRESSED,  LOG_SINK_SERIAL, "[HID] Key [%u,%u] PRESSED: %s") \
+    X(UART_TX_CMD,      LOG_SINK_SERIAL, "[UART] Sent command 0x%02X (%u bytes payload)") \
+    X(UART_TX_PAYLOAD,  LOG_SINK_WEB_TX, "CMD 0x%02X + %u bytes [%08X]") \
+    X(UART_TX_NAME,     LOG_SINK_WEB_TX, "CMD 0x%02X %s") \
+    X(ATMEGA_LIGHT,     LOG_SINK_SERIAL, "[ATMEGA LIGHT] Level: %u") \
+    X(WEB_RX,           LOG_SINK_SERIAL, "[WEB_UI] Received %u bytes: %s") \
+    X(WEB_JSON_ERROR,   LOG_SINK_SERIAL, "[WEB_UI] JSON parse error: %s") \
+    X(WEB_UNKNOWN_TYPE, LOG_SINK_SERIAL, "[WEB_UI] Unknown message type: %s") \
+    X(LINK_QUEUE_FULL,  LOG_SINK_SERIAL, "[LINK] TX queue full, CMD 0x%02X dropped (%u queued)") \
+    X(LINK_RETRY,       LOG_SINK_SERIAL, "[LINK] Retry CMD 0x%02X seq %u (#%u)") \
+    X(LINK_DROPPED,     LOG_SINK_SERIAL, "[LINK] CMD 0x%02X seq %u dropped after retries") \
+    X(LINK_BAD_FRAME,   LOG_SINK_SERIAL, "[LINK] Bad RX frame (%u bytes, reason %u)") \
+    X(LINK_BAUD_OK,     LOG_SINK_SERIAL, "[LINK] %u baud OK: test %u B in %u us (%u B/s)") \
+    X(LINK_BAUD_FAIL,   LOG_SINK_SERIAL, "[LINK] %u baud failed (%u), back to %u") \
+    X(LINK_BAUD_NO_PEER, LOG_SINK_SERIAL, "[LINK] No baud reply from ATmega, retry in %u ms") \
+    X(LINK_THROUGHPUT,  LOG_SINK_SERIAL, "[LINK] %u baud: %u B/s payload, %u B/s wire") \
+    X(LINK_BACKPRESSURE, LOG_SINK_SERIAL, "[LINK] TX back-pressure: %u deferred writes, %u queue-full drops") \
+    X(BOOT_STAGE,       LOG_SINK_SERIAL, "[BOOT] %u us (t=%u ms): %s") \
+    X(BOOT_KEYS_LIVE,   LOG_SINK_SERIAL, "[BOOT] Keys live at %u ms (setup %u us)") \
+    X(BOOT_BLE_READY,   LOG_SINK_SERIAL, "[BOOT] BLE ready in %u ms (t=%u ms, ok=%u)") \
+    X(BOOT_FIRST_REPORT, LOG_SINK_SERIAL, "[BOOT] First HID report at %u ms (keys live at %u ms)") \
+    X(LED_BENCH,        LOG_SINK_SERIAL, "[LED] Bench %u LEDs: %u cycles/frame (%u us at %u MHz): %s") \
+    X(LED_STATS,        LOG_SINK_SERIAL, "[LED] %u frames, %u pushed, %u unchanged, render max %u cycles") \
+    X(BLE_CONN_OPEN,    LOG_SINK_SERIAL, "[BLE] Connected: interval %u us, latency %u, timeout %u ms (radio ~%u ppm)") \
+    X(BLE_CONN_REQUEST, LOG_SINK_SERIAL, "[BLE] Conn params request %u-%u us, latency %u: %s") \
+    X(BLE_CONN_UPDATED, LOG_SINK_SERIAL, "[BLE] Conn params: interval %u us, latency %u, timeout %u ms, status %u (radio ~%u ppm)") \
+    X(BLE_INIT,         LOG_SINK_SERIAL, "[BLE] Init %u ms, %u B heap used: %s") \
+    X(BLE_BENCH,        LOG_SINK_SERIAL, "[BLE] Notify bench: %u/%u reports in %u us (%u reports/s)") \
+    X(BLE_SLOT_SELECT,  LOG_SINK_SERIAL, "[BLE] Slot %u selected: %s") \
+    X(BLE_SLOT_ADV,     LOG_SINK_SERIAL, "[BLE] Slot %u advertising: %s") \
+    X(BLE_SLOT_CONNECTED, LOG_SINK_SERIAL, "[BLE] Slot %u host connected, switch took %u ms") \
+    X(BLE_SLOT_REJECTED, LOG_SINK_SERIAL, "[BLE] Host of slot %u rejected while slot %u is active") \
+    X(BLE_SLOT_BONDED,  LOG_SINK_SERIAL, "[BLE] Slot %u bonded (address type %u)") \
+    X(BLE_SLOT_CLEARED, LOG_SINK_SERIAL, "[BLE] Slot %u cleared") \
+    X(USB_HID_PROTOCOL, LOG_SINK_SERIAL, "[USB] HID %s protocol") \
+    X(POWER_MODE,       LOG_SINK_SERIAL, "[POWER] Idle after %u ms quiet (min %u MHz): %s") \
+    X(POWER_IDLE,       LOG_SINK_SERIAL, "[POWER] Idle after %u ms quiet: %s") \
+    X(POWER_WAKE,       LOG_SINK_SERIAL, "[POWER] Wake after %u ms idle: %s") \
+    X(POWER_WAKE_SLOW,  LOG_SINK_SERIAL, "[POWER] First report %u us after wake (budget %u us)") \
+    X(SCHED_OVERRUN,    LOG_SINK_SERIAL, "[SCHED] %u us > budget %u us (%u overruns since last warning): %s")
+
+enum LogFmt : uint16_t {
+#define LOG_FMT_ENUM(name, sinks, fmt) LOGF_##name,
+    LOG_FORMATS(LOG_FMT_ENUM)
+#undef LOG_FMT_ENUM
+    LOGF_COUNT
+};
+
+#endif // LOG_FORMATS_H
@@ -0,0 +1,230 @@
+/*
+ * PowerIdle.cpp — Verrous PM, réveil GPIO par niveau, mesures par état
+ */
+#include "PowerIdle.h"
+#include "Log.h"
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <esp_timer.h>
+#include <driver/gpio.h>
+#include <hal/gpio_ll.h>
+
+#define WAKE_MATCH_US 100000   // Front sans rapport HID dans ce délai (bruit, encodeur): pas mesuré
+
+static void IRAM_ATTR power_wake_isr(void* arg) {
+    static_cast<PowerIdle*>(arg)->onEdgeIsr();
+}
+
+const char* PowerIdle::modeName(Mode m) {
+    switch (m) {
+        case MODE_LIGHT_SLEEP: return "light_sleep";
+        case MODE_DFS:         return "dfs";
+        default:               return "wait";
+    }
+}
+
+void PowerIdle::begin(uint32_t idleAfterMs) {
+    _idleAfterMs = idleAfterMs;
+    _lastActivityMs = _stateSinceMs = millis();
+
+    for (uint8_t r = 0; r < NUM_ROWS; r++) _pins[_pinCount++] = ROW_PINS[r];
+    _pins[_pinCount++] = ENC_CLK_PIN;
+    _pins[_pinCount++] = ENC_DT_PIN;
+    _pins[_pinCount++] = ENC_SW_PIN;
+    esp_sleep_enable_gpio_wakeup();
+
+#if CONFIG_PM_ENABLE
+    // Light sleep automatique seulement avec CONFIG_FREERTOS_USE_TICKLESS_IDLE, sinon DFS seul
+    esp_pm_config_esp32s3_t cfg = {};
+    cfg.max_freq_mhz = getCpuFrequencyMhz();
+    cfg.min_freq_mhz = POWER_IDLE_MIN_MHZ;
+    cfg.light_sleep_enable = true;
+    if (esp_pm_configure(&cfg) == ESP_OK) {
+        _mode = MODE_LIGHT_SLEEP;
+    } else {
+        cfg.light_sleep_enable = false;
+        if (esp_pm_configure(&cfg) == ESP_OK) _mode = MODE_DFS;
+    }
+    if (_mode != MODE_WAIT &&
+        (esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "keypad", (esp_pm_lock_handle_t*)&_lockFreq) != ESP_OK ||
+         esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "keypad", (esp_pm_lock_handle_t*)&_lockSleep) != ESP_OK)) {
+        // Sans verrou, l'actif serait lui aussi ralenti: gestion d'énergie désactivée
+        cfg.min_freq_mhz = cfg.max_freq_mhz;
+        cfg.light_sleep_enable = false;
+        esp_pm_configure(&cfg);
+        _lockFreq = _lockSleep = nullptr;
+        _mode = MODE_WAIT;
+    }
+    if (_mode == MODE_LIGHT_SLEEP &&
+        esp_pm_lock_create(ESP_PM_NO_LIGHT_SLEEP, 0, "atmega", (esp_pm_lock_handle_t*)&_lockLink) != ESP_OK) {
+        // Sans verrou de liaison, des trames de l'ATmega seraient perdues en light sleep
+        cfg.light_sleep_enable = false;
+        esp_pm_configure(&cfg);
+        _lockLink = nullptr;
+        _mode = MODE_DFS;
+    }
+#endif
+    _hold(true);
+    LOG_I(LOGF_POWER_MODE, (unsigned)_idleAfterMs, (unsigned)POWER_IDLE_MIN_MHZ, modeName(_mode));
+}
+
+void PowerIdle::_hold(bool active) {
+#if CONFIG_PM_ENABLE
+    if (!_lockFreq || !_lockSleep) return;
+    if (active) {
+        esp_pm_lock_acquire((esp_pm_lock_handle_t)_lockFreq);
+        esp_pm_lock_acquire((esp_pm_lock_handle_t)_lockSleep);
+    } else {
+        esp_pm_lock_release((esp_pm_lock_handle_t)_lockSleep);
+        esp_pm_lock_release((esp_pm_lock_handle_t)_lockFreq);
+    }
+#else
+    (void)active;
+#endif
+}
+
+// Verrou de liaison: pris tant que la liaison est abonnée et que l'on n'est pas en veille
+void PowerIdle::_lockLinkSet(bool locked) {
+    if (locked == _linkLocked) return;
+    _linkLocked = locked;
+#if CONFIG_PM_ENABLE
+    if (!_lockLink) return;
+    if (locked) esp_pm_lock_acquire((esp_pm_lock_handle_t)_lockLink);
+    else esp_pm_lock_release((esp_pm_lock_handle_t)_lockLink);
+#endif
+}
+
+void PowerIdle::holdLink(bool held) {
+    _linkHeld = held;
+    _lockLinkSet(held && !_idle);
+}
+
+bool PowerIdle::linkResync() {
+    bool resync = _linkResync;
+    _linkResync = false;
+    return resync;
+}
+
+void PowerIdle::_account(uint32_t nowMs) {
+    uint32_t elapsed = nowMs - _stateSinceMs;
+    if (_idle) _st.idleMs += elapsed;
+    else _st.activeMs += elapsed;
+    _stateSinceMs = nowMs;
+}
+
+void PowerIdle::onActivity(uint32_t nowMs) {
+    _lastActivityMs = nowMs;
+    if (!_idle) return;
+    _account(nowMs);
+    _idle = false;
+    _hold(true);
+    if (_linkHeld) {
+        _lockLinkSet(true);
+        _linkResync = true;   // Trames de l'ATmega perdues pendant la veille (UART RX sans réveil)
+    }
+    LOG_I(LOGF_POWER_WAKE, (unsigned)(nowMs - _idleSinceMs), _wakePending ? "edge" : "activity");
+}
+
+void PowerIdle::onInput(uint32_t nowMs, uint32_t nowUs) {
+    if (_wakePending) {
+        _wakePending = false;
+        uint32_t us = nowUs - _wakeEdgeUs;
+        if (us < WAKE_MATCH_US) {
+            _st.wakeLastUs = us;
+            if (us > _st.wakeMaxUs) _st.wakeMaxUs = us;
+            if (us > POWER_WAKE_BUDGET_US) {
+                _st.overBudget++;
+                LOG_W(LOGF_POWER_WAKE_SLOW, (unsigned)us, (unsigned)POWER_WAKE_BUDGET_US);
+            }
+        }
+    }
+    onActivity(nowMs);
+}
+
+bool PowerIdle::due(uint32_t nowMs, bool busy) {
+    if (_idleAfterMs == 0) {
+        onActivity(nowMs);
+        return false;
+    }
+    if (busy) {
+        // Occupé (fondu LED, file HID...): réveil, sans relancer la période calme
+        if (_idle) {
+            uint32_t last = _lastActivityMs;
+            onActivity(nowMs);
+            _lastActivityMs = last;
+        }
+        return false;
+    }
+    return _idle || (nowMs - _lastActivityMs) >= _idleAfterMs;
+}
+
+void PowerIdle::sleep(uint32_t nowMs) {
+    if (!_idle) {
+        _account(nowMs);
+        _idle = true;
+        _idleSinceMs = nowMs;
+        _wakePending = false;
+        _st.entries++;
+        _hold(false);
+        _lockLinkSet(false);
+        LOG_I(LOGF_POWER_IDLE, (unsigned)(nowMs - _lastActivityMs), modeName(_mode));
+    }
+
+    _task = xTaskGetCurrentTaskHandle();
+    ulTaskNotifyTake(pdTRUE, 0);   // Notification restée d'une attente précédente (wake())
+    _edgeUs = 0;
+    _arm();
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(POWER_IDLE_WAIT_MS));
+    _disarm();
+
+    uint32_t edgeUs = _edgeUs;
+    if (edgeUs != 0) {
+        _st.edgeWakes++;
+        _wakePending = true;
+        _wakeEdgeUs = edgeUs;
+        onActivity(millis());   // Pleine cadence dès le passage suivant de loop()
+    } else {
+        _st.timerWakes++;
+    }
+}
+
+void PowerIdle::wake() {
+    TaskHandle_t t = (TaskHandle_t)_task;
+    if (t) xTaskNotifyGive(t);
+}
+
+// Lignes: colonnes à 0 (appelant), une touche tire sa ligne à 0. Encodeur: niveau opposé à l'actuel.
+// Niveau (le light sleep ne se réveille pas sur front); l'ISR coupe les interruptions aussitôt.
+void PowerIdle::_arm() {
+    for (uint8_t i = 0; i < _pinCount; i++) {
+        uint8_t pin = _pins[i];
+        bool low = (i < NUM_ROWS) || digitalRead(pin) == HIGH;
+        attachInterruptArg(pin, power_wake_isr, this, low ? ONLOW : ONHIGH);
+        gpio_wakeup_enable((gpio_num_t)pin, low ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+    }
+}
+
+void PowerIdle::_disarm() {
+    for (uint8_t i = 0; i < _pinCount; i++) {
+        gpio_wakeup_disable((gpio_num_t)_pins[i]);
+        detachInterrupt(_pins[i]);
+    }
+}
+
+void IRAM_ATTR PowerIdle::onEdgeIsr() {
+    // Interruption par niveau: coupée tout de suite (sinon relancée tant que la touche est tenue)
+    for (uint8_t i = 0; i < _pinCount; i++) gpio_ll_intr_disable(&GPIO, (gpio_num_t)_pins[i]);
+    if (_edgeUs == 0) _edgeUs = (uint32_t)esp_timer_get_time() | 1;
+    TaskHandle_t t = (TaskHandle_t)_task;
+    BaseType_t woken = pdFALSE;
+    if (t) vTaskNotifyGiveFromISR(t, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
+PowerIdle::Stats PowerIdle::stats(uint32_t nowMs) const {
+    Stats st = _st;
+    uint32_t elapsed = nowMs - _stateSinceMs;
+    if (_idle) st.idleMs += elapsed;
+    else st.activeMs += elapsed;
+    return st;
+}
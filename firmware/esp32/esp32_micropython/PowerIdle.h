@@ -0,0 +1,89 @@
+/*
+ * PowerIdle.h — Veille après une période calme: réveil sur front (touches, encodeur)
+ *
+ * Actif: verrous PM tenus (CPU au maximum, pas de light sleep), comportement inchangé.
+ * Après idleAfterMs sans touche, encodeur ni message web (et rien d'occupé: USB, files HID,
+ * LED animée...), loop() appelle sleep(): verrous rendus, lignes de la matrice (colonnes à 0
+ * par l'appelant) et encodeur armés en réveil GPIO par niveau, tâche bloquée jusqu'au
+ * premier front ou POWER_IDLE_WAIT_MS (entretien: BLE, liaison, web). Pendant l'attente:
+ *   - MODE_LIGHT_SLEEP: light sleep automatique (esp_pm + tickless idle), la connexion BLE
+ *     est tenue par le contrôleur entre deux événements. L'UART RX ne réveille pas le light
+ *     sleep: le verrou de liaison (holdLink) est rendu en veille et repris au réveil, où
+ *     linkResync() demande de relire l'état de l'ATmega (pushes perdus pendant la veille)
+ *   - MODE_DFS: build sans tickless idle, fréquence CPU abaissée à POWER_IDLE_MIN_MHZ
+ *   - MODE_WAIT: build sans gestion d'énergie, CPU en attente d'interruption (tâche idle)
+ *
+ * Mesures: temps par état, réveils, front → premier rapport HID (borne POWER_WAKE_BUDGET_US).
+ * loop() uniquement, sauf wake() (toute tâche) et l'ISR de réveil.
+ */
+#ifndef POWER_IDLE_H
+#define POWER_IDLE_H
+
+#include "Config.h"
+
+class PowerIdle {
+public:
+    enum Mode : uint8_t { MODE_WAIT, MODE_DFS, MODE_LIGHT_SLEEP };
+
+    struct Stats {
+        uint32_t entries;       // Passages en veille
+        uint32_t edgeWakes;     // Sorties de veille sur front (touche, encodeur)
+        uint32_t timerWakes;    // Réveils d'entretien (POWER_IDLE_WAIT_MS), veille continue
+        uint32_t activeMs;      // Temps par état (courant par état: voir ARCHITECTURE.md)
+        uint32_t idleMs;
+        uint32_t wakeLastUs;    // Front → premier rapport HID déposé
+        uint32_t wakeMaxUs;
+        uint32_t overBudget;    // Au-delà de POWER_WAKE_BUDGET_US
+    };
+
+    void begin(uint32_t idleAfterMs);
+    void setIdleAfterMs(uint32_t ms) { _idleAfterMs = ms; }   // 0: jamais de veille
+    uint32_t idleAfterMs() const { return _idleAfterMs; }
+
+    void onActivity(uint32_t nowMs);                 // Message web, réglage
+    void onInput(uint32_t nowMs, uint32_t nowUs);    // Touche, encodeur: rapport HID déposé
+    bool due(uint32_t nowMs, bool busy);             // busy: activité en cours, veille repoussée
+    void sleep(uint32_t nowMs);                      // Bloque jusqu'à un front ou POWER_IDLE_WAIT_MS
+    void wake();                                     // Toute tâche (ex. console BLE): fin d'attente
+    void holdLink(bool held);                        // ATmega abonné (pushes): pas de light sleep hors veille
+    bool linkHeld() const { return _linkLocked; }    // Verrou de liaison tenu (faux en veille)
+    bool linkResync();                               // Vrai une fois après la veille: état à relire
+
+    bool idle() const { return _idle; }
+    Mode mode() const { return _mode; }
+    static const char* modeName(Mode m);
+    Stats stats(uint32_t nowMs) const;
+
+    void onEdgeIsr();   // ISR de réveil (IRAM)
+
+private:
+    void _account(uint32_t nowMs);
+    void _hold(bool active);
+    void _lockLinkSet(bool locked);
+    void _arm();
+    void _disarm();
+
+    uint32_t _idleAfterMs = 0;
+    Mode _mode = MODE_WAIT;
+    bool _idle = false;
+    uint32_t _lastActivityMs = 0;
+    uint32_t _stateSinceMs = 0;
+    uint32_t _idleSinceMs = 0;
+    bool _wakePending = false;          // Front reçu, premier rapport pas encore mesuré
+    uint32_t _wakeEdgeUs = 0;
+    Stats _st = {};
+
+    // Broches de réveil copiées en RAM (lues par l'ISR, cache flash possiblement coupé)
+    uint8_t _pins[NUM_ROWS + 3] = {};
+    uint8_t _pinCount = 0;
+    volatile uint32_t _edgeUs = 0;      // Écrit par l'ISR (0: pas de front)
+    void* volatile _task = nullptr;     // Tâche en attente (loopTask)
+    void* _lockFreq = nullptr;          // esp_pm_lock_handle_t
+    void* _lockSleep = nullptr;
+    void* _lockLink = nullptr;          // NO_LIGHT_SLEEP: liaison abonnée, hors veille
+    bool _linkHeld = false;             // Abonnement (holdLink)
+    bool _linkLocked = false;
+    bool _linkResync = false;           // Réveil après une veille sans verrou de liaison
+};
+
+#endif // POWER_IDLE_H
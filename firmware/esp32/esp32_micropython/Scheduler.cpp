@@ -0,0 +1,242 @@
+/*
+ * Scheduler.cpp — Roue d'échéances hiérarchique, choix par priorité, mesures par tâche
+ */
+#include "Scheduler.h"
+#include "Log.h"
+#include <string.h>
+
+static_assert(SCHED_MAX_TASKS <= 32, "masque des tâches prêtes sur 32 bits");
+static_assert(SCHED_MAX_TASKS < Scheduler::NONE, "ids sur 8 bits");
+static_assert(SCHED_WHEEL_LEVELS >= 1 && SCHED_WHEEL_LEVELS * 64 < Scheduler::NONE, "cases sur 8 bits");
+
+void Scheduler::begin(Clock clock) {
+    _clock = clock;
+    _lastUs = _clock();
+    _fracUs = 0;
+    _nowMs = _wheelMs = 0;
+    _ready = 0;
+    _inWheel = 0;
+    memset(_slots, NONE, sizeof(_slots));
+}
+
+uint8_t Scheduler::add(const char* name, Fn fn, uint32_t periodMs, uint8_t prio, uint32_t budgetUs) {
+    if (_count >= SCHED_MAX_TASKS) return NONE;
+    Task& t = _t[_count];
+    memset(&t, 0, sizeof(t));
+    t.name = name;
+    t.fn = fn;
+    t.periodMs = periodMs;
+    t.prio = prio;
+    t.budgetUs = budgetUs;
+    t.slot = NONE;
+    return _count++;
+}
+
+// ─── Temps ──────────────────────────────────────────────────────────────────
+// Horloge en ms cumulée depuis des écarts µs: indifférente au rebouclage de micros() (~71 min)
+void Scheduler::_sync() {
+    uint32_t now = _clock();
+    _fracUs += now - _lastUs;
+    _lastUs = now;
+    _nowMs += _fracUs / 1000;
+    _fracUs %= 1000;
+}
+
+// ─── Roue ───────────────────────────────────────────────────────────────────
+// Niveau n: cases de 64^n ms. Une échéance va au plus bas niveau dont l'empan la contient;
+// la case d'un niveau supérieur est redistribuée quand le temps entre dans son bloc.
+void Scheduler::_insert(uint8_t id) {
+    Task& t = _t[id];
+    int32_t delta = (int32_t)(t.due - _wheelMs);
+    if (delta <= 0) {
+        _ready |= 1UL << id;
+        return;
+    }
+    uint8_t level = 0;
+    uint32_t at = t.due;
+    while ((uint32_t)delta >= (1UL << (WHEEL_BITS * (level + 1)))) {
+        if (++level == SCHED_WHEEL_LEVELS) {
+            // Au-delà de l'horizon: rangée au dernier bloc atteignable, reclassée à son passage
+            level = SCHED_WHEEL_LEVELS - 1;
+            at = _wheelMs + (1UL << (WHEEL_BITS * SCHED_WHEEL_LEVELS)) - 1;
+            break;
+        }
+    }
+    uint8_t slot = level * WHEEL_SIZE + ((at >> (WHEEL_BITS * level)) & (WHEEL_SIZE - 1));
+    t.slot = slot;
+    t.prev = NONE;
+    t.next = _slots[slot];
+    if (t.next != NONE) _t[t.next].prev = id;
+    _slots[slot] = id;
+    _inWheel++;
+}
+
+void Scheduler::_unlink(uint8_t id) {
+    Task& t = _t[id];
+    _ready &= ~(1UL << id);
+    if (t.slot == NONE) return;
+    if (t.prev != NONE) _t[t.prev].next = t.next;
+    else _slots[t.slot] = t.next;
+    if (t.next != NONE) _t[t.next].prev = t.prev;
+    t.slot = NONE;
+    _inWheel--;
+}
+
+void Scheduler::_cascade(uint8_t level) {
+    uint8_t slot = level * WHEEL_SIZE + ((_wheelMs >> (WHEEL_BITS * level)) & (WHEEL_SIZE - 1));
+    uint8_t id = _slots[slot];
+    _slots[slot] = NONE;
+    while (id != NONE) {
+        uint8_t next = _t[id].next;
+        _t[id].slot = NONE;
+        _inWheel--;
+        _insert(id);
+        id = next;
+    }
+}
+
+void Scheduler::_advance() {
+    if (_inWheel == 0) {
+        _wheelMs = _nowMs;
+        return;
+    }
+    while (_wheelMs != _nowMs) {
+        _wheelMs++;
+        for (uint8_t level = SCHED_WHEEL_LEVELS - 1; level > 0; level--) {
+            if ((_wheelMs & ((1UL << (WHEEL_BITS * level)) - 1)) == 0) _cascade(level);
+        }
+        _cascade(0);   // Case du niveau 0: toutes échues (delta <= 0 à la réinsertion)
+        if (_inWheel == 0) _wheelMs = _nowMs;
+    }
+}
+
+// ─── Armement ───────────────────────────────────────────────────────────────
+void Scheduler::start(uint8_t id, uint32_t delayMs) {
+    if (id >= _count) return;
+    _sync();
+    _advance();
+    Task& t = _t[id];
+    _unlink(id);
+    t.due = _nowMs + delayMs;
+    t.armed = true;
+    t.started = false;
+    _insert(id);
+}
+
+void Scheduler::trigger(uint8_t id, uint32_t delayMs) {
+    if (id < _count && !_t[id].armed) start(id, delayMs);
+}
+
+void Scheduler::cancel(uint8_t id) {
+    if (id >= _count) return;
+    _unlink(id);
+    _t[id].armed = false;
+}
+
+// ─── Exécution ──────────────────────────────────────────────────────────────
+uint8_t Scheduler::_pick(uint32_t ran) const {
+    uint32_t cand = _ready & ~ran;
+    uint8_t best = NONE;
+    for (uint8_t id = 0; cand; id++, cand >>= 1) {
+        if ((cand & 1) && (best == NONE || _t[id].prio < _t[best].prio)) best = id;
+    }
+    return best;
+}
+
+void Scheduler::_account(Task& t, uint32_t startUs, uint32_t lateUs, uint32_t execUs) {
+    Stats& st = t.st;
+    st.runs++;
+    st.lateSumUs += lateUs;
+    if (lateUs > st.lateMaxUs) st.lateMaxUs = lateUs;
+    if (t.periodMs && t.started) {
+        int32_t d = (int32_t)(startUs - t.lastStartUs - t.periodMs * 1000);
+        uint32_t jitter = (d < 0) ? -d : d;
+        st.jitterSumUs += jitter;
+        st.jitterCount++;
+        if (jitter > st.jitterMaxUs) st.jitterMaxUs = jitter;
+    }
+    t.lastStartUs = startUs;
+    t.started = true;
+    st.execLastUs = execUs;
+    if (execUs > st.execMaxUs) st.execMaxUs = execUs;
+
+    if (execUs <= t.budgetUs) return;
+    st.overruns++;
+    t.overrunsPending++;
+    if (!t.warned || _nowMs - t.warnedAtMs >= SCHED_WARN_MS) {
+        LOG_W(LOGF_SCHED_OVERRUN, (unsigned)execUs, (unsigned)t.budgetUs, (unsigned)t.overrunsPending, t.name);
+        t.warned = true;
+        t.warnedAtMs = _nowMs;
+        t.overrunsPending = 0;
+    }
+}
+
+void Scheduler::run() {
+    uint32_t ran = 0;
+    _sync();
+    _advance();
+    for (;;) {
+        uint8_t id = _pick(ran);
+        if (id == NONE) break;
+        ran |= 1UL << id;
+        _ready &= ~(1UL << id);
+
+        Task& t = _t[id];
+        uint32_t startUs = _lastUs;
+        uint32_t lateUs = (_nowMs - t.due) * 1000 + _fracUs;
+        if (t.periodMs) {
+            // Replanifiée avant l'appel: la tâche peut se désarmer (cancel) ou se décaler (start)
+            uint32_t next = t.due + t.periodMs;
+            if ((int32_t)(next - _nowMs) <= 0) {
+                t.st.skipped += (_nowMs - t.due) / t.periodMs;
+                next = _nowMs + t.periodMs;
+            }
+            t.due = next;
+            _insert(id);
+        } else {
+            t.armed = false;
+        }
+
+        t.fn(_nowMs);
+        uint32_t execUs = _clock() - startUs;
+        _sync();
+        _account(t, startUs, lateUs, execUs);
+        _advance();   // Échues pendant la tâche: la plus prioritaire passe avant les suivantes
+    }
+}
+
+uint32_t Scheduler::nextDueUs() {
+    _sync();
+    _advance();
+    if (_ready) return 0;
+    bool any = false;
+    uint32_t best = 0;
+    for (uint8_t id = 0; id < _count; id++) {
+        const Task& t = _t[id];
+        if (!t.armed) continue;
+        uint32_t delta = t.due - _nowMs;   // > 0: pas prête
+        if (!any || delta < best) best = delta;
+        any = true;
+    }
+    if (!any) return IDLE;
+    return best * 1000 - _fracUs;
+}
+
+void Scheduler::rebase() {
+    _sync();
+    _advance();
+    for (uint8_t id = 0; id < _count; id++) {
+        Task& t = _t[id];
+        if (!(_ready & (1UL << id)) || !t.periodMs) continue;
+        t.due = _nowMs;
+        t.started = false;
+    }
+}
+
+void Scheduler::resetStats() {
+    for (uint8_t id = 0; id < _count; id++) {
+        memset(&_t[id].st, 0, sizeof(Stats));
+        _t[id].started = false;
+        _t[id].overrunsPending = 0;
+    }
+}
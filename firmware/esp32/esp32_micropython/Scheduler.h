@@ -0,0 +1,108 @@
+/*
+ * Scheduler.h — Ordonnanceur coopératif de loop(): échéances dans une roue hiérarchique
+ *
+ * Tâches enregistrées une fois (add) avec leur période (0: ponctuelle, armée par start()),
+ * leur priorité (0 = la plus haute) et leur budget d'exécution. Les échéances sont rangées
+ * dans une roue à SCHED_WHEEL_LEVELS niveaux de 64 cases (1 ms, 64 ms, 4,096 s: ~4 min
+ * d'horizon, une échéance plus lointaine est reclassée au passage): armer, annuler et
+ * avancer d'une ms coûtent O(1) quel que soit le nombre de tâches.
+ *
+ * run() exécute les tâches échues par priorité, chacune une fois par appel. L'horloge est
+ * relue après chaque tâche: une tâche plus prioritaire échue entre-temps (chemin HID) passe
+ * avant les suivantes. Une tâche périodique en retard de plus d'une période n'est pas
+ * rejouée en rafale (périodes sautées comptées).
+ *
+ * Mesures par tâche: retard au départ sur l'échéance, gigue (écart entre deux départs et la
+ * période), durée, dépassements de budget (LOG_W, un par SCHED_WARN_MS au plus).
+ * Temps lu sur l'horloge passée à begin() (µs): tourne en temps virtuel sur l'hôte.
+ * loop() uniquement (tâches, start() et cancel() compris).
+ */
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include "Config.h"
+
+class Scheduler {
+public:
+    using Fn = void (*)(uint32_t nowMs);
+    using Clock = uint32_t (*)();   // µs, reboucle sur 32 bits (micros())
+
+    static const uint8_t NONE = 0xFF;
+    static const uint32_t IDLE = 0xFFFFFFFF;
+
+    struct Stats {
+        uint32_t runs;
+        uint32_t lateMaxUs;     // Départ - échéance
+        uint64_t lateSumUs;
+        uint32_t jitterMaxUs;   // |intervalle entre deux départs - période| (périodiques)
+        uint64_t jitterSumUs;
+        uint32_t jitterCount;
+        uint32_t execLastUs;
+        uint32_t execMaxUs;
+        uint32_t overruns;      // Durée > budget
+        uint32_t skipped;       // Périodes sautées (retard > période)
+    };
+
+    void begin(Clock clock);
+    // Tâche non armée (start() pour la lancer); NONE si SCHED_MAX_TASKS est atteint
+    uint8_t add(const char* name, Fn fn, uint32_t periodMs, uint8_t prio, uint32_t budgetUs);
+    void start(uint8_t id, uint32_t delayMs);    // (Re)arme: échéance dans delayMs (0: prochain run())
+    void trigger(uint8_t id, uint32_t delayMs);  // Arme seulement si elle ne l'est pas (coalescence)
+    void cancel(uint8_t id);
+    bool armed(uint8_t id) const { return id < _count && _t[id].armed; }
+
+    void run();
+    uint32_t nextDueUs();   // Délai avant la prochaine échéance, 0 si une tâche est échue, IDLE sinon
+    void rebase();          // Après une attente voulue (veille): échéances dépassées ramenées à maintenant
+
+    uint8_t count() const { return _count; }
+    const char* name(uint8_t id) const { return _t[id].name; }
+    uint32_t periodMs(uint8_t id) const { return _t[id].periodMs; }
+    uint8_t prio(uint8_t id) const { return _t[id].prio; }
+    uint32_t budgetUs(uint8_t id) const { return _t[id].budgetUs; }
+    const Stats& stats(uint8_t id) const { return _t[id].st; }
+    void resetStats();
+
+private:
+    struct Task {
+        const char* name;
+        Fn fn;
+        uint32_t periodMs;
+        uint32_t budgetUs;
+        uint8_t prio;
+        bool armed;
+        uint8_t slot;          // Case (niveau × 64 + index) tant que dans la roue, NONE sinon
+        uint8_t prev, next;    // Liste de la case
+        uint32_t due;          // Échéance (ms de l'ordonnanceur)
+        uint32_t lastStartUs;
+        bool started;          // lastStartUs valide (gigue)
+        bool warned;
+        uint32_t warnedAtMs;
+        uint32_t overrunsPending;   // Dépassements depuis le dernier avertissement
+        Stats st;
+    };
+
+    static const uint8_t WHEEL_BITS = 6;
+    static const uint8_t WHEEL_SIZE = 1 << WHEEL_BITS;
+
+    void _sync();
+    void _advance();
+    void _insert(uint8_t id);
+    void _unlink(uint8_t id);
+    void _cascade(uint8_t level);
+    uint8_t _pick(uint32_t ran) const;
+    void _account(Task& t, uint32_t startUs, uint32_t lateUs, uint32_t execUs);
+
+    Clock _clock = nullptr;
+    uint32_t _lastUs = 0;
+    uint32_t _fracUs = 0;      // µs pas encore comptés dans _nowMs
+    uint32_t _nowMs = 0;       // Horloge de l'ordonnanceur (ms, part de 0 à begin())
+    uint32_t _wheelMs = 0;     // Dernière ms traitée par la roue
+    uint32_t _ready = 0;       // Tâches échues (bit = id)
+    uint8_t _inWheel = 0;      // Tâches rangées dans la roue (0: la roue saute au temps courant)
+    uint8_t _slots[SCHED_WHEEL_LEVELS * WHEEL_SIZE];
+    Task _t[SCHED_MAX_TASKS] = {};
+    uint8_t _count = 0;
+};
+
+#endif // SCHEDULER_H
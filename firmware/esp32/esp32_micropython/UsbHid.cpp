@@ -0,0 +1,186 @@
+/*
+ * UsbHid.cpp — Interface HID TinyUSB: descripteurs, envoi direct, mesure des transferts IN
+ */
+#include "UsbHid.h"
+#include "Log.h"
+#include "esp32-hal-tinyusb.h"
+#include "tusb.h"
+#include <string.h>
+
+static UsbHid hid;
+
+UsbHid& usbHid() { return hid; }
+
+#define NKRO_REPORT_LEN (1 + HID_USB_NKRO_BITS / 8)   // Modificateurs + bitmap
+
+// Clavier 6 touches (format boot, LEDs en sortie), consumer 16 bits, clavier NKRO en bitmap
+static const uint8_t REPORT_DESC[] = {
+    TUD_HID_REPORT_DESC_KEYBOARD(HID_REPORT_ID(HID_USB_ID_KEYBOARD)),
+    TUD_HID_REPORT_DESC_CONSUMER(HID_REPORT_ID(HID_USB_ID_CONSUMER)),
+    HID_USAGE_PAGE(HID_USAGE_PAGE_DESKTOP),
+    HID_USAGE(HID_USAGE_DESKTOP_KEYBOARD),
+    HID_COLLECTION(HID_COLLECTION_APPLICATION),
+        HID_REPORT_ID(HID_USB_ID_NKRO)
+        HID_USAGE_PAGE(HID_USAGE_PAGE_KEYBOARD),
+        HID_USAGE_MIN(224),
+        HID_USAGE_MAX(231),
+        HID_LOGICAL_MIN(0),
+        HID_LOGICAL_MAX(1),
+        HID_REPORT_COUNT(8),
+        HID_REPORT_SIZE(1),
+        HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+        HID_USAGE_MIN(0),
+        HID_USAGE_MAX(HID_USB_NKRO_BITS - 1),
+        HID_REPORT_COUNT(HID_USB_NKRO_BITS),
+        HID_REPORT_SIZE(1),
+        HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+    HID_COLLECTION_END,
+};
+
+// Appelé par USB.begin() pendant la construction du descripteur de configuration
+static uint16_t load_descriptor(uint8_t* dst, uint8_t* itf) {
+    uint8_t str = tinyusb_add_string_descriptor("KeyPad HID");
+    uint8_t epIn = tinyusb_get_free_in_endpoint();
+    TU_VERIFY(epIn != 0);
+    // Sous-classe boot, protocole clavier: reconnu par les BIOS / UEFI
+    uint8_t desc[TUD_HID_DESC_LEN] = {
+        TUD_HID_DESCRIPTOR(*itf, str, HID_ITF_PROTOCOL_KEYBOARD, sizeof(REPORT_DESC), (uint8_t)(0x80 | epIn),
+                           HID_USB_EP_SIZE, HID_USB_INTERVAL_MS)
+    };
+    *itf += 1;
+    memcpy(dst, desc, sizeof(desc));
+    return sizeof(desc);
+}
+
+bool UsbHid::begin() {
+    return tinyusb_enable_interface(USB_INTERFACE_HID, TUD_HID_DESC_LEN, load_descriptor) == ESP_OK;
+}
+
+bool UsbHid::mounted() const {
+    return tud_mounted();
+}
+
+bool UsbHid::bootProtocol() const {
+    return tud_hid_n_get_protocol(0) == HID_PROTOCOL_BOOT;
+}
+
+bool UsbHid::nkro() const {
+    return HID_USB_NKRO && !bootProtocol();
+}
+
+bool UsbHid::_send(uint8_t id, const uint8_t* data, uint16_t len, uint32_t readyUs) {
+    if (!tud_hid_n_ready(0)) {
+        portENTER_CRITICAL(&_mux);
+        _st.busy++;
+        portEXIT_CRITICAL(&_mux);
+        return false;
+    }
+    // Avant l'envoi: la fin du transfert peut arriver (tâche USB) avant le retour de tud_hid_n_report()
+    portENTER_CRITICAL(&_mux);
+    _pending = true;
+    _pendingReadyUs = readyUs;
+    _pendingSentUs = micros();
+    portEXIT_CRITICAL(&_mux);
+
+    bool ok = tud_hid_n_report(0, id, data, len);
+
+    portENTER_CRITICAL(&_mux);
+    if (ok) {
+        _st.sent++;
+    } else {
+        _pending = false;
+        _st.busy++;
+    }
+    portEXIT_CRITICAL(&_mux);
+    return ok;
+}
+
+bool UsbHid::sendKeyboard(const uint8_t* report, uint32_t readyUs) {
+    if (bootProtocol()) return _send(0, report, 8, readyUs);   // Sans report ID
+    if (!nkro()) return _send(HID_USB_ID_KEYBOARD, report, 8, readyUs);
+
+    uint8_t bits[NKRO_REPORT_LEN] = {report[0]};
+    for (uint8_t i = 2; i < 8; i++) {
+        uint8_t k = report[i];
+        if (k != 0 && k < HID_USB_NKRO_BITS) bits[1 + k / 8] |= 1 << (k % 8);
+    }
+    return _send(HID_USB_ID_NKRO, bits, sizeof(bits), readyUs);
+}
+
+bool UsbHid::sendConsumer(uint16_t code, uint32_t readyUs) {
+    if (bootProtocol()) {
+        portENTER_CRITICAL(&_mux);
+        _st.bootDropped++;
+        portEXIT_CRITICAL(&_mux);
+        return true;  // Pas de consumer en boot: rapport consommé, pas réessayé
+    }
+    uint8_t data[2] = {(uint8_t)(code & 0xFF), (uint8_t)(code >> 8)};
+    return _send(HID_USB_ID_CONSUMER, data, sizeof(data), readyUs);
+}
+
+void UsbHid::onComplete() {
+    uint32_t now = micros();
+    portENTER_CRITICAL(&_mux);
+    if (_pending) {
+        _pending = false;
+        _st.completed++;
+        _st.lastUs = now - _pendingReadyUs;
+        _st.sumUs += _st.lastUs;
+        if (_st.lastUs > _st.maxUs) _st.maxUs = _st.lastUs;
+        _st.busLastUs = now - _pendingSentUs;
+        if (_st.busLastUs > _st.busMaxUs) _st.busMaxUs = _st.busLastUs;
+    }
+    portEXIT_CRITICAL(&_mux);
+}
+
+void UsbHid::onProtocol(uint8_t protocol) {
+    LOG_I(LOGF_USB_HID_PROTOCOL, protocol == HID_PROTOCOL_BOOT ? "boot" : "report");
+}
+
+UsbHid::Stats UsbHid::stats() const {
+    portENTER_CRITICAL(&_mux);
+    Stats st = _st;
+    portEXIT_CRITICAL(&_mux);
+    return st;
+}
+
+// ─── Callbacks TinyUSB (tâche USB) ─────────────────────────────────────────
+// Définis ici: la bibliothèque USBHID du core (qui a les siens) n'est plus incluse
+
+uint8_t const* tud_hid_descriptor_report_cb(uint8_t instance) {
+    (void)instance;
+    return REPORT_DESC;
+}
+
+// GET_REPORT (rare, à l'énumération): rapport vide, aucune touche
+uint16_t tud_hid_get_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t* buffer,
+                               uint16_t reqlen) {
+    (void)instance;
+    (void)report_type;
+    uint16_t len = (report_id == HID_USB_ID_CONSUMER) ? 2 : (report_id == HID_USB_ID_NKRO) ? NKRO_REPORT_LEN : 8;
+    if (len > reqlen) len = reqlen;
+    memset(buffer, 0, len);
+    return len;
+}
+
+// LEDs clavier de l'hôte (Verr. Num, Maj): ignorées
+void tud_hid_set_report_cb(uint8_t instance, uint8_t report_id, hid_report_type_t report_type, uint8_t const* buffer,
+                           uint16_t bufsize) {
+    (void)instance;
+    (void)report_id;
+    (void)report_type;
+    (void)buffer;
+    (void)bufsize;
+}
+
+void tud_hid_set_protocol_cb(uint8_t instance, uint8_t protocol) {
+    (void)instance;
+    hid.onProtocol(protocol);
+}
+
+void tud_hid_report_complete_cb(uint8_t instance, uint8_t const* report, uint16_t len) {
+    (void)instance;
+    (void)report;
+    (void)len;
+    hid.onComplete();
+}
@@ -0,0 +1,60 @@
+/*
+ * UsbHid.h — Interface HID USB propre (TinyUSB): clavier boot, NKRO, consumer, bInterval 1
+ *
+ * Une seule interface (sous-classe boot, protocole clavier) et un descripteur à report IDs:
+ * clavier 6 touches (HID_USB_ID_KEYBOARD), consumer (HID_USB_ID_CONSUMER), bitmap NKRO
+ * (HID_USB_ID_NKRO). En protocole boot (BIOS, UEFI), rapport clavier de 8 octets sans ID.
+ * Les rapports partent directement par tud_hid_report(), sans la couche ASCII ni l'attente
+ * de USBHID; un endpoint occupé rend false (HidRouter réessaie au tick suivant).
+ *
+ * Mesure: dépôt dans HidRouter → fin du transfert IN (rapport lu par l'hôte), et
+ * tud_hid_report() → fin du transfert IN (bus seul, ≤ bInterval si l'hôte suit).
+ * begin() avant USB.begin(); send*() depuis la tâche hid_tx; callbacks depuis la tâche USB.
+ */
+#ifndef USB_HID_H
+#define USB_HID_H
+
+#include "Config.h"
+
+class UsbHid {
+public:
+    struct Stats {
+        uint32_t sent;          // Rapports pris par TinyUSB
+        uint32_t completed;     // Transferts IN terminés
+        uint32_t busy;          // Endpoint occupé (réessayé)
+        uint32_t bootDropped;   // Consumer en protocole boot (aucun rapport possible)
+        uint32_t lastUs;        // Dépôt → fin du transfert IN
+        uint32_t maxUs;
+        uint64_t sumUs;
+        uint32_t busLastUs;     // tud_hid_report() → fin du transfert IN
+        uint32_t busMaxUs;
+    };
+
+    bool begin();               // Déclare l'interface (avant USB.begin())
+    bool mounted() const;       // Énuméré et configuré par l'hôte
+    bool bootProtocol() const;
+    bool nkro() const;          // Touches en bitmap (protocole report et HID_USB_NKRO)
+
+    // report: modificateurs, réservé, 6 touches; readyUs: dépôt (micros())
+    bool sendKeyboard(const uint8_t* report, uint32_t readyUs);
+    bool sendConsumer(uint16_t code, uint32_t readyUs);
+
+    Stats stats() const;
+
+    // Tâche USB (callbacks TinyUSB)
+    void onComplete();
+    void onProtocol(uint8_t protocol);
+
+private:
+    bool _send(uint8_t id, const uint8_t* data, uint16_t len, uint32_t readyUs);
+
+    Stats _st = {};
+    bool _pending = false;      // Un transfert IN en cours (endpoint unique)
+    uint32_t _pendingReadyUs = 0;
+    uint32_t _pendingSentUs = 0;
+    mutable portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+};
+
+UsbHid& usbHid();
+
+#endif // USB_HID_H
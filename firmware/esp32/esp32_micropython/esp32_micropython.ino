@@ -11,7 +11,7 @@
  * Si le numpad n'apparaît pas: brancher sur le port USB natif, pas sur UART.
  * Voir firmware/esp32/USB_CONNECTION.md pour clavier + IDE ouverte.
  *
- * Dépendances: Adafruit NeoPixel
+ * Dépendances: ArduinoJson 6.x (LEDs: RMT du core, voir LedEngine)
  * Arduino: Board = ESP32S3 Dev Module
  */
 
@@ -19,18 +19,21 @@
 #include "KeyMatrix.h"
 #include "Encoder.h"
 #include "HidOutput.h"
+#include "Log.h"
+#include "AtmegaLink.h"
+#include "LedEngine.h"
+#include "LedFade.h"
+#include "BleConnParams.h"
+#include "BleTransport.h"
+#include "BleSlots.h"
+#include "UsbHid.h"
+#include "PowerIdle.h"
+#include "Scheduler.h"
 
 #include <USB.h>
-#include <USBHIDKeyboard.h>
-#include <USBHIDConsumerControl.h>
-#include <BLEDevice.h>
-#include <BLEServer.h>
-#include <BLEUtils.h>
-#include <BLE2902.h>
 #include <Preferences.h>
 #include <ArduinoJson.h>
 #include <HardwareSerial.h>
-#include <Adafruit_NeoPixel.h>
 #include <Update.h>
 #include <string.h>
 
@@ -69,10 +72,15 @@ static int base64_decode(const char* in, size_t inlen, uint8_t* out, size_t outm
 KeyMatrix keyMatrix;
 Encoder encoder;
 HidOutput hidOutput;
+Log logger;
+AtmegaLink atmegaLink;
+LedEngine ledEngine;
+BleConnParams bleConn;
+BleSlots bleSlots;
+PowerIdle powerIdle;
+Scheduler scheduler;
 
 HardwareSerial SerialAtmega(1);
-USBHIDKeyboard Keyboard;
-USBHIDConsumerControl ConsumerControl;
 Preferences preferences;
 
 // Keymap par défaut (grille physique)
@@ -86,10 +94,7 @@ const char* DEFAULT_KEYMAP[NUM_ROWS][NUM_COLS] = {
 
 String KEYMAP[NUM_ROWS][NUM_COLS];
 
-// UART ATmega
-    String atmega_rx_buffer = "";
-unsigned long null_bytes_count = 0;
-unsigned long last_null_warning = 0;
+// UART ATmega (compteurs de liaison: atmegaLink.stats() / peer())
 uint16_t last_light_level = 0;
 
 // LED
@@ -98,17 +103,13 @@ int led_brightness = 128;
 bool backlight_enabled = true;
 bool env_brightness_enabled = false;  // Toggle "Selon l'environnement" du web
 
-// BLE (Bluedroid — Android, Windows, compatible)
-BLEServer* pServer = nullptr;
-BLECharacteristic* pInputCharacteristic = nullptr;
-BLECharacteristic* pSerialCharacteristic = nullptr;
+// BLE (bleTransport(): Bluedroid ou NimBLE selon BLE_STACK)
 bool deviceConnected = false;
 bool oldDeviceConnected = false;
 String bleSerialBuffer = "";
-bool BLE_AVAILABLE = false;
+volatile bool BLE_AVAILABLE = false;  // Écrit par la tâche ble_init (démarrage par étapes)
 
 String platformDetected = "unknown";
-Adafruit_NeoPixel ledStrip(LED_STRIP_COUNT, LED_STRIP_PIN, NEO_GRB + NEO_KHZ800);
 
 // OTA
 bool ota_in_progress = false;
@@ -118,32 +119,65 @@ size_t ota_file_size = 0;
 #define OTA_DECODE_BUF_SIZE 384  // Base64 decode buffer (256 bytes raw -> 344 chars base64)
 
 String last_key_pressed = "";
-unsigned long last_light_poll = 0;
 unsigned long last_last_key_send = 0;
 #define LAST_KEY_SEND_MIN_MS 500   // Throttle: évite double envoi sur un même appui
 uint16_t last_light_sent_to_web = 0xFFFF;  // Valeur invalide pour forcer premier envoi
-unsigned long last_light_send_time = 0;
-#define LIGHT_SEND_MIN_INTERVAL_MS 2000  // Throttle: max 1 envoi / 2 s (sauf si valeur change)
 unsigned long last_uart_log_to_web = 0;
-#define UART_LOG_TO_WEB_INTERVAL_MS 1000  // Throttle: max 1 uart_log / s vers web (éviter flood BLE)
+#define UART_LOG_TO_WEB_INTERVAL_MS 1000  // BLE: max 1 uart_log / s vers web (tâche uart_log, éviter flood BLE)
+const char* uart_log_pending_dir = "rx";
+String uart_log_pending;  // Dernière ligne en attente de la tâche uart_log (les précédentes sont fusionnées)
 
-// BLE Switch: PROFILE+1 maintenu 2s → déconnecte et permet de connecter un autre appareil
-unsigned long bleSwitchComboStart = 0;
-unsigned long bleSwitchLastTrigger = 0;
+// Démarrage par étapes (setup / BOOT_STAGES)
+unsigned long bootKeysLiveMs = 0;  // millis() en fin de setup(): matrice scannée, USB HID prêt
+bool bootFirstReport = false;
+uint8_t bootStage = 0;
 
-#define SERVICE_UUID_SERIAL "0000ffe0-0000-1000-8000-00805f9b34fb"
-#define CHAR_UUID_SERIAL "0000ffe1-0000-1000-8000-00805f9b34fb"
+// BLE Switch: PROFILE + 1/2/3 maintenus BLE_SWITCH_COMBO_MS → slot BLE 1/2/3 (BleSlots)
+int8_t bleSwitchComboSlot = -1;
+
+// Tâches de loop() (Scheduler), enregistrées dans setup()
+uint8_t taskHid, taskBoot, taskLink, taskBle, taskWeb, taskLed;
+uint8_t taskBleCombo, taskBleHello, taskLightWeb, taskUartLog, taskRestart;
 
 // ==================== DÉCLARATIONS FORWARD ====================
 void send_to_web(String data);
 void send_uart_log_to_web(const char* dir, const char* msg);
+void send_light_to_web(uint16_t light_value, bool force);
+void send_uart_log_line(const char* dir, const char* msg);
 void send_last_key_to_atmega();
 void update_per_key_leds();
 void set_key_led_pressed(int row, int col, bool pressed);
 void update_builtin_led_from_light();
+void led_strip_off();
+bool power_busy();
 
 // ==================== CALLBACKS (logique événementielle) ====================
 
+#if ENABLE_BLE_DEVICE_SWITCH
+// Slot du combo PROFILE(0,0) + 1/2/3 (ligne 3, colonnes 0..BLE_SLOT_COUNT-1), -1 sinon
+static int8_t ble_switch_combo_slot() {
+    if (!keyMatrix.isKeyPressed(0, 0)) return -1;
+    for (uint8_t c = 0; c < BLE_SLOT_COUNT; c++) {
+        if (keyMatrix.isKeyPressed(3, c)) return c;
+    }
+    return -1;
+}
+#endif
+
+// Délai jusqu'au premier rapport HID (touche ou encodeur), une fois par boot
+static void boot_note_report() {
+    if (bootFirstReport) return;
+    bootFirstReport = true;
+    LOG_I(LOGF_BOOT_FIRST_REPORT, (unsigned)millis(), (unsigned)bootKeysLiveMs);
+}
+
+// Touche ou encodeur: rapport HID déposé (premier rapport du boot, BLE actif, veille repoussée)
+static void note_input() {
+    boot_note_report();
+    bleConn.onActivity(millis());
+    powerIdle.onInput(millis(), micros());
+}
+
 void onKeyPress(uint8_t row, uint8_t col, bool pressed, bool isRepeat) {
     if (!pressed) return;
     String symbol = KEYMAP[row][col];
@@ -151,18 +185,17 @@ void onKeyPress(uint8_t row, uint8_t col, bool pressed, bool isRepeat) {
     if (isRepeat && !HidOutput::keyShouldRepeat(symbol)) return;
 
 #if ENABLE_BLE_DEVICE_SWITCH
-    // Ne pas envoyer si combo PROFILE+1 en cours (switch BLE)
-    if (keyMatrix.isKeyPressed(0, 0) && keyMatrix.isKeyPressed(3, 0)) return;
+    // Ne pas envoyer si combo PROFILE + 1/2/3 en cours (switch de slot BLE)
+    if (ble_switch_combo_slot() >= 0) return;
 #endif
 
-    Serial.printf("[HID] Key [%d,%d] PRESSED: %s\n", row, col, symbol.c_str());
+    LOG_I(LOGF_HID_KEY_PRESSED, row, col, symbol.c_str());
     last_key_pressed = symbol;
 
     hidOutput.sendKey(symbol, row, col);
+    note_input();
 
-    set_key_led_pressed(row, col, true);
-    delay(50);
-    update_per_key_leds();
+    set_key_led_pressed(row, col, true);  // Flash réactif rendu par LedEngine, sans attente
 
     String keypress_msg = "{\"type\":\"keypress\",\"row\":" + String(row) + ",\"col\":" + String(col) + "}";
     send_to_web(keypress_msg);
@@ -173,26 +206,37 @@ void onEncoderRotate(int8_t dir, uint8_t steps) {
     for (uint8_t i = 0; i < steps; i++) {
         if (dir > 0) hidOutput.sendVolumeUp();
         else hidOutput.sendVolumeDown();
-        // Android BLE: espacement requis entre rapports Consumer (sinon "volume max ou rien")
-        if (deviceConnected && i < steps - 1) delay(BLE_VOLUME_STEP_DELAY_MS);
+        note_input();
+        // Android BLE: espacement BLE_VOLUME_STEP_DELAY_MS tenu dans la file BLE, sans bloquer l'USB
     }
 }
 
 void onEncoderButton(bool pressed) {
-    if (pressed) hidOutput.sendMute();
+    if (pressed) {
+        hidOutput.sendMute();
+        note_input();
+    }
 }
 
 // ==================== DÉCLARATIONS FORWARD (suite) ====================
 
+void read_serial();
 void processWebMessage(String message);
 void send_atmega_command(uint8_t cmd, uint8_t* payload = nullptr, int payload_len = 0);
 void read_atmega_uart();
+bool on_atmega_frame(uint8_t cmd, const uint8_t* payload, uint8_t len);
+void send_link_stats_to_web();
+void send_power_to_web();
+void send_sched_to_web(bool reset);
+void send_ble_slots_to_web();
 void send_light_level();
+void subscribe_light_level();
 void send_last_key_to_atmega();
 void send_display_data_to_atmega();
 void handle_config_message(JsonObject& data);
 void handle_backlight_message(JsonObject& data);
 void handle_display_message(JsonObject& data);
+void handle_hid_route_message(JsonDocument& doc);
 void send_config_to_web();
 uint8_t count_configured_keys();
 void send_status_message(String message);
@@ -204,120 +248,91 @@ int row_col_to_led_index(int row, int col);
 void apply_keymap_defaults();
 
 // ==================== CALLBACKS BLE ====================
+// Tâche de la pile BLE (BleTransport::Callbacks)
+
+// Les rapports HID ne partent vers l'hôte qu'une fois accepté par BleSlots (loop)
+static void ble_on_connected(const uint8_t* addr, uint8_t addrType, uint16_t interval, uint16_t latency,
+                             uint16_t timeout) {
+    deviceConnected = true;
+    bleSlots.onConnect(addr);
+    BleConnParams::Params p = {interval, latency, timeout};
+    bleConn.onConnect(p);
+    Serial.println("[BLE] Client connected");
+}
 
-class MyServerCallbacks: public BLEServerCallbacks {
-    void onConnect(BLEServer* pSrv) override {
-        deviceConnected = true;
-        hidOutput.setBleState(true, pInputCharacteristic);
-        Serial.println("[BLE] Client connected");
-    }
-    void onDisconnect(BLEServer* pSrv) override {
-        deviceConnected = false;
-        hidOutput.setBleState(false, nullptr);
-        Serial.println("[BLE] Client disconnected");
-    }
-};
+static void ble_on_disconnected() {
+    deviceConnected = false;
+    bleSlots.onDisconnect();
+    bleConn.onDisconnect();  // File BLE fermée par loop() (HidRouter n'est pas touché depuis la tâche BT)
+    Serial.println("[BLE] Client disconnected");
+}
 
-class SerialCharacteristicCallbacks: public BLECharacteristicCallbacks {
-    void onWrite(BLECharacteristic* pCharacteristic) override {
-        String value = pCharacteristic->getValue();
-        if (value.length() > 0) {
-            bleSerialBuffer += value;
-        }
-    }
-};
+// Résultat de chaque négociation de paramètres (demandée par BleConnParams ou par l'hôte)
+static void ble_on_conn_params(uint8_t status, uint16_t interval, uint16_t latency, uint16_t timeout) {
+    BleConnParams::Params p = {interval, latency, timeout};
+    bleConn.onUpdate(status, p);
+}
+
+static void ble_on_paired(const uint8_t* addr, uint8_t addrType, bool bonded) {
+    bleSlots.onPaired(addr, addrType, bonded);
+}
+
+static void ble_on_serial(const uint8_t* data, size_t len) {
+    bleSerialBuffer.concat((const char*)data, len);
+    powerIdle.wake();  // Message web: loop() sort de l'attente de veille sans attendre POWER_IDLE_WAIT_MS
+}
+
+static bool ble_request_conn_params(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout) {
+    return bleTransport().requestConnParams(minInterval, maxInterval, latency, timeout);
+}
 
 // ==================== SETUP ====================
 
-void setup() {
-    // IMPORTANT: Tools > USB CDC On Boot: Enabled = Serial sur port USB natif.
-    //            Disabled = HID seul sur port USB natif; utiliser port UART pour Serial/flash.
-    // Délai pour laisser le port USB s'initialiser après le boot
-    delay(2000);
-    
-    Serial.begin(115200);
-    delay(500);
-    Serial.println("\n\n=== ESP32-S3 Macropad Initialization ===");
-    Serial.println("Migration complète depuis MicroPython");
-    
-    // Initialiser USB HID (clavier + Consumer Control pour volume/média)
+// Démarrage par étapes: setup() ne fait que le chemin critique d'une touche (USB HID,
+// keymap, LEDs, matrice, encodeur), sans delay(). Le reste (BOOT_STAGES) tourne ensuite
+// une étape par passage de la tâche boot (Scheduler), entre deux scans; BLE s'initialise dans une tâche de fond.
+// Chaque étape est chronométrée ([BOOT] ... us), ainsi que le premier rapport HID.
+
+static void boot_timed(const char* name, void (*stage)()) {
+    uint32_t t0 = micros();
+    stage();
+    LOG_I(LOGF_BOOT_STAGE, (unsigned)(micros() - t0), (unsigned)millis(), name);
+}
+
+// Envoi HID: files HidRouter vidées à leur cadence (USB 1 ms, BLE intervalle de connexion),
+// réveil par dépôt (HidOutput::setWake) ou à la prochaine échéance
+static TaskHandle_t hidTxTask = nullptr;
+
+static void hid_tx_wake() {
+    if (hidTxTask) xTaskNotifyGive(hidTxTask);
+}
+
+static void hid_tx_task(void*) {
+    for (;;) {
+        uint32_t waitUs = hidOutput.poll(micros());
+        TickType_t ticks = (waitUs == HidRouter::IDLE) ? portMAX_DELAY : pdMS_TO_TICKS((waitUs + 999) / 1000);
+        ulTaskNotifyTake(pdTRUE, ticks ? ticks : 1);
+    }
+}
+
+static void boot_usb() {
+    // Interface HID propre (clavier boot + NKRO + consumer, bInterval 1), déclarée avant USB.begin()
+    // Plus d'attente après USB.begin(): l'énumération continue en tâche de fond (TinyUSB)
+    bool hidOk = usbHid().begin();
     USB.begin();
-    delay(1000);
-    Keyboard.begin();
-    ConsumerControl.begin();
-    delay(1000);
-    Serial.println("[USB] USB HID initialized (Keyboard + Consumer Control)");
-    
-    // Initialiser BLE avec un nom qui indique clairement que c'est un clavier
-    // iPhone/iOS reconnaît mieux les appareils avec "Keyboard" dans le nom
-    try {
-        BLEDevice::init("Macropad Keyboard");
-        
-        // Configurer la sécurité BLE — évite échecs d’appairage iOS sur HID personnalisés
-        BLESecurity* pSecurity = new BLESecurity();
-        pSecurity->setAuthenticationMode(ESP_LE_AUTH_NO_BOND);
-        pSecurity->setCapability(ESP_IO_CAP_NONE);
-        pSecurity->setInitEncryptionKey(ESP_BLE_ENC_KEY_MASK | ESP_BLE_ID_KEY_MASK);
-        pServer = BLEDevice::createServer();
-        pServer->setCallbacks(new MyServerCallbacks());
-        BLEService* pService = pServer->createService(BLEUUID((uint16_t)0x1812));
-        uint8_t info[] = {0x01, 0x01, 0x00, 0x03};
-        BLECharacteristic* pInfo = pService->createCharacteristic(BLEUUID((uint16_t)0x2A4A), BLECharacteristic::PROPERTY_READ);
-        pInfo->setValue(info, 4);
-        uint8_t reportMap[] = {
-            0x05, 0x01, 0x09, 0x06, 0xA1, 0x01, 0x85, 0x01,
-            0x05, 0x07, 0x19, 0xE0, 0x29, 0xE7, 0x15, 0x00, 0x25, 0x01, 0x75, 0x01, 0x95, 0x08,
-            0x81, 0x02, 0x95, 0x01, 0x75, 0x08, 0x81, 0x01, 0x95, 0x06, 0x75, 0x08, 0x15, 0x00, 0x25, 0x81,
-            0x05, 0x07, 0x19, 0x00, 0x29, 0x81, 0x81, 0x00, 0xC0,
-            0x05, 0x0C, 0x09, 0x01, 0xA1, 0x01, 0x85, 0x02,
-            0x15, 0x00, 0x26, 0x9C, 0x02, 0x75, 0x10, 0x95, 0x01, 0x09, 0xE9, 0x09, 0xEA, 0x09, 0xE2, 0x09, 0xB5, 0x09, 0xB6, 0x09, 0xCD, 0x81, 0x00, 0xC0
-        };
-        BLECharacteristic* pMap = pService->createCharacteristic(BLEUUID((uint16_t)0x2A4B), BLECharacteristic::PROPERTY_READ);
-        pMap->setValue(reportMap, sizeof(reportMap));
-        uint8_t proto = 0x01;
-        BLECharacteristic* pProto = pService->createCharacteristic(BLEUUID((uint16_t)0x2A4E), BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_WRITE_NR);
-        pProto->setValue(&proto, 1);
-        uint8_t ctrl = 0x00;
-        BLECharacteristic* pCtrl = pService->createCharacteristic(BLEUUID((uint16_t)0x2A4C), BLECharacteristic::PROPERTY_WRITE_NR);
-        pCtrl->setValue(&ctrl, 1);
-        pInputCharacteristic = pService->createCharacteristic(BLEUUID((uint16_t)0x2A4D), BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY | BLECharacteristic::PROPERTY_WRITE_NR);
-        pInputCharacteristic->addDescriptor(new BLE2902());
-        uint8_t empty_report[9] = {0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-        pInputCharacteristic->setValue(empty_report, 9);
-        pService->start();
-        BLEService* pDevInfo = pServer->createService(BLEUUID((uint16_t)0x180A));
-        BLECharacteristic* pMfr = pDevInfo->createCharacteristic(BLEUUID((uint16_t)0x2A29), BLECharacteristic::PROPERTY_READ);
-        pMfr->setValue("Macropad");
-        BLECharacteristic* pModel = pDevInfo->createCharacteristic(BLEUUID((uint16_t)0x2A24), BLECharacteristic::PROPERTY_READ);
-        pModel->setValue("Keyboard");
-        pDevInfo->start();
-        BLEService* pBat = pServer->createService(BLEUUID((uint16_t)0x180F));
-        BLECharacteristic* pBatLev = pBat->createCharacteristic(BLEUUID((uint16_t)0x2A19), BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY);
-        pBatLev->addDescriptor(new BLE2902());
-        uint8_t bat = 100;
-        pBatLev->setValue(&bat, 1);
-        pBat->start();
-        BLEService* pSerialSvc = pServer->createService(BLEUUID(SERVICE_UUID_SERIAL));
-        pSerialCharacteristic = pSerialSvc->createCharacteristic(BLEUUID(CHAR_UUID_SERIAL), BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_WRITE | BLECharacteristic::PROPERTY_NOTIFY | BLECharacteristic::PROPERTY_WRITE_NR);
-        pSerialCharacteristic->addDescriptor(new BLE2902());
-        pSerialCharacteristic->setCallbacks(new SerialCharacteristicCallbacks());
-        pSerialSvc->start();
-        BLEAdvertising* pAdvertising = BLEDevice::getAdvertising();
-        pAdvertising->addServiceUUID(BLEUUID((uint16_t)0x1812));
-        pAdvertising->addServiceUUID(BLEUUID((uint16_t)0x180A));
-        pAdvertising->addServiceUUID(BLEUUID((uint16_t)0x180F));
-        pAdvertising->addServiceUUID(BLEUUID(SERVICE_UUID_SERIAL));
-        pAdvertising->setScanResponse(true);
-        pAdvertising->setMinPreferred(0x06);
-        pAdvertising->setMaxPreferred(0x12);
-        BLEDevice::startAdvertising();
-        BLE_AVAILABLE = true;
-        Serial.println("[BLE] BLE HID started (Android/Windows)");
-    } catch (...) {
-        BLE_AVAILABLE = false;
-        Serial.println("[BLE] Error initializing BLE");
+    hidOutput.begin();
+    hidOutput.setWake(hid_tx_wake);
+    if (xTaskCreatePinnedToCore(hid_tx_task, "hid_tx", HID_TX_TASK_STACK, nullptr, HID_TX_TASK_PRIO, &hidTxTask,
+                                HID_TX_TASK_CORE) != pdPASS) {
+        hidTxTask = nullptr;  // Files vidées par loop() (cadence limitée à un passage)
     }
-    
+    Serial.printf("[USB] USB HID %s (boot keyboard + %s + consumer, %u ms polling)\n",
+                  hidOk ? "initialized" : "interface FAILED", HID_USB_NKRO ? "NKRO" : "6KRO",
+                  (unsigned)HID_USB_INTERVAL_MS);
+}
+
+static void boot_nvs() {
+    // Keymap avant le premier scan: une touche ne part jamais avec la mauvaise affectation
     preferences.begin("macropad", false);
     platformDetected = preferences.getString("platform", "unknown");
     // Charger config backlight persistée (env_brightness = LED selon luminosité)
@@ -325,6 +340,7 @@ void setup() {
     backlight_enabled = preferences.getBool("backlight_en", true);
     led_brightness = preferences.getUChar("led_brightness", 128);
     led_brightness = max(0, min(255, led_brightness));
+    ledEngine.setEffect((LedEngine::Effect)preferences.getUChar("led_effect", LED_EFFECT_DEFAULT));
     Serial.printf("[SYSTEM] Platform: %s (Keypad HID - layout indépendant)\n", platformDetected.c_str());
     
     // Keymap: charger la sauvegarde ou appliquer les valeurs par défaut
@@ -338,13 +354,38 @@ void setup() {
         }
     }
     Serial.println("[CONFIG] Keymap loaded from preferences");
-    
-    // Initialiser UART ATmega
-    SerialAtmega.begin(ATMEGA_UART_BAUD, SERIAL_8N1, ATMEGA_UART_RX, ATMEGA_UART_TX);
-    delay(100);
-    Serial.printf("[UART] ATmega UART initialized TX=%d, RX=%d, %d baud\n",
-                  ATMEGA_UART_TX, ATMEGA_UART_RX, ATMEGA_UART_BAUD);
-    
+
+    // Hôtes BLE liés: un enregistrement par slot (clés de chiffrement: NVS de la pile)
+    BleSlots::Slot slots[BLE_SLOT_COUNT] = {};
+    for (uint8_t i = 0; i < BLE_SLOT_COUNT; i++) {
+        String key = "ble_slot_" + String(i);
+        if (preferences.isKey(key.c_str())) preferences.getBytes(key.c_str(), &slots[i], sizeof(slots[i]));
+    }
+    bleSlots.begin(&bleTransport(), &bleConn, preferences.getUChar("ble_slot", 0), slots);
+
+    // Règles de routage HID (touche, media): absentes = sortie du slot
+    hidOutput.setMediaRoute((HidOutput::Mode)preferences.getUChar("rt_media", HidOutput::MODE_AUTO));
+    for (int r = 0; r < NUM_ROWS; r++) {
+        for (int c = 0; c < NUM_COLS; c++) {
+            String key = "rt_" + String(r) + "_" + String(c);
+            if (preferences.isKey(key.c_str())) hidOutput.setKeyRoute(r, c, (HidOutput::Mode)preferences.getUChar(key.c_str()));
+        }
+    }
+}
+
+// Slots marqués par BleSlots (liaison, refus de paramètres, mode de sortie, slot actif)
+static void ble_slots_save() {
+    uint8_t dirty = bleSlots.takeDirty();
+    if (!dirty) return;
+    for (uint8_t i = 0; i < BLE_SLOT_COUNT; i++) {
+        if (!(dirty & (1 << i))) continue;
+        String key = "ble_slot_" + String(i);
+        preferences.putBytes(key.c_str(), &bleSlots.slot(i), sizeof(BleSlots::Slot));
+    }
+    if (dirty & BleSlots::DIRTY_ACTIVE) preferences.putUChar("ble_slot", bleSlots.active());
+}
+
+static void boot_leds() {
 #if LED_PWM_PIN >= 0
     // PWM LED externe (si pin différent de la built-in)
     ledcSetup(led_pwm_channel, 1000, 10);
@@ -352,21 +393,25 @@ void setup() {
     ledcWrite(led_pwm_channel, backlight_enabled ? (led_brightness * 1023 / 255) : 0);
     Serial.printf("[LED] LED PWM initialized on GPIO %d\n", LED_PWM_PIN);
 #else
-    Serial.println("[LED] Built-in LED only (NeoPixel), no PWM");
+    Serial.println("[LED] Built-in LED only (WS2812), no PWM");
 #endif
     
 #if ENABLE_LED_STRIP
-    ledStrip.begin();
-    ledStrip.setBrightness(255);
-    delay(10);
+    ledEngine.setBrightness(255);
+    if (!ledEngine.begin(LED_STRIP_PIN, LED_STRIP_COUNT)) {
+        Serial.println("[LED] RMT init failed, RGB disabled");
+    }
     update_builtin_led_from_light();
-    Serial.printf("[LED] RGB initialized on GPIO %d (%d LED%s)\n", LED_STRIP_PIN, LED_STRIP_COUNT, LED_STRIP_COUNT > 1 ? "s" : "");
+    Serial.printf("[LED] RGB initialized on GPIO %d (%d LED%s, effect %s)\n", LED_STRIP_PIN, LED_STRIP_COUNT,
+                  LED_STRIP_COUNT > 1 ? "s" : "", LedEngine::effectName(ledEngine.effect()));
 #else
     pinMode(LED_STRIP_PIN, OUTPUT);
     digitalWrite(LED_STRIP_PIN, LOW);
     Serial.println("[LED] RGB disabled");
 #endif
-    
+}
+
+static void boot_inputs() {
     // Modules (logique événementielle)
     keyMatrix.begin();
     keyMatrix.setCallback(onKeyPress);
@@ -377,68 +422,170 @@ void setup() {
     encoder.setButtonCallback(onEncoderButton);
     Serial.println("[ENCODER] Rotary encoder initialized");
 
-    hidOutput.begin(&Keyboard, &ConsumerControl);
-    
+    // Après la NVS (période calme réglable) et les broches de la matrice et de l'encodeur
+    powerIdle.begin(preferences.getUInt("idle_ms", POWER_IDLE_MS));
+}
+
+static void ble_init() {
+    static const BleTransport::Callbacks callbacks = {
+        ble_on_connected, ble_on_disconnected, ble_on_paired, ble_on_conn_params, ble_on_serial
+    };
+    bleConn.setRequester(ble_request_conn_params);
+    // Temps d'init et tas consommé logués par start(): [BLE] Init ... : <pile>
+    BLE_AVAILABLE = bleTransport().start(BLE_DEVICE_NAME, callbacks);
+    if (BLE_AVAILABLE) Serial.printf("[BLE] BLE HID started (%s)\n", bleTransport().stackName());
+    else Serial.println("[BLE] Error initializing BLE");
+}
+
+// Init de la pile BLE (centaines de ms avec Bluedroid) hors de loop() (scan et USB continuent)
+static void ble_init_task(void*) {
+    uint32_t t0 = millis();
+    ble_init();
+    LOG_I(LOGF_BOOT_BLE_READY, (unsigned)(millis() - t0), (unsigned)millis(), BLE_AVAILABLE ? 1u : 0u);
+    vTaskDelete(nullptr);
+}
+
+static void boot_ble() {
+    if (xTaskCreatePinnedToCore(ble_init_task, "ble_init", BOOT_BLE_TASK_STACK, nullptr, 1, nullptr,
+                                BOOT_BLE_TASK_CORE) != pdPASS) {
+        ble_init();  // Pas de mémoire pour la tâche: init bloquante comme avant
+    }
+}
+
+static void boot_uart() {
+    // Initialiser UART ATmega (négociation de vitesse non bloquante, suivie dans loop)
+    SerialAtmega.setTxBufferSize(ATMEGA_UART_TX_BUFFER);  // Avant begin()
+    SerialAtmega.setRxBufferSize(ATMEGA_UART_RX_BUFFER);  // LINK_RX_FILL_MS à LINK_BAUD_MAX
+    SerialAtmega.begin(ATMEGA_UART_BAUD, SERIAL_8N1, ATMEGA_UART_RX, ATMEGA_UART_TX);
+    atmegaLink.begin(&SerialAtmega);
+    atmegaLink.setFrameCallback(on_atmega_frame);
+    atmegaLink.setBaudSetter([](uint32_t baud) { SerialAtmega.updateBaudRate(baud); });
+    atmegaLink.negotiate();  // 9600 → vitesse max commune (suivi dans loop)
+    subscribe_light_level();
+    powerIdle.holdLink(true);  // Pushes de l'ATmega: l'UART RX ne réveille pas le light sleep
+    Serial.printf("[UART] ATmega UART initialized TX=%d, RX=%d, %d baud\n",
+                  ATMEGA_UART_TX, ATMEGA_UART_RX, ATMEGA_UART_BAUD);
+}
+
+static void boot_display() {
     send_display_data_to_atmega();
-    Serial.println("[MAIN] Initialization complete");
-    Serial.println("Ready!");
 }
 
-// ==================== LOOP PRINCIPAL ====================
+// Étapes différées, dans l'ordre (une par passage de la tâche boot)
+struct BootStage {
+    const char* name;
+    void (*run)();
+};
+static const BootStage BOOT_STAGES[] = {
+    {"ble", boot_ble},          // Lance la tâche BLE en premier: la plus longue
+    {"uart", boot_uart},
+    {"display", boot_display},  // Après uart: file de la liaison prête
+};
+#define BOOT_STAGE_COUNT (sizeof(BOOT_STAGES) / sizeof(BOOT_STAGES[0]))
 
-void loop() {
-    unsigned long now = millis();
-    
-    // Lire l'encodeur AVANT le scan matrice (évite interférences GPIO sur CLK/DT)
-    delay(1);
+// ==================== TÂCHES DE LOOP (Scheduler) ====================
+// Par priorité: hid (0) > boot, link (1) > ble (2) > led (3) > web (4) > restart (5).
+// Périodiques armées une fois; ponctuelles (période 0) armées par les événements.
+
+// Lire l'encodeur AVANT le scan matrice (évite interférences GPIO sur CLK/DT)
+static void task_hid(uint32_t) {
     encoder.update();
     keyMatrix.scan();
+    if (!hidTxTask) hidOutput.poll(micros());  // Pas de tâche d'envoi: files vidées ici
+}
+
+// Démarrage différé: une étape par passage, les touches sont servies entre deux
+static void task_boot(uint32_t) {
+    boot_timed(BOOT_STAGES[bootStage].name, BOOT_STAGES[bootStage].run);
+    if (++bootStage < BOOT_STAGE_COUNT) {
+        scheduler.start(taskBoot, 0);
+        return;
+    }
+    scheduler.start(taskLink, 0);
+    scheduler.start(taskBle, 0);
+    scheduler.start(taskLed, 0);
+    scheduler.start(taskWeb, 0);
+    Serial.println("[MAIN] Initialization complete");
+    Serial.println("Ready!");
+}
 
+static void task_link(uint32_t) {
+    read_atmega_uart();
+}
+
+// Hôte du slot actif accepté, publicité (dirigée puis ouverte) relancée par BleSlots
+static void task_ble(uint32_t) {
+    uint32_t now = millis();
 #if ENABLE_BLE_DEVICE_SWITCH
-    // PROFILE(0,0) + 1(3,0) maintenu 2s → déconnecte BLE pour connecter un autre appareil
-    bool profileHeld = keyMatrix.isKeyPressed(0, 0);
-    bool oneHeld = keyMatrix.isKeyPressed(3, 0);
-    if (profileHeld && oneHeld && (now - bleSwitchLastTrigger) > 2000) {
-        if (bleSwitchComboStart == 0) bleSwitchComboStart = now;
-        else if ((now - bleSwitchComboStart) >= BLE_SWITCH_COMBO_MS) {
-            bleSwitchComboStart = 0;
-            bleSwitchLastTrigger = now;
-            if (BLE_AVAILABLE && pServer && pServer->getConnectedCount() > 0) {
-                Serial.println("[BLE] Pour changer d'appareil, deconnectez depuis le telephone/PC");
-                send_last_key_to_atmega();
-            }
-        }
-    } else {
-        bleSwitchComboStart = 0;
+    // PROFILE(0,0) + 1/2/3 (3,0..2) maintenus → slot BLE 1/2/3 (tâche combo, une fois par appui)
+    int8_t comboSlot = ble_switch_combo_slot();
+    if (comboSlot != bleSwitchComboSlot) {
+        if (comboSlot >= 0) scheduler.start(taskBleCombo, BLE_SWITCH_COMBO_MS);
+        else scheduler.cancel(taskBleCombo);
+        bleSwitchComboSlot = comboSlot;
     }
 #endif
 
-    read_serial();
-    
-    // Lire UART ATmega
-    read_atmega_uart();
-    
-    // Gérer BLE
-    if (!deviceConnected && oldDeviceConnected) {
+    if (BLE_AVAILABLE) {
+        bleSlots.poll(now);
+        ble_slots_save();
+    }
+    bool bleHost = bleSlots.connected();
+    if (!bleHost) hidOutput.setBleState(false, nullptr);
+    hidOutput.setMode((HidOutput::Mode)bleSlots.slot(bleSlots.active()).output);
+    if (!bleHost && oldDeviceConnected) {
+        scheduler.cancel(taskBleHello);
         send_display_data_to_atmega();
-        delay(500);
-        BLEDevice::getAdvertising()->start();
-        Serial.println("[BLE] Restarting advertising after disconnect");
-        oldDeviceConnected = deviceConnected;
+        Serial.println("[BLE] Host disconnected");
+        oldDeviceConnected = bleHost;
     }
-    if (deviceConnected && !oldDeviceConnected) {
+    if (bleHost && !oldDeviceConnected) {
         Serial.println("[BLE] New connection established");
-        delay(200);
-        send_display_data_to_atmega();
-        if (pInputCharacteristic != nullptr) {
-            uint8_t empty_report[9] = {0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-            pInputCharacteristic->setValue(empty_report, 9);
-            pInputCharacteristic->notify();
-            Serial.println("[BLE] HID activated");
-        }
-        oldDeviceConnected = deviceConnected;
+        scheduler.start(taskBleHello, BLE_HELLO_DELAY_MS);  // File BLE ouverte par la tâche hello
+        oldDeviceConnected = bleHost;
     }
-    
+    if (bleHost && !scheduler.armed(taskBleHello)) hidOutput.setBleState(true, &bleTransport());
+
+    // Paramètres de connexion: court pendant la frappe, relâché au repos
+    bleConn.poll(now);
+    // File BLE cadencée à l'intervalle négocié (un rapport par événement de connexion)
+    if (bleHost) hidOutput.router().setPaceUs(HidRouter::SINK_BLE, BleConnParams::reportLatencyUs(bleConn.current()));
+    // File USB ouverte une fois l'interface configurée par l'hôte (rien ne s'accumule débranché)
+    hidOutput.setUsbState(usbHid().mounted());
+}
+
+#if ENABLE_BLE_DEVICE_SWITCH
+static void task_ble_combo(uint32_t) {
+    if (!BLE_AVAILABLE || bleSwitchComboSlot < 0) return;
+    bleSlots.select(bleSwitchComboSlot, millis());
+    send_last_key_to_atmega();
+}
+#endif
+
+// BLE_HELLO_DELAY_MS après la connexion: écran, rapport d'activation, puis file BLE ouverte
+// (la tâche hid_tx est seule à notifier ensuite)
+static void task_ble_hello(uint32_t) {
+    if (!bleSlots.connected()) return;
+    send_display_data_to_atmega();
+    if (bleTransport().sendReport(BLE_HID_EMPTY_REPORT, sizeof(BLE_HID_EMPTY_REPORT))) {
+        Serial.println("[BLE] HID activated");
+    }
+    hidOutput.setBleState(true, &bleTransport());
+}
+
+// Transition progressive de la LED, puis trame d'effet (envoyée seulement si elle change)
+static void task_led(uint32_t) {
+    update_builtin_led_from_light();
+#if ENABLE_LED_STRIP
+    ledEngine.update(millis());
+#endif
+}
+
+// Messages web: série USB puis lignes reçues en BLE; lignes uart_log remises par la tâche de log
+static void task_web(uint32_t) {
+    read_serial();
+    logger.pollWeb();
+
     int newlinePos;
     while ((newlinePos = bleSerialBuffer.indexOf('\n')) >= 0) {
         String completeMessage = bleSerialBuffer.substring(0, newlinePos);
@@ -447,17 +594,83 @@ void loop() {
             processWebMessage(completeMessage);
         }
     }
+}
+
+// Luminosité poussée par l'ATmega: relayée hors du traitement de la trame, pushes rapprochés fusionnés
+static void task_light_web(uint32_t) {
+    send_light_to_web(last_light_level, false);
+}
+
+// BLE connecté: une ligne uart_log par UART_LOG_TO_WEB_INTERVAL_MS, la plus récente
+static void task_uart_log(uint32_t) {
+    send_uart_log_line(uart_log_pending_dir, uart_log_pending.c_str());
+    uart_log_pending = "";
+}
+
+static void task_restart(uint32_t) {
+    ESP.restart();
+}
+
+void setup() {
+    // IMPORTANT: Tools > USB CDC On Boot: Enabled = Serial sur port USB natif.
+    //            Disabled = HID seul sur port USB natif; utiliser port UART pour Serial/flash.
+    // Aucun délai d'attente du port USB: les premières lignes peuvent manquer au moniteur
+    // série s'il s'ouvre après le boot (lignes [BOOT]: aussi dans le journal, log_dump)
+    uint32_t t0 = micros();
+    Serial.begin(115200);
+    Serial.println("\n\n=== ESP32-S3 Macropad Initialization ===");
+    Serial.println("Migration complète depuis MicroPython");
+    logger.setWebSink(send_uart_log_to_web);
+    logger.begin();
     
-    // Luminosité ambiante: USB 30s, BLE 60s (pour LED + écran)
-    unsigned long light_interval = deviceConnected ? LIGHT_POLL_INTERVAL_BLE_MS : LIGHT_POLL_INTERVAL_MS;
-    if (now - last_light_poll >= light_interval) {
-        send_light_level();
+    boot_timed("usb", boot_usb);
+    boot_timed("nvs", boot_nvs);
+    boot_timed("led", boot_leds);
+    boot_timed("inputs", boot_inputs);
+
+    // Noms courts: le nom est le dernier argument de LOGF_SCHED_OVERRUN (tronqué au-delà de 7 car.)
+    scheduler.begin([]() -> uint32_t { return micros(); });
+    taskHid = scheduler.add("hid", task_hid, SCHED_HID_MS, 0, SCHED_HID_BUDGET_US);
+    taskBoot = scheduler.add("boot", task_boot, 0, 1, SCHED_DEFAULT_BUDGET_US);
+    taskLink = scheduler.add("link", task_link, SCHED_LINK_MS, 1, SCHED_LINK_BUDGET_US);
+    taskBle = scheduler.add("ble", task_ble, SCHED_BLE_MS, 2, SCHED_BLE_BUDGET_US);
+#if ENABLE_BLE_DEVICE_SWITCH
+    taskBleCombo = scheduler.add("combo", task_ble_combo, 0, 2, SCHED_DEFAULT_BUDGET_US);
+#endif
+    taskBleHello = scheduler.add("hello", task_ble_hello, 0, 2, SCHED_DEFAULT_BUDGET_US);
+    taskLed = scheduler.add("led", task_led, LED_FRAME_MS, 3, SCHED_LED_BUDGET_US);
+    taskWeb = scheduler.add("web", task_web, SCHED_WEB_MS, 4, SCHED_WEB_BUDGET_US);
+    taskLightWeb = scheduler.add("light", task_light_web, 0, 4, SCHED_DEFAULT_BUDGET_US);
+    taskUartLog = scheduler.add("uartlog", task_uart_log, 0, 4, SCHED_DEFAULT_BUDGET_US);
+    taskRestart = scheduler.add("restart", task_restart, 0, 5, SCHED_DEFAULT_BUDGET_US);
+    scheduler.start(taskHid, 0);
+    scheduler.start(taskBoot, 0);
+
+    bootKeysLiveMs = millis();
+    LOG_I(LOGF_BOOT_KEYS_LIVE, (unsigned)bootKeysLiveMs, (unsigned)(micros() - t0));
+}
+
+// ==================== LOOP PRINCIPAL ====================
+
+void loop() {
+    unsigned long now = millis();
+    
+    // Veille après la période calme: loop() bloquée jusqu'à un front (touche, encodeur) ou
+    // POWER_IDLE_WAIT_MS, puis un passage d'entretien; pleine cadence dès le front
+    if (powerIdle.due(now, power_busy())) {
+        keyMatrix.setIdle(true);
+        powerIdle.sleep(now);
+        keyMatrix.setIdle(false);
+        scheduler.rebase();  // Attente voulue: ni retard ni gigue comptés, pas de rattrapage
     }
+    // Sortie de veille (front ou message web): pushes perdus en light sleep, état relu
+    if (powerIdle.linkResync()) subscribe_light_level();
     
-    // Transition progressive de la LED
-    update_builtin_led_from_light();
+    scheduler.run();
     
-    delay(5);
+    // Jusqu'à la prochaine échéance (SCHED_HID_MS au plus: la tâche hid reste armée)
+    uint32_t waitUs = scheduler.nextDueUs();
+    if (waitUs > 0) delay((waitUs + 999) / 1000);
 }
 
 // ==================== COMMUNICATION SÉRIE ====================
@@ -475,7 +688,8 @@ void read_serial() {
 // ==================== TRAITEMENT DES MESSAGES WEB ====================
 
 void processWebMessage(String message) {
-    Serial.printf("[WEB_UI] Received: %s\n", message.c_str());
+    LOG_I(LOGF_WEB_RX, message.length(), message.c_str());
+    powerIdle.onActivity(millis());
     
     if (message.length() < 2) {
         return;
@@ -485,7 +699,7 @@ void processWebMessage(String message) {
     DeserializationError error = deserializeJson(doc, message);
     
     if (error) {
-        Serial.printf("[WEB_UI] JSON parse error: %s\n", error.c_str());
+        LOG_W(LOGF_WEB_JSON_ERROR, error.c_str());
         return;
     }
     
@@ -523,6 +737,53 @@ void processWebMessage(String message) {
             preferences.putString("ble_device_name", name);
             Serial.printf("[CONFIG] BLE device name set: %s\n", name.c_str());
         }
+    } else if (msg_type == "link_stats") {
+        send_link_stats_to_web();
+    } else if (msg_type == "power") {
+        // {"type":"power","idle_after_ms":N}: période calme avant la veille (0 = jamais)
+        if (doc.containsKey("idle_after_ms")) {
+            uint32_t ms = doc["idle_after_ms"] | (uint32_t)POWER_IDLE_MS;
+            powerIdle.setIdleAfterMs(ms);
+            preferences.putUInt("idle_ms", ms);
+        }
+        send_power_to_web();
+    } else if (msg_type == "sched") {
+        // {"type":"sched","reset":true}: mesures remises à zéro après l'envoi
+        send_sched_to_web(doc["reset"] | false);
+    } else if (msg_type == "led_effect") {
+        LedEngine::Effect effect;
+        if (LedEngine::effectFromName(doc["effect"] | "", &effect)) {
+            ledEngine.setEffect(effect);
+            preferences.putUChar("led_effect", (uint8_t)effect);
+            send_status_message(String("LED effect: ") + LedEngine::effectName(effect));
+        }
+    } else if (msg_type == "led_bench") {
+        ledEngine.benchmark(LED_BENCH_FRAMES);
+    } else if (msg_type == "ble_bench") {
+        // Rapports vides: débit de notification de la pile compilée + rappel du coût d'init
+        bleTransport().benchmark(BLE_BENCH_REPORTS);
+    } else if (msg_type == "hid_route") {
+        handle_hid_route_message(doc);
+    } else if (msg_type == "ble_slots") {
+        send_ble_slots_to_web();
+    } else if (msg_type == "ble_slot") {
+        // Slots numérotés 1..BLE_SLOT_COUNT comme sur le pavé (PROFILE + 1/2/3)
+        uint8_t slot = doc["slot"] | 0;
+        if (BLE_AVAILABLE && slot >= 1 && slot <= BLE_SLOT_COUNT) bleSlots.select(slot - 1, millis());
+        send_ble_slots_to_web();
+    } else if (msg_type == "ble_slot_output") {
+        uint8_t slot = doc["slot"] | 0;
+        HidOutput::Mode mode;
+        if (slot >= 1 && slot <= BLE_SLOT_COUNT && HidOutput::modeFromName(doc["output"] | "", &mode)) {
+            bleSlots.setOutput(slot - 1, mode);
+        }
+        send_ble_slots_to_web();
+    } else if (msg_type == "ble_slot_clear") {
+        uint8_t slot = doc["slot"] | 0;
+        if (BLE_AVAILABLE && slot >= 1 && slot <= BLE_SLOT_COUNT) bleSlots.clear(slot - 1, millis());
+        send_ble_slots_to_web();
+    } else if (msg_type == "log_dump") {
+        logger.dump(Serial);  // USB uniquement (trop volumineux pour BLE)
     } else if (msg_type == "ota_start") {
         JsonObject otaObj = doc.as<JsonObject>();
         handle_ota_start(otaObj);
@@ -533,7 +794,7 @@ void processWebMessage(String message) {
         JsonObject otaObj = doc.as<JsonObject>();
         handle_ota_end(otaObj);
     } else {
-        Serial.printf("[WEB_UI] Unknown message type: %s\n", msg_type.c_str());
+        LOG_W(LOGF_WEB_UNKNOWN_TYPE, msg_type.c_str());
     }
 }
 
@@ -603,8 +864,7 @@ void handle_backlight_message(JsonObject& data) {
             ledcWrite(led_pwm_channel, 0);
 #endif
 #if ENABLE_LED_STRIP
-            ledStrip.clear();
-            ledStrip.show();
+            led_strip_off();
 #endif
         } else {
 #if LED_PWM_PIN >= 0
@@ -612,7 +872,7 @@ void handle_backlight_message(JsonObject& data) {
             ledcWrite(led_pwm_channel, pwm_val * 1023 / 255);
 #endif
 #if ENABLE_LED_STRIP
-            ledStrip.setBrightness(led_brightness);
+            ledEngine.setBrightness(led_brightness);
             update_per_key_leds();
 #endif
         }
@@ -625,7 +885,7 @@ void handle_backlight_message(JsonObject& data) {
             uint8_t pwm_val = (env_brightness_enabled && last_light_level >= LIGHT_THRESHOLD) ? 0 : led_brightness;
             ledcWrite(led_pwm_channel, pwm_val * 1023 / 255);
 #if ENABLE_LED_STRIP
-            ledStrip.setBrightness(led_brightness);
+            ledEngine.setBrightness(led_brightness);
             update_per_key_leds();
 #endif
         }
@@ -650,6 +910,28 @@ void handle_backlight_message(JsonObject& data) {
     send_status_message("Backlight config updated");
 }
 
+// {"type":"hid_route","media":"ble"} et/ou {"key":"3-1","route":"usb"}; "auto" retire la règle
+void handle_hid_route_message(JsonDocument& doc) {
+    HidOutput::Mode route;
+    if (doc.containsKey("media") && HidOutput::modeFromName(doc["media"] | "", &route)) {
+        hidOutput.setMediaRoute(route);
+        preferences.putUChar("rt_media", route);
+    }
+    if (doc.containsKey("key") && HidOutput::modeFromName(doc["route"] | "", &route)) {
+        String key_id = doc["key"].as<String>();
+        int dash_pos = key_id.indexOf('-');
+        int row = key_id.substring(0, dash_pos).toInt();
+        int col = key_id.substring(dash_pos + 1).toInt();
+        if (dash_pos > 0 && row >= 0 && row < NUM_ROWS && col >= 0 && col < NUM_COLS) {
+            hidOutput.setKeyRoute(row, col, route);
+            String key = "rt_" + String(row) + "_" + String(col);
+            if (route == HidOutput::MODE_AUTO) preferences.remove(key.c_str());
+            else preferences.putUChar(key.c_str(), route);
+        }
+    }
+    send_config_to_web();
+}
+
 void handle_display_message(JsonObject& data) {
     Serial.println("[WEB] Display config:");
     serializeJson(data, Serial);
@@ -663,9 +945,19 @@ void send_config_to_web() {
     doc["rows"] = NUM_ROWS;
     doc["cols"] = NUM_COLS;
     doc["activeProfile"] = "Profil 1";
-    doc["outputMode"] = deviceConnected ? "bluetooth" : "usb";
+    doc["outputMode"] = hidOutput.usesBle() ? "bluetooth" : "usb";
     doc["platform"] = platformDetected;
     doc["bleDeviceName"] = preferences.getString("ble_device_name", "");
+    doc["ledEffect"] = LedEngine::effectName(ledEngine.effect());
+    JsonObject routes = doc.createNestedObject("routes");
+    routes["media"] = HidOutput::modeName(hidOutput.mediaRoute());
+    JsonObject keyRoutes = routes.createNestedObject("keys");
+    for (int r = 0; r < NUM_ROWS; r++) {
+        for (int c = 0; c < NUM_COLS; c++) {
+            HidOutput::Mode route = hidOutput.keyRoute(r, c);
+            if (route != HidOutput::MODE_AUTO) keyRoutes[String(r) + "-" + String(c)] = HidOutput::modeName(route);
+        }
+    }
     
     JsonObject keys = doc.createNestedObject("keys");
     for (int r = 0; r < NUM_ROWS; r++) {
@@ -715,12 +1007,20 @@ int row_col_to_led_index(int row, int col) {
     return idx;
 }
 
-// Transition progressive: step plus grand = extinction plus rapide
-#define LED_FADE_STEP 24
-#define LED_FADE_INTERVAL_MS 15
-static uint8_t led_current_r = 0, led_current_g = 0, led_current_b = 0;
-static uint8_t led_target_r = 0, led_target_g = 0, led_target_b = 0;
-static unsigned long last_led_fade = 0;
+// Transition progressive: fondu perceptuel de LED_FADE_MS, R, G et B arrivent ensemble
+static ledfade::Fade<3> led_fade;
+
+// Veille repoussée: démarrage, OTA, USB monté (alimenté par l'hôte, l'USB ne dort pas),
+// rapports HID en file, touche tenue, LED animée ou en fondu, liaison ATmega en cours
+bool power_busy() {
+    if (bootStage < BOOT_STAGE_COUNT || ota_in_progress || usbHid().mounted()) return true;
+    if (hidOutput.router().queued(HidRouter::SINK_USB) || hidOutput.router().queued(HidRouter::SINK_BLE)) return true;
+    if (keyMatrix.anyPressed() || led_fade.active()) return true;
+#if ENABLE_LED_STRIP
+    if (ledEngine.animating()) return true;
+#endif
+    return !atmegaLink.idle() || atmegaLink.negotiating();
+}
 
 void update_builtin_led_from_light() {
 #if ENABLE_LED_STRIP
@@ -754,34 +1054,13 @@ void update_builtin_led_from_light() {
             tr = tg = tb = 0;
         }
     }
-    led_target_r = tr;
-    led_target_g = tg;
-    led_target_b = tb;
+    const uint8_t target[3] = {tr, tg, tb};
     
-    // Transition progressive (toutes les ~20ms)
-    unsigned long now = millis();
-    if (now - last_led_fade >= LED_FADE_INTERVAL_MS) {
-        last_led_fade = now;
-        uint8_t step = LED_FADE_STEP;
-        if (led_current_r < led_target_r) {
-            led_current_r = (led_target_r - led_current_r <= step) ? led_target_r : led_current_r + step;
-        } else if (led_current_r > led_target_r) {
-            led_current_r = (led_current_r - led_target_r <= step) ? led_target_r : led_current_r - step;
-        }
-        if (led_current_g < led_target_g) {
-            led_current_g = (led_target_g - led_current_g <= step) ? led_target_g : led_current_g + step;
-        } else if (led_current_g > led_target_g) {
-            led_current_g = (led_current_g - led_target_g <= step) ? led_target_g : led_current_g - step;
-        }
-        if (led_current_b < led_target_b) {
-            led_current_b = (led_target_b - led_current_b <= step) ? led_target_b : led_current_b + step;
-        } else if (led_current_b > led_target_b) {
-            led_current_b = (led_current_b - led_target_b <= step) ? led_target_b : led_current_b - step;
-        }
-    }
-    
-    ledStrip.setPixelColor(0, ledStrip.Color(led_current_r, led_current_g, led_current_b));
-    ledStrip.show();
+    // Transition progressive: relancée seulement quand la cible change, évaluée au temps écoulé
+    uint16_t now = (uint16_t)millis();
+    led_fade.retarget(target, LED_FADE_MS, now);
+    led_fade.update(now);
+    ledEngine.setBaseColor(led_fade.value(0), led_fade.value(1), led_fade.value(2));
 #endif
 
 #if LED_PWM_PIN >= 0
@@ -795,6 +1074,15 @@ void update_builtin_led_from_light() {
 #endif
 }
 
+// Extinction immédiate (sans transition)
+void led_strip_off() {
+#if ENABLE_LED_STRIP
+    static const uint8_t off[3] = {0, 0, 0};
+    led_fade.set(off);
+    ledEngine.setBaseColor(0, 0, 0);
+#endif
+}
+
 void update_per_key_leds() {
 #if ENABLE_LED_STRIP
     update_builtin_led_from_light();
@@ -803,8 +1091,10 @@ void update_per_key_leds() {
 
 void set_key_led_pressed(int row, int col, bool pressed) {
 #if ENABLE_LED_STRIP
-    // Pas de flash blanc à l'appui — la LED reste sur la luminosité ambiante
-    if (!pressed) {
+    // Flash seulement avec l'effet réactif: sinon la LED reste sur la luminosité ambiante
+    if (pressed) {
+        ledEngine.keyPressed(row_col_to_led_index(row, col));
+    } else {
         update_builtin_led_from_light();
     }
 #endif
@@ -935,18 +1225,26 @@ void handle_ota_end(JsonObject& data) {
     serializeJson(response, output);
     send_to_web(output);
     
-    delay(500);
-    ESP.restart();
+    scheduler.start(taskRestart, OTA_RESTART_DELAY_MS);  // Réponse partie (USB, BLE) avant le redémarrage
 }
 
 // ==================== COMMUNICATION ATmega ====================
 
+// loop() uniquement (trame LINK_LOG, logger.pollWeb()). USB seul: envoi direct; BLE connecté:
+// tâche uart_log ponctuelle, au plus une par UART_LOG_TO_WEB_INTERVAL_MS, lignes rapprochées fusionnées
 void send_uart_log_to_web(const char* dir, const char* msg) {
-    unsigned long now = millis();
-    if (deviceConnected && (now - last_uart_log_to_web) < UART_LOG_TO_WEB_INTERVAL_MS) {
-        return;  // Throttle: éviter flood BLE
+    if (!deviceConnected) {
+        send_uart_log_line(dir, msg);
+        return;
     }
-    last_uart_log_to_web = now;
+    uart_log_pending_dir = dir;
+    uart_log_pending = msg;
+    uint32_t since = millis() - last_uart_log_to_web;
+    scheduler.trigger(taskUartLog, since >= UART_LOG_TO_WEB_INTERVAL_MS ? 0 : UART_LOG_TO_WEB_INTERVAL_MS - since);
+}
+
+void send_uart_log_line(const char* dir, const char* msg) {
+    last_uart_log_to_web = millis();
     String json = "{\"type\":\"uart_log\",\"dir\":\"";
     json += dir;
     json += "\",\"msg\":\"";
@@ -960,21 +1258,16 @@ void send_uart_log_to_web(const char* dir, const char* msg) {
 
 void send_to_web(String data) {
     Serial.println(data);
-    if (deviceConnected && BLE_AVAILABLE && pSerialCharacteristic != nullptr) {
+    if (deviceConnected && BLE_AVAILABLE) {
         String message = data + "\n";
-        pSerialCharacteristic->setValue(message.c_str());
-        pSerialCharacteristic->notify();
+        bleTransport().sendSerial((const uint8_t*)message.c_str(), message.length());
     }
 }
 
-// Envoyer la luminosité au web (USB et BLE). Throttle 2s pour éviter flood BLE.
-void send_light_to_web_if_needed(uint16_t light_value) {
-    unsigned long now = millis();
-    bool value_changed = (light_value != last_light_sent_to_web);
-    bool interval_elapsed = (now - last_light_send_time >= LIGHT_SEND_MIN_INTERVAL_MS);
-    if (value_changed || interval_elapsed) {
+// Envoyer la luminosité au web (USB et BLE): seulement si elle change, sauf demande du web (force)
+void send_light_to_web(uint16_t light_value, bool force) {
+    if (force || light_value != last_light_sent_to_web) {
         last_light_sent_to_web = light_value;
-        last_light_send_time = now;
         String msg = "{\"type\":\"light\",\"level\":" + String(light_value) + "}";
         send_to_web(msg);  // USB: Serial | BLE: notify
         send_last_key_to_atmega();  // Mettre à jour le statut rétro-éclairage sur l'écran
@@ -983,141 +1276,295 @@ void send_light_to_web_if_needed(uint16_t light_value) {
 }
 
 void send_atmega_command(uint8_t cmd, uint8_t* payload, int payload_len) {
-    SerialAtmega.write(cmd);
-    if (payload != nullptr && payload_len > 0) {
-        SerialAtmega.write(payload, payload_len);
-    }
-    SerialAtmega.write('\n');
-    SerialAtmega.flush();
-    Serial.printf("[UART] Sent command 0x%02X (%d bytes payload)\n", cmd, payload_len);
+    // Tramage COBS/CRC, ACK et retransmissions: voir AtmegaLink
+    if (payload == nullptr) payload_len = 0;
+    if (!atmegaLink.send(cmd, payload, (uint8_t)min(payload_len, 255))) return;
+    LOG_D(LOGF_UART_TX_CMD, cmd, payload_len);
     
     // Log vers la console web (sauf CMD_READ_LIGHT et CMD_SET_LAST_KEY pour éviter flood BLE)
+    // Formaté par la tâche de log: ici seulement cmd + 4 premiers octets bruts
     if (cmd != CMD_READ_LIGHT && cmd != CMD_SET_LAST_KEY) {
-        char buf[128];
-        int n = 0;
         if (payload_len > 0 && payload != nullptr) {
-            n = snprintf(buf, sizeof(buf), "CMD 0x%02X + %d bytes", cmd, payload_len);
-            if (payload_len <= 8 && n < (int)sizeof(buf) - 4) {
-                n += snprintf(buf + n, sizeof(buf) - n, " [");
-                for (int i = 0; i < payload_len && n < (int)sizeof(buf) - 4; i++) {
-                    n += snprintf(buf + n, sizeof(buf) - n, "%02X ", payload[i]);
-                }
-                if (n < (int)sizeof(buf) - 2) snprintf(buf + n, sizeof(buf) - n, "]");
+            uint32_t head = 0;
+            for (int i = 0; i < 4; i++) {
+                head = (head << 8) | ((i < payload_len) ? payload[i] : 0);
             }
+            LOG_I(LOGF_UART_TX_PAYLOAD, cmd, payload_len, head);
         } else {
-            const char* names[] = {"", "READ_LIGHT", "SET_LED", "GET_LED", "UPDATE_DISPLAY", "SET_DISPLAY_DATA", "", "", "SET_IMAGE", "IMAGE_CHUNK", "ATMEGA_DEBUG", "ATMEGA_LOG"};
-            const char* name = (cmd < 12) ? names[cmd] : "?";
-            snprintf(buf, sizeof(buf), "CMD 0x%02X %s", cmd, name);
+            static const char* const names[] = {"", "READ_LIGHT", "SET_LED", "GET_LED", "UPDATE_DISPLAY", "SET_DISPLAY_DATA", "", "", "SET_IMAGE", "IMAGE_CHUNK", "ATMEGA_DEBUG", "ATMEGA_LOG", "SET_LAST_KEY", "LIGHT_SUB"};
+            LOG_I(LOGF_UART_TX_NAME, cmd, (cmd < sizeof(names) / sizeof(names[0])) ? names[cmd] : "?");
         }
-        send_uart_log_to_web("tx", buf);
     }
 }
 
 void read_atmega_uart() {
-    if (!SerialAtmega.available()) {
-        return;
+    atmegaLink.poll();
+}
+
+// Trame valide (CRC vérifié) reçue de l'ATmega
+bool on_atmega_frame(uint8_t cmd, const uint8_t* payload, uint8_t len) {
+    switch (cmd) {
+        case CMD_READ_LIGHT: {
+            LightLevel light;
+            if (lmsg::decode<LightLevelMsg>(payload, len, light) == LightLevelMsg::FIELDS) {
+                last_light_level = light.level;
+                LOG_I(LOGF_ATMEGA_LIGHT, light.level);
+                scheduler.trigger(taskLightWeb, 0);  // Envoi web hors du traitement de la trame
+            }
+            break;
+        }
+        case CMD_LINK_LOG: {
+            char line[LINK_MAX_PAYLOAD + 1];
+            memcpy(line, payload, len);
+            line[len] = '\0';
+            Serial.printf("[ATMEGA] %s\n", line);
+            send_uart_log_to_web("rx", line);
+            break;
+        }
+        default:
+            Serial.printf("[ATMEGA] Frame 0x%02X (%d bytes)\n", cmd, len);
+            return false;
     }
+    return true;
+}
+
+// Santé de la liaison ATmega: compteurs des deux côtés + RTT (message web link_stats)
+void send_link_stats_to_web() {
+    const AtmegaLink::Stats& st = atmegaLink.stats();
+    const AtmegaLink::PeerStatus& peer = atmegaLink.peer();
+    StaticJsonDocument<2048> doc;  // ~100 valeurs (liaison, RTT, ATmega, BLE, HID): 1024 tronquait "ble"
+    doc["type"] = "link_stats";
+    doc["baud"] = atmegaLink.baud();
     
-    // Lire les données disponibles
-    String data = "";
-    while (SerialAtmega.available()) {
-        char c = SerialAtmega.read();
-        data += c;
-    }
+    JsonObject esp = doc.createNestedObject("esp32");
+    esp["tx"] = st.txFrames;
+    esp["rx"] = st.rxFrames;
+    esp["crc"] = st.crcErrors;
+    esp["framing"] = st.framingErrors;
+    esp["overrun"] = st.rxOverruns;
+    esp["dropped"] = st.dropped;
+    esp["retries"] = st.retries;
+    esp["nack"] = st.nacks;
+    esp["unknown"] = st.unknownCmds;
+    esp["tx_stalls"] = st.txStalls;
+    esp["queue_full"] = st.queueFull;
     
-    if (data.length() == 0) {
-        return;
-    }
+    JsonObject rtt = doc.createNestedObject("rtt");
+    rtt["pings"] = st.pings;
+    rtt["lost"] = st.pingsLost;
+    rtt["min_us"] = st.rttMinUs;
+    rtt["avg_us"] = st.pings ? (uint32_t)(st.rttSumUs / st.pings) : 0;
+    rtt["max_us"] = st.rttMaxUs;
+    static const uint16_t edges[] = LINK_RTT_EDGES_MS;
+    JsonArray edgesArr = rtt.createNestedArray("edges_ms");
+    for (uint16_t e : edges) edgesArr.add(e);
+    JsonArray hist = rtt.createNestedArray("hist");
+    for (int i = 0; i < LINK_RTT_BUCKETS; i++) hist.add(st.rttHist[i]);
     
-    // Vérifier si c'est une réponse binaire CMD_READ_LIGHT [0x01][low][high][\n]
-    if (data.length() >= 3 && (uint8_t)data.charAt(0) == CMD_READ_LIGHT) {
-        uint16_t light_value = (uint8_t)data.charAt(1) | ((uint8_t)data.charAt(2) << 8);
-        last_light_level = light_value;
-        Serial.printf("[ATMEGA LIGHT] Level (binary): %d\n", light_value);
-        send_light_to_web_if_needed(light_value);
-        return;
+    if (peer.valid) {
+        JsonObject at = doc.createNestedObject("atmega");
+        at["age_ms"] = millis() - peer.receivedAt;
+        at["baud_idx"] = peer.baudIdx;
+        at["rx"] = peer.rxFrames;
+        at["tx"] = peer.txFrames;
+        at["crc"] = peer.crcErrors;
+        at["framing"] = peer.framingErrors;
+        at["line"] = peer.lineErrors;
+        at["overrun"] = peer.overruns;
+        at["dropped"] = peer.dropped;
+        at["duplicates"] = peer.duplicates;
+        at["unknown"] = peer.unknownCmds;
+        at["tx_full"] = peer.txFull;
     }
     
-    // Traiter les messages texte
-    atmega_rx_buffer += data;
+    // BLE: paramètres négociés, délai d'un rapport et temps radio estimé (BleConnParams)
+    const BleConnParams::Stats& bs = bleConn.stats();
+    JsonObject ble = doc.createNestedObject("ble");
+    ble["connected"] = bleConn.connected();
+    ble["stack"] = bleTransport().stackName();
+    ble["init_ms"] = bleTransport().initStats().initMs;
+    ble["heap_used"] = bleTransport().heapUsed();
+    ble["heap_free"] = ESP.getFreeHeap();
+    if (bleConn.connected()) {
+        BleConnParams::Params p = bleConn.current();
+        ble["mode"] = BleConnParams::modeName(BleConnParams::classify(p));
+        ble["interval_us"] = (uint32_t)p.interval * 1250;
+        ble["latency"] = p.latency;
+        ble["timeout_ms"] = (uint32_t)p.timeout * 10;
+        ble["report_latency_us"] = BleConnParams::reportLatencyUs(p);
+        ble["duty_ppm"] = BleConnParams::dutyPpm(p);
+    }
+    ble["avg_duty_ppm"] = bleConn.averageDutyPpm();
+    ble["connected_ms"] = bs.connectedMs;
+    ble["active_ms"] = bs.activeMs;
+    ble["requests"] = bs.requests;
+    ble["accepted"] = bs.accepted;
+    ble["rejected"] = bs.rejected;
+    ble["slot"] = bleSlots.active() + 1;
     
-    int newlinePos;
-    while ((newlinePos = atmega_rx_buffer.indexOf('\n')) >= 0) {
-        String line = atmega_rx_buffer.substring(0, newlinePos);
-        line.trim();  // Enlever \r si présent
-        atmega_rx_buffer = atmega_rx_buffer.substring(newlinePos + 1);
-        
-        if (line.length() == 0) continue;
-        
-        // Réponse binaire CMD_READ_LIGHT (reçu par morceaux)
-        if (line.length() >= 3 && (uint8_t)line.charAt(0) == CMD_READ_LIGHT) {
-            uint16_t light_value = (uint8_t)line.charAt(1) | ((uint8_t)line.charAt(2) << 8);
-            last_light_level = light_value;
-            Serial.printf("[ATMEGA LIGHT] Level (binary): %d\n", light_value);
-            send_light_to_web_if_needed(light_value);
-            continue;
-        }
-        // Format ASCII "LIGHT=XXX"
-        if (line.startsWith("LIGHT=")) {
-            uint16_t light_value = line.substring(6).toInt();
-            last_light_level = light_value;
-            Serial.printf("[ATMEGA LIGHT] Level (ASCII): %d\n", light_value);
-            send_light_to_web_if_needed(light_value);
-            continue;
+    // HID: une file par transport (HidRouter), délai dépôt → envoi accepté
+    JsonObject hid = doc.createNestedObject("hid");
+    for (uint8_t s = 0; s < HidRouter::SINK_COUNT; s++) {
+        HidRouter::Sink sink = (HidRouter::Sink)s;
+        HidRouter::Stats hs = hidOutput.router().stats(sink);
+        JsonObject o = hid.createNestedObject(HidRouter::sinkName(sink));
+        o["active"] = hidOutput.router().active(sink);
+        o["queued"] = hidOutput.router().queued(sink);
+        o["sent"] = hs.sent;
+        o["dropped"] = hs.dropped;
+        o["retries"] = hs.retries;
+        o["max_queued"] = hs.maxQueued;
+        o["max_delay_us"] = hs.maxDelayUs;
+        if (sink == HidRouter::SINK_USB) {
+            // Interface UsbHid: dépôt → fin du transfert IN (rapport lu par l'hôte), puis bus seul
+            UsbHid::Stats us = usbHid().stats();
+            o["protocol"] = usbHid().bootProtocol() ? "boot" : "report";
+            o["nkro"] = usbHid().nkro();
+            o["completed"] = us.completed;
+            o["busy"] = us.busy;
+            o["in_last_us"] = us.lastUs;
+            o["in_avg_us"] = us.completed ? (uint32_t)(us.sumUs / us.completed) : 0;
+            o["in_max_us"] = us.maxUs;
+            o["bus_max_us"] = us.busMaxUs;
         }
-        // Format debug ATmega "[LIGHT] Level: NNN (0x...)"
-        if (line.startsWith("[LIGHT] Level: ")) {
-            int spacePos = line.indexOf(' ', 15);
-            if (spacePos > 15) {
-                uint16_t light_value = (uint16_t)line.substring(15, spacePos).toInt();
-                if (light_value <= 1023) {
-                    last_light_level = light_value;
-                    send_light_to_web_if_needed(light_value);
-                }
-            }
-            continue;
+    }
+    
+    String output;
+    serializeJson(doc, output);
+    send_to_web(output);
+}
+
+// Veille: mode obtenu au boot, temps par état (courant par état mesuré au banc: ARCHITECTURE.md),
+// réveils, front → premier rapport HID
+void send_power_to_web() {
+    StaticJsonDocument<512> doc;
+    PowerIdle::Stats st = powerIdle.stats(millis());
+    doc["type"] = "power";
+    doc["mode"] = PowerIdle::modeName(powerIdle.mode());
+    doc["link_held"] = powerIdle.linkHeld();
+    doc["idle_after_ms"] = powerIdle.idleAfterMs();
+    doc["idle"] = powerIdle.idle();
+    doc["busy"] = power_busy();
+    doc["active_ms"] = st.activeMs;
+    doc["idle_ms"] = st.idleMs;
+    doc["entries"] = st.entries;
+    doc["edge_wakes"] = st.edgeWakes;
+    doc["timer_wakes"] = st.timerWakes;
+    doc["wake_last_us"] = st.wakeLastUs;
+    doc["wake_max_us"] = st.wakeMaxUs;
+    doc["wake_budget_us"] = POWER_WAKE_BUDGET_US;
+    doc["over_budget"] = st.overBudget;
+    String output;
+    serializeJson(doc, output);
+    send_to_web(output);
+}
+
+// Ordonnanceur de loop(): par tâche, retard au départ, gigue, durée, dépassements de budget
+void send_sched_to_web(bool reset) {
+    DynamicJsonDocument doc(3072);  // ~12 valeurs × SCHED_MAX_TASKS: tas, processWebMessage tient déjà 4 Ko de pile
+    doc["type"] = "sched";
+    doc["warn_ms"] = SCHED_WARN_MS;
+    JsonArray arr = doc.createNestedArray("tasks");
+    for (uint8_t id = 0; id < scheduler.count(); id++) {
+        const Scheduler::Stats& st = scheduler.stats(id);
+        JsonObject o = arr.createNestedObject();
+        o["name"] = scheduler.name(id);
+        o["period_ms"] = scheduler.periodMs(id);
+        o["prio"] = scheduler.prio(id);
+        o["budget_us"] = scheduler.budgetUs(id);
+        o["runs"] = st.runs;
+        o["late_avg_us"] = st.runs ? (uint32_t)(st.lateSumUs / st.runs) : 0;
+        o["late_max_us"] = st.lateMaxUs;
+        o["jitter_avg_us"] = st.jitterCount ? (uint32_t)(st.jitterSumUs / st.jitterCount) : 0;
+        o["jitter_max_us"] = st.jitterMaxUs;
+        o["exec_last_us"] = st.execLastUs;
+        o["exec_max_us"] = st.execMaxUs;
+        o["overruns"] = st.overruns;
+        o["skipped"] = st.skipped;
+    }
+    String output;
+    serializeJson(doc, output);
+    send_to_web(output);
+    if (reset) scheduler.resetStats();
+}
+
+// Slots BLE: hôte lié, mode de sortie, refus de paramètres; durée du dernier changement de slot
+void send_ble_slots_to_web() {
+    StaticJsonDocument<1024> doc;
+    const BleSlots::Stats& st = bleSlots.stats();
+    doc["type"] = "ble_slots";
+    doc["active"] = bleSlots.active() + 1;
+    doc["connected"] = bleSlots.connected();
+    doc["switches"] = st.switches;
+    doc["last_switch_ms"] = st.lastSwitchMs;
+    doc["rejected"] = st.rejected;
+    doc["directed"] = st.directed;
+    JsonArray arr = doc.createNestedArray("slots");
+    for (uint8_t i = 0; i < BLE_SLOT_COUNT; i++) {
+        const BleSlots::Slot& s = bleSlots.slot(i);
+        JsonObject o = arr.createNestedObject();
+        o["slot"] = i + 1;
+        o["bonded"] = s.bonded != 0;
+        if (s.bonded) {
+            char addr[18];
+            snprintf(addr, sizeof(addr), "%02X:%02X:%02X:%02X:%02X:%02X",  // Ordre de la pile
+                     s.addr[0], s.addr[1], s.addr[2], s.addr[3], s.addr[4], s.addr[5]);
+            o["addr"] = addr;
+            o["addr_type"] = s.addrType;
         }
-        Serial.printf("[ATMEGA] %s\n", line.c_str());
-        send_uart_log_to_web("rx", line.c_str());
+        o["output"] = HidOutput::modeName((HidOutput::Mode)s.output);
+        o["refused"] = s.refused;
     }
+    String output;
+    serializeJson(doc, output);
+    send_to_web(output);
 }
 
+// Dernière valeur poussée par l'ATmega (aucun aller-retour UART)
 void send_light_level() {
-    unsigned long now = millis();
-    if (last_light_poll != 0 && (now - last_light_poll) < LIGHT_POLL_MIN_INTERVAL_MS) return;
-    last_light_poll = now;
-    send_atmega_command(CMD_READ_LIGHT, nullptr, 0);
-    send_light_to_web_if_needed(last_light_level);
+    send_light_to_web(last_light_level, true);
 }
 
-void send_last_key_to_atmega() {
-    String last_key = last_key_pressed.length() > 0 ? last_key_pressed : "";
-    int len = last_key.length();
-    if (len > 15) len = 15;
-    uint8_t payload[20];
-    int pos = 0;
-    payload[pos++] = len & 0xFF;
-    if (len > 0) {
-        memcpy(&payload[pos], last_key.c_str(), len);
-        pos += len;
+// Abonnement aux pushes de luminosité (l'ATmega répond avec la valeur courante)
+void subscribe_light_level() {
+    LightSubscribe sub = {LIGHT_SUB_DELTA, LIGHT_THRESHOLD, LIGHT_SUB_HYSTERESIS, LIGHT_SUB_MIN_INTERVAL_MS};
+    uint8_t payload[LightSubscribeMsg::MAX];
+    uint8_t len = lmsg::encode<LightSubscribeMsg>(sub, payload);
+    send_atmega_command(CMD_LIGHT_SUBSCRIBE, payload, len);
+}
+
+// État d'écran envoyé à l'ATmega (CMD_SET_DISPLAY_DATA / CMD_SET_LAST_KEY)
+void fill_display_data(DisplayData& d) {
+    memset(&d, 0, sizeof(d));
+    d.brightness = led_brightness;
+    strlcpy(d.mode, "data", sizeof(d.mode));
+    strlcpy(d.profile, "Profil 1", sizeof(d.profile));
+    strlcpy(d.output, hidOutput.usesBle() ? "bluetooth" : "usb", sizeof(d.output));
+    if (hidOutput.usesBle()) {
+        snprintf(d.device, sizeof(d.device), "%sBluetooth %u", hidOutput.usesUsb() ? "USB + " : "",
+                 bleSlots.active() + 1);
     }
+    d.keys = count_configured_keys();
+    strlcpy(d.lastKey, last_key_pressed.c_str(), sizeof(d.lastKey));
     // Rétro-éclairage pour l'écran: selon env_brightness_enabled ou manuel
-    int back_en;
-    uint8_t back_val;
     if (env_brightness_enabled) {
 #if LIGHT_SENSOR_INVERTED
-        back_en = (last_light_level >= LIGHT_THRESHOLD) ? 1 : 0;
+        d.backlightEnabled = (last_light_level >= LIGHT_THRESHOLD) ? 1 : 0;
 #else
-        back_en = (last_light_level < LIGHT_THRESHOLD) ? 1 : 0;
+        d.backlightEnabled = (last_light_level < LIGHT_THRESHOLD) ? 1 : 0;
 #endif
-        back_val = back_en ? (led_brightness & 0xFF) : 0;
     } else {
-        back_en = backlight_enabled ? 1 : 0;
-        back_val = back_en ? (led_brightness & 0xFF) : 0;
+        d.backlightEnabled = backlight_enabled ? 1 : 0;
     }
-    payload[pos++] = back_en & 0xFF;
-    payload[pos++] = back_val;
-    send_atmega_command(CMD_SET_LAST_KEY, payload, pos);
+    d.backlightBrightness = d.backlightEnabled ? (led_brightness & 0xFF) : 0;
+}
+
+void send_last_key_to_atmega() {
+    DisplayData d;
+    fill_display_data(d);
+    uint8_t payload[LastKeyMsg::MAX];
+    uint8_t len = lmsg::encode<LastKeyMsg>(d, payload);
+    send_atmega_command(CMD_SET_LAST_KEY, payload, len);
 }
 
 uint8_t count_configured_keys() {
@@ -1131,45 +1578,9 @@ uint8_t count_configured_keys() {
 }
 
 void send_display_data_to_atmega() {
-    uint8_t payload[80];
-    int pos = 0;
-    payload[pos++] = led_brightness;
-    const char* mode = "data";
-    uint8_t mode_len = strlen(mode);
-    payload[pos++] = mode_len;
-    memcpy(&payload[pos], mode, mode_len);
-    pos += mode_len;
-    const char* profile = "Profil 1";
-    uint8_t profile_len = strlen(profile);
-    payload[pos++] = profile_len;
-    memcpy(&payload[pos], profile, profile_len);
-    pos += profile_len;
-    const char* output = deviceConnected ? "bluetooth" : "usb";
-    uint8_t output_len = strlen(output);
-    payload[pos++] = output_len;
-    memcpy(&payload[pos], output, output_len);
-    pos += output_len;
-    payload[pos++] = count_configured_keys();
-    uint8_t last_key_len = min((int)last_key_pressed.length(), 15);
-    payload[pos++] = last_key_len;
-    if (last_key_len > 0) {
-        memcpy(&payload[pos], last_key_pressed.c_str(), last_key_len);
-        pos += last_key_len;
-    }
-    int back_en;
-    uint8_t back_val;
-    if (env_brightness_enabled) {
-#if LIGHT_SENSOR_INVERTED
-        back_en = (last_light_level >= LIGHT_THRESHOLD) ? 1 : 0;
-#else
-        back_en = (last_light_level < LIGHT_THRESHOLD) ? 1 : 0;
-#endif
-        back_val = back_en ? (led_brightness & 0xFF) : 0;
-    } else {
-        back_en = backlight_enabled ? 1 : 0;
-        back_val = back_en ? (led_brightness & 0xFF) : 0;
-    }
-    payload[pos++] = back_en & 0xFF;
-    payload[pos++] = back_val;
-    send_atmega_command(CMD_SET_DISPLAY_DATA, payload, pos);
+    DisplayData d;
+    fill_display_data(d);
+    uint8_t payload[DisplayDataMsg::MAX];
+    uint8_t len = lmsg::encode<DisplayDataMsg>(d, payload);
+    send_atmega_command(CMD_SET_DISPLAY_DATA, payload, len);
 }
@@ -0,0 +1,78 @@
+/* Arduino.h — Sous-ensemble du cœur Arduino-ESP32 pour compiler AtmegaLink/Log sur l'hôte */
+#ifndef SIM_HAL_ARDUINO_H
+#define SIM_HAL_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+
+using std::max;
+using std::min;
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t b) = 0;
+    virtual size_t write(const uint8_t* buf, size_t len) {
+        for (size_t i = 0; i < len; i++) write(buf[i]);
+        return len;
+    }
+    size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+    size_t println(const char* s = "") { return print(s) + print("\n"); }
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int availableForWrite() { return 0; }
+    virtual void flush() {}
+};
+
+// Console: sortie standard (protégée, la tâche de log écrit depuis son propre thread)
+class SimConsole : public Stream {
+public:
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t* buf, size_t len) override;
+    int available() override { return 0; }
+    int read() override { return -1; }
+};
+extern SimConsole Serial;
+
+class EspClass {
+public:
+    uint32_t getCycleCount();
+    uint32_t getFreeHeap();
+};
+extern EspClass ESP;
+
+// FreeRTOS: tâches = threads détachés, ticks = ms
+typedef void* TaskHandle_t;
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+#define tskIDLE_PRIORITY 0
+#define ARDUINO_RUNNING_CORE 1
+#define pdMS_TO_TICKS(ms) (ms)
+#define pdPASS 1
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void*), const char* name, uint32_t stack, void* arg,
+                                   int prio, TaskHandle_t* handle, int core);
+void vTaskDelay(TickType_t ticks);
+
+// Sections critiques (portMUX): verrou tournant entre threads
+struct portMUX_TYPE {
+    std::atomic_flag flag = ATOMIC_FLAG_INIT;
+};
+#define portMUX_INITIALIZER_UNLOCKED {}
+#define portENTER_CRITICAL(mux) while ((mux)->flag.test_and_set(std::memory_order_acquire)) {}
+#define portEXIT_CRITICAL(mux) (mux)->flag.clear(std::memory_order_release)
+
+#endif // SIM_HAL_ARDUINO_H
@@ -0,0 +1,13 @@
+/* avr/interrupt.h — Vecteurs et sei/cli simulés */
+#ifndef SIM_HAL_AVR_INTERRUPT_H
+#define SIM_HAL_AVR_INTERRUPT_H
+
+#include "../../sim_avr.h"
+
+// Les vecteurs sont appelés par la machine (sim_avr.cpp) avec SREG.I coupé
+#define ISR(vector) extern "C" void vector(void); extern "C" void vector(void)
+
+static inline void sei(void) { sim_avr_sei(); }
+static inline void cli(void) { sim_avr_cli(); }
+
+#endif // SIM_HAL_AVR_INTERRUPT_H
@@ -0,0 +1,58 @@
+/* avr/io.h — Registres ATmega328P simulés (co-simulation hôte, voir firmware/sim/README.md) */
+#ifndef SIM_HAL_AVR_IO_H
+#define SIM_HAL_AVR_IO_H
+
+#include "../../sim_avr.h"
+
+// Point d'entrée du firmware appelé par le thread AVR du simulateur
+#define main avr_main
+int avr_main(void);
+
+#ifndef F_CPU
+#define F_CPU SIM_F_CPU
+#endif
+
+#define SIM_REG8(name) static SimReg8 name(SIM_##name);
+SIM_REG8(PORTB) SIM_REG8(DDRB) SIM_REG8(PINB) SIM_REG8(PORTC) SIM_REG8(DDRC) SIM_REG8(PINC)
+SIM_REG8(PORTD) SIM_REG8(DDRD) SIM_REG8(PIND)
+SIM_REG8(SPCR) SIM_REG8(SPSR) SIM_REG8(SPDR)
+SIM_REG8(ADMUX) SIM_REG8(ADCSRA) SIM_REG8(ADCSRB) SIM_REG8(DIDR0) SIM_REG8(ADCL) SIM_REG8(ADCH)
+SIM_REG8(TCCR0A) SIM_REG8(TCCR0B) SIM_REG8(OCR0A) SIM_REG8(OCR0B) SIM_REG8(TCNT0) SIM_REG8(TIMSK0)
+SIM_REG8(TCCR1A) SIM_REG8(TCCR1B)
+SIM_REG8(TCCR2A) SIM_REG8(TCCR2B) SIM_REG8(OCR2A) SIM_REG8(OCR2B) SIM_REG8(TCNT2) SIM_REG8(TIMSK2)
+SIM_REG8(TIFR2) SIM_REG8(ASSR)
+SIM_REG8(UBRR0H) SIM_REG8(UBRR0L) SIM_REG8(UCSR0A) SIM_REG8(UCSR0B) SIM_REG8(UCSR0C) SIM_REG8(UDR0)
+SIM_REG8(MCUSR) SIM_REG8(WDTCSR) SIM_REG8(SMCR) SIM_REG8(PRR) SIM_REG8(SREG) SIM_REG8(GPIOR0)
+#undef SIM_REG8
+static SimAdc16 ADC;
+static SimTimer16 TCNT1;
+
+// Bits (noms et positions de l'iom328p.h d'avr-libc)
+enum { PB0, PB1, PB2, PB3, PB4, PB5, PB6, PB7 };
+enum { PC0, PC1, PC2, PC3, PC4, PC5, PC6 };
+enum { PD0, PD1, PD2, PD3, PD4, PD5, PD6, PD7 };
+enum { SPR0, SPR1, CPHA, CPOL, MSTR, DORD, SPE, SPIE };
+enum { SPI2X = 0, WCOL = 6, SPIF = 7 };
+enum { MUX0, MUX1, MUX2, MUX3, ADLAR = 5, REFS0 = 6, REFS1 = 7 };
+enum { ADPS0, ADPS1, ADPS2, ADIE, ADIF, ADATE, ADSC, ADEN };
+enum { ADTS0, ADTS1, ADTS2, ACME = 6 };
+enum { ADC0D, ADC1D, ADC2D, ADC3D, ADC4D, ADC5D };
+enum { WGM00, WGM01, COM0B0 = 4, COM0B1, COM0A0, COM0A1 };
+enum { CS00, CS01, CS02, WGM02 };
+enum { TOIE0, OCIE0A, OCIE0B };
+enum { CS10, CS11, CS12, WGM12, WGM13 };
+enum { WGM20, WGM21, COM2B0 = 4, COM2B1, COM2A0, COM2A1 };
+enum { CS20, CS21, CS22, WGM22 };
+enum { TOIE2, OCIE2A, OCIE2B };
+enum { TOV2, OCF2A, OCF2B };
+enum { TCR2BUB, TCR2AUB, OCR2BUB, OCR2AUB, TCN2UB, AS2, EXCLK };
+enum { MPCM0, U2X0, UPE0, DOR0, FE0, UDRE0, TXC0, RXC0 };
+enum { TXB80, RXB80, UCSZ02, TXEN0, RXEN0, UDRIE0, TXCIE0, RXCIE0 };
+enum { UCPOL0, UCSZ00, UCSZ01, USBS0, UPM00, UPM01, UMSEL00, UMSEL01 };
+enum { PORF, EXTRF, BORF, WDRF };
+enum { WDP0, WDP1, WDP2, WDE, WDCE, WDP3, WDIE, WDIF };
+enum { SE, SM0, SM1, SM2 };
+enum { PRADC, PRUSART0, PRSPI, PRTIM1, PRTIM0 = 5, PRTIM2, PRTWI };
+#define SREG_I 7
+
+#endif // SIM_HAL_AVR_IO_H
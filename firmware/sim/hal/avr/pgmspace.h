@@ -0,0 +1,10 @@
+/* avr/pgmspace.h — Flash simulée: PROGMEM sans effet, lecture directe */
+#ifndef SIM_HAL_AVR_PGMSPACE_H
+#define SIM_HAL_AVR_PGMSPACE_H
+
+#include <stdint.h>
+
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+
+#endif // SIM_HAL_AVR_PGMSPACE_H
@@ -0,0 +1,20 @@
+/* avr/sleep.h — Sommeil simulé: le temps avance jusqu'à la prochaine interruption */
+#ifndef SIM_HAL_AVR_SLEEP_H
+#define SIM_HAL_AVR_SLEEP_H
+
+#include "../../sim_avr.h"
+
+#define SLEEP_MODE_IDLE 0
+#define SLEEP_MODE_ADC 1
+#define SLEEP_MODE_PWR_DOWN 2
+#define SLEEP_MODE_PWR_SAVE 3
+#define SLEEP_MODE_STANDBY 6
+#define SLEEP_MODE_EXT_STANDBY 7
+
+static inline void set_sleep_mode(uint8_t mode) { sim_avr_set_sleep_mode(mode); }
+static inline void sleep_enable(void) {}
+static inline void sleep_disable(void) {}
+static inline void sleep_cpu(void) { sim_avr_sleep(); }
+static inline void sleep_mode(void) { sim_avr_sleep(); }
+
+#endif // SIM_HAL_AVR_SLEEP_H
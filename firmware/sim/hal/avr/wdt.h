@@ -0,0 +1,14 @@
+/* avr/wdt.h — Watchdog simulé (sans effet) */
+#ifndef SIM_HAL_AVR_WDT_H
+#define SIM_HAL_AVR_WDT_H
+
+#define WDTO_15MS 0
+#define WDTO_250MS 4
+#define WDTO_1S 6
+#define WDTO_2S 7
+
+static inline void wdt_disable(void) {}
+static inline void wdt_enable(unsigned char) {}
+static inline void wdt_reset(void) {}
+
+#endif // SIM_HAL_AVR_WDT_H
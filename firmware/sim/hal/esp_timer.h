@@ -0,0 +1,9 @@
+/* esp_timer.h — Horloge µs de l'hôte (même origine que micros()) */
+#ifndef SIM_HAL_ESP_TIMER_H
+#define SIM_HAL_ESP_TIMER_H
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
+
+#endif // SIM_HAL_ESP_TIMER_H
@@ -0,0 +1,13 @@
+/* util/crc16.h — _crc_ccitt_update (même calcul que l'assembleur d'avr-libc) */
+#ifndef SIM_HAL_UTIL_CRC16_H
+#define SIM_HAL_UTIL_CRC16_H
+
+#include <stdint.h>
+
+static inline uint16_t _crc_ccitt_update(uint16_t crc, uint8_t data) {
+    data ^= (uint8_t)(crc & 0xFF);
+    data ^= (uint8_t)(data << 4);
+    return ((((uint16_t)data << 8) | (crc >> 8)) ^ (uint8_t)(data >> 4) ^ ((uint16_t)data << 3));
+}
+
+#endif // SIM_HAL_UTIL_CRC16_H
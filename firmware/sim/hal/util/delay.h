@@ -0,0 +1,10 @@
+/* util/delay.h — Attentes simulées (avancent le temps virtuel, interruptions servies) */
+#ifndef SIM_HAL_UTIL_DELAY_H
+#define SIM_HAL_UTIL_DELAY_H
+
+#include "../../sim_avr.h"
+
+static inline void _delay_ms(double ms) { sim_avr_delay_ns((uint64_t)(ms * 1000000.0)); }
+static inline void _delay_us(double us) { sim_avr_delay_ns((uint64_t)(us * 1000.0)); }
+
+#endif // SIM_HAL_UTIL_DELAY_H
@@ -0,0 +1,1258 @@
+/*
+ * keypad_sim.cpp — Co-simulation ESP32 ↔ ATmega sur une paire PTY Linux
+ *
+ * Thread AVR: atmega_light/main.cpp tel quel sur la machine simulée (sim_avr.cpp),
+ *   côté maître du PTY. Thread principal: AtmegaLink + Log de l'ESP32 sur un
+ *   SimUart côté esclave, pilotés par les scénarios ci-dessous.
+ *
+ * Scénarios: codecs des messages (LinkMessages.h), filtre ADC de l'ATmega, paramètres de connexion BLE
+ * et slots d'hôtes liés sur un hôte simulé (sim_ble.cpp, sans ATmega), files HID USB + BLE
+ * (HidRouter), négociation de vitesse,
+ * latence de commande (GET_LED), débit et exactitude du framebuffer (image
+ * RGB565), écran de données, police, banc de dessin, push de luminosité, puis
+ * fuzzing du parseur de trames de l'ATmega (--fuzz N).
+ * Sortie: tableau des résultats, code de retour 1 si un scénario échoue.
+ *
+ * Voir README.md pour la compilation et les options.
+ */
+#include "sim_avr.h"
+#include "sim_esp.h"
+#include "sim_ble.h"
+
+#include "AtmegaLink.h"
+#include "BleConnParams.h"
+#include "BleSlots.h"
+#include "HidRouter.h"
+#include "Scheduler.h"
+#include "Log.h"
+#include "../atmega/atmega_light/font_5x7.h"
+
+#include <fcntl.h>
+#include <stdarg.h>
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+Log logger;
+AtmegaLink atmegaLink;
+BleConnParams bleConn;
+BleSlots bleSlots;
+
+#define SIM_IMAGE_MAX_ROWS 102   // Taille d'image sur 16 bits côté ATmega
+#define SIM_BOOT_TIMEOUT_MS 5000
+#define SIM_BOOT_LINK_MAX_MS 5.0   // sei() de l'ATmega (temps virtuel depuis le reset)
+#define SIM_PANEL_PIXELS (320 * 210)  // Effacement de boot: ST7789_WIDTH × ST7789_HEIGHT
+#define SIM_NEGOTIATE_TIMEOUT_MS 20000
+#define SIM_REPLY_TIMEOUT_MS 1500
+#define SIM_LIGHT_TIMEOUT_MS 4000
+#define SIM_LIGHT_TOLERANCE 8
+#define SIM_ADC_OVERSAMPLE 16      // ADC_OVERSAMPLE de main.cpp
+#define SIM_ADC_DECIMATE_SHIFT 2   // ADC_DECIMATE_SHIFT
+#define SIM_ADC_IIR_FRAC 4         // ADC_IIR_FRAC
+#define SIM_ADC_STEP_NONE 0xFFFF   // ADC_STEP_NONE
+#define SIM_ADC_SAMPLE_HZ 160      // Rafale de 16 conversions par TASK_ADC_MS (100 ms)
+#define SIM_ADC_NOISE 20           // Bruit uniforme ± LSB autour de 500
+#define SIM_ADC_NOISE_S 120
+#define SIM_ADC_WARMUP_S 10        // Premier échantillon décimé (graine, non filtré) oublié: 3 τ
+#define SIM_ADC_STEP_S 3           // Durée de l'échelon et des extrêmes
+#define SIM_ADC_SEED 1             // Suite de bruit fixe: vérification déterministe
+#define SIM_ADC_SETTLE_MAX_MS 700  // Échelon 500 → 800 à ±1 près
+#define SIM_SLEEP_QUIET_MS 1000
+#define SIM_SLEEP_MIN_PCT 90.0   // Part du temps endormie, liaison au repos (calcul CPU non compté)
+#define SIM_FUZZ_REPLY_MS 5
+#define SIM_DRAW_QUIET_MS 50
+#define SIM_ZONE_X 20       // ZONE_X de main.cpp
+#define SIM_ZONE_W 280      // ZONE_W
+#define SIM_PROFILE_Y 52    // y_profile de display_update_partial()
+#define SIM_TEXT_FG 0xFFFF  // WHITE_COL sur INNER_BG
+#define SIM_TEXT_BG 0x0000
+#define SIM_FUZZ_SETTLE_MS 5000
+#define SIM_FUZZ_FRAME_MAX (LINK_FRAME_MAX + 16)  // Trame mutée rallongée
+#define SIM_BLE_STEP_MS 10      // Pas de loop() en temps virtuel (scénarios ble et slots)
+#define SIM_BLE_KEY_MS 100      // Une touche toutes les 100 ms pendant la frappe
+#define SIM_ROUTER_KEYS 5       // Rafale de touches (appui + relâché) vers USB et BLE
+#define SIM_ROUTER_BLE_PACE_US 30000   // Intervalle BLE de 30 ms
+#define SIM_ROUTER_CONGESTED_MS 200    // Pile BLE saturée (notification refusée) au début
+#define SIM_SCHED_START_US (0xFFFFFFFFu - 50000)  // micros() reboucle 50 ms après le départ
+#define SIM_SCHED_RUN_MS 300000        // 5 min: au-delà de l'horizon de la roue (64^3 ms)
+#define SIM_SCHED_FAR_MS 290000        // Ponctuelle hors horizon, reclassée en route
+#define SIM_SCHED_COMBO_MS 1000        // Ponctuelle réarmée à mi-chemin: part à 1500 ms
+#define SIM_SCHED_SLOW_US 3000         // Tâche lente, budget 2000 us: dépasse à chaque passage
+
+struct Options {
+    SimAvrConfig avr;
+    bool negotiate = true;
+    bool ptyOnly = false;
+    bool verbose = false;
+    int latencyCount = 200;
+    int imageRows = 40;
+    long fuzz = 0;
+    const char* dumpFb = nullptr;
+};
+
+struct Result {
+    std::string name;
+    bool pass;
+    std::string detail;
+};
+
+// Réponses observées par le callback de trames
+struct Observed {
+    bool ledReply = false;
+    unsigned long ledAtUs = 0;
+    uint32_t lightPushes = 0;
+    uint16_t light = 0;
+    unsigned long lightAtUs = 0;
+};
+
+static Options opt;
+static Observed obs;
+static std::vector<Result> results;
+
+static std::string fmt(const char* f, ...) __attribute__((format(printf, 1, 2)));
+static std::string fmt(const char* f, ...) {
+    char buf[256];
+    va_list ap;
+    va_start(ap, f);
+    vsnprintf(buf, sizeof(buf), f, ap);
+    va_end(ap);
+    return buf;
+}
+
+static void report(const std::string& name, bool pass, const std::string& detail) {
+    results.push_back({name, pass, detail});
+    printf("[SIM] %-10s %s  %s\n", name.c_str(), pass ? "ok  " : "FAIL", detail.c_str());
+    fflush(stdout);
+}
+
+static bool faultsInjected() {
+    return opt.avr.rxLoss > 0 || opt.avr.rxCorrupt > 0 || opt.avr.txLoss > 0 || opt.avr.txCorrupt > 0 ||
+           opt.avr.lineMaxBaud != 0;
+}
+
+// ─── Équivalents hôte du sketch (esp32_micropython.ino) ───────────────────────
+
+static bool send_atmega_command(uint8_t cmd, const uint8_t* payload = nullptr, uint8_t len = 0) {
+    return atmegaLink.send(cmd, payload, len);
+}
+
+static void read_atmega_uart() {
+    atmegaLink.poll();
+}
+
+static bool on_atmega_frame(uint8_t cmd, const uint8_t* payload, uint8_t len) {
+    switch (cmd) {
+        case CMD_GET_LED:
+            obs.ledReply = true;
+            obs.ledAtUs = micros();
+            return true;
+        case CMD_READ_LIGHT: {
+            LightLevel light;
+            if (lmsg::decode<LightLevelMsg>(payload, len, light) == LightLevelMsg::FIELDS) {
+                obs.light = light.level;
+                obs.lightAtUs = micros();
+                obs.lightPushes++;
+            }
+            return true;
+        }
+        case CMD_LINK_LOG:
+            if (opt.verbose) printf("[ATMEGA] %.*s\n", (int)len, (const char*)payload);
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Pomper le lien jusqu'à ce que cond() soit vrai (false sur timeout)
+static bool pump_until(const std::function<bool()>& cond, unsigned long timeoutMs) {
+    unsigned long t0 = millis();
+    for (;;) {
+        read_atmega_uart();
+        if (cond()) return true;
+        if (millis() - t0 >= timeoutMs) return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+// Attendre une place dans la file (un send() refusé serait compté et loggé)
+static void send_blocking(uint8_t cmd, const uint8_t* payload, uint8_t len) {
+    pump_until([] { return atmegaLink.queueFree() > 0; }, SIM_REPLY_TIMEOUT_MS * LINK_TX_QUEUE);
+    send_atmega_command(cmd, payload, len);
+}
+
+static bool wait_idle(unsigned long timeoutMs) {
+    return pump_until([] { return atmegaLink.idle(); }, timeoutMs);
+}
+
+// Fin du dessin: plus aucun octet SPI pendant SIM_DRAW_QUIET_MS
+static bool wait_spi_quiet() {
+    const SimAvrStats& a = sim_avr_stats();
+    uint64_t last = a.spiBytes;
+    unsigned long quietAt = millis();
+    return pump_until([&] {
+        uint64_t now = a.spiBytes;
+        if (now != last) {
+            last = now;
+            quietAt = millis();
+        }
+        return millis() - quietAt >= SIM_DRAW_QUIET_MS;
+    }, SIM_REPLY_TIMEOUT_MS * 10);
+}
+
+static uint32_t fb_hash(const std::vector<uint16_t>& fb) {
+    uint32_t h = 2166136261u;  // FNV-1a
+    for (uint16_t px : fb) {
+        h = (h ^ (px & 0xFF)) * 16777619u;
+        h = (h ^ (px >> 8)) * 16777619u;
+    }
+    return h;
+}
+
+static void dump_ppm(const char* path, const std::vector<uint16_t>& fb) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return;
+    fprintf(f, "P6\n%d %d\n255\n", SIM_FB_WIDTH, SIM_FB_HEIGHT);
+    for (uint16_t px : fb) {
+        uint8_t rgb[3] = {(uint8_t)((px >> 8) & 0xF8), (uint8_t)((px >> 3) & 0xFC), (uint8_t)(px << 3)};
+        fwrite(rgb, 1, 3, f);
+    }
+    fclose(f);
+}
+
+// ─── Scénarios ────────────────────────────────────────────────────────────────
+
+// Schémas de LinkMessages.h, sans l'ATmega: aller-retour encode → decode, octets
+// identiques à l'ancien empaquetage manuel, troncatures et champs invalides
+static void scenario_codec() {
+    uint32_t checks = 0, errors = 0;
+    auto check = [&](bool ok) {
+        checks++;
+        errors += !ok;
+    };
+    uint8_t buf[LINK_MAX_PAYLOAD];
+
+    DisplayData d = {128, "data", "Profile 2", "usb", 12, "F5", 1, 200, "Sim host"};
+    static const uint8_t legacy[] = {128, 4, 'd', 'a', 't', 'a', 9, 'P', 'r', 'o', 'f', 'i', 'l', 'e', ' ', '2',
+                                     3, 'u', 's', 'b', 12, 2, 'F', '5', 1, 200, 0 /* heure */,
+                                     8, 'S', 'i', 'm', ' ', 'h', 'o', 's', 't'};
+    uint8_t n = lmsg::encode<DisplayDataMsg>(d, buf, sizeof(buf));
+    check(n == sizeof(legacy) && memcmp(buf, legacy, n) == 0);
+    DisplayData r = {};
+    check(lmsg::decode<DisplayDataMsg>(buf, n, r) == DisplayDataMsg::FIELDS && memcmp(&d, &r, sizeof(d)) == 0);
+    check(lmsg::encode<DisplayDataMsg>(d, buf, n - 1) == 0);
+
+    // Chaque préfixe décode un nombre croissant de champs (copie à la taille exacte: ASan)
+    uint8_t prev = 0;
+    for (uint8_t len = 0; len <= n; len++) {
+        std::vector<uint8_t> prefix(legacy, legacy + len);
+        DisplayData t = {};
+        uint8_t fields = lmsg::decode<DisplayDataMsg>(prefix.data(), len, t);
+        check(fields >= prev);
+        prev = fields;
+    }
+    check(prev == DisplayDataMsg::FIELDS);
+
+    // Longueur hors tableau: arrêt, le champ garde sa valeur
+    std::vector<uint8_t> bad(legacy, legacy + n);
+    bad[1] = sizeof(d.mode);
+    strcpy(r.mode, "keep");
+    check(lmsg::decode<DisplayDataMsg>(bad.data(), n, r) == 1 && strcmp(r.mode, "keep") == 0);
+
+    // Chaîne non terminée: tronquée à la taille du tableau - 1
+    memset(d.lastKey, 'K', sizeof(d.lastKey));
+    n = lmsg::encode<LastKeyMsg>(d, buf, sizeof(buf));
+    check(n == sizeof(d.lastKey) + 2 && buf[0] == sizeof(d.lastKey) - 1);
+    check(lmsg::decode<LastKeyMsg>(buf, n, r) == LastKeyMsg::FIELDS && strlen(r.lastKey) == sizeof(r.lastKey) - 1);
+    strcpy(d.lastKey, "F6");
+    d.backlightBrightness = 180;
+    static const uint8_t lastKey[] = {2, 'F', '6', 1, 180};
+    n = lmsg::encode<LastKeyMsg>(d, buf, sizeof(buf));
+    check(n == sizeof(lastKey) && memcmp(buf, lastKey, n) == 0);
+
+    LightSubscribe sub = {8, 500, 40, 200}, sub2 = {};
+    static const uint8_t subBytes[] = {8, 0, 0xF4, 1, 40, 0, 200, 0};
+    n = lmsg::encode<LightSubscribeMsg>(sub, buf, sizeof(buf));
+    check(n == sizeof(subBytes) && memcmp(buf, subBytes, n) == 0);
+    check(lmsg::decode<LightSubscribeMsg>(buf, n - 1, sub2) == 3);
+
+    LinkStatus st = {LINK_STATUS_VERSION, 3, 0x8001, 0x8102, 0x8203, 0x8304, 0x8405,
+                     0x8506, 0x8607, 0x8708, 0x8809, 0x890A}, st2 = {};
+    n = lmsg::encode<LinkStatusMsg>(st, buf, sizeof(buf));
+    check(n == 22 && buf[0] == LINK_STATUS_VERSION && buf[2] == 0x01 && buf[3] == 0x80);
+    check(lmsg::decode<LinkStatusMsg>(buf, n, st2) == LinkStatusMsg::FIELDS && memcmp(&st, &st2, sizeof(st)) == 0);
+
+    // Chunk d'image: données lues en place dans le payload
+    uint8_t pixels[LINK_IMAGE_CHUNK_MAX + 1];
+    for (uint8_t i = 0; i < sizeof(pixels); i++) pixels[i] = i ^ 0x5A;
+    ImageChunk chunk = {0x1234, pixels, LINK_IMAGE_CHUNK_MAX}, chunk2 = {};
+    n = lmsg::encode<ImageChunkMsg>(chunk, buf, sizeof(buf));
+    check(n == 3 + LINK_IMAGE_CHUNK_MAX && buf[0] == 0x34 && buf[1] == 0x12 && buf[2] == LINK_IMAGE_CHUNK_MAX);
+    check(lmsg::decode<ImageChunkMsg>(buf, n, chunk2) == ImageChunkMsg::FIELDS && chunk2.index == 0x1234 &&
+          chunk2.data == buf + 3 && memcmp(chunk2.data, pixels, LINK_IMAGE_CHUNK_MAX) == 0);
+    chunk.size = LINK_IMAGE_CHUNK_MAX + 1;
+    check(lmsg::encode<ImageChunkMsg>(chunk, buf, sizeof(buf)) == 0);
+    buf[2] = LINK_IMAGE_CHUNK_MAX + 1;
+    check(lmsg::decode<ImageChunkMsg>(buf, sizeof(buf), chunk2) == 1);
+
+    report("codec", errors == 0, fmt("%u checks, %u failed", checks, errors));
+}
+
+// ─── ADC de l'ATmega: filtre de main.cpp appelé directement (sans la machine simulée) ───
+
+uint16_t adc_iir_step(uint16_t state, uint16_t sample12, uint16_t* pending);  // main.cpp (fonctions pures)
+uint16_t adc_state_level(uint16_t state);
+
+// Conversions brutes à SIM_ADC_SAMPLE_HZ, décimées par SIM_ADC_OVERSAMPLE comme ADC_vect
+struct SimAdcFilter {
+    uint16_t state = 0;
+    uint16_t pending = SIM_ADC_STEP_NONE;
+    bool seeded = false;
+    uint16_t acc = 0;
+    uint8_t count = 0;
+
+    void sample(uint16_t raw) {
+        acc += raw;
+        if (++count < SIM_ADC_OVERSAMPLE) return;
+        uint16_t sample12 = (acc + (1 << (SIM_ADC_DECIMATE_SHIFT - 1))) >> SIM_ADC_DECIMATE_SHIFT;
+        acc = 0;
+        count = 0;
+        state = seeded ? adc_iir_step(state, sample12, &pending) : (uint16_t)(sample12 << SIM_ADC_IIR_FRAC);
+        seeded = true;
+    }
+    uint16_t level() const { return adc_state_level(state); }
+};
+
+// Bruit ±SIM_ADC_NOISE LSB à 500: niveau filtré à ±1 (après la graine); échelon 500 → 800: délai jusqu'à ±1
+// de la cible (et plus jamais au-delà); 0 et 1023 atteints sans débordement
+static void scenario_adc() {
+    std::mt19937 rng(SIM_ADC_SEED);
+    std::uniform_int_distribution<int> noise(-SIM_ADC_NOISE, SIM_ADC_NOISE);
+    SimAdcFilter f;
+    uint16_t lo = 1023, hi = 0;
+    for (uint32_t i = 0; i < (uint32_t)SIM_ADC_SAMPLE_HZ * SIM_ADC_NOISE_S; i++) {
+        f.sample((uint16_t)(500 + noise(rng)));
+        if (i < (uint32_t)SIM_ADC_SAMPLE_HZ * SIM_ADC_WARMUP_S) continue;
+        lo = std::min(lo, f.level());
+        hi = std::max(hi, f.level());
+    }
+    bool noiseOk = lo >= 499 && hi <= 501;
+
+    SimAdcFilter g;
+    for (uint8_t i = 0; i < SIM_ADC_OVERSAMPLE; i++) g.sample(500);
+    uint32_t settled = 0;  // Conversions depuis l'échelon jusqu'à la dernière hors de ±1
+    for (uint32_t i = 1; i <= (uint32_t)SIM_ADC_SAMPLE_HZ * SIM_ADC_STEP_S; i++) {
+        g.sample(800);
+        if (g.level() + 1 < 800 || g.level() > 801) settled = i;
+    }
+    double settleMs = settled * 1000.0 / SIM_ADC_SAMPLE_HZ;
+
+    SimAdcFilter r;
+    bool rangeOk = true;
+    for (uint32_t i = 0; i < (uint32_t)SIM_ADC_SAMPLE_HZ * SIM_ADC_STEP_S; i++) r.sample(1023);
+    rangeOk &= r.level() == 1023;
+    for (uint32_t i = 0; i < (uint32_t)SIM_ADC_SAMPLE_HZ * SIM_ADC_STEP_S; i++) r.sample(0);
+    rangeOk &= r.level() == 0;
+
+    report("adc", noiseOk && settleMs <= SIM_ADC_SETTLE_MAX_MS && rangeOk,
+           fmt("500 +/- %u LSB over %u s (after %u s): %u..%u; step 500 -> 800 within +/-1 after %.0f ms (max %u); "
+               "0 / 1023 %s",
+               (unsigned)SIM_ADC_NOISE, (unsigned)SIM_ADC_NOISE_S, (unsigned)SIM_ADC_WARMUP_S, lo, hi, settleMs,
+               (unsigned)SIM_ADC_SETTLE_MAX_MS, rangeOk ? "ok" : "FAIL"));
+}
+
+// ─── BLE: BleConnParams et BleSlots sur le transport simulé (temps virtuel) ───
+
+static std::string bleSerialIn;
+static uint32_t bleNowMs = 0;
+
+static void ble_on_connected(const uint8_t* addr, uint8_t, uint16_t interval, uint16_t latency, uint16_t timeout) {
+    bleSlots.onConnect(addr);
+    bleConn.onConnect({interval, latency, timeout});
+}
+
+static void ble_on_disconnected() {
+    bleSlots.onDisconnect();
+    bleConn.onDisconnect();
+}
+
+static void ble_on_paired(const uint8_t* addr, uint8_t addrType, bool bonded) {
+    bleSlots.onPaired(addr, addrType, bonded);
+}
+
+static void ble_on_conn_params(uint8_t status, uint16_t interval, uint16_t latency, uint16_t timeout) {
+    bleConn.onUpdate(status, {interval, latency, timeout});
+}
+
+static void ble_on_serial(const uint8_t* data, size_t len) { bleSerialIn.append((const char*)data, len); }
+
+static bool ble_request_conn_params(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout) {
+    return bleTransport().requestConnParams(minInterval, maxInterval, latency, timeout);
+}
+
+// loop() jusqu'à untilMs: touches jusqu'à activeUntilMs, l'hôte répond entre deux passages.
+// waiting: hôte à portée, qui se connecte dès qu'une publicité le laisse faire
+static void ble_run(uint32_t& nowMs, uint32_t untilMs, uint32_t activeUntilMs,
+                    const SimBleTransport::Host* waiting = nullptr) {
+    for (; nowMs < untilMs; nowMs += SIM_BLE_STEP_MS) {
+        if (nowMs < activeUntilMs && nowMs % SIM_BLE_KEY_MS == 0) bleConn.onActivity(nowMs);
+        bleSlots.poll(nowMs);
+        bleConn.poll(nowMs);
+        simBle().hostEvent();
+        if (waiting) simBle().connect(*waiting);
+    }
+}
+
+// Hôte qui accepte 7,5 ms: actif → repos → actif, trois demandes acceptées. Hôte qui refuse
+// sous 20 ms: demande active refusée, plage de repli acceptée aussitôt (20 ms), puis repos.
+// Puis rapports du banc de débit et console série à travers le transport.
+static void scenario_ble() {
+    static const BleTransport::Callbacks callbacks = {
+        ble_on_connected, ble_on_disconnected, ble_on_paired, ble_on_conn_params, ble_on_serial
+    };
+    bleConn.setRequester(ble_request_conn_params);
+    bool ok = bleTransport().start(BLE_DEVICE_NAME, callbacks) && simBle().advertising();
+    bleSlots.begin(&bleTransport(), &bleConn, 0, nullptr);
+    const BleConnParams::Stats& st = bleConn.stats();
+    uint32_t& now = bleNowMs;
+
+    static const SimBleTransport::Host fast = {BLE_CONN_ACTIVE_MIN, 24, 0, 500, {0x5A, 0x11, 0x22, 0x33, 0x44, 0x55}, 0};
+    ok &= simBle().connect(fast);
+    ble_run(now, BLE_CONN_SETTLE_MS + 1000, BLE_CONN_SETTLE_MS + 1000);
+    BleConnParams::Params active = bleConn.current();
+    ok &= bleConn.mode() == BleConnParams::ACTIVE && bleSlots.connected();
+    ble_run(now, now + BLE_CONN_IDLE_MS + 500, 0);
+    BleConnParams::Params idle = bleConn.current();
+    ok &= bleConn.mode() == BleConnParams::IDLE;
+    ble_run(now, now + 500, now + 500);
+    ok &= bleConn.mode() == BleConnParams::ACTIVE && st.requests == 3 && st.accepted == 3 && st.rejected == 0;
+
+    simBle().clearReports();
+    uint16_t sent = bleTransport().benchmark(BLE_BENCH_REPORTS);
+    bool reportsOk = sent == BLE_BENCH_REPORTS && simBle().reports().size() == BLE_BENCH_REPORTS;
+    for (const std::vector<uint8_t>& r : simBle().reports()) {
+        reportsOk &= r.size() == sizeof(BLE_HID_EMPTY_REPORT) && memcmp(r.data(), BLE_HID_EMPTY_REPORT, r.size()) == 0;
+    }
+    static const char msg[] = "{\"type\":\"link_stats\"}\n";
+    simBle().hostWrite(msg);
+    bool serialOk = bleSerialIn == msg && bleTransport().sendSerial((const uint8_t*)msg, sizeof(msg) - 1) &&
+                    simBle().serialOut().size() == sizeof(msg) - 1;
+    simBle().disconnect();
+    bleConn.poll(now);
+    ok &= !bleConn.connected() && !bleTransport().sendReport(BLE_HID_EMPTY_REPORT, sizeof(BLE_HID_EMPTY_REPORT));
+
+    // Hôte qui refuse l'intervalle actif (minimum 20 ms): repli 15–30 ms accepté
+    static const SimBleTransport::Host slow = {16, 24, 0, 500, {0x5A, 0x66, 0x77, 0x88, 0x99, 0xAA}, 0};
+    uint32_t requests0 = st.requests, rejected0 = st.rejected;
+    ble_run(now, now + BLE_SLOT_READV_MS + SIM_BLE_STEP_MS, 0, &slow);
+    uint32_t t0 = now;
+    ble_run(now, t0 + BLE_CONN_SETTLE_MS + 4000, t0 + BLE_CONN_SETTLE_MS + 4000);
+    uint32_t activeRequests = st.requests - requests0;
+    BleConnParams::Params fallback = bleConn.current();
+    bool refusedOnce = activeRequests == 2 && st.rejected - rejected0 == 1 && bleConn.mode() == BleConnParams::ACTIVE &&
+                       fallback.interval == 16;
+    ble_run(now, now + BLE_CONN_IDLE_MS + 500, 0);
+    refusedOnce &= st.requests - requests0 == 3 && bleConn.mode() == BleConnParams::IDLE;
+    simBle().disconnect();
+    ble_run(now, now + SIM_BLE_STEP_MS, 0);
+
+    report("ble", ok && reportsOk && serialOk && refusedOnce,
+           fmt("active %u us, idle %u us lat %u, %u/%u accepted, refusing host %u req / %u rejected, fallback %u us, "
+               "bench %u/%u reports, serial %s",
+               (unsigned)BleConnParams::reportLatencyUs(active), (unsigned)BleConnParams::reportLatencyUs(idle),
+               idle.latency, st.accepted, st.requests, activeRequests, st.rejected - rejected0,
+               (unsigned)BleConnParams::reportLatencyUs(fallback), sent, (unsigned)BLE_BENCH_REPORTS,
+               serialOk ? "ok" : "FAIL"));
+}
+
+// Slots BLE (après scenario_ble): A lié au slot 1, B (refuse l'actif) au slot 2; retour au
+// slot 1 par publicité dirigée, B refusé sur le slot 1, puis "reboot" (slots relus comme de
+// la NVS) sur le slot 2: B reçoit directement la plage de repli, sans nouveau refus.
+static void scenario_slots() {
+    static const SimBleTransport::Host hostA = {BLE_CONN_ACTIVE_MIN, 24, 0, 500, {0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5}, 0};
+    static const SimBleTransport::Host hostB = {16, 24, 0, 500, {0xB0, 0xB1, 0xB2, 0xB3, 0xB4, 0xB5}, 1};
+    const BleConnParams::Stats& st = bleConn.stats();
+    const BleSlots::Stats& ss = bleSlots.stats();
+    uint32_t& now = bleNowMs;
+    bleSlots.takeDirty();
+
+    // Slot 1 vide: publicité ouverte, A s'y lie
+    ble_run(now, now + BLE_SLOT_READV_MS + 2 * SIM_BLE_STEP_MS, 0, &hostA);
+    simBle().pair();
+    ble_run(now, now + BLE_CONN_SETTLE_MS + 500, now + BLE_CONN_SETTLE_MS + 500);
+    bool ok = bleSlots.connected() && bleSlots.slot(0).bonded && memcmp(bleSlots.slot(0).addr, hostA.addr, 6) == 0 &&
+              bleSlots.takeDirty() == 0x01;
+
+    // Slot 2: A déconnecté, B se lie et refuse l'actif (refus mémorisé dans le slot)
+    bleSlots.select(1, now);
+    ble_run(now, now + BLE_SLOT_READV_MS + 2 * SIM_BLE_STEP_MS, 0, &hostB);
+    simBle().pair();
+    ble_run(now, now + BLE_CONN_SETTLE_MS + 1000, now + BLE_CONN_SETTLE_MS + 1000);
+    ok &= bleSlots.connected() && bleSlots.slot(1).bonded && bleSlots.slot(1).addrType == 1 &&
+          bleSlots.slot(1).refused == (1 << BleConnParams::ACTIVE) && bleSlots.takeDirty() == (0x02 | BleSlots::DIRTY_ACTIVE);
+
+    // Retour au slot 1: B déconnecté, publicité dirigée vers A (B à portée n'y a pas accès)
+    bleSlots.select(0, now);
+    ble_run(now, now + BLE_SLOT_READV_MS + 2 * SIM_BLE_STEP_MS, 0, &hostB);
+    bool directedOk = simBle().directed() && !simBle().connected() && ss.directed == 1;
+    ble_run(now, now + 500, 0, &hostA);
+    uint32_t switchMs = ss.lastSwitchMs;
+    directedOk &= bleSlots.connected() && bleSlots.active() == 0 && ss.switches == 2 && switchMs < 1000;
+
+    // A parti: dirigée puis ouverte; B se connecte et est refusé, A revient
+    simBle().disconnect();
+    ble_run(now, now + BLE_SLOT_READV_MS + BLE_SLOT_DIRECTED_MS + 200, 0, &hostB);
+    bool rejectOk = ss.rejected > 0 && !bleSlots.connected() && !simBle().connected();
+    ble_run(now, now + 300, 0, &hostA);
+    rejectOk &= bleSlots.connected() && bleSlots.active() == 0;
+
+    // "Reboot" sur le slot 2 depuis la copie des slots: B retrouve son repli du premier coup
+    BleSlots::Slot saved[BLE_SLOT_COUNT];
+    for (uint8_t i = 0; i < BLE_SLOT_COUNT; i++) saved[i] = bleSlots.slot(i);
+    simBle().disconnect();
+    ble_run(now, now + SIM_BLE_STEP_MS, 0);
+    bleSlots.begin(&bleTransport(), &bleConn, 1, saved);
+    uint32_t requests0 = st.requests, rejected0 = st.rejected;
+    ble_run(now, now + 200, 0, &hostB);
+    ble_run(now, now + BLE_CONN_SETTLE_MS + 1000, now + BLE_CONN_SETTLE_MS + 1000);
+    bool keptOk = bleSlots.connected() && bleSlots.active() == 1 && st.requests - requests0 == 1 &&
+                  st.rejected == rejected0 && bleConn.mode() == BleConnParams::ACTIVE && bleConn.current().interval == 16;
+
+    // Slot 2 oublié: liaison retirée de la pile, B déconnecté
+    bleSlots.clear(1, now);
+    ble_run(now, now + SIM_BLE_STEP_MS, 0);
+    bool clearOk = !bleSlots.slot(1).bonded && !simBle().bonded(hostB.addr) && simBle().bonded(hostA.addr) &&
+                   !simBle().connected();
+
+    report("slots", ok && directedOk && rejectOk && keptOk && clearOk,
+           fmt("switch %u ms (directed %s), %u rejected (%s), refusal kept %s, clear %s", switchMs,
+               directedOk ? "ok" : "FAIL", ss.rejected, rejectOk ? "ok" : "FAIL", keptOk ? "ok" : "FAIL",
+               clearOk ? "ok" : "FAIL"));
+}
+
+// ─── HID: HidRouter, une file et une cadence par transport (temps virtuel, µs) ───
+
+struct SimSent {
+    uint32_t us;
+    uint8_t key;     // data[2] (0 = relâché)
+};
+static uint32_t routerNowUs = 0;
+static bool routerBleBusy = false;
+static std::vector<SimSent> routerSent[HidRouter::SINK_COUNT];
+
+static bool router_usb_send(const HidRouter::Report& r, uint32_t) {
+    routerSent[HidRouter::SINK_USB].push_back({routerNowUs, r.data[2]});
+    return true;
+}
+
+static bool router_ble_send(const HidRouter::Report& r, uint32_t) {
+    if (routerBleBusy) return false;
+    routerSent[HidRouter::SINK_BLE].push_back({routerNowUs, r.data[2]});
+    return true;
+}
+
+// Tâche hid_tx: poll(), puis attente de l'échéance arrondie au tick de 1 ms (au moins un tick)
+static void router_run(HidRouter& router, uint32_t untilUs) {
+    while (routerNowUs < untilUs) {
+        routerBleBusy = routerNowUs < SIM_ROUTER_CONGESTED_MS * 1000;
+        uint32_t waitUs = router.poll(routerNowUs);
+        uint32_t ticks = (waitUs == HidRouter::IDLE) ? 1 : (waitUs + 999) / 1000;
+        routerNowUs += (ticks ? ticks : 1) * 1000;
+    }
+}
+
+// Écart minimal entre deux envois d'une file, et ordre appui / relâché respecté
+static bool router_check(const std::vector<SimSent>& sent, uint32_t minGapUs, uint32_t* spanUs) {
+    bool ok = sent.size() == 2 * SIM_ROUTER_KEYS;
+    for (size_t i = 0; ok && i < sent.size(); i++) {
+        ok &= sent[i].key == ((i % 2) ? 0 : 4 + i / 2);
+        if (i > 0) ok &= sent[i].us - sent[i - 1].us >= minGapUs;
+    }
+    *spanUs = sent.empty() ? 0 : sent.back().us;
+    return ok;
+}
+
+// Rafale de SIM_ROUTER_KEYS touches vers USB et BLE, pile BLE saturée au début: l'USB part à
+// 1 ms d'écart sans attendre, le BLE reprend à son intervalle une fois libre. Puis file pleine
+// (groupes refusés entiers), maintien holdMs, fermeture de la file à la déconnexion.
+static void scenario_router() {
+    HidRouter router;
+    router.setSink(HidRouter::SINK_USB, router_usb_send, HID_USB_PACE_US);
+    router.setSink(HidRouter::SINK_BLE, router_ble_send, SIM_ROUTER_BLE_PACE_US);
+    router.setActive(HidRouter::SINK_USB, true);
+    router.setActive(HidRouter::SINK_BLE, true);
+
+    bool ok = true;
+    for (uint8_t k = 0; k < SIM_ROUTER_KEYS; k++) {
+        HidRouter::Report r[2] = {};
+        r[0].kind = r[1].kind = HidRouter::KIND_KEYBOARD;
+        r[0].len = r[1].len = 8;
+        r[0].data[2] = 4 + k;   // 'a', 'b', ...
+        ok &= router.submit(HidRouter::SINK_USB, r, 2, routerNowUs);
+        ok &= router.submit(HidRouter::SINK_BLE, r, 2, routerNowUs);
+    }
+    router_run(router, 1000000);
+    uint32_t usbSpanUs = 0, bleSpanUs = 0;
+    bool usbOk = router_check(routerSent[HidRouter::SINK_USB], HID_USB_PACE_US, &usbSpanUs) &&
+                 usbSpanUs < 2 * SIM_ROUTER_KEYS * HID_USB_PACE_US;
+    bool bleOk = router_check(routerSent[HidRouter::SINK_BLE], SIM_ROUTER_BLE_PACE_US, &bleSpanUs) &&
+                 routerSent[HidRouter::SINK_BLE].front().us >= SIM_ROUTER_CONGESTED_MS * 1000;
+    HidRouter::Stats usb = router.stats(HidRouter::SINK_USB), ble = router.stats(HidRouter::SINK_BLE);
+    bleOk &= ble.retries > 0 && ble.dropped == 0 && usb.retries == 0;
+
+    // File pleine: appui + relâché acceptés ou refusés ensemble, la file garde des paires
+    HidRouter::Report pair[2] = {};
+    pair[0].kind = pair[1].kind = HidRouter::KIND_KEYBOARD;
+    pair[0].len = pair[1].len = 8;
+    pair[0].data[2] = 0x1E;
+    uint8_t accepted = 0;
+    for (uint8_t i = 0; i < HID_QUEUE_LEN; i++) accepted += router.submit(HidRouter::SINK_BLE, pair, 2, routerNowUs);
+    bool fullOk = accepted == HID_QUEUE_LEN / 2 && router.queued(HidRouter::SINK_BLE) == HID_QUEUE_LEN &&
+                  router.stats(HidRouter::SINK_BLE).dropped == HID_QUEUE_LEN;
+    router.setActive(HidRouter::SINK_BLE, false);
+    fullOk &= router.queued(HidRouter::SINK_BLE) == 0 && !router.submit(HidRouter::SINK_BLE, pair, 2, routerNowUs);
+
+    // holdMs du relâché: le rapport suivant attend cadence + maintien
+    routerSent[HidRouter::SINK_USB].clear();
+    pair[1].holdMs = BLE_VOLUME_STEP_DELAY_MS;
+    router.submit(HidRouter::SINK_USB, pair, 2, routerNowUs);
+    router.submit(HidRouter::SINK_USB, pair, 2, routerNowUs);
+    router_run(router, routerNowUs + 1000000);
+    const std::vector<SimSent>& held = routerSent[HidRouter::SINK_USB];
+    bool holdOk = held.size() == 4 &&
+                  held[2].us - held[1].us >= HID_USB_PACE_US + BLE_VOLUME_STEP_DELAY_MS * 1000;
+
+    report("router", ok && usbOk && bleOk && fullOk && holdOk,
+           fmt("usb %u reports in %u us (max delay %u us), ble %u reports after %u ms congested, done at %u ms "
+               "(%u retries); full queue %u/%u pairs, hold %s",
+               usb.sent, usbSpanUs, usb.maxDelayUs, ble.sent, (unsigned)SIM_ROUTER_CONGESTED_MS, bleSpanUs / 1000,
+               ble.retries, accepted, (unsigned)HID_QUEUE_LEN, holdOk ? "ok" : "FAIL"));
+}
+
+// ─── Ordonnanceur de loop(): Scheduler en temps virtuel (µs), coût des tâches simulé ───
+
+static uint64_t schedElapsedUs = 0;
+static uint32_t schedHidRuns = 0, schedCancelledRuns = 0;
+static uint64_t schedComboAtUs = 0, schedFarAtUs = 0;
+
+static uint32_t sched_clock() { return SIM_SCHED_START_US + (uint32_t)schedElapsedUs; }
+static void sched_hid(uint32_t) { schedHidRuns++; schedElapsedUs += 200; }
+static void sched_link(uint32_t) { schedElapsedUs += 100; }
+static void sched_led(uint32_t) { schedElapsedUs += 500; }
+static void sched_slow(uint32_t) { schedElapsedUs += SIM_SCHED_SLOW_US; }
+static void sched_combo(uint32_t) { schedComboAtUs = schedElapsedUs; }
+static void sched_cancelled(uint32_t) { schedCancelledRuns++; }
+static void sched_far(uint32_t) { schedFarAtUs = schedElapsedUs; }
+
+// loop() du firmware: run(), puis delay() arrondi à la ms jusqu'à la prochaine échéance.
+// hid (2 ms) servi avant tout le reste, retard borné par la tâche lente; micros() reboucle.
+static void scenario_sched() {
+    Scheduler sched;
+    sched.begin(sched_clock);
+    uint8_t hid = sched.add("hid", sched_hid, 2, 0, 1000);
+    uint8_t link = sched.add("link", sched_link, 5, 1, 2000);
+    uint8_t led = sched.add("led", sched_led, 20, 3, 2000);
+    uint8_t slow = sched.add("slow", sched_slow, 100, 4, 2000);
+    uint8_t combo = sched.add("combo", sched_combo, 0, 2, 5000);
+    uint8_t cancelled = sched.add("cancel", sched_cancelled, 0, 2, 5000);
+    uint8_t far = sched.add("far", sched_far, 0, 5, 5000);
+    for (uint8_t id : {hid, link, led, slow}) sched.start(id, 0);
+    sched.start(combo, SIM_SCHED_COMBO_MS);
+    sched.start(cancelled, SIM_SCHED_COMBO_MS);
+    sched.start(far, SIM_SCHED_FAR_MS);
+
+    bool rearmed = false;
+    while (schedElapsedUs < (uint64_t)SIM_SCHED_RUN_MS * 1000) {
+        if (!rearmed && schedElapsedUs >= SIM_SCHED_COMBO_MS * 500) {
+            sched.start(combo, SIM_SCHED_COMBO_MS);
+            sched.cancel(cancelled);
+            rearmed = true;
+        }
+        sched.run();
+        uint32_t waitUs = sched.nextDueUs();
+        schedElapsedUs += (uint64_t)((waitUs + 999) / 1000) * 1000;
+    }
+
+    const Scheduler::Stats& h = sched.stats(hid);
+    const Scheduler::Stats& sl = sched.stats(slow);
+    uint32_t expected = SIM_SCHED_RUN_MS / 2;
+    bool hidOk = h.runs == schedHidRuns && h.runs + h.skipped + 2 >= expected && h.runs + h.skipped <= expected + 2 &&
+                 h.lateMaxUs <= SIM_SCHED_SLOW_US + 1000;
+    bool slowOk = sl.overruns == sl.runs && sl.runs >= SIM_SCHED_RUN_MS / 100 - 1;
+    uint32_t comboMs = schedComboAtUs / 1000, farMs = schedFarAtUs / 1000;
+    bool oneShotOk = comboMs >= SIM_SCHED_COMBO_MS * 3 / 2 && comboMs <= SIM_SCHED_COMBO_MS * 3 / 2 + 2 &&
+                     schedCancelledRuns == 0 && !sched.armed(combo) &&
+                     farMs >= SIM_SCHED_FAR_MS && farMs <= SIM_SCHED_FAR_MS + 5;  // Priorité la plus basse
+    report("sched", hidOk && slowOk && oneShotOk,
+           fmt("hid %u runs + %u skipped in %u s, late avg %u us max %u us, jitter avg %u us max %u us; "
+               "slow %u/%u over budget; combo at %u ms, cancelled %s, far at %u ms (micros() wrapped)",
+               h.runs, h.skipped, (unsigned)(SIM_SCHED_RUN_MS / 1000), (unsigned)(h.lateSumUs / h.runs),
+               h.lateMaxUs, (unsigned)(h.jitterSumUs / (h.jitterCount ? h.jitterCount : 1)), h.jitterMaxUs,
+               sl.overruns, sl.runs, comboMs, schedCancelledRuns ? "FIRED" : "never ran", farMs));
+}
+
+// Boot par étapes de l'ATmega: liaison prête tout de suite (sei), une commande acquittée et
+// servie pendant que l'écran démarre encore, puis écran effacé et panneau dessiné
+static bool scenario_boot() {
+    const SimAvrStats& a = sim_avr_stats();
+    bool booted = pump_until([] { return sim_avr_ready(); }, SIM_BOOT_TIMEOUT_MS);
+    obs.ledReply = false;
+    send_blocking(CMD_GET_LED, nullptr, 0);
+    bool replied = pump_until([] { return obs.ledReply; }, SIM_REPLY_TIMEOUT_MS);
+    uint64_t replyNs = a.lastRxNs;
+    bool duringInit = replied && a.pixels < SIM_PANEL_PIXELS;
+    bool drawn = pump_until([&] { return a.pixels >= SIM_PANEL_PIXELS; }, SIM_BOOT_TIMEOUT_MS) && wait_spi_quiet();
+    wait_idle(SIM_REPLY_TIMEOUT_MS);
+    double linkMs = a.readyNs / 1e6;
+    report("boot", booted && duringInit && drawn && linkMs <= SIM_BOOT_LINK_MAX_MS,
+           fmt("link ready (sei) at %.2f ms, GET_LED received at %.1f ms, answered %s, DISPON at %.1f ms, panel drawn at %.1f ms",
+               linkMs, replyNs / 1e6, duringInit ? "during display init" : "AFTER display init",
+               a.displayOnNs / 1e6, a.lastSpiNs / 1e6));
+    return booted;
+}
+
+static void scenario_negotiate() {
+    if (!opt.negotiate) {
+        report("baud", true, fmt("negotiation skipped, %u baud", (unsigned)atmegaLink.baud()));
+        return;
+    }
+    unsigned long t0 = millis();
+    atmegaLink.negotiate();
+    bool done = pump_until([] { return !atmegaLink.negotiating() && atmegaLink.idle(); }, SIM_NEGOTIATE_TIMEOUT_MS);
+    uint32_t esp = atmegaLink.baud();
+    uint32_t avr = sim_avr_stats().avrBaud.load();
+    bool agree = esp == avr || (esp > avr ? esp - avr : avr - esp) * 50 <= esp;
+    report("baud", done && agree,
+           fmt("ESP32 %u / ATmega %u baud in %lu ms", (unsigned)esp, (unsigned)avr, millis() - t0));
+}
+
+static void scenario_latency() {
+    std::vector<uint32_t> us;
+    uint32_t timeouts = 0;
+    const AtmegaLink::Stats& ls = atmegaLink.stats();
+    uint32_t bad0 = ls.crcErrors + ls.framingErrors + ls.rxOverruns + ls.dropped;
+    for (int i = 0; i < opt.latencyCount; i++) {
+        obs.ledReply = false;
+        unsigned long t0 = micros();
+        send_blocking(CMD_GET_LED, nullptr, 0);
+        if (pump_until([] { return obs.ledReply; }, SIM_REPLY_TIMEOUT_MS)) {
+            us.push_back(obs.ledAtUs - t0);
+        } else {
+            timeouts++;
+        }
+        wait_idle(SIM_REPLY_TIMEOUT_MS);
+    }
+    if (us.empty()) {
+        report("latency", false, "no GET_LED reply");
+        return;
+    }
+    std::sort(us.begin(), us.end());
+    uint64_t sum = 0;
+    for (uint32_t v : us) sum += v;
+    // Réponses non acquittées: avec fautes, chaque réponse manquante doit correspondre
+    // à une trame rejetée ou abandonnée (sinon l'ATmega n'a pas répondu)
+    uint32_t bad = ls.crcErrors + ls.framingErrors + ls.rxOverruns + ls.dropped - bad0;
+    bool pass = faultsInjected() ? timeouts <= bad : timeouts == 0;
+    report("latency", pass,
+           fmt("GET_LED x%d: min %u / avg %u / p99 %u / max %u us, %u timeouts (%u bad frames)",
+               opt.latencyCount, us.front(), (unsigned)(sum / us.size()), us[us.size() * 99 / 100], us.back(),
+               timeouts, bad));
+}
+
+static uint16_t image_pixel(uint16_t x, uint16_t y) {
+    return (uint16_t)((x * 0x0841u) ^ (y * 0x1863u) ^ 0xA5A5u);
+}
+
+static void scenario_image() {
+    int rows = std::min(std::max(opt.imageRows, 1), SIM_IMAGE_MAX_ROWS);
+    uint32_t size = (uint32_t)SIM_FB_WIDTH * 2 * rows;
+    std::vector<uint8_t> image(size);
+    for (uint32_t i = 0; i < size / 2; i++) {
+        uint16_t px = image_pixel(i % SIM_FB_WIDTH, i / SIM_FB_WIDTH);
+        image[2 * i] = px >> 8;  // RGB565 poids fort d'abord (ordre du ST7789)
+        image[2 * i + 1] = px & 0xFF;
+    }
+    const AtmegaLink::Stats& ls = atmegaLink.stats();
+    uint32_t dropped0 = ls.dropped;
+    uint64_t wire0 = sim_avr_stats().rxBytes.load();
+    unsigned long t0 = micros();
+
+    uint8_t payload[LINK_MAX_PAYLOAD];
+    ImageStart start = {(uint16_t)size};
+    send_blocking(CMD_SET_DISPLAY_IMAGE, payload, lmsg::encode<ImageStartMsg>(start, payload, sizeof(payload)));
+    for (uint32_t off = 0, idx = 0; off < size; off += LINK_IMAGE_CHUNK_MAX, idx++) {
+        ImageChunk chunk = {(uint16_t)idx, image.data() + off,
+                            (uint8_t)std::min<uint32_t>(LINK_IMAGE_CHUNK_MAX, size - off)};
+        send_blocking(CMD_SET_DISPLAY_IMAGE_CHUNK, payload,
+                      lmsg::encode<ImageChunkMsg>(chunk, payload, sizeof(payload)));
+    }
+    bool idle = wait_idle(30000);
+    double secs = (micros() - t0) / 1e6;
+    uint64_t wire = sim_avr_stats().rxBytes.load() - wire0;
+
+    std::vector<uint16_t> fb;
+    sim_avr_snapshot(fb);
+    uint32_t bad = 0;
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < SIM_FB_WIDTH; x++) {
+            if (fb[y * SIM_FB_WIDTH + x] != image_pixel(x, y)) bad++;
+        }
+    }
+    uint32_t dropped = ls.dropped - dropped0;
+    // Sans fautes: image exacte; avec fautes: seuls les chunks abandonnés peuvent manquer
+    bool pass = idle && (bad == 0 || (faultsInjected() && bad <= dropped * (LINK_IMAGE_CHUNK_MAX / 2)));
+    report("image", pass,
+           fmt("%u B in %.2f s: %.0f B/s payload, %.0f B/s wire; %u bad pixels, %u chunks dropped", (unsigned)size,
+               secs, size / secs, wire / secs, bad, dropped));
+}
+
+static void scenario_display() {
+    std::vector<uint16_t> before, after;
+    sim_avr_snapshot(before);
+    uint64_t oob0 = sim_avr_stats().oobPixels.load();
+    uint32_t ledWrites0 = sim_avr_stats().ledWrites.load();
+
+    DisplayData d = {128, "data", "Profile 2", "usb", 12, "F5", 1, 200, "Sim host"};
+    uint8_t payload[LINK_MAX_PAYLOAD];
+    send_blocking(CMD_SET_DISPLAY_DATA, payload, lmsg::encode<DisplayDataMsg>(d, payload, sizeof(payload)));
+    strcpy(d.lastKey, "F6");
+    d.backlightBrightness = 180;
+    send_blocking(CMD_SET_LAST_KEY, payload, lmsg::encode<LastKeyMsg>(d, payload, sizeof(payload)));
+    bool idle = wait_idle(5000);
+    delay(100);  // Le dessin se fait dans la boucle principale de l'ATmega
+    // La LED rejoint 180 par un fondu (LED_FADE_MS), pas d'un coup
+    bool faded = pump_until([] { return sim_avr_stats().ledDuty.load() == 180; }, SIM_REPLY_TIMEOUT_MS);
+    uint32_t ledSteps = sim_avr_stats().ledWrites.load() - ledWrites0;
+
+    sim_avr_snapshot(after);
+    uint32_t changed = 0;
+    for (size_t i = 0; i < after.size(); i++) changed += after[i] != before[i];
+    uint64_t oob = sim_avr_stats().oobPixels.load() - oob0;
+    uint8_t led = sim_avr_stats().ledDuty.load();
+    report("display", idle && changed > 0 && oob == 0 && faded && led == 180 && ledSteps > 1,
+           fmt("%u pixels changed, %u out of bounds, LED duty %u (%u PWM steps), fb hash %08X", changed,
+               (unsigned)oob, led, ledSteps, fb_hash(after)));
+    if (opt.dumpFb) dump_ppm(opt.dumpFb, after);
+}
+
+// Coût d'un dessin de l'ATmega: du dernier octet de la commande au dernier octet SPI
+// (temps virtuel, donc cycles d'attente SPI/registres; le calcul pur n'est pas compté)
+struct DrawCost {
+    uint64_t cycles, spiBytes, csBursts, windows, pixels;
+};
+
+static bool measure_draw(uint8_t cmd, const uint8_t* payload, uint8_t len, DrawCost& cost) {
+    const SimAvrStats& a = sim_avr_stats();
+    if (!wait_idle(5000)) return false;
+    uint64_t bytes0 = a.spiBytes, bursts0 = a.csBursts, windows0 = a.windows, pixels0 = a.pixels;
+    send_blocking(cmd, payload, len);
+    if (!wait_idle(5000)) return false;
+    wait_spi_quiet();
+    uint64_t rx = a.lastRxNs, spi = a.lastSpiNs;
+    cost.cycles = spi > rx ? (spi - rx) * SIM_F_CPU / 1000000000ULL : 0;
+    cost.spiBytes = a.spiBytes - bytes0;
+    cost.csBursts = a.csBursts - bursts0;
+    cost.windows = a.windows - windows0;
+    cost.pixels = a.pixels - pixels0;
+    return cost.spiBytes > 0;
+}
+
+static std::string draw_cost_str(const DrawCost& c) {
+    return fmt("%lu cycles (%.1f ms), %lu SPI B, %lu CS, %lu windows", (unsigned long)c.cycles,
+               c.cycles * 1000.0 / SIM_F_CPU, (unsigned long)c.spiBytes, (unsigned long)c.csBursts,
+               (unsigned long)c.windows);
+}
+
+// Banc de dessin: toutes les zones texte du panneau (6 zones changées par une seule
+// CMD_SET_DISPLAY_DATA), une touche qui ne change qu'un caractère (compositeur: un seul
+// glyphe redessiné), puis l'écran complet de CMD_UPDATE_DISPLAY
+static void scenario_redraw() {
+    uint64_t oob0 = sim_avr_stats().oobPixels.load(), errors0 = sim_avr_stats().spiErrors.load();
+    DisplayData d = {128, "data", "Redraw bench", "bluetooth", 17, "VOL+", 0, 0, "Host 2"};
+    uint8_t payload[LINK_MAX_PAYLOAD];
+    DrawCost zones, key, full;
+    bool ok = measure_draw(CMD_SET_DISPLAY_DATA, payload,
+                           lmsg::encode<DisplayDataMsg>(d, payload, sizeof(payload)), zones);
+    std::vector<uint16_t> fb;
+    sim_avr_snapshot(fb);
+    uint32_t zonesHash = fb_hash(fb);
+    strcpy(d.lastKey, "VOL-");
+    ok = measure_draw(CMD_SET_LAST_KEY, payload, lmsg::encode<LastKeyMsg>(d, payload, sizeof(payload)), key) &&
+         key.windows == 1 && key.pixels == FONT_WIDTH * FONT_HEIGHT && ok;
+    ok = measure_draw(CMD_UPDATE_DISPLAY, nullptr, 0, full) && ok;
+    uint64_t oob = sim_avr_stats().oobPixels.load() - oob0;
+    uint64_t errors = sim_avr_stats().spiErrors.load() - errors0;
+    sim_avr_snapshot(fb);
+    report("redraw", ok && oob == 0 && errors == 0,
+           fmt("zones: %s, fb hash %08X; one-glyph key: %s, %lu px; full panel: %s, fb hash %08X; %lu SPI errors",
+               draw_cost_str(zones).c_str(), zonesHash, draw_cost_str(key).c_str(), (unsigned long)key.pixels,
+               draw_cost_str(full).c_str(), fb_hash(fb), (unsigned long)errors));
+}
+
+// Glyphe attendu d'un code Latin-1, lu directement dans les tables de font_5x7.h
+static const uint8_t* ref_glyph(uint8_t code) {
+    if (code >= FONT_FIRST && code <= FONT_LAST) return font_5x7[code - FONT_FIRST];
+    if (code == 0xA0) return font_5x7[0];
+    const uint8_t* hit = (const uint8_t*)memchr(font_latin1_codes, code, sizeof(font_latin1_codes));
+    return hit ? font_latin1[hit - font_latin1_codes] : font_5x7['?' - FONT_FIRST];
+}
+
+// Pixels de la zone profil différents du rendu attendu (codes Latin-1, échelle 1, fond partout ailleurs)
+static uint32_t profile_zone_errors(const std::vector<uint16_t>& fb, const char* latin1) {
+    uint32_t bad = 0;
+    size_t n = strlen(latin1);
+    for (uint16_t row = 0; row < FONT_HEIGHT; row++) {
+        for (uint16_t dx = 0; dx < SIM_ZONE_W; dx++) {
+            size_t i = dx / FONT_ADVANCE;
+            uint8_t col = dx % FONT_ADVANCE;
+            bool on = i < n && col < FONT_WIDTH && (ref_glyph(latin1[i])[col] >> row & 1);
+            uint16_t px = fb[(SIM_PROFILE_Y + row) * SIM_FB_WIDTH + SIM_ZONE_X + dx];
+            bad += px != (on ? SIM_TEXT_FG : SIM_TEXT_BG);
+        }
+    }
+    return bad;
+}
+
+uint16_t font_text_width(const char* text, uint8_t scale);  // main.cpp (fonction pure)
+
+// Police de l'ATmega: profil UTF-8 accentué rendu glyphe par glyphe (tables en flash),
+// puis profil plus court: l'ancien texte doit être effacé exactement, rien au-delà
+static void scenario_font() {
+    DisplayData d = {128, "data", "", "usb", 12, "F6", 1, 180, "Sim host"};
+    uint8_t payload[LINK_MAX_PAYLOAD];
+    std::vector<uint16_t> fb;
+    static const struct {
+        const char* utf8;
+        const char* latin1;
+    } cases[] = {
+        // 23 octets UTF-8: profile[] plein
+        {"\xC3\x89t\xC3\xA9\xC3\xA0 No\xC3\xABl \xC2\xAB\xC2\xBB\xC2\xB0\xE2\x82\xAC",
+         "\xC9t\xE9\xE0 No\xEBl \xAB\xBB\xB0?"},
+        // « é » sur les octets 22-23: coupé par le champ, retiré entier à l'encodage
+        {"Bureau principal: 1234\xC3\xA9", "Bureau principal: 1234"},
+        {"Nuit", "Nuit"},
+    };
+    uint32_t bad = 0;
+    bool ok = true;
+    for (const auto& c : cases) {
+        snprintf(d.profile, sizeof(d.profile), "%s", c.utf8);
+        send_blocking(CMD_SET_DISPLAY_DATA, payload, lmsg::encode<DisplayDataMsg>(d, payload));
+        ok = wait_idle(5000) && ok;
+        delay(100);
+        sim_avr_snapshot(fb);
+        bad += profile_zone_errors(fb, c.latin1);
+    }
+    uint16_t w1 = font_text_width("\xC3\x89t\xC3\xA9", 1), w3 = font_text_width("\xC3\x89t\xC3\xA9", 3);
+    report("font", ok && bad == 0 && w1 == 17 && w3 == 51,
+           fmt("%u wrong pixels in the profile zone, width(\"\xC3\x89t\xC3\xA9\") = %u / %u px at 1x / 3x", bad, w1, w3));
+}
+
+static void scenario_light() {
+    uint16_t target = 900;
+    uint32_t pushes0 = obs.lightPushes;
+    unsigned long t0 = micros();
+    sim_avr_set_light(target, 3);
+    bool first = pump_until([&] { return obs.lightPushes != pushes0; }, SIM_LIGHT_TIMEOUT_MS);
+    unsigned long firstUs = obs.lightAtUs - t0;
+    bool settled = pump_until([&] { return abs((int)obs.light - (int)target) <= SIM_LIGHT_TOLERANCE; },
+                              SIM_LIGHT_TIMEOUT_MS);
+    report("light", first && settled,
+           fmt("500 -> %u: first push after %lu ms, settled (%u) after %lu ms, %u pushes", target, firstUs / 1000,
+               obs.light, (obs.lightAtUs - t0) / 1000, obs.lightPushes - pushes0));
+}
+
+// ATmega au repos (pings de l'ESP32 seulement): part du temps en sommeil, réveils par source.
+// Durée en ticks Timer2 (1 ms chacun): temps virtuel de l'ATmega, pas l'horloge murale
+static void scenario_sleep() {
+    const SimAvrStats& a = sim_avr_stats();
+    wait_idle(SIM_REPLY_TIMEOUT_MS);
+    uint64_t sleepNs0 = a.sleepNs, sleeps0 = a.sleeps, tick0 = a.isrTimer2, rx0 = a.isrRx, adc0 = a.isrAdc,
+             conv0 = a.adcConversions;
+    pump_until([] { return false; }, SIM_SLEEP_QUIET_MS);
+    uint64_t ticks = a.isrTimer2 - tick0;
+    double asleep = ticks ? (a.sleepNs - sleepNs0) / (ticks * 1e4) : 0;
+    report("sleep", ticks > 0 && asleep >= SIM_SLEEP_MIN_PCT,
+           fmt("%lu ms quiet: asleep %.1f%%, %lu wakes (%lu tick, %lu RX, %lu ADC interrupts), %lu ADC conversions", (unsigned long)ticks,
+               asleep, (unsigned long)(a.sleeps - sleeps0), (unsigned long)ticks, (unsigned long)(a.isrRx - rx0),
+               (unsigned long)(a.isrAdc - adc0), (unsigned long)(a.adcConversions - conv0)));
+}
+
+// ─── Fuzzing du parseur de l'ATmega ───────────────────────────────────────────
+
+// Lire une trame brute valide (COBS + CRC) depuis le port, hors AtmegaLink
+static bool read_raw_frame(SimUart& port, uint8_t* frame, uint16_t& len, unsigned long timeoutMs) {
+    uint8_t buf[LINK_ENCODED_MAX];
+    uint16_t n = 0;
+    unsigned long t0 = millis();
+    while (millis() - t0 < timeoutMs) {
+        int c = port.read();
+        if (c < 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            continue;
+        }
+        if (c != 0) {
+            if (n < sizeof(buf)) buf[n++] = (uint8_t)c;
+            continue;
+        }
+        uint16_t d = (n && n < sizeof(buf)) ? AtmegaLink::cobsDecode(buf, n) : 0;
+        n = 0;
+        if (d < LINK_HEADER_SIZE + LINK_CRC_SIZE) continue;
+        uint16_t crc = buf[d - 2] | (buf[d - 1] << 8);
+        if (crc != AtmegaLink::crc16(buf, d - 2)) continue;
+        memcpy(frame, buf, d);
+        len = d;
+        return true;
+    }
+    return false;
+}
+
+static void write_encoded(SimUart& port, const uint8_t* raw, uint16_t len) {
+    uint8_t enc[SIM_FUZZ_FRAME_MAX + SIM_FUZZ_FRAME_MAX / 254 + 2];
+    uint16_t e = AtmegaLink::cobsEncode(raw, len, enc);
+    enc[e++] = 0x00;
+    while (port.availableForWrite() < (int)e) std::this_thread::sleep_for(std::chrono::microseconds(50));
+    port.write(enc, e);
+}
+
+static uint16_t build_frame(uint8_t* raw, uint8_t seq, uint8_t cmd, const uint8_t* data, uint8_t len) {
+    raw[0] = seq;
+    raw[1] = cmd;
+    raw[2] = len;
+    memcpy(raw + LINK_HEADER_SIZE, data, len);
+    uint16_t crc = AtmegaLink::crc16(raw, LINK_HEADER_SIZE + len);
+    raw[LINK_HEADER_SIZE + len] = crc & 0xFF;
+    raw[LINK_HEADER_SIZE + len + 1] = crc >> 8;
+    return LINK_HEADER_SIZE + len + LINK_CRC_SIZE;
+}
+
+// L'ATmega répond-il encore? Laisser passer les trames en retard (commandes lourdes
+// en file, logs à 9600), puis PING avec un jeton frais à son débit courant
+static bool fuzz_alive(SimUart& port, uint8_t& seq) {
+    uint8_t frame[LINK_FRAME_MAX];
+    uint16_t len;
+    for (int attempt = 0; attempt < 3; attempt++) {
+        port.updateBaudRate(sim_avr_stats().avrBaud.load());
+        unsigned long q0 = millis();
+        while (millis() - q0 < SIM_FUZZ_SETTLE_MS && read_raw_frame(port, frame, len, 200)) {
+        }
+        uint8_t token[4] = {0xF0, 0x0D, (uint8_t)attempt, seq};
+        uint8_t raw[LINK_FRAME_MAX];
+        write_encoded(port, raw, build_frame(raw, seq++, CMD_LINK_PING, token, sizeof(token)));
+        unsigned long t0 = millis();
+        while (millis() - t0 < SIM_FUZZ_SETTLE_MS && read_raw_frame(port, frame, len, SIM_FUZZ_SETTLE_MS)) {
+            if (frame[1] == CMD_LINK_PING && frame[2] == sizeof(token) &&
+                memcmp(frame + LINK_HEADER_SIZE, token, sizeof(token)) == 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static void scenario_fuzz(SimUart& port) {
+    // Commandes connues (CMD_LINK_BAUD_SET exclue: changerait la vitesse à l'aveugle)
+    static const uint8_t known[] = {CMD_READ_LIGHT, CMD_SET_LED, CMD_GET_LED, CMD_UPDATE_DISPLAY,
+                                    CMD_SET_DISPLAY_DATA, CMD_SET_DISPLAY_IMAGE, CMD_SET_DISPLAY_IMAGE_CHUNK,
+                                    CMD_SET_ATMEGA_DEBUG, CMD_SET_ATMEGA_LOG_LEVEL, CMD_SET_LAST_KEY,
+                                    CMD_LIGHT_SUBSCRIBE, CMD_LINK_LOG, CMD_LINK_BAUD_CAPS, CMD_LINK_BAUD_TEST,
+                                    CMD_LINK_PING, CMD_LINK_STATUS, CMD_LINK_ACK, CMD_LINK_NACK};
+    std::mt19937 rng(opt.avr.seed ^ 0x5EEDu);
+    uint64_t oob0 = sim_avr_stats().oobPixels.load();
+    uint32_t valid = 0, mutated = 0, garbage = 0, fallbacks = 0;
+    uint8_t seq = (uint8_t)rng();
+    uint32_t baud = sim_avr_stats().avrBaud.load();
+    port.updateBaudRate(baud);
+    unsigned long t0 = millis();
+
+    for (long i = 0; i < opt.fuzz; i++) {
+        uint8_t raw[SIM_FUZZ_FRAME_MAX];
+        uint8_t data[LINK_MAX_PAYLOAD];
+        uint8_t cmd;
+        do {
+            cmd = (rng() & 1) ? known[rng() % sizeof(known)] : (uint8_t)rng();
+        } while (cmd == CMD_LINK_BAUD_SET);
+        uint8_t len = (uint8_t)(rng() % (LINK_MAX_PAYLOAD + 1));
+        for (uint8_t k = 0; k < len; k++) data[k] = (uint8_t)rng();
+        if (cmd == CMD_SET_DISPLAY_IMAGE_CHUNK && len >= 3 && (rng() & 1)) data[2] = (uint8_t)(rng() % 70);
+        uint16_t n = build_frame(raw, seq++, cmd, data, len);
+
+        uint32_t kind = rng() % 100;
+        if (kind < 70) {
+            write_encoded(port, raw, n);
+            valid++;
+        } else if (kind < 95) {
+            // Trame mutée: champ LEN faux, octets inversés, tronquée ou rallongée
+            switch (rng() % 4) {
+                case 0: raw[2] = (uint8_t)rng(); break;
+                case 1: raw[rng() % n] ^= (uint8_t)(1 << (rng() % 8)); break;
+                case 2: n = (uint16_t)(rng() % n); break;
+                default:
+                    for (int k = 0; k < 8 && n < sizeof(raw); k++) raw[n++] = (uint8_t)rng();
+                    break;
+            }
+            write_encoded(port, raw, n ? n : 1);
+            mutated++;
+        } else {
+            // Octets bruts (délimiteurs compris)
+            uint8_t junk[160];
+            uint16_t j = 1 + rng() % sizeof(junk);
+            for (uint16_t k = 0; k < j; k++) junk[k] = (rng() % 8) ? (uint8_t)rng() : 0;
+            while (port.availableForWrite() < (int)j) std::this_thread::sleep_for(std::chrono::microseconds(50));
+            port.write(junk, j);
+            garbage++;
+        }
+        uint8_t frame[LINK_FRAME_MAX];
+        uint16_t flen;
+        read_raw_frame(port, frame, flen, SIM_FUZZ_REPLY_MS);
+        // Trames invalides en rafale: l'ATmega revient seul à 9600, suivre
+        uint32_t now = sim_avr_stats().avrBaud.load();
+        if (now != baud) {
+            baud = now;
+            port.updateBaudRate(baud);
+            fallbacks++;
+        }
+    }
+    bool alive = fuzz_alive(port, seq);
+    uint64_t oob = sim_avr_stats().oobPixels.load() - oob0;
+    report("fuzz", alive && oob == 0,
+           fmt("%ld frames (%u valid, %u mutated, %u garbage) in %lu ms, %u baud fallbacks, %u oob pixels, %s",
+               opt.fuzz, valid, mutated, garbage, millis() - t0, fallbacks, (unsigned)oob,
+               alive ? "ATmega alive" : "ATmega NOT responding"));
+}
+
+// ─── Main ─────────────────────────────────────────────────────────────────────
+
+static void usage() {
+    puts("usage: keypad_sim [options]\n"
+         "  --loss P            perte d'octets (deux sens), probabilité 0..1\n"
+         "  --corrupt P         bit inversé par octet (deux sens)\n"
+         "  --line-max-baud B   ligne dégradée au-delà de B baud (10 % d'octets faux)\n"
+         "  --seed N            graine des fautes injectées et du fuzzing\n"
+         "  --no-negotiate      rester à 9600 baud\n"
+         "  --latency N         nombre de GET_LED chronométrés (200)\n"
+         "  --image-rows R      lignes de l'image de test (40, max 102)\n"
+         "  --fuzz N            N trames de fuzzing après les scénarios\n"
+         "  --dump-fb FILE      framebuffer final au format PPM\n"
+         "  --pty               ATmega seule sur un PTY (affiche le chemin de l'esclave)\n"
+         "  --verbose           logs de l'ATmega");
+}
+
+static bool parse_args(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        const char* v = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (a == "--loss" && v) {
+            opt.avr.rxLoss = opt.avr.txLoss = atof(v), i++;
+        } else if (a == "--corrupt" && v) {
+            opt.avr.rxCorrupt = opt.avr.txCorrupt = atof(v), i++;
+        } else if (a == "--line-max-baud" && v) {
+            opt.avr.lineMaxBaud = (uint32_t)atol(v), i++;
+        } else if (a == "--seed" && v) {
+            opt.avr.seed = (uint32_t)atol(v), i++;
+        } else if (a == "--latency" && v) {
+            opt.latencyCount = atoi(v), i++;
+        } else if (a == "--image-rows" && v) {
+            opt.imageRows = atoi(v), i++;
+        } else if (a == "--fuzz" && v) {
+            opt.fuzz = atol(v), i++;
+        } else if (a == "--dump-fb" && v) {
+            opt.dumpFb = v, i++;
+        } else if (a == "--no-negotiate") {
+            opt.negotiate = false;
+        } else if (a == "--pty") {
+            opt.ptyOnly = true;
+        } else if (a == "--verbose") {
+            opt.verbose = true;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (!parse_args(argc, argv)) {
+        usage();
+        return 2;
+    }
+    int master, slave;
+    char name[128];
+    if (openpty(&master, &slave, name, nullptr, nullptr) != 0) {
+        perror("openpty");
+        return 2;
+    }
+    // Ligne brute des deux côtés (ni écho, ni traduction CR/LF, ni signaux)
+    struct termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+    if (opt.ptyOnly) {
+        printf("[SIM] ATmega on %s (raw, any baud)\n", name);
+        fflush(stdout);
+        sim_avr_run(master, opt.avr);  // Ne retourne pas
+        return 0;
+    }
+
+    fcntl(slave, F_SETFL, fcntl(slave, F_GETFL) | O_NONBLOCK);
+    SimUart port(slave, ATMEGA_UART_BAUD, ATMEGA_UART_TX_BUFFER);
+    opt.avr.peerBaud = port.baudSource();
+    sim_avr_set_light(500, 3);
+    std::thread avr(sim_avr_run, master, opt.avr);
+    avr.detach();
+
+    logger.begin();
+    atmegaLink.begin(&port);
+    atmegaLink.setFrameCallback(on_atmega_frame);
+    static SimUart* portRef = &port;
+    atmegaLink.setBaudSetter([](uint32_t baud) { portRef->updateBaudRate(baud); });
+
+    scenario_codec();
+    scenario_adc();
+    scenario_ble();
+    scenario_slots();
+    scenario_router();
+    scenario_sched();
+    if (scenario_boot()) {
+        if (opt.verbose) {
+            uint8_t on = 1;
+            send_blocking(CMD_SET_ATMEGA_DEBUG, &on, 1);
+        }
+        scenario_negotiate();
+        scenario_latency();
+        scenario_image();
+        scenario_display();
+        scenario_font();
+        scenario_redraw();
+        scenario_light();
+        scenario_sleep();
+        if (opt.fuzz > 0) scenario_fuzz(port);
+    }
+
+    const AtmegaLink::Stats& s = atmegaLink.stats();
+    const SimAvrStats& a = sim_avr_stats();
+    printf("[SIM] link: %u tx / %u rx frames, %u retries, %u nacks, %u dropped, %u crc, %u framing\n",
+           s.txFrames, s.rxFrames, s.retries, s.nacks, s.dropped, s.crcErrors, s.framingErrors);
+    printf("[SIM] wire: %lu B to ATmega (%lu lost, %lu corrupted, %lu overruns), %lu B from ATmega, "
+           "%lu baud-mismatch bytes\n",
+           (unsigned long)a.rxBytes, (unsigned long)a.rxLost, (unsigned long)a.rxCorrupted,
+           (unsigned long)a.rxOverruns, (unsigned long)a.txBytes, (unsigned long)a.baudMismatch);
+    printf("[SIM] spi: %lu bytes, %lu CS bursts, %lu windows, %lu pixels (%lu oob), %lu errors, %lu ms busy\n",
+           (unsigned long)a.spiBytes, (unsigned long)a.csBursts, (unsigned long)a.windows,
+           (unsigned long)a.pixels, (unsigned long)a.oobPixels, (unsigned long)a.spiErrors,
+           (unsigned long)(a.spiBusyNs / 1000000));
+
+    int failed = 0;
+    for (const Result& r : results) failed += !r.pass;
+    printf("[SIM] %d/%d scenarios passed\n", (int)results.size() - failed, (int)results.size());
+    fflush(stdout);
+    sim_avr_stop();
+    _exit(failed ? 1 : 0);  // Thread AVR et tâche de log toujours en vie: pas de destructeurs
+}
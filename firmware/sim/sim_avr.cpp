@@ -0,0 +1,731 @@
+/*
+ * sim_avr.cpp — Machine ATmega328P simulée: horloge, UART0, SPI → ST7789, ADC
+ *
+ * Boucle à événements: chaque avance du temps virtuel (sim_advance) traite dans
+ * l'ordre les arrivées d'octets RX, les fins d'émission TX, les fins de
+ * conversion ADC et les comparaisons de Timer2, et sert les interruptions dès que
+ * SREG.I le permet.
+ */
+#include "sim_avr.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+
+// Vecteurs définis par main.cpp (macro ISR de hal/avr/interrupt.h)
+extern "C" void USART_RX_vect(void);
+extern "C" void USART_UDRE_vect(void);
+extern "C" void ADC_vect(void);
+extern "C" void TIMER2_COMPA_vect(void);
+int avr_main(void);
+
+#define NS_PER_CYCLE (1000000000ULL / SIM_F_CPU)
+#define REG_READ_NS NS_PER_CYCLE       // Attente active: 1 cycle par lecture de registre
+#define FD_POLL_NS 20000ULL            // Lecture du PTY au plus toutes les 20 µs virtuelles
+#define PACE_SLACK_NS 200000ULL        // Avance tolérée sur l'horloge murale
+#define PACE_PERIOD_NS 100000ULL       // Calage et requêtes du harnais toutes les 100 µs virtuelles
+#define DEGRADED_LINE_ERROR_RATE 0.10
+
+// Bits (mêmes positions que hal/avr/io.h, non inclus ici: il redéfinit main)
+#define B_SREG_I 7
+#define B_RXC0 7
+#define B_TXC0 6
+#define B_UDRE0 5
+#define B_FE0 4
+#define B_DOR0 3
+#define B_U2X0 1
+#define B_RXCIE0 7
+#define B_UDRIE0 5
+#define B_RXEN0 4
+#define B_TXEN0 3
+#define B_SPE 6
+#define B_MSTR 4
+#define B_SPIF 7
+#define B_SPI2X 0
+#define B_ADEN 7
+#define B_ADSC 6
+#define B_ADATE 5
+#define B_ADIF 4
+#define B_ADIE 3
+#define B_WGM21 1
+#define B_OCIE2A 1
+#define B_OCF2A 1
+#define ST_CS_PIN 2   // PB2
+#define ST_DC_PIN 1   // PB1
+#define ST_RST_PIN 0  // PB0
+
+#define ST7789_CASET 0x2A
+#define ST7789_RASET 0x2B
+#define ST7789_RAMWR 0x2C
+#define ST7789_SWRESET 0x01
+#define ST7789_DISPON 0x29
+
+namespace {
+
+struct RxByte {
+    uint64_t at;   // Fin du bit de stop (ns virtuelles)
+    uint8_t value;
+    bool fe;
+};
+
+struct RxSlot {
+    uint8_t value;
+    bool fe;
+    bool dor;
+};
+
+struct St7789 {
+    uint8_t cmd = 0;
+    uint8_t argc = 0;
+    uint8_t args[4] = {};
+    uint16_t x0 = 0, x1 = SIM_FB_WIDTH - 1, y0 = 0, y1 = SIM_FB_HEIGHT - 1;
+    uint16_t cx = 0, cy = 0;
+    bool half = false;
+    uint8_t hi = 0;
+};
+
+SimAvrConfig cfg;
+SimAvrStats stats;
+int linkFd = -1;
+std::mt19937 rng;
+std::uniform_real_distribution<double> uni(0.0, 1.0);
+
+uint8_t regs[SIM_REG_COUNT];
+uint64_t nowNs = 0;
+std::chrono::steady_clock::time_point wallOrigin;
+uint64_t lastPollNs = 0;
+uint64_t lastPaceNs = 0;
+bool inIsr = false;
+uint8_t sleepMode = 0;
+uint64_t isrCount = 0;    // Vecteurs servis (réveil du sommeil)
+bool seiServed = false;   // sei() a servi une interruption: le sleep qui suit ne dort pas
+
+// UART
+std::deque<RxByte> rxWire;
+uint64_t rxWireFree = 0;
+RxSlot rxFifo[2];
+uint8_t rxCount = 0;
+bool rxDorPending = false;
+bool txShifting = false;
+uint64_t txShiftEnd = 0;
+uint8_t txShiftByte = 0;  // Livré au PTY à la fin du bit de stop
+bool txPending = false;
+uint8_t txPendingByte = 0;
+bool txcFlag = true;
+
+// ADC
+uint64_t adcNext = 0;   // 0 = pas de conversion en cours
+bool adcWarm = false;   // Une conversion faite depuis ADEN: les suivantes durent 13 cycles
+uint16_t adcResult = 0;
+std::atomic<uint16_t> lightInput{500};
+std::atomic<uint16_t> lightNoise{0};
+
+// SPI
+bool spiShifting = false;
+uint64_t spiDoneNs = 0;  // Fin de l'octet en cours
+bool spifFlag = false;
+bool spifSeen = false;   // SPSR lu avec SPIF levé: le prochain accès à SPDR l'efface
+
+// Timer1
+uint16_t t1Count = 0;
+uint64_t t1Base = 0;
+
+// Timer2 (CTC seul: comparaison OCR2A, TCNT2 non modélisé)
+uint64_t t2Next = 0;   // 0 = arrêté
+uint64_t t2PeriodNs = 0;
+
+// ST7789
+St7789 panel;
+std::vector<uint16_t> framebuffer(SIM_FB_WIDTH * SIM_FB_HEIGHT, 0);
+
+std::atomic<bool> readyFlag{false};
+std::atomic<bool> stopFlag{false};
+std::atomic<bool> snapshotWanted{false};
+std::mutex snapshotMutex;
+std::condition_variable snapshotCv;
+std::vector<uint16_t> snapshotBuf;
+bool snapshotDone = false;
+
+inline bool bit(uint8_t id, uint8_t b) { return regs[id] & (1 << b); }
+
+uint32_t avrBaud() {
+    uint16_t ubrr = ((regs[SIM_UBRR0H] & 0x0F) << 8) | regs[SIM_UBRR0L];
+    uint32_t div = bit(SIM_UCSR0A, B_U2X0) ? 8 : 16;
+    return SIM_F_CPU / (div * (ubrr + 1UL));
+}
+
+// Débit du pair (ESP32) comparé à ±2 %: sinon chaque octet arrive faux
+bool baudMatches() {
+    if (!cfg.peerBaud) return true;
+    uint32_t a = avrBaud();
+    uint32_t p = cfg.peerBaud->load(std::memory_order_relaxed);
+    uint32_t d = a > p ? a - p : p - a;
+    return d * 50 <= p;
+}
+
+uint64_t byteNs(uint32_t baud) { return 10ULL * 1000000000ULL / baud; }
+
+// Erreurs injectées sur un octet; retourne false si l'octet est perdu
+bool injectFaults(uint8_t& value, bool& fe, double loss, double corrupt,
+                  std::atomic<uint64_t>& lost, std::atomic<uint64_t>& corrupted) {
+    fe = false;
+    if (!baudMatches()) {
+        stats.baudMismatch++;
+        value = (uint8_t)rng();
+        fe = (rng() & 1) != 0;
+        return true;
+    }
+    if (loss > 0 && uni(rng) < loss) {
+        lost++;
+        return false;
+    }
+    if (corrupt > 0 && uni(rng) < corrupt) {
+        corrupted++;
+        value ^= (uint8_t)(1 << (rng() & 7));
+    }
+    if (cfg.lineMaxBaud && avrBaud() > cfg.lineMaxBaud && uni(rng) < DEGRADED_LINE_ERROR_RATE) {
+        corrupted++;
+        value ^= (uint8_t)(1 << (rng() & 7));
+        fe = (rng() & 3) == 0;
+    }
+    return true;
+}
+
+// ─── PTY ──────────────────────────────────────────────────────────────────────
+
+void pollLink() {
+    lastPollNs = nowNs;
+    uint8_t buf[256];
+    for (;;) {
+        ssize_t n = read(linkFd, buf, sizeof(buf));
+        if (n <= 0) break;
+        uint32_t wireBaud = cfg.peerBaud ? cfg.peerBaud->load(std::memory_order_relaxed) : avrBaud();
+        uint64_t bt = byteNs(wireBaud);
+        for (ssize_t i = 0; i < n; i++) {
+            RxByte b;
+            b.value = buf[i];
+            if (!injectFaults(b.value, b.fe, cfg.rxLoss, cfg.rxCorrupt, stats.rxLost, stats.rxCorrupted)) continue;
+            rxWireFree = (rxWireFree > nowNs ? rxWireFree : nowNs) + bt;
+            b.at = rxWireFree;
+            rxWire.push_back(b);
+        }
+    }
+}
+
+void emitByte(uint8_t value) {
+    bool fe;
+    if (!injectFaults(value, fe, cfg.txLoss, cfg.txCorrupt, stats.txLost, stats.txCorrupted)) return;
+    stats.txBytes++;
+    for (;;) {
+        ssize_t n = write(linkFd, &value, 1);
+        if (n == 1) return;
+        if (n < 0 && errno != EAGAIN && errno != EINTR) return;  // Pair fermé: octet perdu
+        struct pollfd p = {linkFd, POLLOUT, 0};
+        poll(&p, 1, 10);
+    }
+}
+
+// ─── ST7789 ───────────────────────────────────────────────────────────────────
+
+void panelCommand(uint8_t cmd) {
+    panel.cmd = cmd;
+    panel.argc = 0;
+    if (cmd == ST7789_RAMWR) {
+        panel.cx = panel.x0;
+        panel.cy = panel.y0;
+        panel.half = false;
+        stats.windows++;
+    } else if (cmd == ST7789_SWRESET) {
+        panel = St7789();
+    } else if (cmd == ST7789_DISPON && stats.displayOnNs == 0) {
+        stats.displayOnNs = nowNs;
+    }
+}
+
+void panelData(uint8_t v) {
+    switch (panel.cmd) {
+        case ST7789_CASET:
+        case ST7789_RASET:
+            if (panel.argc < 4) panel.args[panel.argc++] = v;
+            if (panel.argc == 4) {
+                uint16_t s = (panel.args[0] << 8) | panel.args[1];
+                uint16_t e = (panel.args[2] << 8) | panel.args[3];
+                if (panel.cmd == ST7789_CASET) {
+                    panel.x0 = s;
+                    panel.x1 = e;
+                } else {
+                    panel.y0 = s;
+                    panel.y1 = e;
+                }
+            }
+            break;
+        case ST7789_RAMWR: {
+            if (!panel.half) {
+                panel.hi = v;
+                panel.half = true;
+                break;
+            }
+            panel.half = false;
+            stats.pixels++;
+            if (panel.x0 > panel.x1 || panel.y0 > panel.y1 || panel.cx >= SIM_FB_WIDTH || panel.cy >= SIM_FB_HEIGHT) {
+                stats.oobPixels++;
+            } else {
+                framebuffer[panel.cy * SIM_FB_WIDTH + panel.cx] = (uint16_t)((panel.hi << 8) | v);
+            }
+            // Balayage de la fenêtre: colonne puis ligne, retour au début en fin de fenêtre
+            if (++panel.cx > panel.x1) {
+                panel.cx = panel.x0;
+                if (++panel.cy > panel.y1) panel.cy = panel.y0;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+// ─── Interruptions ────────────────────────────────────────────────────────────
+
+void runIsr(void (*vector)(void), std::atomic<uint64_t>& counter) {
+    counter++;
+    isrCount++;
+    inIsr = true;
+    regs[SIM_SREG] &= ~(1 << B_SREG_I);
+    vector();
+    regs[SIM_SREG] |= (1 << B_SREG_I);  // RETI
+    inIsr = false;
+}
+
+// Servir les interruptions en attente, par priorité de vecteur (TIMER2_COMPA, RX, UDRE, ADC)
+void dispatch() {
+    if (inIsr || !bit(SIM_SREG, B_SREG_I)) return;
+    for (int guard = 0; guard < 1024; guard++) {
+        if (bit(SIM_TIFR2, B_OCF2A) && bit(SIM_TIMSK2, B_OCIE2A)) {
+            regs[SIM_TIFR2] &= ~(1 << B_OCF2A);
+            runIsr(TIMER2_COMPA_vect, stats.isrTimer2);
+        } else if (rxCount > 0 && bit(SIM_UCSR0B, B_RXCIE0)) {
+            runIsr(USART_RX_vect, stats.isrRx);
+        } else if (!txPending && bit(SIM_UCSR0B, B_UDRIE0) && bit(SIM_UCSR0B, B_TXEN0)) {
+            runIsr(USART_UDRE_vect, stats.isrUdre);
+        } else if (bit(SIM_ADCSRA, B_ADIF) && bit(SIM_ADCSRA, B_ADIE)) {
+            regs[SIM_ADCSRA] &= ~(1 << B_ADIF);  // Effacé par l'entrée dans le vecteur
+            runIsr(ADC_vect, stats.isrAdc);
+        } else {
+            return;
+        }
+    }
+}
+
+// ─── Événements ───────────────────────────────────────────────────────────────
+
+uint64_t adcConversionNs(bool first) {
+    static const uint8_t div[8] = {2, 2, 4, 8, 16, 32, 64, 128};
+    uint32_t cycles = (first ? 25 : 13) * div[regs[SIM_ADCSRA] & 0x07];
+    return cycles * NS_PER_CYCLE;
+}
+
+void adcComplete() {
+    int32_t v = lightInput.load(std::memory_order_relaxed);
+    uint16_t noise = lightNoise.load(std::memory_order_relaxed);
+    if (noise) v += (int32_t)(rng() % (2 * noise + 1)) - noise;
+    adcResult = (uint16_t)(v < 0 ? 0 : (v > 1023 ? 1023 : v));
+    adcWarm = true;
+    stats.adcConversions++;
+    regs[SIM_ADCSRA] |= (1 << B_ADIF);
+    if (bit(SIM_ADCSRA, B_ADATE) && (regs[SIM_ADCSRB] & 0x07) == 0) {
+        adcNext += adcConversionNs(false);  // Mode libre: la suivante démarre aussitôt
+    } else {
+        regs[SIM_ADCSRA] &= ~(1 << B_ADSC);
+        adcNext = 0;
+    }
+}
+
+void rxArrive(const RxByte& b) {
+    stats.rxBytes++;
+    stats.lastRxNs = nowNs;
+    if (!bit(SIM_UCSR0B, B_RXEN0)) return;
+    if (rxCount == 2) {
+        rxDorPending = true;  // Octet perdu, signalé sur le prochain lu
+        stats.rxOverruns++;
+        return;
+    }
+    rxFifo[rxCount++] = {b.value, b.fe, rxDorPending};
+    rxDorPending = false;
+}
+
+void txShiftDone() {
+    emitByte(txShiftByte);
+    if (txPending) {
+        txPending = false;
+        txShiftByte = txPendingByte;
+        txShiftEnd += byteNs(avrBaud());
+    } else {
+        txShifting = false;
+        txcFlag = true;
+    }
+}
+
+// Timer2: réglage relu à chaque écriture (prescaler de TCCR2B, CTC par WGM21, OCR2A)
+void timer2Setup() {
+    static const uint16_t div[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+    uint16_t d = div[regs[SIM_TCCR2B] & 0x07];
+    if (!d || !bit(SIM_TCCR2A, B_WGM21)) {
+        t2Next = 0;
+        return;
+    }
+    t2PeriodNs = (uint64_t)d * (regs[SIM_OCR2A] + 1) * NS_PER_CYCLE;
+    t2Next = nowNs + t2PeriodNs;
+}
+
+void timer2Compare() {
+    regs[SIM_TIFR2] |= (1 << B_OCF2A);
+    t2Next += t2PeriodNs;
+}
+
+uint64_t nextEvent() {
+    uint64_t t = UINT64_MAX;
+    if (!rxWire.empty()) t = rxWire.front().at;
+    if (txShifting && txShiftEnd < t) t = txShiftEnd;
+    if (adcNext && adcNext < t) t = adcNext;
+    if (t2Next && t2Next < t) t = t2Next;
+    return t;
+}
+
+void pace() {
+    lastPaceNs = nowNs;
+    if (!cfg.realTime) return;
+    uint64_t wall = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - wallOrigin).count();
+    if (nowNs > wall + PACE_SLACK_NS) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(nowNs - wall));
+    }
+}
+
+void serviceHarness() {
+    if (snapshotWanted.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(snapshotMutex);
+        snapshotBuf = framebuffer;
+        snapshotDone = true;
+        snapshotWanted.store(false, std::memory_order_release);
+        snapshotCv.notify_all();
+    }
+    if (stopFlag.load(std::memory_order_relaxed)) {
+        // Le firmware ne rend jamais la main: le thread reste garé ici
+        std::mutex parked;
+        std::unique_lock<std::mutex> lock(parked);
+        std::condition_variable cv;
+        for (;;) cv.wait(lock);
+    }
+}
+
+void advance(uint64_t ns) {
+    uint64_t target = nowNs + ns;
+    if (target - lastPollNs >= FD_POLL_NS || ns >= FD_POLL_NS) pollLink();
+    for (;;) {
+        uint64_t t = nextEvent();
+        if (t > target) break;
+        if (t > nowNs) nowNs = t;
+        if (!rxWire.empty() && rxWire.front().at == t) {
+            RxByte b = rxWire.front();
+            rxWire.pop_front();
+            rxArrive(b);
+        } else if (txShifting && txShiftEnd == t) {
+            txShiftDone();
+        } else if (adcNext == t) {
+            adcComplete();
+        } else {
+            timer2Compare();
+        }
+        dispatch();
+    }
+    if (nowNs < target) nowNs = target;  // Une ISR imbriquée a pu avancer plus loin
+    dispatch();
+    if (nowNs - lastPaceNs >= PACE_PERIOD_NS) {
+        pace();
+        serviceHarness();
+    }
+}
+
+// ─── Registres ────────────────────────────────────────────────────────────────
+
+uint8_t readUcsr0a() {
+    uint8_t v = regs[SIM_UCSR0A] & ((1 << B_U2X0) | 1);
+    if (rxCount) {
+        v |= (1 << B_RXC0);
+        if (rxFifo[0].fe) v |= (1 << B_FE0);
+        if (rxFifo[0].dor) v |= (1 << B_DOR0);
+    }
+    if (txcFlag) v |= (1 << B_TXC0);
+    if (!txPending) v |= (1 << B_UDRE0);
+    return v;
+}
+
+void writeUdr0(uint8_t v) {
+    if (!bit(SIM_UCSR0B, B_TXEN0)) return;
+    txcFlag = false;
+    if (!txShifting) {
+        txShiftByte = v;
+        txShifting = true;
+        txShiftEnd = nowNs + byteNs(avrBaud());
+    } else if (!txPending) {
+        txPending = true;
+        txPendingByte = v;
+    }
+    // UDRE = 0: écriture ignorée (comme le matériel, le firmware ne doit pas le faire)
+}
+
+uint16_t timer1Now() {
+    static const uint16_t div[8] = {0, 1, 8, 64, 256, 1024, 0, 0};  // 6-7: horloge externe, non modélisée
+    uint64_t tickNs = div[regs[SIM_TCCR1B] & 0x07] * NS_PER_CYCLE;
+    return tickNs ? (uint16_t)(t1Count + (nowNs - t1Base) / tickNs) : t1Count;
+}
+
+void spiUpdate() {
+    if (spiShifting && nowNs >= spiDoneNs) {
+        spiShifting = false;
+        spifFlag = true;
+    }
+}
+
+uint8_t readSpsr() {
+    // Attente active sur SPIF: saut direct à la fin de l'octet (interruptions servies)
+    spiUpdate();
+    advance(spiShifting ? spiDoneNs - nowNs : REG_READ_NS);
+    spiUpdate();
+    if (spifFlag) spifSeen = true;
+    return (regs[SIM_SPSR] & ~(1 << B_SPIF)) | (spifFlag ? (1 << B_SPIF) : 0);
+}
+
+void writeSpdr(uint8_t v) {
+    if (!bit(SIM_SPCR, B_SPE) || !bit(SIM_SPCR, B_MSTR)) {
+        regs[SIM_SPDR] = v;
+        return;
+    }
+    spiUpdate();
+    if (spiShifting) {
+        stats.spiErrors++;  // WCOL: écriture ignorée, l'octet en cours continue
+        return;
+    }
+    if (spifSeen) spifFlag = false;
+    spifSeen = false;
+    regs[SIM_SPDR] = v;
+    stats.spiBytes++;
+    if (!(regs[SIM_PORTB] & (1 << ST_CS_PIN))) {
+        if (regs[SIM_PORTB] & (1 << ST_DC_PIN)) {
+            panelData(v);
+        } else {
+            panelCommand(v);
+        }
+    }
+    static const uint8_t div[4] = {4, 16, 64, 128};
+    uint32_t cycles = 8 * div[regs[SIM_SPCR] & 0x03] / (bit(SIM_SPSR, B_SPI2X) ? 2 : 1);
+    stats.spiBusyNs += cycles * NS_PER_CYCLE;
+    spiShifting = true;
+    spiDoneNs = nowNs + cycles * NS_PER_CYCLE;
+    stats.lastSpiNs = spiDoneNs;
+}
+
+void writePortb(uint8_t v) {
+    uint8_t old = regs[SIM_PORTB];
+    spiUpdate();
+    if (spiShifting && ((old ^ v) & ((1 << ST_CS_PIN) | (1 << ST_DC_PIN)))) {
+        stats.spiErrors++;  // L'écran échantillonne DC au 8e bit: octet mal interprété
+    }
+    regs[SIM_PORTB] = v;
+    if ((old & (1 << ST_CS_PIN)) && !(v & (1 << ST_CS_PIN))) stats.csBursts++;
+    if (!(v & (1 << ST_RST_PIN)) && (old & (1 << ST_RST_PIN))) panel = St7789();
+}
+
+void writeAdcsra(uint8_t v) {
+    uint8_t keep = regs[SIM_ADCSRA] & (1 << B_ADIF);
+    if (v & (1 << B_ADIF)) keep = 0;  // Effacé en écrivant 1
+    regs[SIM_ADCSRA] = (v & ~(1 << B_ADIF)) | keep;
+    if (!(v & (1 << B_ADEN))) {
+        adcNext = 0;
+        adcWarm = false;
+        regs[SIM_ADCSRA] &= ~(1 << B_ADSC);
+    } else if ((v & (1 << B_ADSC)) && !adcNext) {
+        adcNext = nowNs + adcConversionNs(!adcWarm);
+    }
+}
+
+}  // namespace
+
+uint8_t sim_reg_read(uint8_t id) {
+    switch (id) {
+        case SIM_UCSR0A:
+            advance(REG_READ_NS);
+            return readUcsr0a();
+        case SIM_UDR0: {
+            if (!rxCount) return 0;
+            uint8_t v = rxFifo[0].value;
+            rxFifo[0] = rxFifo[1];
+            rxCount--;
+            return v;
+        }
+        case SIM_SPSR:
+            return readSpsr();
+        case SIM_SREG:
+            advance(REG_READ_NS);
+            return regs[SIM_SREG];
+        case SIM_ADCSRA:
+            advance(REG_READ_NS);
+            return regs[SIM_ADCSRA];
+        case SIM_ADCL:
+            return adcResult & 0xFF;
+        case SIM_ADCH:
+            return adcResult >> 8;
+        default:
+            return regs[id];
+    }
+}
+
+void sim_reg_write(uint8_t id, uint8_t value) {
+    switch (id) {
+        case SIM_UDR0:
+            writeUdr0(value);
+            break;
+        case SIM_UCSR0A:
+            regs[SIM_UCSR0A] = value & ((1 << B_U2X0) | 1);
+            if (value & (1 << B_TXC0)) txcFlag = false;
+            stats.avrBaud = avrBaud();
+            break;
+        case SIM_UBRR0L:
+        case SIM_UBRR0H:
+            regs[id] = value;
+            stats.avrBaud = avrBaud();
+            break;
+        case SIM_UCSR0B:
+            regs[id] = value;
+            dispatch();
+            break;
+        case SIM_SPDR:
+            writeSpdr(value);
+            break;
+        case SIM_PORTB:
+            writePortb(value);
+            break;
+        case SIM_ADCSRA:
+            writeAdcsra(value);
+            dispatch();
+            break;
+        case SIM_OCR0B:
+            regs[id] = value;
+            stats.ledDuty = value;
+            stats.ledWrites++;
+            break;
+        case SIM_TCCR1B:
+            t1Count = timer1Now();
+            t1Base = nowNs;
+            regs[id] = value;
+            break;
+        case SIM_TCCR2A:
+        case SIM_TCCR2B:
+        case SIM_OCR2A:
+            regs[id] = value;
+            timer2Setup();
+            break;
+        case SIM_TIFR2:
+            regs[id] &= ~value;  // Drapeaux effacés en écrivant 1
+            break;
+        case SIM_SREG:
+            regs[id] = value;
+            dispatch();
+            break;
+        default:
+            regs[id] = value;
+            break;
+    }
+}
+
+uint16_t sim_adc_read(void) { return adcResult; }
+
+uint16_t sim_timer1_read(void) { return timer1Now(); }
+
+void sim_timer1_write(uint16_t value) {
+    t1Count = value;
+    t1Base = nowNs;
+}
+
+void sim_avr_delay_ns(uint64_t ns) { advance(ns); }
+
+void sim_avr_cli(void) {
+    regs[SIM_SREG] &= ~(1 << B_SREG_I);
+    seiServed = false;
+}
+
+void sim_avr_sei(void) {
+    regs[SIM_SREG] |= (1 << B_SREG_I);
+    if (!readyFlag.load()) stats.readyNs = nowNs;
+    readyFlag.store(true, std::memory_order_release);
+    uint64_t before = isrCount;
+    dispatch();
+    seiServed = isrCount != before;
+}
+
+void sim_avr_set_sleep_mode(uint8_t mode) { sleepMode = mode; }
+
+// Sommeil: le temps saute d'événement en événement jusqu'à une interruption servie.
+// « sei(); sleep_cpu(); »: une interruption servie par le sei() aurait réveillé le CPU
+// juste après l'instruction SLEEP (exécutée avant le vecteur sur le matériel)
+void sim_avr_sleep(void) {
+    if (seiServed) {
+        seiServed = false;
+        return;
+    }
+    if (sleepMode == 1 && bit(SIM_ADCSRA, B_ADEN) && !adcNext) {
+        adcNext = nowNs + adcConversionNs(false);  // ADC Noise Reduction: démarre une conversion
+    }
+    stats.sleeps++;
+    uint64_t t0 = nowNs;
+    uint64_t before = isrCount;
+    while (isrCount == before) {
+        uint64_t t = nextEvent();
+        uint64_t step = (t == UINT64_MAX || t <= nowNs) ? FD_POLL_NS : t - nowNs;
+        if (step > FD_POLL_NS) step = FD_POLL_NS;
+        advance(step);
+    }
+    stats.sleepNs += nowNs - t0;
+}
+
+void sim_avr_run(int fd, const SimAvrConfig& config) {
+    cfg = config;
+    linkFd = fd;
+    rng.seed(cfg.seed);
+    memset(regs, 0, sizeof(regs));
+    regs[SIM_PORTB] = 0;
+    wallOrigin = std::chrono::steady_clock::now();
+    stats.avrBaud = avrBaud();
+    avr_main();
+}
+
+void sim_avr_stop(void) { stopFlag.store(true); }
+
+bool sim_avr_ready(void) { return readyFlag.load(std::memory_order_acquire); }
+
+const SimAvrStats& sim_avr_stats(void) { return stats; }
+
+void sim_avr_set_light(uint16_t adc, uint16_t noise) {
+    lightInput.store(adc);
+    lightNoise.store(noise);
+}
+
+void sim_avr_snapshot(std::vector<uint16_t>& fb) {
+    std::unique_lock<std::mutex> lock(snapshotMutex);
+    snapshotDone = false;
+    snapshotWanted.store(true, std::memory_order_release);
+    if (snapshotCv.wait_for(lock, std::chrono::seconds(2), [] { return snapshotDone; })) {
+        fb = snapshotBuf;
+    } else {
+        snapshotWanted.store(false);
+        fb.assign(SIM_FB_WIDTH * SIM_FB_HEIGHT, 0);  // Thread AVR bloqué: image vide
+    }
+}
@@ -0,0 +1,130 @@
+/*
+ * sim_avr.h — ATmega328P simulé pour exécuter atmega_light/main.cpp sur Linux
+ *
+ * Les registres utilisés par main.cpp (UART0, SPI, ADC, ports, SREG...) sont des
+ * objets SimReg8: chaque lecture/écriture passe par la machine (sim_avr.cpp),
+ * qui modélise l'UART (timing au débit réel, FIFO 2 octets, FE/DOR), le SPI vers
+ * un ST7789 (framebuffer RGB565 en mémoire), l'ADC en mode libre, Timer2 en CTC
+ * et le sommeil (réveil par la première interruption servie).
+ *
+ * Temps virtuel: avancé par _delay_*, les octets SPI et les attentes actives sur
+ * registres, calé sur l'horloge murale. SPI: un octet occupe 8 fronts de SCK après
+ * l'écriture de SPDR; SPIF suit la règle du matériel (lecture de SPSR puis accès à SPDR). Les interruptions sont servies entre deux
+ * accès registre si SREG.I est levé (un vecteur à la fois, I coupé pendant l'ISR).
+ *
+ * Côté harnais (keypad_sim.cpp): sim_avr_run() dans un thread dédié, reliée à un
+ * descripteur (maître du PTY); tout l'état AVR n'est touché que par ce thread.
+ */
+#ifndef SIM_AVR_H
+#define SIM_AVR_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <vector>
+
+#define SIM_F_CPU 8000000UL
+#define SIM_FB_WIDTH 320   // Mémoire du contrôleur en paysage (MADCTL MV)
+#define SIM_FB_HEIGHT 240
+
+enum SimRegId : uint8_t {
+    SIM_PORTB, SIM_DDRB, SIM_PINB, SIM_PORTC, SIM_DDRC, SIM_PINC, SIM_PORTD, SIM_DDRD, SIM_PIND,
+    SIM_SPCR, SIM_SPSR, SIM_SPDR,
+    SIM_ADMUX, SIM_ADCSRA, SIM_ADCSRB, SIM_DIDR0, SIM_ADCL, SIM_ADCH,
+    SIM_TCCR0A, SIM_TCCR0B, SIM_OCR0A, SIM_OCR0B, SIM_TCNT0, SIM_TIMSK0,
+    SIM_TCCR1A, SIM_TCCR1B,
+    SIM_TCCR2A, SIM_TCCR2B, SIM_OCR2A, SIM_OCR2B, SIM_TCNT2, SIM_TIMSK2, SIM_TIFR2, SIM_ASSR,
+    SIM_UBRR0H, SIM_UBRR0L, SIM_UCSR0A, SIM_UCSR0B, SIM_UCSR0C, SIM_UDR0,
+    SIM_MCUSR, SIM_WDTCSR, SIM_SMCR, SIM_PRR, SIM_SREG, SIM_GPIOR0,
+    SIM_REG_COUNT
+};
+
+uint8_t sim_reg_read(uint8_t id);
+void sim_reg_write(uint8_t id, uint8_t value);
+uint16_t sim_adc_read(void);
+uint16_t sim_timer1_read(void);
+void sim_timer1_write(uint16_t value);
+
+// Registre 8 bits: chaque accès est un point de synchronisation de la machine
+class SimReg8 {
+public:
+    explicit constexpr SimReg8(uint8_t id) : _id(id) {}
+    operator uint8_t() const { return sim_reg_read(_id); }
+    SimReg8& operator=(uint8_t v) { sim_reg_write(_id, v); return *this; }
+    SimReg8& operator|=(uint8_t v) { sim_reg_write(_id, sim_reg_read(_id) | v); return *this; }
+    SimReg8& operator&=(uint8_t v) { sim_reg_write(_id, sim_reg_read(_id) & v); return *this; }
+    SimReg8& operator^=(uint8_t v) { sim_reg_write(_id, sim_reg_read(_id) ^ v); return *this; }
+
+private:
+    uint8_t _id;
+};
+
+// ADC (ADCL + ADCH en une lecture, lecture seule)
+class SimAdc16 {
+public:
+    operator uint16_t() const { return sim_adc_read(); }
+};
+
+// TCNT1 (16 bits): compte au prescaler de TCCR1B sur le temps virtuel
+class SimTimer16 {
+public:
+    operator uint16_t() const { return sim_timer1_read(); }
+    SimTimer16& operator=(uint16_t v) { sim_timer1_write(v); return *this; }
+};
+
+// Primitives appelées par les en-têtes hal/ (interrupt.h, delay.h, sleep.h)
+void sim_avr_delay_ns(uint64_t ns);
+void sim_avr_cli(void);
+void sim_avr_sei(void);
+void sim_avr_set_sleep_mode(uint8_t mode);
+void sim_avr_sleep(void);
+
+// ─── Harnais ──────────────────────────────────────────────────────────────────
+
+struct SimAvrConfig {
+    double rxLoss = 0;          // Probabilité de perte d'un octet ESP32 → ATmega
+    double rxCorrupt = 0;       // Probabilité d'un bit inversé (ESP32 → ATmega)
+    double txLoss = 0;          // Idem ATmega → ESP32
+    double txCorrupt = 0;
+    uint32_t lineMaxBaud = 0;   // Au-delà, ligne dégradée (10 % d'octets faux), 0 = parfaite
+    const std::atomic<uint32_t>* peerBaud = nullptr;  // Débit de l'ESP32 (nullptr = supposé égal)
+    uint32_t seed = 1;
+    bool realTime = true;       // Caler le temps virtuel sur l'horloge murale
+};
+
+// Compteurs (lisibles depuis un autre thread)
+struct SimAvrStats {
+    std::atomic<uint64_t> rxBytes{0}, txBytes{0};
+    std::atomic<uint64_t> rxLost{0}, rxCorrupted{0}, txLost{0}, txCorrupted{0};
+    std::atomic<uint64_t> baudMismatch{0};   // Octets reçus/émis à un débit différent du pair
+    std::atomic<uint64_t> rxOverruns{0};     // DOR: FIFO 2 octets pleine (ISR RX trop tardive)
+    std::atomic<uint64_t> isrRx{0}, isrUdre{0}, isrAdc{0}, isrTimer2{0};
+    std::atomic<uint64_t> adcConversions{0};
+    std::atomic<uint64_t> sleeps{0};         // sleep_cpu() qui ont dormi (réveils)
+    std::atomic<uint64_t> sleepNs{0};        // Temps virtuel passé en sommeil
+    std::atomic<uint64_t> spiBytes{0};
+    std::atomic<uint64_t> csBursts{0};       // Fronts descendants de CS
+    std::atomic<uint64_t> windows{0};        // RAMWR
+    std::atomic<uint64_t> pixels{0};
+    std::atomic<uint64_t> oobPixels{0};      // Pixels hors framebuffer ou fenêtre invalide
+    std::atomic<uint64_t> spiBusyNs{0};      // Temps SPI cumulé
+    std::atomic<uint64_t> spiErrors{0};      // WCOL (SPDR écrit pendant un octet) ou DC/CS changés pendant un octet
+    std::atomic<uint64_t> lastRxNs{0};       // Temps virtuel du dernier octet reçu
+    std::atomic<uint64_t> lastSpiNs{0};      // Temps virtuel de fin du dernier octet SPI
+    std::atomic<uint64_t> readyNs{0};        // Temps virtuel du premier sei() (liaison prête)
+    std::atomic<uint64_t> displayOnNs{0};    // Temps virtuel de DISPON
+    std::atomic<uint32_t> avrBaud{0};
+    std::atomic<uint8_t> ledDuty{0};         // OCR0B
+    std::atomic<uint32_t> ledWrites{0};      // Écritures d'OCR0B (pas du fondu)
+};
+
+// Boucle AVR (ne retourne qu'après sim_avr_stop()): à lancer dans un thread
+void sim_avr_run(int fd, const SimAvrConfig& cfg);
+void sim_avr_stop(void);
+bool sim_avr_ready(void);                  // sei() exécuté (fin du boot)
+const SimAvrStats& sim_avr_stats(void);
+void sim_avr_set_light(uint16_t adc, uint16_t noise);  // Entrée ADC0 (0-1023) ± bruit
+// Copie cohérente du framebuffer (prise par le thread AVR entre deux pas)
+void sim_avr_snapshot(std::vector<uint16_t>& fb);
+
+#endif // SIM_AVR_H
@@ -0,0 +1,114 @@
+/* sim_ble.cpp — Hôte BLE simulé derrière BleTransport */
+#include "sim_ble.h"
+
+#include <string.h>
+
+static SimBleTransport transport;
+
+BleTransport& bleTransport() { return transport; }
+SimBleTransport& simBle() { return transport; }
+
+bool SimBleTransport::begin(const char*, const Callbacks& cb) {
+    _cb = cb;
+    _advertising = true;
+    return true;
+}
+
+bool SimBleTransport::sendReport(const uint8_t* report, size_t len) {
+    if (!_connected) return false;
+    _reports.emplace_back(report, report + len);
+    return true;
+}
+
+bool SimBleTransport::sendSerial(const uint8_t* data, size_t len) {
+    if (!_connected) return false;
+    _serialOut.insert(_serialOut.end(), data, data + len);
+    return true;
+}
+
+bool SimBleTransport::requestConnParams(uint16_t minInterval, uint16_t maxInterval, uint16_t latency,
+                                        uint16_t timeout) {
+    if (!_connected || _pending) return false;
+    _pending = true;
+    _reqMin = minInterval;
+    _reqMax = maxInterval;
+    _reqLatency = latency;
+    _reqTimeout = timeout;
+    return true;
+}
+
+void SimBleTransport::startAdvertising() {
+    _advertising = true;
+    _directed = false;
+}
+
+bool SimBleTransport::advertiseDirected(const uint8_t* addr, uint8_t) {
+    _advertising = true;
+    _directed = true;
+    memcpy(_directedTo, addr, sizeof(_directedTo));
+    return true;
+}
+
+void SimBleTransport::removeBond(const uint8_t* addr, uint8_t) {
+    for (size_t i = 0; i < _bonds.size(); i++) {
+        if (memcmp(_bonds[i].data(), addr, 6) == 0) {
+            _bonds.erase(_bonds.begin() + i);
+            return;
+        }
+    }
+}
+
+bool SimBleTransport::bonded(const uint8_t* addr) const {
+    for (const std::vector<uint8_t>& b : _bonds) {
+        if (memcmp(b.data(), addr, 6) == 0) return true;
+    }
+    return false;
+}
+
+bool SimBleTransport::accepts(const Host& host) const {
+    if (_connected || !_advertising) return false;
+    return !_directed || memcmp(_directedTo, host.addr, sizeof(_directedTo)) == 0;
+}
+
+bool SimBleTransport::connect(const Host& host) {
+    if (!accepts(host)) return false;
+    _host = host;
+    _connected = true;
+    _advertising = false;
+    _pending = false;
+    if (_cb.connected) _cb.connected(host.addr, host.addrType, host.interval, host.latency, host.timeout);
+    return true;
+}
+
+void SimBleTransport::pair() {
+    if (!_connected) return;
+    if (!bonded(_host.addr)) _bonds.emplace_back(_host.addr, _host.addr + 6);
+    if (_cb.paired) _cb.paired(_host.addr, _host.addrType, true);
+}
+
+void SimBleTransport::disconnect() {
+    if (!_connected) return;
+    _connected = false;
+    _pending = false;
+    if (_cb.disconnected) _cb.disconnected();
+}
+
+void SimBleTransport::hostEvent() {
+    if (!_pending) return;
+    _pending = false;
+    if (_host.minInterval > _reqMax) {
+        // Refus: les paramètres courants restent
+        if (_cb.connParamsUpdated) {
+            _cb.connParamsUpdated(BLE_SIM_REJECT, _host.interval, _host.latency, _host.timeout);
+        }
+        return;
+    }
+    _host.interval = (_reqMin > _host.minInterval) ? _reqMin : _host.minInterval;
+    _host.latency = _reqLatency;
+    _host.timeout = _reqTimeout;
+    if (_cb.connParamsUpdated) _cb.connParamsUpdated(0, _host.interval, _host.latency, _host.timeout);
+}
+
+void SimBleTransport::hostWrite(const char* text) {
+    if (_connected && _cb.serialReceived) _cb.serialReceived((const uint8_t*)text, strlen(text));
+}
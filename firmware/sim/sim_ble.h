@@ -0,0 +1,72 @@
+/*
+ * sim_ble.h — BleTransport simulé: hôte BLE piloté par les scénarios
+ *
+ * bleTransport() rend cette implémentation (à la place de Bluedroid / NimBLE).
+ * L'hôte accepte une demande de paramètres si son intervalle minimal tient dans
+ * [min, max] demandé, sinon il la refuse (status BLE_SIM_REJECT, comme iOS sous 15 ms).
+ * La réponse n'arrive qu'au hostEvent() suivant, comme l'événement GAP sur cible.
+ * Un hôte ne se connecte que sur publicité ouverte, ou dirigée vers son adresse;
+ * pair() le lie (liste des liaisons de la "pile", removeBond() l'en retire).
+ */
+#ifndef SIM_BLE_H
+#define SIM_BLE_H
+
+#include "BleTransport.h"
+
+#include <vector>
+
+#define BLE_SIM_REJECT 0x3B  // HCI: Unacceptable Connection Parameters
+
+class SimBleTransport : public BleTransport {
+public:
+    struct Host {
+        uint16_t minInterval;   // Plus petit intervalle accepté (1,25 ms)
+        uint16_t interval;      // Paramètres imposés à la connexion
+        uint16_t latency;
+        uint16_t timeout;
+        uint8_t addr[6];        // Adresse d'identité
+        uint8_t addrType;
+    };
+
+    const char* stackName() const override { return "sim"; }
+    bool begin(const char* name, const Callbacks& cb) override;
+    bool connected() const override { return _connected; }
+    bool sendReport(const uint8_t* report, size_t len) override;
+    bool sendSerial(const uint8_t* data, size_t len) override;
+    void startAdvertising() override;
+    bool advertiseDirected(const uint8_t* addr, uint8_t addrType) override;
+    void disconnect() override;   // Côté firmware ou côté hôte: même événement
+    void removeBond(const uint8_t* addr, uint8_t addrType) override;
+    bool requestConnParams(uint16_t minInterval, uint16_t maxInterval, uint16_t latency, uint16_t timeout) override;
+
+    // Côté hôte
+    bool accepts(const Host& host) const;   // Publicité en cours qui laisse cet hôte se connecter
+    bool connect(const Host& host);
+    void pair();                            // Appairage avec liaison de l'hôte connecté
+    void hostEvent();                   // Répond à la demande en attente
+    void hostWrite(const char* text);   // Écriture sur la caractéristique série
+
+    bool advertising() const { return _advertising; }
+    bool directed() const { return _advertising && _directed; }
+    bool bonded(const uint8_t* addr) const;
+    const std::vector<std::vector<uint8_t>>& reports() const { return _reports; }
+    const std::vector<uint8_t>& serialOut() const { return _serialOut; }
+    void clearReports() { _reports.clear(); }
+
+private:
+    Callbacks _cb = {};
+    Host _host = {};
+    bool _connected = false;
+    bool _advertising = false;
+    bool _directed = false;
+    uint8_t _directedTo[6] = {};
+    std::vector<std::vector<uint8_t>> _bonds;
+    bool _pending = false;
+    uint16_t _reqMin = 0, _reqMax = 0, _reqLatency = 0, _reqTimeout = 0;
+    std::vector<std::vector<uint8_t>> _reports;
+    std::vector<uint8_t> _serialOut;
+};
+
+SimBleTransport& simBle();
+
+#endif // SIM_BLE_H
@@ -0,0 +1,124 @@
+/* sim_esp.cpp — Cœur Arduino minimal (temps, console, tâches) et SimUart */
+#include "sim_esp.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include <esp_timer.h>
+
+namespace {
+const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+std::mutex consoleMutex;
+}
+
+int64_t esp_timer_get_time(void) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+unsigned long millis(void) { return (unsigned long)(esp_timer_get_time() / 1000); }
+unsigned long micros(void) { return (unsigned long)esp_timer_get_time(); }
+void delay(unsigned long ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+size_t Print::printf(const char* fmt, ...) {
+    char buf[256];
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    if (n < 0) return 0;
+    return write((const uint8_t*)buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+}
+
+SimConsole Serial;
+
+size_t SimConsole::write(const uint8_t* buf, size_t len) {
+    std::lock_guard<std::mutex> lock(consoleMutex);
+    fwrite(buf, 1, len, stdout);
+    fflush(stdout);
+    return len;
+}
+
+EspClass ESP;
+
+uint32_t EspClass::getCycleCount() { return (uint32_t)(esp_timer_get_time() * 240); }  // 240 MHz
+uint32_t EspClass::getFreeHeap() { return 0; }  // Pas de tas ESP32 sur l'hôte
+
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void*), const char*, uint32_t, void* arg, int, TaskHandle_t*, int) {
+    std::thread(fn, arg).detach();
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) { std::this_thread::sleep_for(std::chrono::milliseconds(ticks)); }
+
+// ─── SimUart ──────────────────────────────────────────────────────────────────
+
+SimUart::SimUart(int fd, uint32_t baud, size_t txBufferSize) : _fd(fd), _baud(baud), _txSize(txBufferSize) {}
+
+uint32_t SimUart::_byteUs() const {
+    uint32_t us = 10000000UL / baudRate();
+    return us ? us : 1;
+}
+
+void SimUart::updateBaudRate(uint32_t baud) { _baud.store(baud, std::memory_order_relaxed); }
+
+int SimUart::availableForWrite() {
+    uint64_t now = micros();
+    if (_txEndUs <= now) return (int)_txSize;
+    size_t queued = (size_t)((_txEndUs - now + _byteUs() - 1) / _byteUs());
+    return queued >= _txSize ? 0 : (int)(_txSize - queued);
+}
+
+size_t SimUart::write(const uint8_t* buf, size_t len) {
+    uint64_t now = micros();
+    _txEndUs = (_txEndUs > now ? _txEndUs : now) + (uint64_t)len * _byteUs();
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = ::write(_fd, buf + done, len - done);
+        if (n > 0) {
+            done += (size_t)n;
+        } else if (n < 0 && errno != EAGAIN && errno != EINTR) {
+            break;
+        } else {
+            struct pollfd p = {_fd, POLLOUT, 0};
+            poll(&p, 1, 10);
+        }
+    }
+    return done;
+}
+
+void SimUart::flush() {
+    uint64_t now = micros();
+    if (_txEndUs > now) std::this_thread::sleep_for(std::chrono::microseconds(_txEndUs - now));
+}
+
+void SimUart::_fill() {
+    if (_rxHead > 0) {
+        memmove(_rx, _rx + _rxHead, _rxLen - _rxHead);
+        _rxLen -= _rxHead;
+        _rxHead = 0;
+    }
+    if (_rxLen == sizeof(_rx)) return;
+    ssize_t n = ::read(_fd, _rx + _rxLen, sizeof(_rx) - _rxLen);
+    if (n > 0) _rxLen += (size_t)n;
+}
+
+int SimUart::available() {
+    _fill();
+    return (int)(_rxLen - _rxHead);
+}
+
+int SimUart::read() {
+    if (_rxHead == _rxLen) _fill();
+    if (_rxHead == _rxLen) return -1;
+    return _rx[_rxHead++];
+}
+
+void SimUart::discardInput() {
+    while (available()) _rxHead = _rxLen;
+}
@@ -0,0 +1,44 @@
+/*
+ * sim_esp.h — Port série ESP32 simulé sur un descripteur (esclave du PTY)
+ *
+ * Même contrat que HardwareSerial pour AtmegaLink: write() jamais bloquant,
+ * availableForWrite() = place restante d'un tampon TX qui se vide au débit courant,
+ * updateBaudRate() publie le débit pour la machine AVR (désaccord = octets faux).
+ */
+#ifndef SIM_ESP_H
+#define SIM_ESP_H
+
+#include <Arduino.h>
+#include <atomic>
+
+class SimUart : public Stream {
+public:
+    SimUart(int fd, uint32_t baud, size_t txBufferSize);
+
+    void updateBaudRate(uint32_t baud);
+    uint32_t baudRate() const { return _baud.load(std::memory_order_relaxed); }
+    // Débit lu par la machine AVR (SimAvrConfig::peerBaud)
+    const std::atomic<uint32_t>* baudSource() const { return &_baud; }
+
+    size_t write(uint8_t b) override { return write(&b, 1); }
+    size_t write(const uint8_t* buf, size_t len) override;
+    int available() override;
+    int read() override;
+    int availableForWrite() override;
+    void flush() override;  // Attend la fin d'émission (tampon TX vide)
+    void discardInput();
+
+private:
+    int _fd;
+    std::atomic<uint32_t> _baud;
+    size_t _txSize;
+    uint64_t _txEndUs = 0;  // Fin d'émission du dernier octet écrit (micros)
+    uint8_t _rx[512];
+    size_t _rxHead = 0;
+    size_t _rxLen = 0;
+
+    uint32_t _byteUs() const;
+    void _fill();
+};
+
+#endif // SIM_ESP_H
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""
+log_decode.py — Décode un dump de l'anneau de log binaire de l'ESP32 (Log.h)
+
+Entrées acceptées:
+  - capture du moniteur série contenant les lignes "LOGDUMP ..." ({"type":"log_dump"})
+  - fichier binaire brut (--raw): enregistrements de 32 octets concaténés
+
+La table des formats est relue depuis LogFormats.h (ID = position dans la liste).
+
+Usage:
+  python3 log_decode.py capture.txt
+  python3 log_decode.py --raw ring.bin
+  python3 log_decode.py --formats ../esp32/esp32_micropython/LogFormats.h capture.txt
+"""
+import argparse
+import os
+import re
+import struct
+import sys
+
+RECORD_SIZE = 32
+RECORD = struct.Struct("<IIHBB20s")  # seq, ts_us, fmt, level, len, data
+LEVELS = "-EWID"
+DEFAULT_FORMATS = os.path.join(os.path.dirname(__file__), "..", "esp32", "esp32_micropython", "LogFormats.h")
+
+ENTRY_RE = re.compile(r'X\(\s*(\w+)\s*,\s*[\w|\s]+,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+SPEC_RE = re.compile(r"%([-0-9]*)([duxXcs%])")
+
+
+def load_formats(path):
+    with open(path, encoding="utf-8") as f:
+        text = f.read()
+    start = text.index("#define LOG_FORMATS(X)")
+    body = text[start:text.index("enum LogFmt", start)]
+    return [(name, bytes(fmt, "utf-8").decode("unicode_escape")) for name, fmt in ENTRY_RE.findall(body)]
+
+
+def format_record(fmt, data):
+    out = []
+    pos = 0
+    last = 0
+    for m in SPEC_RE.finditer(fmt):
+        out.append(fmt[last:m.start()])
+        last = m.end()
+        flags, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+        elif conv == "s":
+            raw = data[pos:]
+            out.append(("%" + flags + "s") % raw.split(b"\0", 1)[0].decode("latin-1"))
+            pos = len(data)
+        else:
+            v = struct.unpack_from("<I", data, pos)[0] if pos + 4 <= len(data) else 0
+            pos += 4
+            if conv == "d" and v >= 0x80000000:
+                v -= 1 << 32
+            out.append(("%" + flags + ("d" if conv == "u" else conv)) % (chr(v & 0xFF) if conv == "c" else v))
+    out.append(fmt[last:])
+    return "".join(out)
+
+
+def read_records(path, raw):
+    if raw:
+        with open(path, "rb") as f:
+            blob = f.read()
+        return [blob[i:i + RECORD_SIZE] for i in range(0, len(blob) - RECORD_SIZE + 1, RECORD_SIZE)]
+    records = []
+    with open(path, encoding="utf-8", errors="replace") as f:
+        for line in f:
+            line = line.strip()
+            if not line.startswith("LOGDUMP ") or " BEGIN" in line or line.endswith(" END"):
+                continue
+            hexdata = line.split(" ", 1)[1]
+            if len(hexdata) == RECORD_SIZE * 2:
+                records.append(bytes.fromhex(hexdata))
+    return records
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Décodeur de l'anneau de log binaire ESP32")
+    ap.add_argument("dump", help="capture série (LOGDUMP) ou fichier binaire (--raw)")
+    ap.add_argument("--raw", action="store_true", help="dump binaire brut")
+    ap.add_argument("--formats", default=DEFAULT_FORMATS, help="chemin vers LogFormats.h")
+    args = ap.parse_args()
+
+    formats = load_formats(args.formats)
+    decoded = []
+    for rec in read_records(args.dump, args.raw):
+        seq, ts_us, fmt_id, level, length, data = RECORD.unpack(rec)
+        if seq == 0:
+            continue
+        data = data[:min(length, len(data))]
+        if fmt_id < len(formats):
+            text = format_record(formats[fmt_id][1], data)
+        else:
+            text = "[LOG] fmt inconnu %u (%s)" % (fmt_id, data.hex())
+        decoded.append((seq, ts_us, level, text))
+
+    decoded.sort()
+    prev_seq = None
+    for seq, ts_us, level, text in decoded:
+        if prev_seq is not None and seq != prev_seq + 1:
+            print("-- %d enregistrement(s) manquant(s) --" % (seq - prev_seq - 1))
+        prev_seq = seq
+        lvl = LEVELS[level] if level < len(LEVELS) else "?"
+        print("%10.6f %s #%-6d %s" % (ts_us / 1e6, lvl, seq, text))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())